@@ -51,7 +51,19 @@ public:
     bool queue_query(GWBUF* buffer);
 
     /**
-     * Destroy the client by sending a COM_QUIT to the backend
+     * Get the number of bytes that the service has not yet read
+     *
+     * This is the data queued in the client as well as the data in the send
+     * queue of the socket. The latter only grows once the service stops reading,
+     * e.g. because the write queue of its backend is above `writeq_high_water`.
+     *
+     * @return Number of bytes not yet read by the service
+     */
+    size_t pending_bytes() const;
+
+    /**
+     * Destroy the client by sending a COM_QUIT to the backend. A client whose
+     * connection has failed is deleted at once.
      *
      * @note After calling this function, object must be treated as a deleted object
      */
@@ -81,6 +93,7 @@ private:
     mxs::Buffer             m_partial;
     size_t                  m_expected_bytes;
     std::deque<mxs::Buffer> m_queue;
+    size_t                  m_queued_bytes;     // The number of bytes in m_queue
     MYSQL_session           m_client;
     MySQLProtocol           m_protocol;
     bool                    m_self_destruct;
@@ -37,7 +37,8 @@ public:
         RouteInfo(uint32_t target,
                   uint8_t  command,
                   uint32_t type_mask,
-                  uint32_t stmt_id);
+                  uint32_t stmt_id,
+                  bool     ps_cached = false);
 
         void reset();
 
@@ -61,6 +62,14 @@ public:
             return m_stmt_id;
         }
 
+        /**
+         * @return True if the target is the cached route target of a prepared statement
+         */
+        bool ps_cached() const
+        {
+            return m_ps_cached;
+        }
+
         void set_command(uint8_t c)
         {
             m_command = c;
@@ -96,6 +105,7 @@ public:
         uint8_t  m_command;     /**< The command byte, 0xff for unknown commands */
         uint32_t m_type_mask;   /**< The query type, QUERY_TYPE_UNKNOWN for unknown types*/
         uint32_t m_stmt_id;     /**< Prepared statement ID, 0 for unknown */
+        bool     m_ps_cached;   /**< Whether the target came from the prepared statement */
     };
 
     class Handler
@@ -319,17 +329,6 @@ private:
         return m_tmp_tables.find(table) != m_tmp_tables.end();
     }
 
-    /**
-     * @brief Get the type of a stored prepared statement
-     *
-     * @param id The unique identifier for the prepared statement or the plaintext
-     *           name of the prepared statement
-     *
-     * @return The type of the prepared statement
-     */
-    uint32_t ps_get_type(uint32_t id) const;
-    uint32_t ps_get_type(std::string id) const;
-
     /**
      * @brief Get the internal ID for the given binary prepared statement
      *
@@ -321,10 +321,23 @@ public:
     /**
      * Get next worker
      *
+     * If the calling thread has reserved a worker with reserve_worker(), that
+     * worker is returned and the reservation is cleared.
+     *
      * @return The worker where work should be assigned
      */
     static RoutingWorker* pick_worker();
 
+    /**
+     * Reserve the worker the next call to pick_worker() made by the calling
+     * thread will return. This allows the id of a session to encode the worker
+     * that will handle it, although the id is needed before the client DCB is
+     * added to a worker.
+     *
+     * @return The id of the reserved worker.
+     */
+    static int reserve_worker();
+
     /**
      * Worker local storage
      */
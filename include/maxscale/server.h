@@ -486,6 +486,29 @@ bool server_set_disk_space_threshold(SERVER* server, const char* disk_space_thre
  */
 void server_add_response_average(SERVER* server, double ave, int num_samples);
 
+/**
+ * @brief Set the GTID position of the server.
+ *
+ * Called by the monitors that track the replication position of the server.
+ *
+ * @param server   The server.
+ * @param gtid_pos The position as a comma separated list of GTIDs, one per
+ *                 replication domain. An empty string if not known. Only the
+ *                 first 16 domains are stored.
+ */
+void server_set_gtid_pos(SERVER* server, const char* gtid_pos);
+
+/**
+ * @brief Get the latest sequence number of a replication domain the server has.
+ *
+ * @param server The server.
+ * @param domain The replication domain.
+ *
+ * @return The sequence number of the latest GTID of the domain, as reported
+ *         by the monitor, or 0 if not known.
+ */
+uint64_t server_get_gtid_sequence(const SERVER* server, uint32_t domain);
+
 extern int     server_free(SERVER* server);
 extern SERVER* server_find_by_unique_name(const char* name);
 extern int     server_find_by_unique_names(char** server_names, int size, SERVER*** output);
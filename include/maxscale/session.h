@@ -472,12 +472,34 @@ static inline bool session_set_autocommit(MXS_SESSION* ses, bool autocommit)
 MXS_SESSION* session_get_by_id(uint64_t id);
 
 /**
- * Get the next available unique (assuming no overflow) session id number.
+ * Get the next available unique session id number.
+ *
+ * The id encodes the routing worker the next client connection accepted by
+ * the calling thread will be assigned to, which allows sessions to be looked
+ * up without visiting all workers.
+ *
+ * The ids fit in 32 bits, as that is the size of the connection id sent to
+ * MariaDB clients. The lowest 7 bits hold the id of the worker and the rest
+ * a counter, so 2^25 - 1 ids are generated for the workers together before
+ * the counter wraps around. After that, an id is only reused if no session
+ * of the worker has it. An id that has been generated but not given to a
+ * session yet, e.g. while the client is authenticating, is not checked for.
  *
  * @return An unused session id.
  */
 uint64_t session_get_next_id();
 
+/**
+ * Get the id of the routing worker a session id was generated for.
+ *
+ * @param id  A session id generated with session_get_next_id().
+ *
+ * @return The id of the routing worker that handles the session, provided
+ *         the session belongs to a protocol that lets the worker be chosen
+ *         by round-robin.
+ */
+int session_get_worker_id(uint64_t id);
+
 /**
  * @brief Close a session
  *
@@ -517,6 +539,23 @@ json_t* session_to_json(const MXS_SESSION* session, const char* host);
  */
 json_t* session_list_to_json(const char* host);
 
+/**
+ * @brief Convert a page of sessions to JSON
+ *
+ * The sessions are ordered by their id. The routing workers convert their own
+ * sessions concurrently and each worker converts only the sessions that may
+ * end up on the page.
+ *
+ * @param host    Hostname of this server
+ * @param cursor  Only sessions whose id is larger than this are included
+ * @param size    The maximum number of sessions on the page, 0 for no limit
+ * @param fields  Comma separated list of the attributes to include, NULL for all
+ *
+ * @return A JSON array with the sessions. If there are more sessions, the links
+ *         of the resource contain a link to the next page.
+ */
+json_t* session_list_page_to_json(const char* host, uint64_t cursor, size_t size, const char* fields);
+
 /**
  * Qualify the session for connection pooling
  *
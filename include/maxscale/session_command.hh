@@ -79,6 +79,22 @@ public:
      */
     bool eq(const SessionCommand& rhs) const;
 
+    /**
+     * @brief Calculate a hash of the command
+     *
+     * Commands that are equal have the same hash.
+     *
+     * @return Hash of the buffer contents
+     */
+    size_t hash() const;
+
+    /**
+     * @brief Get the length of the command
+     *
+     * @return Length of the buffer in bytes
+     */
+    size_t length() const;
+
     /**
      * Mark the session command as a re-execution of another command
      *
@@ -15,6 +15,7 @@
 #include <maxscale/ccdefs.hh>
 
 #include <stdio.h>
+#include <string.h>
 #include <openssl/sha.h>
 #include <zlib.h>
 
@@ -634,6 +635,198 @@ static inline bool operator!=(const CRC32Checksum& lhs, const CRC32Checksum& rhs
     return !(lhs == rhs);
 }
 
+/**
+ * A 128-bit MurmurHash3 checksum
+ *
+ * Not suitable for cryptographic purposes but a lot faster than SHA1.
+ */
+class Murmur3Checksum : public Checksum
+{
+public:
+
+    typedef std::array<uint64_t, 2> Sum;
+
+    Murmur3Checksum()
+    {
+        reset();
+        m_sum.fill(0);
+    }
+
+    void update(GWBUF* buffer)
+    {
+        for (GWBUF* b = buffer; b; b = b->next)
+        {
+            update(GWBUF_DATA(b), GWBUF_LENGTH(b));
+        }
+    }
+
+    /**
+     * Update the checksum calculation
+     *
+     * @param data Data to add to the calculation
+     * @param len  Length of the data
+     */
+    void update(const uint8_t* data, size_t len)
+    {
+        m_len += len;
+
+        // The data arrives in arbitrary pieces, the hash is calculated in 16 byte blocks
+        if (m_tail_len > 0)
+        {
+            size_t n = std::min(len, sizeof(m_tail) - m_tail_len);
+            memcpy(m_tail + m_tail_len, data, n);
+            m_tail_len += n;
+            data += n;
+            len -= n;
+
+            if (m_tail_len == sizeof(m_tail))
+            {
+                process_block(m_tail);
+                m_tail_len = 0;
+            }
+        }
+
+        for (; len >= sizeof(m_tail); data += sizeof(m_tail), len -= sizeof(m_tail))
+        {
+            process_block(data);
+        }
+
+        if (len > 0)
+        {
+            memcpy(m_tail, data, len);
+            m_tail_len = len;
+        }
+    }
+
+    void finalize(GWBUF* buffer = NULL)
+    {
+        update(buffer);
+
+        uint64_t k1 = 0;
+        uint64_t k2 = 0;
+
+        for (size_t i = m_tail_len; i > 8; i--)
+        {
+            k2 ^= (uint64_t)m_tail[i - 1] << ((i - 9) * 8);
+        }
+
+        if (m_tail_len > 8)
+        {
+            m_h2 ^= rotl(k2 * C2, 33) * C1;
+        }
+
+        for (size_t i = std::min(m_tail_len, (size_t)8); i > 0; i--)
+        {
+            k1 ^= (uint64_t)m_tail[i - 1] << ((i - 1) * 8);
+        }
+
+        if (m_tail_len > 0)
+        {
+            m_h1 ^= rotl(k1 * C1, 31) * C2;
+        }
+
+        m_h1 ^= m_len;
+        m_h2 ^= m_len;
+        m_h1 += m_h2;
+        m_h2 += m_h1;
+        m_h1 = fmix(m_h1);
+        m_h2 = fmix(m_h2);
+        m_h1 += m_h2;
+        m_h2 += m_h1;
+
+        m_sum[0] = m_h1;
+        m_sum[1] = m_h2;
+        reset();
+    }
+
+    void reset()
+    {
+        m_h1 = 0;
+        m_h2 = 0;
+        m_len = 0;
+        m_tail_len = 0;
+    }
+
+    std::string hex() const
+    {
+        uint8_t bytes[16];
+
+        for (int i = 0; i < 16; i++)
+        {
+            bytes[i] = m_sum[i / 8] >> ((i % 8) * 8);
+        }
+
+        return mxs::to_hex(bytes, bytes + sizeof(bytes));
+    }
+
+    /**
+     * @return The final checksum, valid after finalize() has been called
+     */
+    const Sum& value() const
+    {
+        return m_sum;
+    }
+
+    bool eq(const Murmur3Checksum& rhs) const
+    {
+        return m_sum == rhs.m_sum;
+    }
+
+private:
+
+    static const uint64_t C1 = 0x87c37b91114253d5ULL;
+    static const uint64_t C2 = 0x4cf5ad432745937fULL;
+
+    static uint64_t rotl(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static uint64_t fmix(uint64_t k)
+    {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    void process_block(const uint8_t* block)
+    {
+        uint64_t k1 = 0;
+        uint64_t k2 = 0;
+
+        for (int i = 7; i >= 0; i--)
+        {
+            k1 = (k1 << 8) | block[i];
+            k2 = (k2 << 8) | block[i + 8];
+        }
+
+        m_h1 ^= rotl(k1 * C1, 31) * C2;
+        m_h1 = (rotl(m_h1, 27) + m_h2) * 5 + 0x52dce729;
+        m_h2 ^= rotl(k2 * C2, 33) * C1;
+        m_h2 = (rotl(m_h2, 31) + m_h1) * 5 + 0x38495ab5;
+    }
+
+    uint64_t m_h1;          /**< Ongoing hash state */
+    uint64_t m_h2;          /**< Ongoing hash state */
+    uint64_t m_len;         /**< Number of bytes processed */
+    uint8_t  m_tail[16];    /**< Bytes not yet processed */
+    size_t   m_tail_len;    /**< Number of bytes in m_tail */
+    Sum      m_sum;         /**< Final checksum */
+};
+
+static inline bool operator==(const Murmur3Checksum& lhs, const Murmur3Checksum& rhs)
+{
+    return lhs.eq(rhs);
+}
+
+static inline bool operator!=(const Murmur3Checksum& lhs, const Murmur3Checksum& rhs)
+{
+    return !(lhs == rhs);
+}
+
 /**
  * Read bytes into a 64-bit unsigned integer.
  *
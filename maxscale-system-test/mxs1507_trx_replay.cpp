@@ -38,6 +38,11 @@ int main(int argc, char** argv)
                         mysql_error(test.maxscales->conn_rwsplit[0]));
         };
 
+    // The slaves are made to reply slower than the master to session commands
+    test.repl->connect();
+    std::string master_id = get_row(test.repl->nodes[0], "SELECT @@server_id")[0];
+    test.repl->disconnect();
+
     struct TrxTest
     {
         string                    description;
@@ -219,6 +224,20 @@ int main(int argc, char** argv)
             {
             }
         },
+        {
+            "Replay while slaves are executing a session command",
+            {
+                bind(ok, "SET @a = (SELECT SLEEP(IF(@@server_id = " + master_id + ", 0, 10)))"),
+                bind(ok, "BEGIN"),
+                bind(ok, "SELECT 1"),
+            },
+            {
+                bind(ok, "SELECT 2"),
+                bind(ok, "COMMIT"),
+            },
+            {
+            }
+        },
         {
             "Empty transaction",
             {
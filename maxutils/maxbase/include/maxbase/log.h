@@ -64,6 +64,12 @@ typedef enum mxb_log_augmentation_t
     MXB_LOG_AUGMENTATION_MASK     = (MXB_LOG_AUGMENT_WITH_FUNCTION)
 } mxb_log_augmentation_t;
 
+typedef enum mxb_log_overflow_t
+{
+    MXB_LOG_OVERFLOW_BLOCK, // Wait until the log writer has caught up.
+    MXB_LOG_OVERFLOW_DROP   // Drop the message; the number of dropped messages is logged.
+} mxb_log_overflow_t;
+
 typedef struct MXB_LOG_THROTTLING
 {
     size_t count;       // Maximum number of a specific message...
@@ -226,6 +232,16 @@ void mxb_log_set_throttling(const MXB_LOG_THROTTLING* throttling);
  */
 void mxb_log_get_throttling(MXB_LOG_THROTTLING* throttling);
 
+/**
+ * Set what to do with a message that cannot be buffered, because the
+ * log writer does not keep up with the logging.
+ *
+ * @param overflow  What to do.
+ *
+ * @attention Must be called before the log is initialized, to have an effect.
+ */
+void mxb_log_set_overflow(mxb_log_overflow_t overflow);
+
 /**
  * Redirect  stdout to the log file
  *
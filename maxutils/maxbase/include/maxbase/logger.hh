@@ -14,9 +14,11 @@
 
 #include <maxbase/ccdefs.hh>
 
+#include <condition_variable>
 #include <string>
 #include <mutex>
 #include <memory>
+#include <thread>
 
 #include <unistd.h>
 
@@ -62,6 +64,15 @@ public:
      */
     virtual bool rotate() = 0;
 
+    /**
+     * Write all messages that have not yet been written
+     *
+     * Returns once the messages have been written.
+     */
+    virtual void flush()
+    {
+    }
+
     /**
      * Get the name of the log file
      *
@@ -81,20 +92,48 @@ protected:
     std::string m_filename;
 };
 
+/**
+ * A logger that writes to a file
+ *
+ * The messages are not written by the thread that logs them, but are
+ * appended to a buffer from which a dedicated thread writes them to the
+ * file in batches. A slow disk thus does not stall the logging threads,
+ * unless the amount of messages waiting to be written exceeds the limit.
+ *
+ * A logger must not exist when the process forks, as the child would not
+ * have the writer thread.
+ */
 class FileLogger : public Logger
 {
 public:
     FileLogger(const FileLogger&) = delete;
     FileLogger& operator=(const FileLogger&) = delete;
 
+    /**
+     * What to do with a message, if the messages waiting to be written
+     * already exceed the limit.
+     */
+    enum Overflow
+    {
+        BLOCK,  // Wait until the writer thread has caught up.
+        DROP    // Discard the message; the number of discarded messages is logged.
+    };
+
+    // The default maximum number of bytes waiting to be written.
+    static const size_t DEFAULT_MAX_PENDING = 1024 * 1024;
+
     /**
      * Create a new logger that writes to a file
      *
-     * @param logdir Log file to open
+     * @param logdir       Log file to open
+     * @param overflow     What to do if the writer thread does not keep up.
+     * @param max_pending  The maximum number of bytes waiting to be written.
      *
      * @return New logger instance or an empty unique_ptr on error
      */
-    static std::unique_ptr<Logger> create(const std::string& filename);
+    static std::unique_ptr<Logger> create(const std::string& filename,
+                                          Overflow overflow = BLOCK,
+                                          size_t max_pending = DEFAULT_MAX_PENDING);
 
     /**
      * Close the log
@@ -104,28 +143,48 @@ public:
     ~FileLogger();
 
     /**
-     * Write a message to the log
+     * Queue a message to be written to the log
      *
      * @param msg Message to write
      * @param len Length of message
      *
-     * @return True on success
+     * @return True on success, false if the message was dropped
      */
     bool write(const char* msg, int len);
 
     /**
      * Rotate the logfile by reopening it
      *
+     * The messages waiting to be written are written to the old file.
+     *
      * @return True if the log was rotated. False if the opening of the new file
      *         descriptor failed in which case the old file descriptor will be used.
      */
     bool rotate();
 
-private:
-    int        m_fd;
-    std::mutex m_lock;
+    /**
+     * Write the messages waiting to be written, in the calling thread
+     */
+    void flush();
 
-    FileLogger(int fd, const std::string& filename);
+private:
+    int                     m_fd;
+    std::mutex              m_fd_lock;      // Held while m_fd is used, acquired before m_lock.
+    std::mutex              m_lock;         // Protects the members below.
+    std::condition_variable m_pending_cond; // Signalled when there is something to write.
+    std::condition_variable m_space_cond;   // Signalled when messages have been written.
+    std::string             m_pending;      // Messages waiting to be written.
+    std::string             m_writing;      // Messages being written, protected by m_fd_lock.
+    const Overflow          m_overflow;
+    const size_t            m_max_pending;
+    uint64_t                m_dropped;      // Messages dropped since the last write.
+    bool                    m_stop;
+    std::thread             m_thread;       // Must be last, as it uses the members above.
+
+    FileLogger(int fd, const std::string& filename, Overflow overflow, size_t max_pending);
+    void run();
+    bool write_pending();
+    bool write_fd(const char* msg, size_t len);
     bool write_header();
     bool write_footer(const char* suffix);
     void close(const char* msg);
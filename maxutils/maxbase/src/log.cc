@@ -21,6 +21,7 @@
 #include <cstring>
 #include <string>
 #include <cstdio>
+#include <atomic>
 #include <mutex>
 #include <unordered_map>
 
@@ -269,7 +270,6 @@ class MessageRegistryStats
 public:
     MessageRegistryStats()
         : m_first_ms(time_monotonic_ms())
-        , m_last_ms(0)
         , m_count(0)
     {
     }
@@ -280,68 +280,59 @@ public:
 
         uint64_t now_ms = time_monotonic_ms();
 
-        std::lock_guard<std::mutex> guard(m_lock);
+        // The statistics are updated without the lock; it is only taken when the
+        // window is reset. The start of the window is read before the counter is
+        // incremented and a reset stores the counter before the start, so a
+        // counter is never compared against the start of a newer window.
+        uint64_t first_ms = m_first_ms.load();
+        size_t count = ++m_count;
 
-        ++m_count;
-
-        // Less that t.window_ms milliseconds since the message was logged
-        // the last time. May have to be throttled.
-        if (m_count < t.count)
+        if (count < t.count)
         {
             // t.count times has not been reached, still ok to log.
         }
-        else if (m_count == t.count)
+        else if (count == t.count && now_ms - first_ms < t.window_ms)
         {
-            // t.count times has been reached. Was it within the window?
-            if (now_ms - m_first_ms < t.window_ms)
-            {
-                // Within the window, suppress the message.
-                rv = MESSAGE_SUPPRESSED;
-            }
-            else
-            {
-                // Not within the window, reset the situation.
-
-                // The flooding situation is analyzed window by window.
-                // That means that if there in each of two consequtive
-                // windows are not enough messages for throttling to take
-                // effect, but there would be if the window was placed at a
-                // slightly different position (e.g. starting in the middle
-                // of the first and ending in the middle of the second) it
-                // will go undetected and no throttling will be made.
-                // However, if that's the case, it was a spike so the
-                // flooding will stop anyway.
-
-                m_first_ms = now_ms;
-                m_count = 1;
-            }
+            // t.count times has been reached within the window, suppress the message.
+            rv = MESSAGE_SUPPRESSED;
+        }
+        else if (count > t.count && now_ms - first_ms < (t.window_ms + t.suppress_ms))
+        {
+            // In suppression mode and still in the suppression window.
+            rv = MESSAGE_STILL_SUPPRESSED;
         }
         else
         {
-            // In suppression mode.
-            if (now_ms - m_first_ms < (t.window_ms + t.suppress_ms))
+            // Either t.count times was reached outside the window, or we have
+            // exited the suppression window. Reset the situation.
+
+            // The flooding situation is analyzed window by window.
+            // That means that if there in each of two consequtive
+            // windows are not enough messages for throttling to take
+            // effect, but there would be if the window was placed at a
+            // slightly different position (e.g. starting in the middle
+            // of the first and ending in the middle of the second) it
+            // will go undetected and no throttling will be made.
+            // However, if that's the case, it was a spike so the
+            // flooding will stop anyway.
+
+            std::lock_guard<std::mutex> guard(m_lock);
+
+            if (m_first_ms.load() == first_ms)
             {
-                // Still in the suppression window.
-                rv = MESSAGE_STILL_SUPPRESSED;
-            }
-            else
-            {
-                // We have exited the suppression window, reset the situation.
-                m_first_ms = now_ms;
+                // Not yet reset by another thread.
                 m_count = 1;
+                m_first_ms = now_ms;
             }
         }
 
-        m_last_ms = now_ms;
-
         return rv;
     }
 
 private:
-    std::mutex m_lock;
-    uint64_t   m_first_ms;  /** The time when the error was logged the first time in this window. */
-    uint64_t   m_last_ms;   /** The time when the error was logged the last time. */
-    size_t     m_count;     /** How many times the error has been reported within this window. */
+    std::mutex            m_lock;       /** Serializes the resets of the window. */
+    std::atomic<uint64_t> m_first_ms;   /** When the error was logged the first time in this window. */
+    std::atomic<size_t>   m_count;      /** How many times the error has been reported within this window. */
 };
 }
 
@@ -386,6 +377,7 @@ struct this_unit
     bool                             do_syslog;         // Can change during the lifetime of log_manager.
     bool                             do_maxlog;         // Can change during the lifetime of log_manager.
     bool                             redirect_stdout;
+    mxb_log_overflow_t               overflow;
     MXB_LOG_THROTTLING               throttling;        // Can change during the lifetime of log_manager.
     std::unique_ptr<mxb::Logger>     sLogger;
     std::unique_ptr<MessageRegistry> sMessage_registry;
@@ -397,6 +389,7 @@ struct this_unit
     true,                       // do_syslog
     true,                       // do_maxlog
     false,                      // redirect_stdout
+    MXB_LOG_OVERFLOW_BLOCK,     // overflow
     DEFAULT_LOG_THROTTLING,     // throttling
 };
 
@@ -410,13 +403,40 @@ public:
     MessageRegistry& operator=(const MessageRegistry&) = delete;
 
     MessageRegistry()
+        : m_generation(++s_generation)
     {
     }
 
     Stats& get_stats(const Key& key)
     {
-        std::lock_guard<std::mutex> guard(m_lock);
-        return m_registry[key];
+        // The stats are looked up in a cache of the calling thread, so the
+        // registry lock is taken only when a thread logs a particular message
+        // for the first time. The stats are never moved, as the elements of
+        // an unordered_map are not relocated when it grows.
+        thread_local ThreadCache cache;
+
+        if (cache.generation != m_generation)
+        {
+            // The cache refers to a registry that no longer exists.
+            cache.stats.clear();
+            cache.generation = m_generation;
+        }
+
+        Stats* stats;
+        auto it = cache.stats.find(key);
+
+        if (it != cache.stats.end())
+        {
+            stats = it->second;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            stats = &m_registry[key];
+            cache.stats.insert(std::make_pair(key, stats));
+        }
+
+        return *stats;
     }
 
     message_suppression_t get_status(const char* file, int line)
@@ -440,9 +460,25 @@ public:
     }
 
 private:
+    struct ThreadCache
+    {
+        ThreadCache()
+            : generation(0)
+        {
+        }
+
+        uint64_t                        generation; // The registry the cache refers to.
+        std::unordered_map<Key, Stats*> stats;
+    };
+
+    static std::atomic<uint64_t> s_generation;
+
+    const uint64_t                 m_generation;
     std::mutex                     m_lock;
     std::unordered_map<Key, Stats> m_registry;
 };
+
+std::atomic<uint64_t> MessageRegistry::s_generation(0);
 }
 
 bool mxb_log_init(const char* ident,
@@ -488,7 +524,9 @@ bool mxb_log_init(const char* ident,
     {
     case MXB_LOG_TARGET_FS:
     case MXB_LOG_TARGET_DEFAULT:
-        this_unit.sLogger = mxb::FileLogger::create(filepath);
+        this_unit.sLogger = mxb::FileLogger::create(filepath,
+                                                    this_unit.overflow == MXB_LOG_OVERFLOW_DROP
+                                                    ? mxb::FileLogger::DROP : mxb::FileLogger::BLOCK);
 
         if (this_unit.sLogger && this_unit.redirect_stdout)
         {
@@ -609,6 +647,11 @@ void mxb_log_get_throttling(MXB_LOG_THROTTLING* throttling)
     *throttling = this_unit.throttling;
 }
 
+void mxb_log_set_overflow(mxb_log_overflow_t overflow)
+{
+    this_unit.overflow = overflow;
+}
+
 void mxs_log_redirect_stdout(bool redirect)
 {
     this_unit.redirect_stdout = redirect;
@@ -875,6 +918,13 @@ int mxb_log_message(int priority,
                 msg.push_back('\n');
 
                 err = this_unit.sLogger->write(msg.c_str(), msg.length()) ? 0 : -1;
+
+                if (level <= LOG_CRIT)
+                {
+                    // The process may be about to die, so the message is
+                    // not left for the writer thread.
+                    this_unit.sLogger->flush();
+                }
             }
         }
     }
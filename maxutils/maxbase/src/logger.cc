@@ -73,6 +73,28 @@ struct this_unit
     std::string ident;
 } this_unit;
 
+std::string get_dropped_message(uint64_t dropped)
+{
+    time_t t = time(NULL);
+    struct tm tm;
+    localtime_r(&t, &tm);
+
+    char message[256];
+    snprintf(message,
+             sizeof(message),
+             "%04d-%02d-%02d %02d:%02d:%02d   warning: %lu log messages were dropped, "
+             "as they could not be written fast enough.\n",
+             tm.tm_year + 1900,
+             tm.tm_mon + 1,
+             tm.tm_mday,
+             tm.tm_hour,
+             tm.tm_min,
+             tm.tm_sec,
+             (unsigned long)dropped);
+
+    return message;
+}
+
 std::string get_ident()
 {
     if (this_unit.ident.empty())
@@ -101,17 +123,20 @@ void Logger::set_ident(const std::string& ident)
     this_unit.ident = ident;
 }
 
-std::unique_ptr<Logger> FileLogger::create(const std::string& filename)
+std::unique_ptr<Logger> FileLogger::create(const std::string& filename,
+                                           Overflow overflow,
+                                           size_t max_pending)
 {
     std::unique_ptr<FileLogger> logger;
     int fd = open_fd(filename);
 
     if (fd != -1)
     {
-        logger.reset(new(std::nothrow) FileLogger(fd, filename));
+        logger.reset(new(std::nothrow) FileLogger(fd, filename, overflow, max_pending));
 
         if (logger)
         {
+            std::lock_guard<std::mutex> guard(logger->m_fd_lock);
             logger->write_header();
         }
         else
@@ -125,10 +150,21 @@ std::unique_ptr<Logger> FileLogger::create(const std::string& filename)
 
 FileLogger::~FileLogger()
 {
-    std::lock_guard<std::mutex> guard(m_lock);
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stop = true;
+    }
+
+    m_pending_cond.notify_one();
+    m_space_cond.notify_all();
+    m_thread.join();
+
+    std::lock_guard<std::mutex> guard(m_fd_lock);
     // As mxb_assert() logs to the log-file, it cannot be used here.
     assert(m_fd != -1);
 
+    write_pending();
+
     std::string suffix = get_ident();
     suffix += " is shut down.";
 
@@ -138,31 +174,37 @@ FileLogger::~FileLogger()
 bool FileLogger::write(const char* msg, int len)
 {
     bool rval = true;
-    std::lock_guard<std::mutex> guard(m_lock);
+    std::unique_lock<std::mutex> guard(m_lock);
 
-    while (len > 0)
+    // A message is always accepted if nothing is pending, as otherwise
+    // a message larger than the limit could never be logged.
+    auto has_space = [this, len]() {
+            return m_pending.empty() || m_pending.size() + len <= m_max_pending || m_stop;
+        };
+
+    if (!has_space())
     {
-        int rc;
-        do
+        if (m_overflow == DROP)
         {
-            rc = ::write(m_fd, msg, len);
+            ++m_dropped;
+            rval = false;
         }
-        while (rc == -1 && errno == EINTR);
-
-        if (rc == -1)
+        else
         {
-            if (should_log_error())     // Coarse error suppression
-            {
-                LOG_ERROR("Failed to write to log: %d, %s\n", errno, mxb_strerror(errno));
-            }
-
-            rval = false;
-            break;
+            m_space_cond.wait(guard, has_space);
         }
+    }
 
-        // If write only writes a part of the message, retry again
-        len -= rc;
-        msg += rc;
+    if (rval)
+    {
+        bool was_empty = m_pending.empty();
+
+        m_pending.append(msg, len);
+
+        if (was_empty)
+        {
+            m_pending_cond.notify_one();
+        }
     }
 
     return rval;
@@ -170,11 +212,12 @@ bool FileLogger::write(const char* msg, int len)
 
 bool FileLogger::rotate()
 {
-    std::lock_guard<std::mutex> guard(m_lock);
+    std::lock_guard<std::mutex> guard(m_fd_lock);
     int fd = open_fd(m_filename);
 
     if (fd != -1)
     {
+        write_pending();
         close("File closed due to log rotation.");
         m_fd = fd;
     }
@@ -182,14 +225,107 @@ bool FileLogger::rotate()
     return fd != -1;
 }
 
+void FileLogger::flush()
+{
+    std::lock_guard<std::mutex> guard(m_fd_lock);
+    write_pending();
+}
+
 //
 // Private methods
 //
 
-FileLogger::FileLogger(int fd, const std::string& filename)
+FileLogger::FileLogger(int fd, const std::string& filename, Overflow overflow, size_t max_pending)
     : Logger(filename)
     , m_fd(fd)
+    , m_overflow(overflow)
+    , m_max_pending(max_pending)
+    , m_dropped(0)
+    , m_stop(false)
+    , m_thread(&FileLogger::run, this)
+{
+}
+
+void FileLogger::run()
 {
+    std::unique_lock<std::mutex> guard(m_lock);
+
+    while (!m_stop)
+    {
+        m_pending_cond.wait(guard, [this]() {
+                                return !m_pending.empty() || m_stop;
+                            });
+
+        // The file descriptor lock must be acquired before m_lock.
+        guard.unlock();
+
+        {
+            std::lock_guard<std::mutex> fd_guard(m_fd_lock);
+            write_pending();
+        }
+
+        guard.lock();
+    }
+
+    // Whatever is left is written by the destructor.
+}
+
+// Called with m_fd_lock held.
+bool FileLogger::write_pending()
+{
+    uint64_t dropped;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_writing.swap(m_pending);
+        dropped = m_dropped;
+        m_dropped = 0;
+    }
+
+    m_space_cond.notify_all();
+
+    if (dropped != 0)
+    {
+        m_writing += get_dropped_message(dropped);
+    }
+
+    bool rval = write_fd(m_writing.data(), m_writing.length());
+    m_writing.clear();  // The capacity is retained for the next batch.
+
+    return rval;
+}
+
+// Called with m_fd_lock held.
+bool FileLogger::write_fd(const char* msg, size_t len)
+{
+    bool rval = true;
+
+    while (len > 0)
+    {
+        int rc;
+        do
+        {
+            rc = ::write(m_fd, msg, len);
+        }
+        while (rc == -1 && errno == EINTR);
+
+        if (rc == -1)
+        {
+            if (should_log_error())     // Coarse error suppression
+            {
+                LOG_ERROR("Failed to write to log: %d, %s\n", errno, mxb_strerror(errno));
+            }
+
+            rval = false;
+            break;
+        }
+
+        // If write only writes a part of the messages, retry again
+        len -= rc;
+        msg += rc;
+    }
+
+    return rval;
 }
 
 void FileLogger::close(const char* msg)
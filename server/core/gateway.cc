@@ -2838,6 +2838,25 @@ static int cnf_preparser(void* data, const char* section, const char* name, cons
         {
             set_log_augmentation(value);
         }
+        else if (strcmp(name, CN_LOG_OVERFLOW) == 0)
+        {
+            if (strcmp(value, "block") == 0)
+            {
+                mxs_log_set_overflow(MXB_LOG_OVERFLOW_BLOCK);
+            }
+            else if (strcmp(value, "drop") == 0)
+            {
+                mxs_log_set_overflow(MXB_LOG_OVERFLOW_DROP);
+            }
+            else
+            {
+                fprintf(stderr,
+                        "Error: Invalid value '%s' for '%s', expected 'block' or 'drop'.\n",
+                        value,
+                        CN_LOG_OVERFLOW);
+                return 0;
+            }
+        }
         else if (strcmp(name, CN_LOG_TO_SHM) == 0)
         {
             fprintf(stderr,
@@ -18,7 +18,9 @@
 
 #include <maxbase/ccdefs.hh>
 
+#include <atomic>
 #include <mutex>
+#include <vector>
 
 #include <maxbase/average.hh>
 #include <maxscale/server.h>
@@ -34,6 +36,8 @@ public:
 
     Server()
         : m_response_time(maxbase::EMAverage {0.04, 0.35, 500})
+        , m_gtid_version(0)
+        , m_gtid_count(0)
     {
     }
 
@@ -49,10 +53,31 @@ public:
 
     void response_time_add(double ave, int num_samples);
 
+    void     set_gtid_pos(const char* gtid_pos);
+    uint64_t gtid_sequence(uint32_t domain) const;
+
     mutable std::mutex m_lock;
 
 private:
     maxbase::EMAverage m_response_time;
+
+    // The maximum number of replication domains whose position is stored
+    static const size_t MAX_GTID_DOMAINS = 16;
+
+    struct GtidPos
+    {
+        std::atomic<uint32_t> domain;
+        std::atomic<uint64_t> sequence;
+    };
+
+    // The sequence number of each replication domain. The position is written
+    // by the monitor and read by the routing workers for every causal read, so
+    // it is published with a sequence lock: a reader retries if the version was
+    // odd, i.e. an update was in progress, or changed while it was reading.
+    GtidPos               m_gtid_pos[MAX_GTID_DOMAINS];
+    std::atomic<uint64_t> m_gtid_version;
+    std::atomic<size_t>   m_gtid_count;
+    std::mutex            m_gtid_lock;      // Serializes the writers
 };
 
 void server_free(Server* server);
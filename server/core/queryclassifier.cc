@@ -204,17 +204,20 @@ QueryClassifier::RouteInfo::RouteInfo()
     , m_command(0xff)
     , m_type_mask(QUERY_TYPE_UNKNOWN)
     , m_stmt_id(0)
+    , m_ps_cached(false)
 {
 }
 
 QueryClassifier::RouteInfo::RouteInfo(uint32_t target,
                                       uint8_t  command,
                                       uint32_t type_mask,
-                                      uint32_t stmt_id)
+                                      uint32_t stmt_id,
+                                      bool     ps_cached)
     : m_target(target)
     , m_command(command)
     , m_type_mask(type_mask)
     , m_stmt_id(stmt_id)
+    , m_ps_cached(ps_cached)
 {
 }
 
@@ -224,6 +227,7 @@ void QueryClassifier::RouteInfo::reset()
     m_command = 0xff;
     m_type_mask = QUERY_TYPE_UNKNOWN;
     m_stmt_id = 0;
+    m_ps_cached = false;
 }
 
 class QueryClassifier::PSManager
@@ -232,6 +236,33 @@ class QueryClassifier::PSManager
     PSManager& operator=(const PSManager&) = delete;
 
 public:
+    /**
+     * A prepared statement and the routing decisions made for it
+     *
+     * The route target of an execution only depends on the type of the
+     * statement and on the transaction state of the session, so once
+     * computed for a state, it can be reused for all subsequent executions
+     * without hints made in the same state.
+     */
+    struct Stmt
+    {
+        enum
+        {
+            STATE_TRX_ACTIVE    = 0x01,
+            STATE_TRX_READ_ONLY = 0x02,
+            N_STATES            = 0x04
+        };
+
+        Stmt(uint32_t t = QUERY_TYPE_UNKNOWN)
+            : type(t)
+            , targets{}
+        {
+        }
+
+        uint32_t type;                  /**< The type of the statement */
+        uint32_t targets[N_STATES];     /**< Route target by state, TARGET_UNDEFINED if not known */
+    };
+
     PSManager()
     {
     }
@@ -249,11 +280,11 @@ public:
         switch (mxs_mysql_get_command(buffer))
         {
         case MXS_COM_QUERY:
-            m_text_ps[get_text_ps_id(buffer)] = get_prepare_type(buffer);
+            m_text_ps[get_text_ps_id(buffer)] = Stmt(get_prepare_type(buffer));
             break;
 
         case MXS_COM_STMT_PREPARE:
-            m_binary_ps[id] = get_prepare_type(buffer);
+            m_binary_ps[id] = Stmt(get_prepare_type(buffer));
             break;
 
         default:
@@ -262,14 +293,14 @@ public:
         }
     }
 
-    uint32_t get_type(uint32_t id) const
+    Stmt* get(uint32_t id)
     {
-        uint32_t rval = QUERY_TYPE_UNKNOWN;
-        BinaryPSMap::const_iterator it = m_binary_ps.find(id);
+        Stmt* rval = NULL;
+        BinaryPSMap::iterator it = m_binary_ps.find(id);
 
         if (it != m_binary_ps.end())
         {
-            rval = it->second;
+            rval = &it->second;
         }
         else
         {
@@ -279,14 +310,14 @@ public:
         return rval;
     }
 
-    uint32_t get_type(std::string id) const
+    Stmt* get(const std::string& id)
     {
-        uint32_t rval = QUERY_TYPE_UNKNOWN;
-        TextPSMap::const_iterator it = m_text_ps.find(id);
+        Stmt* rval = NULL;
+        TextPSMap::iterator it = m_text_ps.find(id);
 
         if (it != m_text_ps.end())
         {
-            rval = it->second;
+            rval = &it->second;
         }
         else
         {
@@ -331,8 +362,8 @@ public:
     }
 
 private:
-    typedef std::unordered_map<uint32_t, uint32_t>    BinaryPSMap;
-    typedef std::unordered_map<std::string, uint32_t> TextPSMap;
+    typedef std::unordered_map<uint32_t, Stmt>    BinaryPSMap;
+    typedef std::unordered_map<std::string, Stmt> TextPSMap;
 
 private:
     BinaryPSMap m_binary_ps;
@@ -364,16 +395,6 @@ void QueryClassifier::ps_store(GWBUF* pBuffer, uint32_t id)
     return m_sPs_manager->store(pBuffer, id);
 }
 
-uint32_t QueryClassifier::ps_get_type(uint32_t id) const
-{
-    return m_sPs_manager->get_type(id);
-}
-
-uint32_t QueryClassifier::ps_get_type(std::string id) const
-{
-    return m_sPs_manager->get_type(id);
-}
-
 void QueryClassifier::ps_erase(GWBUF* buffer)
 {
     return m_sPs_manager->erase(buffer);
@@ -867,6 +888,7 @@ QueryClassifier::RouteInfo QueryClassifier::update_route_info(
     uint8_t command = 0xFF;
     uint32_t type_mask = QUERY_TYPE_UNKNOWN;
     uint32_t stmt_id = 0;
+    bool ps_cached = false;
 
     // TODO: It may be sufficient to simply check whether we are in a read-only
     // TODO: transaction.
@@ -887,6 +909,15 @@ QueryClassifier::RouteInfo QueryClassifier::update_route_info(
         {
             type_mask = QUERY_TYPE_READ;
         }
+        else if (command == MXS_COM_STMT_EXECUTE && load_data_state() == LOAD_DATA_INACTIVE)
+        {
+            /**
+             * A binary protocol execution is neither a multi-statement nor does it
+             * create temporary tables, so there is nothing to classify. The type
+             * comes from the prepared statement.
+             */
+            type_mask = QUERY_TYPE_EXEC_STMT;
+        }
         else
         {
             type_mask = QueryClassifier::determine_query_type(pBuffer, command);
@@ -944,20 +975,54 @@ QueryClassifier::RouteInfo QueryClassifier::update_route_info(
         }
         else
         {
+            PSManager::Stmt* pStmt = NULL;
+            bool is_ps = false;
+
             if (!in_read_only_trx
                 && command == MXS_COM_QUERY
                 && qc_get_operation(pBuffer) == QUERY_OP_EXECUTE)
             {
-                std::string id = get_text_ps_id(pBuffer);
-                type_mask = ps_get_type(id);
+                pStmt = m_sPs_manager->get(get_text_ps_id(pBuffer));
+                is_ps = true;
             }
             else if (qc_mysql_is_ps_command(command))
             {
                 stmt_id = ps_id_internal_get(pBuffer);
-                type_mask = ps_get_type(stmt_id);
+                pStmt = m_sPs_manager->get(stmt_id);
+                is_ps = true;
+            }
+
+            if (is_ps)
+            {
+                type_mask = pStmt ? pStmt->type : QUERY_TYPE_UNKNOWN;
             }
 
-            route_target = get_route_target(command, type_mask, pBuffer->hint);
+            if (pStmt
+                && (command == MXS_COM_QUERY || command == MXS_COM_STMT_EXECUTE)
+                && !pBuffer->hint
+                && load_data_state() == LOAD_DATA_INACTIVE)
+            {
+                // Executions without hints are routed the same way as the previous
+                // execution in the same transaction state.
+                int state = (session_trx_is_active(m_pSession) ? PSManager::Stmt::STATE_TRX_ACTIVE : 0)
+                    | (session_trx_is_read_only(m_pSession) ? PSManager::Stmt::STATE_TRX_READ_ONLY : 0);
+                uint32_t& target = pStmt->targets[state];
+
+                if (target == TARGET_UNDEFINED)
+                {
+                    target = get_route_target(command, type_mask, NULL);
+                }
+                else
+                {
+                    ps_cached = true;
+                }
+
+                route_target = target;
+            }
+            else
+            {
+                route_target = get_route_target(command, type_mask, pBuffer->hint);
+            }
         }
 
         if (session_trx_is_ending(m_pSession)
@@ -982,7 +1047,7 @@ QueryClassifier::RouteInfo QueryClassifier::update_route_info(
                  load_data_sent());
     }
 
-    m_route_info = RouteInfo(route_target, command, type_mask, stmt_id);
+    m_route_info = RouteInfo(route_target, command, type_mask, stmt_id, ps_cached);
 
     return m_route_info;
 }
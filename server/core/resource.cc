@@ -12,6 +12,9 @@
  */
 #include "internal/resource.hh"
 
+#include <ctype.h>
+#include <errno.h>
+
 #include <list>
 #include <map>
 #include <sstream>
@@ -612,14 +615,53 @@ HttpResponse cb_get_monitor(const HttpRequest& request)
     return HttpResponse(MHD_HTTP_OK, monitor_to_json(monitor, request.host()));
 }
 
+/**
+ * Parse an unsigned integer request option
+ *
+ * @param value  The value of the option
+ * @param result The parsed value
+ *
+ * @return True if the value consists only of decimal digits and fits into 64 bits
+ */
+static bool parse_uint_option(const string& value, uint64_t* result)
+{
+    char* end;
+    errno = 0;
+    *result = strtoull(value.c_str(), &end, 10);
+
+    return !value.empty() && isdigit(value[0]) && *end == '\0' && errno == 0;
+}
+
 HttpResponse cb_all_sessions(const HttpRequest& request)
 {
-    return HttpResponse(MHD_HTTP_OK, session_list_to_json(request.host()));
+    string size = request.get_option("page[size]");
+    string cursor = request.get_option("page[cursor]");
+    string fields = request.get_option("fields[sessions]");
+    uint64_t page_size = 0;
+    uint64_t page_cursor = 0;
+
+    if (!size.empty() && (!parse_uint_option(size, &page_size) || page_size == 0))
+    {
+        return HttpResponse(MHD_HTTP_BAD_REQUEST,
+                            mxs_json_error("Invalid value for `page[size]`: %s", size.c_str()));
+    }
+
+    if (!cursor.empty() && !parse_uint_option(cursor, &page_cursor))
+    {
+        return HttpResponse(MHD_HTTP_BAD_REQUEST,
+                            mxs_json_error("Invalid value for `page[cursor]`: %s", cursor.c_str()));
+    }
+
+    return HttpResponse(MHD_HTTP_OK,
+                        session_list_page_to_json(request.host(),
+                                                  page_cursor,
+                                                  page_size,
+                                                  fields.empty() ? NULL : fields.c_str()));
 }
 
 HttpResponse cb_get_session(const HttpRequest& request)
 {
-    int id = atoi(request.uri_part(1).c_str());
+    uint64_t id = strtoull(request.uri_part(1).c_str(), NULL, 10);
     MXS_SESSION* session = session_get_by_id(id);
 
     if (session)
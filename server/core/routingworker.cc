@@ -88,11 +88,20 @@ int next_worker_id()
 thread_local struct this_thread
 {
     int current_worker_id;      // The worker id of the current thread
+    int reserved_worker_id;     // The worker reserved by the current thread
 } this_thread =
 {
+    WORKER_ABSENT_ID,
     WORKER_ABSENT_ID
 };
 
+int next_round_robin_worker_id()
+{
+    static int id_generator = 0;
+    return this_unit.id_min_worker
+           + (mxb::atomic::add(&id_generator, 1, mxb::atomic::RELAXED) % this_unit.nWorkers);
+}
+
 /**
  * Calls thread_init on all loaded modules.
  *
@@ -960,11 +969,33 @@ std::unique_ptr<json_t> RoutingWorker::get_qc_stats_as_json(const char* zHost)
 // static
 RoutingWorker* RoutingWorker::pick_worker()
 {
-    static int id_generator = 0;
-    int id = this_unit.id_min_worker
-        + (mxb::atomic::add(&id_generator, 1, mxb::atomic::RELAXED) % this_unit.nWorkers);
+    int id = this_thread.reserved_worker_id;
+
+    if (id == WORKER_ABSENT_ID)
+    {
+        id = next_round_robin_worker_id();
+    }
+    else
+    {
+        this_thread.reserved_worker_id = WORKER_ABSENT_ID;
+    }
+
     return get(id);
 }
+
+// static
+int RoutingWorker::reserve_worker()
+{
+    int id = 0;
+
+    if (this_unit.nWorkers != 0)
+    {
+        id = next_round_robin_worker_id();
+        this_thread.reserved_worker_id = id;
+    }
+
+    return id;
+}
 }
 
 size_t mxs_rworker_broadcast_message(uint32_t msg_id, intptr_t arg1, intptr_t arg2)
@@ -1549,6 +1549,18 @@ void server_add_response_average(SERVER* srv, double ave, int num_samples)
     server->response_time_add(ave, num_samples);
 }
 
+void server_set_gtid_pos(SERVER* srv, const char* gtid_pos)
+{
+    Server* server = static_cast<Server*>(srv);
+    server->set_gtid_pos(gtid_pos);
+}
+
+uint64_t server_get_gtid_sequence(const SERVER* srv, uint32_t domain)
+{
+    const Server* server = static_cast<const Server*>(srv);
+    return server->gtid_sequence(domain);
+}
+
 int server_response_time_num_samples(const SERVER* srv)
 {
     const Server* server = static_cast<const Server*>(srv);
@@ -1561,6 +1573,81 @@ double server_response_time_average(const SERVER* srv)
     return server->response_time_average();
 }
 
+void Server::set_gtid_pos(const char* gtid_pos)
+{
+    std::lock_guard<std::mutex> guard(m_gtid_lock);
+    uint64_t version = m_gtid_version.load(std::memory_order_relaxed);
+    m_gtid_version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t count = 0;
+    const char* ptr = gtid_pos;
+
+    // The GTIDs are of the form domain-server_id-sequence
+    while (*ptr && count < MAX_GTID_DOMAINS)
+    {
+        char* end;
+        uint32_t domain = strtoul(ptr, &end, 10);
+
+        if (*end == '-')
+        {
+            strtoul(end + 1, &end, 10);
+
+            if (*end == '-')
+            {
+                uint64_t sequence = strtoull(end + 1, &end, 10);
+                m_gtid_pos[count].domain.store(domain, std::memory_order_relaxed);
+                m_gtid_pos[count].sequence.store(sequence, std::memory_order_relaxed);
+                ++count;
+            }
+        }
+
+        ptr = strchr(end, ',');
+
+        if (ptr)
+        {
+            ++ptr;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    // The domains that do not fit are not known, so causal reads wait for them.
+    m_gtid_count.store(count, std::memory_order_relaxed);
+    m_gtid_version.store(version + 2, std::memory_order_release);
+}
+
+uint64_t Server::gtid_sequence(uint32_t domain) const
+{
+    uint64_t rval;
+    uint64_t before;
+    uint64_t after;
+
+    do
+    {
+        rval = 0;
+        before = m_gtid_version.load(std::memory_order_acquire);
+        size_t count = m_gtid_count.load(std::memory_order_relaxed);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (m_gtid_pos[i].domain.load(std::memory_order_relaxed) == domain)
+            {
+                rval = m_gtid_pos[i].sequence.load(std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_gtid_version.load(std::memory_order_relaxed);
+    }
+    while ((before & 1) || before != after);
+
+    return rval;
+}
+
 /** Apply backend average and adjust sample_max, which determines the weight of a new average
  *  applied to EMAverage.
  *  Sample max is raised if the server is fast, aggresively lowered if the incoming average is clearly
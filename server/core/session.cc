@@ -23,19 +23,26 @@
 #include <string.h>
 #include <errno.h>
 #include <algorithm>
+#include <mutex>
+#include <set>
 #include <string>
 #include <sstream>
+#include <unordered_set>
+#include <vector>
 
 #include <maxscale/alloc.h>
 #include <maxbase/atomic.hh>
 #include <maxscale/clock.h>
 #include <maxscale/dcb.h>
+#include <maxscale/config.h>
 #include <maxscale/housekeeper.h>
+#include <maxscale/limits.h>
 #include <maxscale/log.h>
 #include <maxscale/poll.h>
 #include <maxscale/router.h>
 #include <maxscale/service.h>
 #include <maxscale/utils.h>
+#include <maxscale/utils.hh>
 #include <maxscale/json_api.h>
 #include <maxscale/protocol/mysql.h>
 #include <maxscale/routingworker.hh>
@@ -55,6 +62,32 @@ using namespace maxscale;
  */
 static uint64_t next_session_id = 1;
 
+/** The number of low bits of a session id that hold the id of a routing worker. */
+#define SESSION_ID_WORKER_BITS 7
+
+/** The number of bits of a session id that hold the counter. The ids are sent in the
+ *  32-bit connection id field of the MariaDB handshake, so they must fit in 32 bits. */
+#define SESSION_ID_COUNTER_BITS (32 - SESSION_ID_WORKER_BITS)
+
+static_assert(MXS_MAX_ROUTING_THREADS <= (1 << SESSION_ID_WORKER_BITS),
+              "All routing worker ids must fit in a session id.");
+
+namespace
+{
+
+/**
+ * The ids of the live sessions of a routing worker. Once the counter has wrapped
+ * around, an id is reused only if no session of the worker has it.
+ */
+struct SessionIds
+{
+    std::mutex                   lock;
+    std::unordered_set<uint64_t> ids;
+};
+
+SessionIds session_ids[1 << SESSION_ID_WORKER_BITS];
+}
+
 static uint32_t retain_last_statements = 0;
 static session_dump_statements_t dump_statements = SESSION_DUMP_STATEMENTS_NEVER;
 
@@ -117,6 +150,13 @@ static MXS_SESSION* session_alloc_body(SERVICE* service,
 {
     session->state = SESSION_STATE_READY;
     session->ses_id = id;
+
+    {
+        SessionIds& ids = session_ids[session_get_worker_id(id)];
+        std::lock_guard<std::mutex> guard(ids.lock);
+        ids.ids.insert(id);
+    }
+
     session->client_dcb = client_dcb;
     session->router_session = NULL;
     session->stats.connect = time(0);
@@ -371,6 +411,12 @@ static void session_final_free(MXS_SESSION* ses)
 
     session->state = SESSION_STATE_TO_BE_FREED;
 
+    {
+        SessionIds& ids = session_ids[session_get_worker_id(session->ses_id)];
+        std::lock_guard<std::mutex> guard(ids.lock);
+        ids.ids.erase(session->ses_id);
+    }
+
     mxb::atomic::add(&session->service->stats.n_current, -1, mxb::atomic::RELAXED);
 
     if (session->client_dcb)
@@ -791,9 +837,30 @@ static bool ses_find_id(DCB* dcb, void* data)
 MXS_SESSION* session_get_by_id(uint64_t id)
 {
     MXS_SESSION* session = NULL;
-    void* params[] = {&session, &id};
+    int worker_id = session_get_worker_id(id);
 
-    dcb_foreach(ses_find_id, params);
+    if (worker_id < config_threadcount())
+    {
+        // Sessions registered by their protocol are looked up from the registry
+        // of the worker the id was generated for, without visiting other workers.
+        RoutingWorker* worker = RoutingWorker::get(worker_id);
+
+        worker->call([&session, id]() {
+                         session = mxs_rworker_find_session(id);
+
+                         if (session)
+                         {
+                             session_get_ref(session);
+                         }
+                     }, Worker::EXECUTE_AUTO);
+    }
+
+    if (!session)
+    {
+        // Not a registered session, e.g. an administrative one.
+        void* params[] = {&session, &id};
+        dcb_foreach(ses_find_id, params);
+    }
 
     return session;
 }
@@ -818,7 +885,28 @@ void session_put_ref(MXS_SESSION* session)
 
 uint64_t session_get_next_id()
 {
-    return mxb::atomic::add(&next_session_id, 1, mxb::atomic::RELAXED);
+    const uint64_t n_counter_values = (1 << SESSION_ID_COUNTER_BITS) - 1;
+    uint64_t worker_id = RoutingWorker::reserve_worker();
+    SessionIds& ids = session_ids[worker_id];
+    uint64_t id;
+
+    std::lock_guard<std::mutex> guard(ids.lock);
+
+    do
+    {
+        // The counter wraps around from its largest value to 1, skipping 0
+        uint64_t counter = mxb::atomic::add(&next_session_id, 1, mxb::atomic::RELAXED);
+        counter = (counter - 1) % n_counter_values + 1;
+        id = (counter << SESSION_ID_WORKER_BITS) | worker_id;
+    }
+    while (ids.ids.count(id));
+
+    return id;
+}
+
+int session_get_worker_id(uint64_t id)
+{
+    return id & ((1 << SESSION_ID_WORKER_BITS) - 1);
 }
 
 json_t* session_json_data(const Session* session, const char* host)
@@ -912,27 +1000,142 @@ json_t* session_to_json(const MXS_SESSION* session, const char* host)
 
 struct SessionListData
 {
-    json_t*     json;
-    const char* host;
+    std::vector<Session*> sessions;
+    uint64_t              cursor;
 };
 
 bool seslist_cb(DCB* dcb, void* data)
 {
-    if (dcb->dcb_role == DCB_ROLE_CLIENT_HANDLER)
+    SessionListData* d = (SessionListData*)data;
+
+    if (dcb->dcb_role == DCB_ROLE_CLIENT_HANDLER && dcb->session->ses_id > d->cursor)
     {
-        SessionListData* d = (SessionListData*)data;
-        Session* session = static_cast<Session*>(dcb->session);
-        json_array_append_new(d->json, session_json_data(session, d->host));
+        d->sessions.push_back(static_cast<Session*>(dcb->session));
     }
 
     return true;
 }
 
+static bool session_id_less(const Session* lhs, const Session* rhs)
+{
+    return lhs->ses_id < rhs->ses_id;
+}
+
+static void remove_unlisted_attributes(json_t* data, const std::set<string>& fields)
+{
+    json_t* attr = json_object_get(data, CN_ATTRIBUTES);
+    const char* key;
+    json_t* value;
+    void* tmp;
+
+    json_object_foreach_safe(attr, tmp, key, value)
+    {
+        if (fields.count(key) == 0)
+        {
+            json_object_del(attr, key);
+        }
+    }
+}
+
 json_t* session_list_to_json(const char* host)
 {
-    SessionListData data = {json_array(), host};
-    dcb_foreach(seslist_cb, &data);
-    return mxs_json_resource(host, MXS_JSON_API_SESSIONS, data.json);
+    return session_list_page_to_json(host, 0, 0, NULL);
+}
+
+json_t* session_list_page_to_json(const char* host, uint64_t cursor, size_t size, const char* fields)
+{
+    typedef std::pair<uint64_t, json_t*> Item;
+
+    std::set<string> field_set;
+
+    if (fields)
+    {
+        for (const auto& f : mxs::strtok(fields, ","))
+        {
+            field_set.insert(mxs::trimmed_copy(f));
+        }
+    }
+
+    std::vector<Item> items;
+    bool more = false;
+    std::mutex lock;
+    mxb::Semaphore sem;
+
+    auto n = RoutingWorker::broadcast([&]() {
+                                          SessionListData data;
+                                          data.cursor = cursor;
+                                          dcb_foreach_local(seslist_cb, &data);
+
+                                          auto end = data.sessions.end();
+
+                                          if (size != 0 && data.sessions.size() > size)
+                                          {
+                                              // Only the first sessions of this worker can end up on the page.
+                                              end = data.sessions.begin() + size;
+                                              std::nth_element(data.sessions.begin(), end,
+                                                               data.sessions.end(), session_id_less);
+                                          }
+
+                                          std::vector<Item> local;
+
+                                          for (auto it = data.sessions.begin(); it != end; ++it)
+                                          {
+                                              json_t* json = session_json_data(*it, host);
+
+                                              if (!field_set.empty())
+                                              {
+                                                  remove_unlisted_attributes(json, field_set);
+                                              }
+
+                                              local.push_back(Item((*it)->ses_id, json));
+                                          }
+
+                                          std::lock_guard<std::mutex> guard(lock);
+                                          items.insert(items.end(), local.begin(), local.end());
+                                          more = more || end != data.sessions.end();
+                                      },
+                                      &sem,
+                                      RoutingWorker::EXECUTE_AUTO);
+
+    sem.wait_n(n);
+
+    std::sort(items.begin(), items.end());
+
+    if (size != 0 && items.size() > size)
+    {
+        for (auto it = items.begin() + size; it != items.end(); ++it)
+        {
+            json_decref(it->second);
+        }
+
+        items.resize(size);
+        more = true;
+    }
+
+    json_t* arr = json_array();
+
+    for (const auto& item : items)
+    {
+        json_array_append_new(arr, item.second);
+    }
+
+    json_t* rval = mxs_json_resource(host, MXS_JSON_API_SESSIONS, arr);
+
+    if (more)
+    {
+        stringstream next;
+        next << host << MXS_JSON_API_SESSIONS << "?page[size]=" << size
+             << "&page[cursor]=" << items.back().first;
+
+        if (fields)
+        {
+            next << "&fields[sessions]=" << fields;
+        }
+
+        json_object_set_new(json_object_get(rval, CN_LINKS), "next", json_string(next.str().c_str()));
+    }
+
+    return rval;
 }
 
 void session_qualify_for_pool(MXS_SESSION* session)
@@ -58,6 +58,25 @@ bool SessionCommand::eq(const SessionCommand& rhs) const
     return rhs.m_buffer.compare(m_buffer) == 0;
 }
 
+size_t SessionCommand::hash() const
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (auto it = m_buffer.begin(); it != m_buffer.end(); ++it)
+    {
+        hash ^= *it;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+size_t SessionCommand::length() const
+{
+    return m_buffer.length();
+}
+
 std::string SessionCommand::to_string()
 {
     std::string str;
@@ -17,5 +17,23 @@ describe("Errors", function()
                .should.be.rejected
     })
 
+    it("error on invalid page size", function()
+    {
+        return request.get(base_url + "/sessions?page[size]=abc")
+               .should.be.rejected
+    })
+
+    it("error on zero page size", function()
+    {
+        return request.get(base_url + "/sessions?page[size]=0")
+               .should.be.rejected
+    })
+
+    it("error on invalid page cursor", function()
+    {
+        return request.get(base_url + "/sessions?page[size]=10&page[cursor]=-1")
+               .should.be.rejected
+    })
+
     after(stopMaxScale)
 });
@@ -176,6 +176,46 @@ bool test_serialize()
     return true;
 }
 
+bool test_gtid_pos()
+{
+    SERVER* server = server_alloc("gtid-server", params.params());
+    TEST(server, "Server allocation failed");
+
+    TEST(server_get_gtid_sequence(server, 0) == 0, "An unknown position should be 0");
+
+    server_set_gtid_pos(server, "0-1-100,1-2-200,5-3-18446744073709551615");
+    TEST(server_get_gtid_sequence(server, 0) == 100, "Wrong sequence for domain 0");
+    TEST(server_get_gtid_sequence(server, 1) == 200, "Wrong sequence for domain 1");
+    TEST(server_get_gtid_sequence(server, 5) == 18446744073709551615ULL, "Wrong sequence for domain 5");
+    TEST(server_get_gtid_sequence(server, 2) == 0, "Domain 2 should not be known");
+
+    server_set_gtid_pos(server, "1-2-201");
+    TEST(server_get_gtid_sequence(server, 0) == 0, "Domain 0 should no longer be known");
+    TEST(server_get_gtid_sequence(server, 1) == 201, "Wrong sequence for domain 1 after an update");
+
+    server_set_gtid_pos(server, "abc,0-1,2-x-5, 3-1-7");
+    TEST(server_get_gtid_sequence(server, 0) == 0, "An incomplete GTID should be ignored");
+    TEST(server_get_gtid_sequence(server, 2) == 0, "A GTID with an invalid server id should be ignored");
+    TEST(server_get_gtid_sequence(server, 3) == 7, "A valid GTID after invalid ones should be parsed");
+
+    std::string many;
+
+    for (int i = 0; i < 100; i++)
+    {
+        many += (many.empty() ? "" : ",") + std::to_string(i) + "-1-" + std::to_string(i + 1000);
+    }
+
+    server_set_gtid_pos(server, many.c_str());
+    TEST(server_get_gtid_sequence(server, 0) == 1000, "The first of many domains should be known");
+    TEST(server_get_gtid_sequence(server, 99) == 0, "Domains that do not fit should not be known");
+
+    server_set_gtid_pos(server, "");
+    TEST(server_get_gtid_sequence(server, 0) == 0, "An empty position should clear the domains");
+
+    server_free((Server*)server);
+    return true;
+}
+
 int main(int argc, char** argv)
 {
     /**
@@ -198,6 +238,11 @@ int main(int argc, char** argv)
         result++;
     }
 
+    if (!test_gtid_pos())
+    {
+        result++;
+    }
+
     mxs_log_finish();
     exit(result);
 }
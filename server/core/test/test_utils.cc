@@ -163,8 +163,34 @@ int test_checksums()
     mxb_assert(sum1.hex() == saved);
     mxb_assert(sum2.hex() == saved);
 
+    sum1.reset();
+    sum2.reset();
+
+    // Check that the same data split into several buffers produces the same checksum
+    GWBUF* d3 = gwbuf_alloc_and_load(5, data);
+    d3 = gwbuf_append(d3, gwbuf_alloc_and_load(sizeof(data) - 5, data + 5));
+    sum1.finalize(d3);
+    mxb_assert(sum1.hex() == saved);
+
     gwbuf_free(d1);
     gwbuf_free(d2);
+    gwbuf_free(d3);
+
+    return 0;
+}
+
+int test_murmur3()
+{
+    const char data[] = "The quick brown fox jumps over the lazy dog";
+    mxs::Murmur3Checksum sum;
+
+    // Data longer than one 16 byte block, split at an arbitrary point
+    GWBUF* buf = gwbuf_alloc_and_load(7, data);
+    buf = gwbuf_append(buf, gwbuf_alloc_and_load(sizeof(data) - 1 - 7, data + 7));
+    sum.finalize(buf);
+    mxb_assert(sum.hex() == "6c1b07bc7bbc4be347939ac4a93c437a");
+
+    gwbuf_free(buf);
 
     return 0;
 }
@@ -178,6 +204,8 @@ int main(int argc, char* argv[])
     rv += test_trim_trailing();
     rv += test_checksums<mxs::SHA1Checksum>();
     rv += test_checksums<mxs::CRC32Checksum>();
+    rv += test_checksums<mxs::Murmur3Checksum>();
+    rv += test_murmur3();
 
     return rv;
 }
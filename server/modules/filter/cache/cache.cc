@@ -17,6 +17,7 @@
 #include <set>
 #include <string>
 #include <zlib.h>
+#include <maxbase/atomic.hh>
 #include <maxscale/alloc.h>
 #include <maxscale/buffer.h>
 #include <maxscale/modutil.h>
@@ -122,6 +123,24 @@ json_t* Cache::show_json() const
     return get_info(INFO_ALL);
 }
 
+void Cache::coalesced(coalesce_event_t event)
+{
+    switch (event)
+    {
+    case COALESCE_WAIT:
+        mxb::atomic::add(&m_coalesce.waits, 1, mxb::atomic::RELAXED);
+        break;
+
+    case COALESCE_HIT:
+        mxb::atomic::add(&m_coalesce.hits, 1, mxb::atomic::RELAXED);
+        break;
+
+    case COALESCE_TIMEOUT:
+        mxb::atomic::add(&m_coalesce.timeouts, 1, mxb::atomic::RELAXED);
+        break;
+    }
+}
+
 cache_result_t Cache::get_key(const char* zDefault_db,
                               const GWBUF* pQuery,
                               CACHE_KEY*   pKey) const
@@ -183,6 +202,11 @@ const CacheRules* Cache::should_store(const char* zDefaultDb, const GWBUF* pQuer
     return pRules;
 }
 
+cache_result_t Cache::put_refreshed_value(int worker_id, const CACHE_KEY& key, const GWBUF* pValue)
+{
+    return put_value(key, pValue);
+}
+
 json_t* Cache::do_get_info(uint32_t what) const
 {
     json_t* pInfo = json_object();
@@ -205,6 +229,23 @@ json_t* Cache::do_get_info(uint32_t what) const
                 json_object_set(pInfo, "rules", pArray);
             }
         }
+
+        if ((what & INFO_COALESCE) && m_config.coalesce_timeout != 0)
+        {
+            json_t* pCoalesce = json_object();
+
+            if (pCoalesce)
+            {
+                using mxb::atomic::load;
+                using mxb::atomic::RELAXED;
+
+                json_object_set_new(pCoalesce, "waits", json_integer(load(&m_coalesce.waits, RELAXED)));
+                json_object_set_new(pCoalesce, "hits", json_integer(load(&m_coalesce.hits, RELAXED)));
+                json_object_set_new(pCoalesce, "timeouts", json_integer(load(&m_coalesce.timeouts, RELAXED)));
+
+                json_object_set_new(pInfo, "coalesced", pCoalesce);
+            }
+        }
     }
 
     return pInfo;
@@ -30,10 +30,11 @@ class Cache
 public:
     enum what_info_t
     {
-        INFO_RULES   = 0x01,/*< Include information about the rules. */
-        INFO_PENDING = 0x02,/*< Include information about any pending items. */
-        INFO_STORAGE = 0x04,/*< Include information about the storage. */
-        INFO_ALL     = (INFO_RULES | INFO_PENDING | INFO_STORAGE)
+        INFO_RULES    = 0x01,/*< Include information about the rules. */
+        INFO_PENDING  = 0x02,/*< Include information about any pending items. */
+        INFO_STORAGE  = 0x04,/*< Include information about the storage. */
+        INFO_COALESCE = 0x08,/*< Include information about coalesced cache misses. */
+        INFO_ALL      = (INFO_RULES | INFO_PENDING | INFO_STORAGE | INFO_COALESCE)
     };
 
     typedef std::shared_ptr<CacheRules>     SCacheRules;
@@ -79,6 +80,21 @@ public:
      */
     virtual void refreshed(const CACHE_KEY& key, const CacheFilterSession* pSession) = 0;
 
+    enum coalesce_event_t
+    {
+        COALESCE_WAIT,      /*< A session started waiting for another session's fetch. */
+        COALESCE_HIT,       /*< A waiting session was served from the cache. */
+        COALESCE_TIMEOUT,   /*< A waiting session gave up and fetched the data itself. */
+    };
+
+    /**
+     * To inform the cache about a session whose cache miss was coalesced with
+     * the fetch of another session.
+     *
+     * @param event  What happened.
+     */
+    void coalesced(coalesce_event_t event);
+
     /**
      * Returns a key for the statement. Takes the current config into account.
      *
@@ -120,6 +136,19 @@ public:
      */
     virtual cache_result_t put_value(const CACHE_KEY& key, const GWBUF* pValue) = 0;
 
+    /**
+     * Store a value that was fetched in order to refresh an entry of another
+     * routing worker. Unless the cache is specific to each worker, this is
+     * the same as put_value().
+     *
+     * @param worker_id  The id of the worker that is refreshing the entry.
+     * @param key        The key of the entry.
+     * @param pValue     The value.
+     *
+     * @return CACHE_RESULT_OK if the value was stored or handed over to the worker.
+     */
+    virtual cache_result_t put_refreshed_value(int worker_id, const CACHE_KEY& key, const GWBUF* pValue);
+
     /**
      * See @Storage::del_value
      */
@@ -142,8 +171,23 @@ private:
     Cache& operator=(const Cache&);
 
 protected:
+    struct CoalesceStats
+    {
+        CoalesceStats()
+            : waits(0)
+            , hits(0)
+            , timeouts(0)
+        {
+        }
+
+        uint64_t waits;     // How many cache misses waited for the fetch of another session.
+        uint64_t hits;      // How many of those were served from the cache.
+        uint64_t timeouts;  // How many of those had to fetch the data themselves.
+    };
+
     const std::string        m_name;    // The name of the instance; the section name in the config.
     const CACHE_CONFIG&      m_config;  // The configuration of the cache instance.
     std::vector<SCacheRules> m_rules;   // The rules of the cache instance.
     SStorageFactory          m_sFactory;// The storage factory.
+    CoalesceStats            m_coalesce;// Statistics of coalesced cache misses.
 };
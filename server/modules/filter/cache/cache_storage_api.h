@@ -56,7 +56,8 @@ typedef enum cache_storage_info
 typedef enum cache_thread_model
 {
     CACHE_THREAD_MODEL_ST,
-    CACHE_THREAD_MODEL_MT
+    CACHE_THREAD_MODEL_MT,
+    CACHE_THREAD_MODEL_SHARDED  /*< Multiple threads, storage partitioned to reduce contention. */
 } cache_thread_model_t;
 
 typedef void* CACHE_STORAGE;
@@ -93,6 +94,7 @@ typedef enum cache_storage_capabilities
     CACHE_STORAGE_CAP_LRU       = 0x04, /*< Storage capable of LRU eviction. */
     CACHE_STORAGE_CAP_MAX_COUNT = 0x08, /*< Storage capable of capping number of entries.*/
     CACHE_STORAGE_CAP_MAX_SIZE  = 0x10, /*< Storage capable of capping size of cache.*/
+    CACHE_STORAGE_CAP_SHARDED   = 0x20, /*< Storage can partition itself, incl. eviction. */
 } cache_storage_capabilities_t;
 
 static inline bool cache_storage_has_cap(uint32_t capabilities, uint32_t mask)
@@ -53,6 +53,10 @@ void cache_config_finish(CACHE_CONFIG& config)
     config.hard_ttl = 0;
     config.soft_ttl = 0;
     config.debug = 0;
+    config.coalesce_timeout = 0;
+    config.refresh_ahead = 0;
+    config.refresh_ahead_hits = 0;
+    config.refresh_ahead_rate = 0;
     config.thread_model = CACHE_DEFAULT_THREAD_MODEL;
     config.selects = CACHE_DEFAULT_SELECTS;
 }
@@ -129,6 +133,7 @@ static const MXS_ENUM_VALUE parameter_cached_data_values[] =
 {
     {"shared",          CACHE_THREAD_MODEL_MT},
     {"thread_specific", CACHE_THREAD_MODEL_ST},
+    {"sharded",         CACHE_THREAD_MODEL_SHARDED},
     {NULL}
 };
 
@@ -254,6 +259,26 @@ extern "C" MXS_MODULE* MXS_CREATE_MODULE()
                 MXS_MODULE_PARAM_BOOL,
                 CACHE_ZDEFAULT_ENABLED
             },
+            {
+                "coalesce_timeout",
+                MXS_MODULE_PARAM_COUNT,
+                CACHE_ZDEFAULT_COALESCE_TIMEOUT
+            },
+            {
+                "refresh_ahead",
+                MXS_MODULE_PARAM_COUNT,
+                CACHE_ZDEFAULT_REFRESH_AHEAD
+            },
+            {
+                "refresh_ahead_hits",
+                MXS_MODULE_PARAM_COUNT,
+                CACHE_ZDEFAULT_REFRESH_AHEAD_HITS
+            },
+            {
+                "refresh_ahead_rate",
+                MXS_MODULE_PARAM_COUNT,
+                CACHE_ZDEFAULT_REFRESH_AHEAD_RATE
+            },
             {MXS_END_MODULE_PARAMS}
         }
     };
@@ -293,6 +318,11 @@ CacheFilter* CacheFilter::create(const char* zName, MXS_CONFIG_PARAMETER* ppPara
                 MXS_EXCEPTION_GUARD(pCache = CacheMT::Create(zName, &pFilter->m_config));
                 break;
 
+            case CACHE_THREAD_MODEL_SHARDED:
+                MXS_NOTICE("Creating sharded cache.");
+                MXS_EXCEPTION_GUARD(pCache = CacheMT::Create(zName, &pFilter->m_config));
+                break;
+
             case CACHE_THREAD_MODEL_ST:
                 MXS_NOTICE("Creating thread specific cache.");
                 MXS_EXCEPTION_GUARD(pCache = CachePT::Create(zName, &pFilter->m_config));
@@ -306,6 +336,11 @@ CacheFilter* CacheFilter::create(const char* zName, MXS_CONFIG_PARAMETER* ppPara
         if (pCache)
         {
             pFilter->m_sCache = auto_ptr<Cache>(pCache);
+
+            if (pFilter->m_config.refresh_ahead != 0)
+            {
+                pFilter->m_sRefresher = auto_ptr<CacheRefresher>(new CacheRefresher(pFilter->m_config));
+            }
         }
         else
         {
@@ -320,19 +355,49 @@ CacheFilter* CacheFilter::create(const char* zName, MXS_CONFIG_PARAMETER* ppPara
 
 CacheFilterSession* CacheFilter::newSession(MXS_SESSION* pSession)
 {
-    return CacheFilterSession::Create(m_sCache.get(), pSession);
+    return CacheFilterSession::Create(m_sCache.get(), m_sRefresher.get(), pSession);
 }
 
 // static
 void CacheFilter::diagnostics(DCB* pDcb)
 {
     m_sCache->show(pDcb);
+
+    if (m_sRefresher.get())
+    {
+        json_t* pInfo = m_sRefresher->get_info();
+
+        if (pInfo)
+        {
+            char* z = json_dumps(pInfo, JSON_PRESERVE_ORDER | JSON_INDENT(2));
+
+            if (z)
+            {
+                dcb_printf(pDcb, "Refresh ahead:\n%s\n", z);
+                free(z);
+            }
+
+            json_decref(pInfo);
+        }
+    }
 }
 
 // static
 json_t* CacheFilter::diagnostics_json() const
 {
-    return m_sCache->show_json();
+    json_t* pInfo = m_sCache->show_json();
+
+    if (pInfo && m_sRefresher.get())
+    {
+        json_t* pRefreshInfo = m_sRefresher->get_info();
+
+        if (pRefreshInfo)
+        {
+            json_object_set_new(pInfo, "refresh_ahead", pRefreshInfo);
+        }
+    }
+
+    return pInfo;
 }
 
 uint64_t CacheFilter::getCapabilities()
@@ -363,6 +428,10 @@ bool CacheFilter::process_params(MXS_CONFIG_PARAMETER* ppParams, CACHE_CONFIG& c
                                                                         "cache_in_transactions",
                                                                         parameter_cache_in_trxs_values));
     config.enabled = config_get_bool(ppParams, "enabled");
+    config.coalesce_timeout = config_get_integer(ppParams, "coalesce_timeout");
+    config.refresh_ahead = config_get_integer(ppParams, "refresh_ahead");
+    config.refresh_ahead_hits = config_get_integer(ppParams, "refresh_ahead_hits");
+    config.refresh_ahead_rate = config_get_integer(ppParams, "refresh_ahead_rate");
 
     if (!config.storage)
     {
@@ -407,7 +476,7 @@ bool CacheFilter::process_params(MXS_CONFIG_PARAMETER* ppParams, CACHE_CONFIG& c
                 arg = config.storage_options;
                 config.storage_argv[i++] = arg;
 
-                while ((arg = strchr(config.storage_options, ',')))
+                while ((arg = strchr(arg, ',')))
                 {
                     *arg = 0;
                     ++arg;
@@ -437,6 +506,13 @@ bool CacheFilter::process_params(MXS_CONFIG_PARAMETER* ppParams, CACHE_CONFIG& c
             config.soft_ttl = config.hard_ttl;
         }
 
+        if ((config.refresh_ahead != 0) && (config.refresh_ahead >= config.soft_ttl))
+        {
+            MXS_ERROR("The value of the configuration entry 'refresh_ahead' must be "
+                      "less than the value of 'soft_ttl'.");
+            error = true;
+        }
+
         if (config.max_resultset_size == 0)
         {
             if (config.max_size != 0)
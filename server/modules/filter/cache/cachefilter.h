@@ -70,6 +70,14 @@ const cache_selects_t CACHE_DEFAULT_SELECTS = CACHE_SELECTS_ASSUME_CACHEABLE;
 #define CACHE_ZDEFAULT_CACHE_IN_TRXS "all_transactions"
 // Enabled
 #define CACHE_ZDEFAULT_ENABLED "true"
+// Milliseconds
+#define CACHE_ZDEFAULT_COALESCE_TIMEOUT "0"
+// Seconds
+#define CACHE_ZDEFAULT_REFRESH_AHEAD "0"
+// Count
+#define CACHE_ZDEFAULT_REFRESH_AHEAD_HITS "10"
+// Count per second
+#define CACHE_ZDEFAULT_REFRESH_AHEAD_RATE "100"
 
 typedef enum cache_in_trxs
 {
@@ -98,4 +106,8 @@ typedef struct cache_config
     cache_selects_t      selects;           /**< Assume/verify that selects are cacheable. */
     cache_in_trxs_t      cache_in_trxs;     /**< To cache or not to cache inside transactions. */
     bool                 enabled;           /**< Whether the cache is enabled or not. */
+    uint32_t             coalesce_timeout;  /**< How long a miss waits for a concurrent fetch, in ms. */
+    uint32_t             refresh_ahead;     /**< Seconds before soft TTL an entry may be refreshed. */
+    uint32_t             refresh_ahead_hits;/**< Hits needed for an entry to be refreshed ahead. */
+    uint32_t             refresh_ahead_rate;/**< Maximum refreshes per second and worker. */
 } CACHE_CONFIG;
@@ -16,6 +16,7 @@
 #include <maxscale/filter.hh>
 #include "cachefilter.h"
 #include "cachefiltersession.hh"
+#include "cacherefresher.hh"
 
 class CacheFilter : public maxscale::Filter<CacheFilter, CacheFilterSession>
 {
@@ -51,6 +52,7 @@ private:
     static bool process_params(MXS_CONFIG_PARAMETER* ppParams, CACHE_CONFIG& config);
 
 private:
-    CACHE_CONFIG         m_config;
-    std::auto_ptr<Cache> m_sCache;
+    CACHE_CONFIG                  m_config;
+    std::auto_ptr<Cache>          m_sCache;
+    std::auto_ptr<CacheRefresher> m_sRefresher;
 };
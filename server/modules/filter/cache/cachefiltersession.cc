@@ -13,10 +13,13 @@
 
 #define MXS_MODULE_NAME "cache"
 #include "cachefiltersession.hh"
+#include <algorithm>
 #include <new>
 #include <maxscale/alloc.h>
+#include <maxscale/config.h>
 #include <maxscale/modutil.h>
 #include <maxscale/mysql_utils.h>
+#include <maxscale/poll.h>
 #include <maxscale/query_classifier.h>
 #include "storage.hh"
 
@@ -32,6 +35,9 @@ inline bool cache_max_resultset_size_exceeded(const CACHE_CONFIG& config, uint64
 {
     return config.max_resultset_size == 0 ? false : size > config.max_resultset_size;
 }
+
+// How often, in milliseconds, a session waiting for another session's fetch checks the cache.
+const uint32_t CACHE_WAIT_POLL_INTERVAL = 5;
 }
 
 namespace
@@ -41,6 +47,7 @@ const char SV_MAXSCALE_CACHE_POPULATE[] = "@maxscale.cache.populate";
 const char SV_MAXSCALE_CACHE_USE[] = "@maxscale.cache.use";
 const char SV_MAXSCALE_CACHE_SOFT_TTL[] = "@maxscale.cache.soft_ttl";
 const char SV_MAXSCALE_CACHE_HARD_TTL[] = "@maxscale.cache.hard_ttl";
+const char SV_MAXSCALE_CACHE_REFRESH_WORKER[] = "@maxscale.cache.refresh_worker";
 
 const char* NON_CACHEABLE_FUNCTIONS[] =
 {
@@ -179,10 +186,14 @@ bool is_select_statement(GWBUF* pStmt)
 }
 }
 
-CacheFilterSession::CacheFilterSession(MXS_SESSION* pSession, Cache* pCache, char* zDefaultDb)
+CacheFilterSession::CacheFilterSession(MXS_SESSION* pSession,
+                                       Cache* pCache,
+                                       CacheRefresher* pRefresher,
+                                       char* zDefaultDb)
     : maxscale::FilterSession(pSession)
     , m_state(CACHE_EXPECTING_NOTHING)
     , m_pCache(pCache)
+    , m_pRefresher(pRefresher)
     , m_zDefaultDb(zDefaultDb)
     , m_zUseDb(NULL)
     , m_refreshing(false)
@@ -191,6 +202,9 @@ CacheFilterSession::CacheFilterSession(MXS_SESSION* pSession, Cache* pCache, cha
     , m_populate(pCache->config().enabled)
     , m_soft_ttl(pCache->config().soft_ttl)
     , m_hard_ttl(pCache->config().hard_ttl)
+    , m_refresh_worker(-1)
+    , m_pWaiting(NULL)
+    , m_wait_call_id(0)
 {
     m_key.data = 0;
 
@@ -239,16 +253,30 @@ CacheFilterSession::CacheFilterSession(MXS_SESSION* pSession, Cache* pCache, cha
                   "setting the hard TTL not possible.",
                   SV_MAXSCALE_CACHE_HARD_TTL);
     }
+
+    if (!session_add_variable(pSession,
+                              SV_MAXSCALE_CACHE_REFRESH_WORKER,
+                              &CacheFilterSession::set_cache_refresh_worker,
+                              this))
+    {
+        mxb_assert(!true);
+        MXS_ERROR("Could not add MaxScale user variable '%s', entries of a cache "
+                  "specific to each thread cannot be refreshed ahead of time.",
+                  SV_MAXSCALE_CACHE_REFRESH_WORKER);
+    }
 }
 
 CacheFilterSession::~CacheFilterSession()
 {
+    mxb_assert(!m_pWaiting);
     MXS_FREE(m_zUseDb);
     MXS_FREE(m_zDefaultDb);
 }
 
 // static
-CacheFilterSession* CacheFilterSession::Create(Cache* pCache, MXS_SESSION* pSession)
+CacheFilterSession* CacheFilterSession::Create(Cache* pCache,
+                                               CacheRefresher* pRefresher,
+                                               MXS_SESSION* pSession)
 {
     CacheFilterSession* pCacheFilterSession = NULL;
 
@@ -265,7 +293,10 @@ CacheFilterSession* CacheFilterSession::Create(Cache* pCache, MXS_SESSION* pSess
 
     if ((zDb[0] == 0) || zDefaultDb)
     {
-        pCacheFilterSession = new(std::nothrow) CacheFilterSession(pSession, pCache, zDefaultDb);
+        pCacheFilterSession = new(std::nothrow) CacheFilterSession(pSession,
+                                                                     pCache,
+                                                                     pRefresher,
+                                                                     zDefaultDb);
 
         if (!pCacheFilterSession)
         {
@@ -278,6 +309,14 @@ CacheFilterSession* CacheFilterSession::Create(Cache* pCache, MXS_SESSION* pSess
 
 void CacheFilterSession::close()
 {
+    if (m_pWaiting)
+    {
+        stop_waiting();
+        gwbuf_free(m_pWaiting);
+        m_pWaiting = NULL;
+    }
+
+    clear_refreshing();
 }
 
 int CacheFilterSession::routeQuery(GWBUF* pPacket)
@@ -291,6 +330,15 @@ int CacheFilterSession::routeQuery(GWBUF* pPacket)
 
     routing_action_t action = ROUTING_CONTINUE;
 
+    if (m_pWaiting)
+    {
+        // A new statement arrived while the previous one was waiting for the
+        // fetch of another session. It is not worth waiting any longer.
+        stop_waiting();
+        route_waiting(CACHE_IGNORING_RESPONSE);
+    }
+
+    clear_refreshing();
     reset_response_state();
     m_state = CACHE_IGNORING_RESPONSE;
 
@@ -421,6 +469,12 @@ int CacheFilterSession::clientReply(GWBUF* pData)
         m_state = CACHE_IGNORING_RESPONSE;
     }
 
+    if (m_refreshing && (m_state == CACHE_IGNORING_RESPONSE))
+    {
+        // The result will not be stored, so others must not wait for it.
+        clear_refreshing();
+    }
+
     return rv;
 }
 
@@ -769,7 +823,17 @@ void CacheFilterSession::store_result()
     {
         m_res.pData = pData;
 
-        cache_result_t result = m_pCache->put_value(m_key, m_res.pData);
+        cache_result_t result;
+
+        if (m_refresh_worker != -1)
+        {
+            // An internal session refreshing an entry of another worker.
+            result = m_pCache->put_refreshed_value(m_refresh_worker, m_key, m_res.pData);
+        }
+        else
+        {
+            result = m_pCache->put_value(m_key, m_res.pData);
+        }
 
         if (!CACHE_RESULT_IS_OK(result))
         {
@@ -784,6 +848,14 @@ void CacheFilterSession::store_result()
         }
     }
 
+    clear_refreshing();
+}
+
+/**
+ * Inform the cache that this session is no longer fetching the data.
+ */
+void CacheFilterSession::clear_refreshing()
+{
     if (m_refreshing)
     {
         m_pCache->refreshed(m_key, this);
@@ -791,6 +863,131 @@ void CacheFilterSession::store_result()
     }
 }
 
+/**
+ * Hold a SELECT until another session has fetched its result.
+ *
+ * @param pPacket  The SELECT, ownership is taken.
+ */
+void CacheFilterSession::start_waiting(GWBUF* pPacket)
+{
+    mxb_assert(!m_pWaiting);
+
+    mxb::Worker* pWorker = mxb::Worker::get_current();
+    mxb_assert(pWorker);
+
+    uint32_t interval = std::min(CACHE_WAIT_POLL_INTERVAL, m_pCache->config().coalesce_timeout);
+
+    m_pWaiting = pPacket;
+    m_wait_sw.restart();
+    m_wait_call_id = pWorker->delayed_call(interval, &CacheFilterSession::poll_waiting, this);
+    m_state = CACHE_EXPECTING_NOTHING;
+
+    m_pCache->coalesced(Cache::COALESCE_WAIT);
+}
+
+/**
+ * Stop polling the cache on behalf of the waiting SELECT.
+ */
+void CacheFilterSession::stop_waiting()
+{
+    if (m_wait_call_id)
+    {
+        mxb::Worker* pWorker = mxb::Worker::get_current();
+        mxb_assert(pWorker);
+
+        pWorker->cancel_delayed_call(m_wait_call_id);
+        m_wait_call_id = 0;
+    }
+}
+
+/**
+ * Check whether the result of the waiting SELECT has become available.
+ *
+ * @param action  Whether the call should be executed or cancelled.
+ *
+ * @return True, if the cache should be checked again.
+ */
+bool CacheFilterSession::poll_waiting(mxb::Worker::Call::action_t action)
+{
+    bool call_again = false;
+
+    if (action == mxb::Worker::Call::EXECUTE)
+    {
+        mxb_assert(m_pWaiting);
+
+        uint32_t flags = CACHE_FLAGS_INCLUDE_STALE;
+        GWBUF* pResponse;
+        cache_result_t result = m_pCache->get_value(m_key, flags, m_soft_ttl, m_hard_ttl, &pResponse);
+
+        if (CACHE_RESULT_IS_OK(result))
+        {
+            if (log_decisions())
+            {
+                MXS_NOTICE("Data fetched by another session found in cache.");
+            }
+
+            m_wait_call_id = 0;
+            m_pCache->coalesced(Cache::COALESCE_HIT);
+
+            gwbuf_free(m_pWaiting);
+            m_pWaiting = NULL;
+
+            m_up.clientReply(pResponse);
+        }
+        else if (m_pCache->must_refresh(m_key, this))
+        {
+            // The other session did not store the result, so it is up to us.
+            if (log_decisions())
+            {
+                MXS_NOTICE("Data was not fetched by another session, fetching it from server.");
+            }
+
+            m_wait_call_id = 0;
+            m_refreshing = true;
+            route_waiting(CACHE_EXPECTING_RESPONSE);
+        }
+        else if (m_wait_sw.split() >= std::chrono::milliseconds(m_pCache->config().coalesce_timeout))
+        {
+            if (log_decisions())
+            {
+                MXS_NOTICE("Timed out waiting for data being fetched by another session, "
+                           "fetching it from server.");
+            }
+
+            m_wait_call_id = 0;
+            m_pCache->coalesced(Cache::COALESCE_TIMEOUT);
+            route_waiting(CACHE_EXPECTING_RESPONSE);
+        }
+        else
+        {
+            call_again = true;
+        }
+    }
+
+    return call_again;
+}
+
+/**
+ * Send the waiting SELECT to the server.
+ *
+ * @param state  The state in which the response is handled.
+ */
+void CacheFilterSession::route_waiting(cache_session_state_t state)
+{
+    mxb_assert(m_pWaiting);
+
+    GWBUF* pPacket = m_pWaiting;
+    m_pWaiting = NULL;
+
+    reset_response_state();
+    m_state = state;
+
+    if (!m_down.routeQuery(pPacket))
+    {
+        poll_fake_hangup_event(m_pSession->client_dcb);
+    }
+}
+
 /**
  * Whether the cache should be consulted.
  *
@@ -1042,6 +1239,50 @@ CacheFilterSession::routing_action_t CacheFilterSession::route_COM_QUERY(GWBUF*
 }
 
 
+/**
+ * Get a value from the cache, refreshing it in the background if it is
+ * frequently used and about to become stale.
+ *
+ * @param pPacket    The SELECT the value is the result of.
+ * @param ppResponse On successful return, the value.
+ *
+ * @return The result of the lookup. A frequently used value that is being
+ *         refreshed is reported as fresh, even if it is stale.
+ */
+cache_result_t CacheFilterSession::get_value_refreshing_ahead(GWBUF* pPacket, GWBUF** ppResponse)
+{
+    uint32_t flags = CACHE_FLAGS_INCLUDE_STALE;
+    uint32_t soft_ttl = m_soft_ttl - m_pCache->config().refresh_ahead;
+
+    // With the soft TTL shortened by the refresh window, a value is reported
+    // as stale if it is stale or about to become stale.
+    cache_result_t result = m_pCache->get_value(m_key, flags, soft_ttl, m_hard_ttl, ppResponse);
+
+    if (CACHE_RESULT_IS_OK(result) && CACHE_RESULT_IS_STALE(result))
+    {
+        if (m_pRefresher->refresh(m_pSession, m_zDefaultDb, m_key, pPacket))
+        {
+            if (log_decisions())
+            {
+                MXS_NOTICE("Cache data is about to become stale, or is stale, and is "
+                           "being refreshed in the background.");
+            }
+
+            result &= ~CACHE_RESULT_STALE;
+        }
+        else
+        {
+            // Not used frequently enough, so the value is handled as usual.
+            gwbuf_free(*ppResponse);
+            *ppResponse = NULL;
+
+            result = m_pCache->get_value(m_key, flags, m_soft_ttl, m_hard_ttl, ppResponse);
+        }
+    }
+
+    return result;
+}
+
 /**
  * Routes a SELECT packet.
  *
@@ -1063,7 +1304,16 @@ CacheFilterSession::routing_action_t CacheFilterSession::route_SELECT(cache_acti
     {
         uint32_t flags = CACHE_FLAGS_INCLUDE_STALE;
         GWBUF* pResponse;
-        cache_result_t result = m_pCache->get_value(m_key, flags, m_soft_ttl, m_hard_ttl, &pResponse);
+        cache_result_t result;
+
+        if (m_pRefresher && (m_soft_ttl > m_pCache->config().refresh_ahead))
+        {
+            result = get_value_refreshing_ahead(pPacket, &pResponse);
+        }
+        else
+        {
+            result = m_pCache->get_value(m_key, flags, m_soft_ttl, m_hard_ttl, &pResponse);
+        }
 
         if (CACHE_RESULT_IS_OK(result))
         {
@@ -1108,6 +1358,33 @@ CacheFilterSession::routing_action_t CacheFilterSession::route_SELECT(cache_acti
                 routing_action = ROUTING_ABORT;
             }
         }
+        else if (m_pCache->config().coalesce_timeout != 0
+                 && (m_populate || CACHE_RESULT_IS_DISCARDED(result)))
+        {
+            // Concurrent misses of the same key are coalesced; only the first
+            // one fetches the data, the others wait for it to appear in the cache.
+            if (m_pCache->must_refresh(m_key, this))
+            {
+                if (log_decisions())
+                {
+                    MXS_NOTICE("Not found in cache, fetching data from server.");
+                }
+
+                m_refreshing = true;
+                routing_action = ROUTING_CONTINUE;
+            }
+            else
+            {
+                if (log_decisions())
+                {
+                    MXS_NOTICE("Not found in cache, waiting for the data being fetched "
+                               "by another session.");
+                }
+
+                start_waiting(pPacket);
+                routing_action = ROUTING_ABORT;
+            }
+        }
         else
         {
             if (log_decisions())
@@ -1137,7 +1414,7 @@ CacheFilterSession::routing_action_t CacheFilterSession::route_SELECT(cache_acti
                 m_state = CACHE_IGNORING_RESPONSE;
             }
         }
-        else
+        else if (!m_pWaiting)
         {
             if (log_decisions())
             {
@@ -1364,6 +1641,28 @@ char* CacheFilterSession::set_cache_hard_ttl(const char* zName,
     return zMessage;
 }
 
+char* CacheFilterSession::set_cache_refresh_worker(const char* zName,
+                                                   const char* pValue_begin,
+                                                   const char* pValue_end)
+{
+    mxb_assert(strcmp(SV_MAXSCALE_CACHE_REFRESH_WORKER, zName) == 0);
+
+    char* zMessage = NULL;
+
+    uint32_t value;
+
+    if (get_uint32_value(pValue_begin, pValue_end, &value) && value < (uint32_t)config_threadcount())
+    {
+        m_refresh_worker = value;
+    }
+    else
+    {
+        zMessage = create_uint32_error_message(zName, pValue_begin, pValue_end);
+    }
+
+    return zMessage;
+}
+
 // static
 char* CacheFilterSession::set_cache_populate(void* pContext,
                                              const char* zName,
@@ -1408,6 +1707,17 @@ char* CacheFilterSession::set_cache_hard_ttl(void* pContext,
     return pThis->set_cache_hard_ttl(zName, pValue_begin, pValue_end);
 }
 
+// static
+char* CacheFilterSession::set_cache_refresh_worker(void* pContext,
+                                                   const char* zName,
+                                                   const char* pValue_begin,
+                                                   const char* pValue_end)
+{
+    CacheFilterSession* pThis = static_cast<CacheFilterSession*>(pContext);
+
+    return pThis->set_cache_refresh_worker(zName, pValue_begin, pValue_end);
+}
+
 void CacheFilterSession::copy_data(size_t offset, size_t nBytes, uint8_t* pTo) const
 {
     if (offset >= m_res.offset_last)
@@ -13,10 +13,13 @@
 #pragma once
 
 #include <maxscale/ccdefs.hh>
+#include <maxbase/stopwatch.hh>
+#include <maxbase/worker.hh>
 #include <maxscale/buffer.h>
 #include <maxscale/filter.hh>
 #include "cache.hh"
 #include "cachefilter.h"
+#include "cacherefresher.hh"
 #include "cache_storage_api.h"
 
 class CacheFilterSession : public maxscale::FilterSession
@@ -58,13 +61,16 @@ public:
      * @param pCache     Pointer to the cache instance to which this session cache
      *                   belongs. Must remain valid for the lifetime of the CacheFilterSession
      *                   instance being created.
+     * @param pRefresher Pointer to the refresher of the filter instance, or NULL if
+     *                   entries should not be refreshed ahead of time. Must remain valid
+     *                   for the lifetime of the CacheFilterSession instance being created.
      * @param pSession   Pointer to the session this session cache instance is
      *                   specific for. Must remain valid for the lifetime of the CacheFilterSession
      *                   instance being created.
      *
      * @return A new instance or NULL if memory allocation fails.
      */
-    static CacheFilterSession* Create(Cache* pCache, MXS_SESSION* pSession);
+    static CacheFilterSession* Create(Cache* pCache, CacheRefresher* pRefresher, MXS_SESSION* pSession);
 
     /**
      * The session has been closed.
@@ -113,6 +119,12 @@ private:
     }
 
     void store_result();
+    void clear_refreshing();
+
+    void start_waiting(GWBUF* pPacket);
+    void stop_waiting();
+    bool poll_waiting(mxb::Worker::Call::action_t action);
+    void route_waiting(cache_session_state_t state);
 
     enum cache_action_t
     {
@@ -141,6 +153,7 @@ private:
     };
 
     routing_action_t route_COM_QUERY(GWBUF* pPacket);
+    cache_result_t   get_value_refreshing_ahead(GWBUF* pPacket, GWBUF** ppResponse);
     routing_action_t route_SELECT(cache_action_t action, const CacheRules& rules, GWBUF* pPacket);
 
     char* set_cache_populate(const char* zName,
@@ -155,6 +168,9 @@ private:
     char* set_cache_hard_ttl(const char* zName,
                              const char* pValue_begin,
                              const char* pValue_end);
+    char* set_cache_refresh_worker(const char* zName,
+                                   const char* pValue_begin,
+                                   const char* pValue_end);
 
     static char* set_cache_populate(void* pContext,
                                     const char* zName,
@@ -172,17 +188,22 @@ private:
                                     const char* zName,
                                     const char* pValue_begin,
                                     const char* pValue_end);
+    static char* set_cache_refresh_worker(void* pContext,
+                                          const char* zName,
+                                          const char* pValue_begin,
+                                          const char* pValue_end);
 
     void copy_data(size_t offset, size_t nBytes, uint8_t* pTo) const;
 
     void copy_command_header_at_offset(uint8_t* pHeader) const;
 
 private:
-    CacheFilterSession(MXS_SESSION* pSession, Cache* pCache, char* zDefaultDb);
+    CacheFilterSession(MXS_SESSION* pSession, Cache* pCache, CacheRefresher* pRefresher, char* zDefaultDb);
 
 private:
     cache_session_state_t m_state;          /**< What state is the session in, what data is expected. */
     Cache*                m_pCache;         /**< The cache instance the session is associated with. */
+    CacheRefresher*       m_pRefresher;     /**< The refresher of entries about to become stale, or NULL. */
     CACHE_RESPONSE_STATE  m_res;            /**< The response state. */
     CACHE_KEY             m_key;            /**< Key storage. */
     char*                 m_zDefaultDb;     /**< The default database. */
@@ -193,4 +214,8 @@ private:
     bool                  m_populate;       /**< Whether the cache should be populated in this session. */
     uint32_t              m_soft_ttl;       /**< The soft TTL used in the session. */
     uint32_t              m_hard_ttl;       /**< The hard TTL used in the session. */
+    int                   m_refresh_worker; /**< The worker whose entries are refreshed, -1 if none. */
+    GWBUF*                m_pWaiting;       /**< A SELECT waiting for another session's fetch. */
+    uint32_t              m_wait_call_id;   /**< The delayed call polling the cache for m_pWaiting. */
+    mxb::StopWatch        m_wait_sw;        /**< How long m_pWaiting has been waiting. */
 };
@@ -80,7 +80,7 @@ CacheMT* CacheMT::Create(const std::string& name,
 {
     CacheMT* pCache = NULL;
 
-    CacheStorageConfig storage_config(CACHE_THREAD_MODEL_MT,
+    CacheStorageConfig storage_config(pConfig->thread_model,
                                       pConfig->hard_ttl,
                                       pConfig->soft_ttl,
                                       pConfig->max_count,
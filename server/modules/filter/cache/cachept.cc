@@ -14,8 +14,8 @@
 #define MXS_MODULE_NAME "cache"
 #include "cachept.hh"
 
-#include <maxbase/atomic.h>
 #include <maxscale/config.h>
+#include <maxscale/routingworker.hh>
 
 #include "cachest.hh"
 #include "storagefactory.hh"
@@ -23,29 +23,6 @@
 using std::shared_ptr;
 using std::string;
 
-namespace
-{
-
-int u_current_thread_id = 0;
-thread_local int u_thread_id = -1;
-
-/**
- * Get the thread index of the current thread.
- *
- * @return The index of the current thread.
- */
-inline int thread_index()
-{
-    // A value of -1 indicates that the value has not been initialized,
-    if (u_thread_id == -1)
-    {
-        u_thread_id = atomic_add(&u_current_thread_id, 1);
-    }
-
-    return u_thread_id;
-}
-}
-
 CachePT::CachePT(const std::string& name,
                  const CACHE_CONFIG* pConfig,
                  const std::vector<SCacheRules>& rules,
@@ -100,6 +77,7 @@ json_t* CachePT::get_info(uint32_t what) const
         if (what & (INFO_PENDING | INFO_STORAGE))
         {
             what &= ~INFO_RULES;    // The rules are the same, we don't want them duplicated.
+            what &= ~INFO_COALESCE; // Coalescing is tracked by this cache, not the thread caches.
 
             for (size_t i = 0; i < m_caches.size(); ++i)
             {
@@ -141,6 +119,42 @@ cache_result_t CachePT::put_value(const CACHE_KEY& key, const GWBUF* pValue)
     return thread_cache().put_value(key, pValue);
 }
 
+cache_result_t CachePT::put_refreshed_value(int worker_id, const CACHE_KEY& key, const GWBUF* pValue)
+{
+    cache_result_t result = CACHE_RESULT_ERROR;
+
+    if (worker_id == mxs::RoutingWorker::get_current_id())
+    {
+        result = put_value(key, pValue);
+    }
+    else if (worker_id >= 0 && worker_id < (int)m_caches.size())
+    {
+        // The cache of a worker is only accessed by the worker itself, so the
+        // value is handed over to the worker that is refreshing the entry.
+        SCache sCache = m_caches[worker_id];
+        GWBUF* pCopy = gwbuf_deep_clone(pValue);
+
+        if (pCopy)
+        {
+            auto store = [sCache, key, pCopy]() {
+                    sCache->put_value(key, pCopy);
+                    gwbuf_free(pCopy);
+                };
+
+            if (mxs::RoutingWorker::get(worker_id)->execute(store, mxb::Worker::EXECUTE_QUEUED))
+            {
+                result = CACHE_RESULT_OK;
+            }
+            else
+            {
+                gwbuf_free(pCopy);
+            }
+        }
+    }
+
+    return result;
+}
+
 cache_result_t CachePT::del_value(const CACHE_KEY& key)
 {
     return thread_cache().del_value(key);
@@ -202,7 +216,9 @@ CachePT* CachePT::Create(const std::string& name,
 
 Cache& CachePT::thread_cache()
 {
-    int i = thread_index();
+    // The caches are indexed by the id of the routing worker
+    int i = mxs::RoutingWorker::get_current_id();
+    mxb_assert(i >= 0);
     mxb_assert(i < (int)m_caches.size());
     return *m_caches[i].get();
 }
@@ -40,6 +40,8 @@ public:
 
     cache_result_t put_value(const CACHE_KEY& key, const GWBUF* pValue);
 
+    cache_result_t put_refreshed_value(int worker_id, const CACHE_KEY& key, const GWBUF* pValue);
+
     cache_result_t del_value(const CACHE_KEY& key);
 
 private:
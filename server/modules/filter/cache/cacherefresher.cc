@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "cache"
+#include "cacherefresher.hh"
+#include <maxbase/atomic.hh>
+#include <maxscale/modutil.h>
+#include <maxscale/protocol/mariadb_client.hh>
+
+namespace
+{
+
+// The maximum number of entries whose hits are tracked by one worker.
+const size_t CACHE_REFRESH_MAX_TRACKED = 10000;
+
+// How long to wait, in seconds, before trying again to create an internal connection.
+const time_t CACHE_REFRESH_RETRY_INTERVAL = 10;
+
+// How long, in seconds, a refresh may take before it is considered to have failed.
+const time_t CACHE_REFRESH_TIMEOUT = 5;
+
+GWBUF* create_com_init_db(const std::string& db)
+{
+    size_t len = db.length();
+    GWBUF* pPacket = gwbuf_alloc(MYSQL_HEADER_LEN + 1 + len);
+
+    if (pPacket)
+    {
+        uint8_t* pData = GWBUF_DATA(pPacket);
+
+        gw_mysql_set_byte3(pData, 1 + len);
+        pData[3] = 0;
+        pData[4] = MXS_COM_INIT_DB;
+        memcpy(pData + MYSQL_HEADER_LEN + 1, db.c_str(), len);
+    }
+
+    return pPacket;
+}
+
+bool queue(LocalClient* pClient, GWBUF* pPacket)
+{
+    bool rv = false;
+
+    if (pPacket)
+    {
+        rv = pClient->queue_query(pPacket);     // The packet is cloned.
+        gwbuf_free(pPacket);
+    }
+
+    return rv;
+}
+}
+
+CacheRefresher::WorkerState::~WorkerState()
+{
+    for (auto& kv : connections)
+    {
+        if (kv.second.pClient)
+        {
+            kv.second.pClient->self_destruct();
+        }
+    }
+}
+
+CacheRefresher::CacheRefresher(const CACHE_CONFIG& config)
+    : m_config(config)
+{
+}
+
+CacheRefresher::~CacheRefresher()
+{
+}
+
+bool CacheRefresher::refresh(MXS_SESSION* pSession,
+                             const char* zDefaultDb,
+                             const CACHE_KEY& key,
+                             GWBUF* pQuery)
+{
+    WorkerState& state = *m_state;
+    time_t now = time(NULL);
+
+    Entries::iterator i = state.entries.find(key);
+
+    if (i == state.entries.end())
+    {
+        if (state.entries.size() >= CACHE_REFRESH_MAX_TRACKED)
+        {
+            purge(state, now);
+        }
+
+        if (state.entries.size() < CACHE_REFRESH_MAX_TRACKED)
+        {
+            i = state.entries.insert(std::make_pair(key, Entry())).first;
+            i->second.since = now;
+        }
+    }
+    else if (now - i->second.since > (time_t)m_config.refresh_ahead)
+    {
+        // The entry was last tracked during an earlier refresh window. Either
+        // it has been refreshed and is about to become stale again, or the
+        // refresh did not succeed. In both cases, we start from scratch.
+        i->second = Entry();
+        i->second.since = now;
+    }
+
+    bool refreshing = false;
+
+    if (i != state.entries.end())
+    {
+        Entry& entry = i->second;
+
+        ++entry.hits;
+
+        if (entry.refreshing && now - entry.issued >= CACHE_REFRESH_TIMEOUT)
+        {
+            // The entry would no longer be hit during its refresh window, had the
+            // refresh succeeded. The connection may have broken or the statement
+            // failed, neither of which is seen as the responses are ignored.
+            mxb::atomic::add(&m_stats.failures, 1, mxb::atomic::RELAXED);
+            entry.refreshing = false;
+        }
+
+        if (entry.refreshing)
+        {
+            refreshing = true;
+        }
+        else if (entry.hits >= m_config.refresh_ahead_hits)
+        {
+            entry.refreshing = issue(state, pSession, zDefaultDb, pQuery);
+            entry.issued = now;
+            refreshing = entry.refreshing;
+        }
+    }
+
+    return refreshing;
+}
+
+json_t* CacheRefresher::get_info() const
+{
+    using mxb::atomic::load;
+    using mxb::atomic::RELAXED;
+
+    json_t* pInfo = json_object();
+
+    if (pInfo)
+    {
+        json_object_set_new(pInfo, "refreshes", json_integer(load(&m_stats.refreshes, RELAXED)));
+        json_object_set_new(pInfo, "throttled", json_integer(load(&m_stats.throttled, RELAXED)));
+        json_object_set_new(pInfo, "failures", json_integer(load(&m_stats.failures, RELAXED)));
+    }
+
+    return pInfo;
+}
+
+bool CacheRefresher::issue(WorkerState& state, MXS_SESSION* pSession, const char* zDefaultDb, GWBUF* pQuery)
+{
+    bool rv = false;
+    time_t now = time(NULL);
+
+    if (state.second != now)
+    {
+        state.second = now;
+        state.n_refreshes = 0;
+    }
+
+    if (m_config.refresh_ahead_rate != 0 && state.n_refreshes >= m_config.refresh_ahead_rate)
+    {
+        mxb::atomic::add(&m_stats.throttled, 1, mxb::atomic::RELAXED);
+    }
+    else
+    {
+        std::string db(zDefaultDb ? zDefaultDb : "");
+        Connection* pConnection = get_connection(state, pSession, now);
+
+        // The default database of a connection can be changed, but not removed.
+        if (pConnection && (pConnection->db == db || !db.empty()))
+        {
+            rv = true;
+
+            if (pConnection->db != db)
+            {
+                rv = queue(pConnection->pClient, create_com_init_db(db));
+
+                if (rv)
+                {
+                    // The cache filter of the internal session sees the change of the
+                    // default database before the SELECT, so the key will be the same.
+                    pConnection->db = db;
+                }
+            }
+
+            if (rv)
+            {
+                rv = pConnection->pClient->queue_query(pQuery);
+            }
+
+            if (rv)
+            {
+                ++state.n_refreshes;
+                mxb::atomic::add(&m_stats.refreshes, 1, mxb::atomic::RELAXED);
+            }
+            else
+            {
+                // The connection is broken, it will be recreated later.
+                pConnection->pClient->self_destruct();
+                pConnection->pClient = NULL;
+                pConnection->failed = now;
+            }
+        }
+
+        if (!rv)
+        {
+            mxb::atomic::add(&m_stats.failures, 1, mxb::atomic::RELAXED);
+        }
+    }
+
+    return rv;
+}
+
+CacheRefresher::Connection* CacheRefresher::get_connection(WorkerState& state,
+                                                            MXS_SESSION* pSession,
+                                                            time_t now)
+{
+    Connection& connection = state.connections[std::make_pair(pSession->service,
+                                                              std::string(session_get_user(pSession)))];
+
+    if (!connection.pClient && (now - connection.failed >= CACHE_REFRESH_RETRY_INTERVAL))
+    {
+        // The internal session authenticates as the user of this session, but
+        // starts without a default database so that any database can be used.
+        MYSQL_session client = *static_cast<MYSQL_session*>(pSession->client_dcb->data);
+        client.db[0] = 0;
+
+        MySQLProtocol* pProtocol = static_cast<MySQLProtocol*>(pSession->client_dcb->protocol);
+
+        LocalClient* pClient = LocalClient::create(&client, pProtocol, pSession->service);
+
+        // With a cache per thread, the result must be stored in the cache of
+        // this worker, not in that of the worker handling the internal session.
+        std::string worker = std::to_string(mxs::RoutingWorker::get_current_id());
+
+        if (pClient
+            && queue(pClient, modutil_create_query("SET @maxscale.cache.use=false"))
+            && queue(pClient, modutil_create_query(("SET @maxscale.cache.refresh_worker=" + worker).c_str())))
+        {
+            connection.pClient = pClient;
+            connection.db.clear();
+            connection.failed = 0;
+        }
+        else
+        {
+            if (pClient)
+            {
+                pClient->self_destruct();
+            }
+
+            MXS_ERROR("Could not create internal connection to '%s' for refreshing cache "
+                      "entries%s", pSession->service->name,
+                      pSession->service->ports ? "." : ": Service has no network listeners.");
+            connection.failed = now;
+        }
+    }
+
+    return connection.pClient ? &connection : NULL;
+}
+
+void CacheRefresher::purge(WorkerState& state, time_t now)
+{
+    Entries::iterator i = state.entries.begin();
+
+    while (i != state.entries.end())
+    {
+        if (now - i->second.since > (time_t)m_config.refresh_ahead)
+        {
+            i = state.entries.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <maxscale/buffer.h>
+#include <maxscale/routingworker.hh>
+#include <maxscale/service.h>
+#include <maxscale/session.h>
+#include "cachefilter.h"
+#include "cache_storage_api.hh"
+
+class LocalClient;
+
+/**
+ * CacheRefresher refreshes entries that are about to become stale and that
+ * are frequently used, before they become stale.
+ *
+ * The refreshing is performed in the background, over an internal connection
+ * to the service of the session. On that connection the use of the cache is
+ * disabled, so the statement reaches the server and the cache filter of the
+ * internal session stores the fresh result. The internal session may be
+ * handled by another worker, so it is told which worker the entry belongs
+ * to. The responses are not waited for; a refresh that has not replaced the
+ * entry within a few seconds is considered to have failed.
+ *
+ * All state, including the internal connections, is specific to a routing
+ * worker, so no locking is needed.
+ */
+class CacheRefresher
+{
+public:
+    CacheRefresher(const CACHE_CONFIG& config);
+    ~CacheRefresher();
+
+    /**
+     * Register a hit on an entry whose soft TTL will soon be exceeded and
+     * refresh the entry in the background, if it is used frequently enough.
+     *
+     * @param pSession    The session that hit the entry.
+     * @param zDefaultDb  The default database of the session, may be NULL.
+     * @param key         The key of the entry.
+     * @param pQuery      The SELECT that produced the entry.
+     *
+     * @return True, if the entry is being refreshed, in which case the stale
+     *         value may be returned to the client. False, if the entry is not
+     *         used frequently enough or if it could not be refreshed.
+     */
+    bool refresh(MXS_SESSION* pSession,
+                 const char* zDefaultDb,
+                 const CACHE_KEY& key,
+                 GWBUF* pQuery);
+
+    /**
+     * Get statistics of the refreshing.
+     *
+     * @return JSON object.
+     */
+    json_t* get_info() const;
+
+private:
+    struct Entry
+    {
+        Entry()
+            : since(0)
+            , hits(0)
+            , refreshing(false)
+            , issued(0)
+        {
+        }
+
+        time_t   since;         // When the entry was first hit during the refresh window.
+        uint32_t hits;          // Number of hits since then.
+        bool     refreshing;    // Whether a refresh has been issued.
+        time_t   issued;        // When the refresh was issued.
+    };
+
+    struct Connection
+    {
+        Connection()
+            : pClient(NULL)
+            , failed(0)
+        {
+        }
+
+        LocalClient* pClient;   // The internal connection, NULL if not connected.
+        std::string  db;        // The default database of the connection.
+        time_t       failed;    // When the connection last could not be created.
+    };
+
+    typedef std::unordered_map<CACHE_KEY, Entry>                   Entries;
+    typedef std::map<std::pair<SERVICE*, std::string>, Connection> Connections;
+
+    // Only the empty initial value is ever copied, when a worker first
+    // accesses its own instance.
+    struct WorkerState
+    {
+        WorkerState()
+            : second(0)
+            , n_refreshes(0)
+        {
+        }
+
+        ~WorkerState();
+
+        Entries     entries;        // Entries hit during their refresh window.
+        Connections connections;    // Internal connections, per service and user.
+        time_t      second;         // The second n_refreshes applies to.
+        uint32_t    n_refreshes;    // Refreshes issued during that second.
+    };
+
+    struct Stats
+    {
+        Stats()
+            : refreshes(0)
+            , throttled(0)
+            , failures(0)
+        {
+        }
+
+        uint64_t refreshes;     // Number of issued refreshes.
+        uint64_t throttled;     // Number of refreshes not issued due to the rate limit.
+        uint64_t failures;      // Number of refreshes that could not be issued.
+    };
+
+    bool        issue(WorkerState& state, MXS_SESSION* pSession, const char* zDefaultDb, GWBUF* pQuery);
+    Connection* get_connection(WorkerState& state, MXS_SESSION* pSession, time_t now);
+    void        purge(WorkerState& state, time_t now);
+
+private:
+    CacheRefresher(const CacheRefresher&);
+    CacheRefresher& operator=(const CacheRefresher&);
+
+private:
+    const CACHE_CONFIG&             m_config;   // The configuration of the filter instance.
+    mxs::rworker_local<WorkerState> m_state;    // The state of each worker.
+    Stats                           m_stats;    // Updated atomically.
+};
@@ -18,6 +18,7 @@
 #include <maxscale/query_classifier.h>
 #include "inmemorystoragest.hh"
 #include "inmemorystoragemt.hh"
+#include "inmemorystoragesharded.hh"
 
 using std::auto_ptr;
 using std::string;
@@ -45,7 +46,7 @@ InMemoryStorage::~InMemoryStorage()
 
 bool InMemoryStorage::Initialize(uint32_t* pCapabilities)
 {
-    *pCapabilities = (CACHE_STORAGE_CAP_ST | CACHE_STORAGE_CAP_MT);
+    *pCapabilities = (CACHE_STORAGE_CAP_ST | CACHE_STORAGE_CAP_MT | CACHE_STORAGE_CAP_SHARDED);
 
     return true;
 }
@@ -57,14 +58,17 @@ InMemoryStorage* InMemoryStorage::Create_instance(const char* zName,
 {
     mxb_assert(zName);
 
-    if (config.max_count != 0)
+    // The sharded storage enforces the limits itself.
+    bool enforces_limits = (config.thread_model == CACHE_THREAD_MODEL_SHARDED);
+
+    if (config.max_count != 0 && !enforces_limits)
     {
         MXS_WARNING("A maximum item count of %u specified, although 'storage_inMemory' "
                     "does not enforce such a limit.",
                     (unsigned int)config.max_count);
     }
 
-    if (config.max_size != 0)
+    if (config.max_size != 0 && !enforces_limits)
     {
         MXS_WARNING("A maximum size of %lu specified, although 'storage_inMemory' "
                     "does not enforce such a limit.",
@@ -79,6 +83,10 @@ InMemoryStorage* InMemoryStorage::Create_instance(const char* zName,
         sStorage = InMemoryStorageST::Create(zName, config, argc, argv);
         break;
 
+    case CACHE_THREAD_MODEL_SHARDED:
+        sStorage = InMemoryStorageSharded::Create(zName, config, argc, argv);
+        break;
+
     default:
         mxb_assert(!true);
         MXS_ERROR("Unknown thread model %d, creating multi-thread aware storage.",
@@ -89,7 +97,10 @@ InMemoryStorage* InMemoryStorage::Create_instance(const char* zName,
         break;
     }
 
-    MXS_NOTICE("Storage module created.");
+    if (sStorage.get())
+    {
+        MXS_NOTICE("Storage module created.");
+    }
 
     return sStorage.release();
 }
@@ -43,13 +43,18 @@ public:
 
     cache_result_t get_head(CACHE_KEY* pKey, GWBUF** ppHead) const;
     cache_result_t get_tail(CACHE_KEY* pKey, GWBUF** ppHead) const;
-    cache_result_t get_size(uint64_t* pSize) const;
-    cache_result_t get_items(uint64_t* pItems) const;
+    virtual cache_result_t get_size(uint64_t* pSize) const;
+    virtual cache_result_t get_items(uint64_t* pItems) const;
 
 protected:
     InMemoryStorage(const std::string& name,
                     const CACHE_STORAGE_CONFIG& config);
 
+    const CACHE_STORAGE_CONFIG& config() const
+    {
+        return m_config;
+    }
+
     cache_result_t do_get_info(uint32_t what, json_t** ppInfo) const;
     cache_result_t do_get_value(const CACHE_KEY& key,
                                 uint32_t flags,
@@ -59,24 +64,7 @@ protected:
     cache_result_t do_put_value(const CACHE_KEY& key, const GWBUF& value);
     cache_result_t do_del_value(const CACHE_KEY& key);
 
-private:
-    InMemoryStorage(const InMemoryStorage&);
-    InMemoryStorage& operator=(const InMemoryStorage&);
-
-private:
-    typedef std::vector<uint8_t> Value;
-
-    struct Entry
-    {
-        Entry()
-            : time(0)
-        {
-        }
-
-        uint32_t time;
-        Value    value;
-    };
-
+protected:
     struct Stats
     {
         Stats()
@@ -99,6 +87,24 @@ private:
         uint64_t deletes;   /*< How many times an existing key in the cache was deleted. */
     };
 
+private:
+    InMemoryStorage(const InMemoryStorage&);
+    InMemoryStorage& operator=(const InMemoryStorage&);
+
+private:
+    typedef std::vector<uint8_t> Value;
+
+    struct Entry
+    {
+        Entry()
+            : time(0)
+        {
+        }
+
+        uint32_t time;
+        Value    value;
+    };
+
     typedef std::unordered_map<CACHE_KEY, Entry> Entries;
 
     std::string                m_name;
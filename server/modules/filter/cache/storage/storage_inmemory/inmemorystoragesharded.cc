@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "storage_inmemory"
+#include "inmemorystoragesharded.hh"
+#include <string.h>
+
+using std::auto_ptr;
+using std::lock_guard;
+using std::mutex;
+
+InMemoryStorageSharded::InMemoryStorageSharded(const std::string& name,
+                                               const CACHE_STORAGE_CONFIG& config,
+                                               size_t n_shards)
+    : InMemoryStorage(name, config)
+    , m_shards(n_shards)
+    , m_size(0)
+    , m_items(0)
+{
+}
+
+InMemoryStorageSharded::~InMemoryStorageSharded()
+{
+}
+
+auto_ptr<InMemoryStorageSharded> InMemoryStorageSharded::Create(const std::string& name,
+                                                                const CACHE_STORAGE_CONFIG& config,
+                                                                int argc,
+                                                                char* argv[])
+{
+    size_t n_shards = DEFAULT_SHARDS;
+    bool error = false;
+
+    for (int i = 0; i < argc; ++i)
+    {
+        const char* zArg = argv[i];
+        const char zShards[] = "shards=";
+
+        if (strncmp(zArg, zShards, sizeof(zShards) - 1) == 0)
+        {
+            const char* zValue = zArg + sizeof(zShards) - 1;
+            char* zEnd;
+            long value = strtol(zValue, &zEnd, 10);
+
+            if (*zValue && !*zEnd && value > 0 && value <= (long)MAX_SHARDS)
+            {
+                n_shards = value;
+            }
+            else
+            {
+                MXS_ERROR("Invalid value '%s' for 'shards', the value must be an "
+                          "integer between 1 and %lu.", zValue, (unsigned long)MAX_SHARDS);
+                error = true;
+            }
+        }
+        else
+        {
+            MXS_WARNING("Unknown storage option '%s' ignored.", zArg);
+        }
+    }
+
+    auto_ptr<InMemoryStorageSharded> sStorage;
+
+    if (!error)
+    {
+        sStorage.reset(new InMemoryStorageSharded(name, config, n_shards));
+        MXS_NOTICE("Sharded storage with %lu shards created.", (unsigned long)n_shards);
+    }
+
+    return sStorage;
+}
+
+cache_result_t InMemoryStorageSharded::get_info(uint32_t what, json_t** ppInfo) const
+{
+    Stats stats;
+    uint64_t evictions = 0;
+
+    for (const Shard& shard : m_shards)
+    {
+        lock_guard<mutex> guard(shard.lock);
+
+        stats.hits += shard.stats.hits;
+        stats.misses += shard.stats.misses;
+        stats.updates += shard.stats.updates;
+        stats.deletes += shard.stats.deletes;
+        evictions += shard.evictions;
+    }
+
+    stats.size = m_size.load(std::memory_order_relaxed);
+    stats.items = m_items.load(std::memory_order_relaxed);
+
+    *ppInfo = json_object();
+
+    if (*ppInfo)
+    {
+        stats.fill(*ppInfo);
+        json_object_set_new(*ppInfo, "evictions", json_integer(evictions));
+        json_object_set_new(*ppInfo, "shards", json_integer(m_shards.size()));
+    }
+
+    return *ppInfo ? CACHE_RESULT_OK : CACHE_RESULT_OUT_OF_RESOURCES;
+}
+
+cache_result_t InMemoryStorageSharded::get_value(const CACHE_KEY& key,
+                                                 uint32_t flags,
+                                                 uint32_t soft_ttl,
+                                                 uint32_t hard_ttl,
+                                                 GWBUF**  ppResult)
+{
+    if (soft_ttl == CACHE_USE_CONFIG_TTL)
+    {
+        soft_ttl = config().soft_ttl;
+    }
+
+    if (hard_ttl == CACHE_USE_CONFIG_TTL)
+    {
+        hard_ttl = config().hard_ttl;
+    }
+
+    if (soft_ttl > hard_ttl)
+    {
+        soft_ttl = hard_ttl;
+    }
+
+    cache_result_t result = CACHE_RESULT_NOT_FOUND;
+    bool is_soft_stale = false;
+    SValue sValue;
+
+    Shard& shard = m_shards[shard_index(key)];
+
+    {
+        lock_guard<mutex> guard(shard.lock);
+
+        Entries::iterator i = shard.entries.find(key);
+
+        if (i != shard.entries.end())
+        {
+            shard.stats.hits += 1;
+
+            Entry& entry = i->second;
+
+            uint32_t now = time(NULL);
+
+            bool is_hard_stale = hard_ttl == 0 ? false : (now - entry.time > hard_ttl);
+            is_soft_stale = soft_ttl == 0 ? false : (now - entry.time > soft_ttl);
+            bool include_stale = ((flags & CACHE_FLAGS_INCLUDE_STALE) != 0);
+
+            if (is_hard_stale)
+            {
+                erase(shard, i);
+                result |= CACHE_RESULT_DISCARDED;
+            }
+            else if (!is_soft_stale || include_stale)
+            {
+                // Only the reference is obtained while the lock is held.
+                sValue = entry.sValue;
+                shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru);
+            }
+            else
+            {
+                mxb_assert(is_soft_stale);
+                result |= CACHE_RESULT_STALE;
+            }
+        }
+        else
+        {
+            shard.stats.misses += 1;
+        }
+    }
+
+    if (sValue)
+    {
+        size_t length = sValue->size();
+
+        *ppResult = gwbuf_alloc(length);
+
+        if (*ppResult)
+        {
+            memcpy(GWBUF_DATA(*ppResult), sValue->data(), length);
+
+            result = CACHE_RESULT_OK;
+
+            if (is_soft_stale)
+            {
+                result |= CACHE_RESULT_STALE;
+            }
+        }
+        else
+        {
+            result = CACHE_RESULT_OUT_OF_RESOURCES;
+        }
+    }
+
+    return result;
+}
+
+cache_result_t InMemoryStorageSharded::put_value(const CACHE_KEY& key, const GWBUF& value)
+{
+    mxb_assert(GWBUF_IS_CONTIGUOUS(&value));
+
+    size_t size = GWBUF_LENGTH(&value);
+    size_t index = shard_index(key);
+    Shard& shard = m_shards[index];
+
+    cache_result_t result = CACHE_RESULT_OK;
+
+    if (config().max_size != 0 && size > config().max_size)
+    {
+        // A value that can never fit must not evict everything else, but
+        // an existing, now outdated value must not be left behind either.
+        del_value(key);
+        result = CACHE_RESULT_OUT_OF_RESOURCES;
+    }
+    else
+    {
+        const uint8_t* pData = GWBUF_DATA(&value);
+
+        // The value is copied before the lock is acquired.
+        SValue sValue = std::make_shared<const Value>(pData, pData + size);
+
+        {
+            lock_guard<mutex> guard(shard.lock);
+
+            Entries::iterator i = shard.entries.find(key);
+
+            if (i == shard.entries.end())
+            {
+                Entry& entry = shard.entries[key];
+
+                shard.lru.push_front(key);
+                entry.lru = shard.lru.begin();
+                entry.sValue.swap(sValue);
+                entry.time = time(NULL);
+
+                m_items.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                Entry& entry = i->second;
+
+                shard.stats.updates += 1;
+                shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru);
+
+                m_size.fetch_sub(entry.sValue->size(), std::memory_order_relaxed);
+
+                // A reader may still hold the old value; it is released when
+                // the last reference to it goes away.
+                entry.sValue.swap(sValue);
+                entry.time = time(NULL);
+            }
+
+            m_size.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        if (is_over_limit())
+        {
+            // Other shards are given the chance to evict first, so that the
+            // value just stored is evicted only as the last resort.
+            evict((index + 1) % m_shards.size());
+        }
+    }
+
+    return result;
+}
+
+cache_result_t InMemoryStorageSharded::del_value(const CACHE_KEY& key)
+{
+    cache_result_t result = CACHE_RESULT_NOT_FOUND;
+
+    Shard& shard = m_shards[shard_index(key)];
+    lock_guard<mutex> guard(shard.lock);
+
+    Entries::iterator i = shard.entries.find(key);
+
+    if (i != shard.entries.end())
+    {
+        shard.stats.deletes += 1;
+        erase(shard, i);
+
+        result = CACHE_RESULT_OK;
+    }
+
+    return result;
+}
+
+cache_result_t InMemoryStorageSharded::get_size(uint64_t* pSize) const
+{
+    *pSize = m_size.load(std::memory_order_relaxed);
+
+    return CACHE_RESULT_OK;
+}
+
+cache_result_t InMemoryStorageSharded::get_items(uint64_t* pItems) const
+{
+    *pItems = m_items.load(std::memory_order_relaxed);
+
+    return CACHE_RESULT_OK;
+}
+
+bool InMemoryStorageSharded::is_over_limit() const
+{
+    const CACHE_STORAGE_CONFIG& c = config();
+
+    return (c.max_size != 0 && m_size.load(std::memory_order_relaxed) > c.max_size)
+           || (c.max_count != 0 && m_items.load(std::memory_order_relaxed) > c.max_count);
+}
+
+void InMemoryStorageSharded::erase(Shard& shard, Entries::iterator i)
+{
+    Entry& entry = i->second;
+
+    mxb_assert(m_size.load(std::memory_order_relaxed) >= entry.sValue->size());
+    mxb_assert(m_items.load(std::memory_order_relaxed) > 0);
+
+    m_size.fetch_sub(entry.sValue->size(), std::memory_order_relaxed);
+    m_items.fetch_sub(1, std::memory_order_relaxed);
+
+    shard.lru.erase(entry.lru);
+    shard.entries.erase(i);
+}
+
+void InMemoryStorageSharded::evict(size_t index)
+{
+    size_t n_shards = m_shards.size();
+    size_t n_empty = 0;     // Number of consecutive shards with nothing to evict.
+
+    // Only one shard lock is held at a time. The least recently used entry of
+    // each shard is evicted in turn until the storage is within its limits.
+    while (is_over_limit() && n_empty < n_shards)
+    {
+        Shard& shard = m_shards[index];
+        bool evicted = false;
+
+        {
+            lock_guard<mutex> guard(shard.lock);
+
+            if (!shard.lru.empty())
+            {
+                Entries::iterator i = shard.entries.find(shard.lru.back());
+                mxb_assert(i != shard.entries.end());
+
+                erase(shard, i);
+                shard.evictions += 1;
+                evicted = true;
+            }
+        }
+
+        n_empty = evicted ? 0 : n_empty + 1;
+        index = (index + 1) % n_shards;
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include "inmemorystorage.hh"
+
+/**
+ * A storage shared by all threads and partitioned into a number of shards,
+ * each with a lock of its own. A key is always stored in the shard selected
+ * by its hash, so threads accessing different keys seldom contend for the
+ * same lock.
+ *
+ * The values are stored as immutable, reference counted buffers, so a lookup
+ * only needs to hold the lock of the shard while it obtains a reference to
+ * the value; the value is copied into the result outside the lock.
+ *
+ * The maximum count and the maximum size apply to the storage as a whole.
+ * Each shard maintains its own LRU list, from which entries are evicted
+ * when a limit is exceeded.
+ */
+class InMemoryStorageSharded : public InMemoryStorage
+{
+public:
+    ~InMemoryStorageSharded();
+
+    typedef std::auto_ptr<InMemoryStorageSharded> SInMemoryStorageSharded;
+
+    static const size_t DEFAULT_SHARDS = 16;
+    static const size_t MAX_SHARDS = 1024;
+
+    static SInMemoryStorageSharded Create(const std::string& name,
+                                          const CACHE_STORAGE_CONFIG& config,
+                                          int argc,
+                                          char* argv[]);
+
+    cache_result_t get_info(uint32_t what, json_t** ppInfo) const;
+    cache_result_t get_value(const CACHE_KEY& key,
+                             uint32_t flags,
+                             uint32_t soft_ttl,
+                             uint32_t hard_ttl,
+                             GWBUF**  ppResult);
+    cache_result_t put_value(const CACHE_KEY& key, const GWBUF& value);
+    cache_result_t del_value(const CACHE_KEY& key);
+
+    cache_result_t get_size(uint64_t* pSize) const;
+    cache_result_t get_items(uint64_t* pItems) const;
+
+private:
+    InMemoryStorageSharded(const std::string& name,
+                           const CACHE_STORAGE_CONFIG& config,
+                           size_t n_shards);
+
+    InMemoryStorageSharded(const InMemoryStorageSharded&);
+    InMemoryStorageSharded& operator=(const InMemoryStorageSharded&);
+
+private:
+    typedef std::vector<uint8_t>             Value;
+    typedef std::shared_ptr<const Value>     SValue;
+    typedef std::list<CACHE_KEY>             Lru;
+
+    struct Entry
+    {
+        Entry()
+            : time(0)
+        {
+        }
+
+        uint32_t      time;     /*< When the value was stored. */
+        SValue        sValue;   /*< The value, never modified once stored. */
+        Lru::iterator lru;      /*< The position of the key in the LRU list of the shard. */
+    };
+
+    typedef std::unordered_map<CACHE_KEY, Entry> Entries;
+
+    struct Shard
+    {
+        Shard()
+            : evictions(0)
+        {
+        }
+
+        mutable std::mutex lock;        /*< Protects everything in the shard. */
+        Entries            entries;     /*< The entries of the shard. */
+        Lru                lru;         /*< Most recently used key first. */
+        Stats              stats;       /*< Size and items are tracked globally. */
+        uint64_t           evictions;   /*< How many entries were evicted from the shard. */
+    };
+
+    size_t shard_index(const CACHE_KEY& key) const
+    {
+        return key.data % m_shards.size();
+    }
+
+    bool is_over_limit() const;
+    void erase(Shard& shard, Entries::iterator i);
+    void evict(size_t index);
+
+    std::vector<Shard>    m_shards;     /*< The shards. */
+    std::atomic<uint64_t> m_size;       /*< The total size of the values in all shards. */
+    std::atomic<uint64_t> m_items;      /*< The total number of items in all shards. */
+};
@@ -157,9 +157,25 @@ Storage* StorageFactory::createStorage(const char* zName,
 
     CacheStorageConfig used_config(config);
 
+    if (used_config.thread_model == CACHE_THREAD_MODEL_SHARDED
+        && !cache_storage_has_cap(m_storage_caps, CACHE_STORAGE_CAP_SHARDED))
+    {
+        MXS_WARNING("Storage '%s' cannot be sharded, a shared storage will be used instead.",
+                    zName);
+        used_config.thread_model = CACHE_THREAD_MODEL_MT;
+    }
+
+    // The thread model to be used by the LRUStorage, if one is needed.
+    cache_thread_model_t thread_model = used_config.thread_model;
+
     uint32_t mask = CACHE_STORAGE_CAP_MAX_COUNT | CACHE_STORAGE_CAP_MAX_SIZE;
 
-    if (!cache_storage_has_cap(m_storage_caps, mask))
+    // A sharded storage handles the eviction itself, per shard, so it must
+    // not be wrapped with a LRUStorage that would serialize all access.
+    bool use_lru = (thread_model != CACHE_THREAD_MODEL_SHARDED)
+        && !cache_storage_has_cap(m_storage_caps, mask);
+
+    if (use_lru)
     {
         // Since we will wrap the native storage with a LRUStorage, according
         // to the used threading model, the storage itself may be single
@@ -173,20 +189,20 @@ Storage* StorageFactory::createStorage(const char* zName,
 
     if (pStorage)
     {
-        if (!cache_storage_has_cap(m_storage_caps, mask))
+        if (use_lru)
         {
             // Ok, so the cache cannot handle eviction. Let's decorate the
             // real storage with a storage than can.
 
             LRUStorage* pLruStorage = NULL;
 
-            if (config.thread_model == CACHE_THREAD_MODEL_ST)
+            if (thread_model == CACHE_THREAD_MODEL_ST)
             {
                 pLruStorage = LRUStorageST::create(config, pStorage);
             }
             else
             {
-                mxb_assert(config.thread_model == CACHE_THREAD_MODEL_MT);
+                mxb_assert(thread_model == CACHE_THREAD_MODEL_MT);
 
                 pLruStorage = LRUStorageMT::create(config, pStorage);
             }
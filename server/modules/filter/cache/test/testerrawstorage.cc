@@ -36,7 +36,18 @@ int TesterRawStorage::execute(size_t n_threads, size_t n_seconds, const CacheIte
         delete pStorage;
     }
 
-    return combine_rvs(rv1, rv2);
+    int rv3 = EXIT_FAILURE;
+    config.thread_model = CACHE_THREAD_MODEL_SHARDED;
+
+    pStorage = get_storage(config);
+
+    if (pStorage)
+    {
+        rv3 = execute_tasks(n_threads, n_seconds, cache_items, *pStorage);
+        delete pStorage;
+    }
+
+    return combine_rvs(rv1, rv2, rv3);
 }
 
 Storage* TesterRawStorage::get_storage(const CACHE_STORAGE_CONFIG& config) const
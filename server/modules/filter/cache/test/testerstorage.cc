@@ -305,7 +305,22 @@ int TesterStorage::test_ttl(const CacheItems& cache_items)
         delete pStorage;
     }
 
-    return combine_rvs(rv1, rv2);
+    out() << "SHARDED" << endl;
+
+    config.thread_model = CACHE_THREAD_MODEL_SHARDED;
+    config.hard_ttl = 6;
+    config.soft_ttl = 3;
+
+    int rv3 = EXIT_FAILURE;
+    pStorage = get_storage(config);
+
+    if (pStorage)
+    {
+        rv3 = test_ttl(cache_items, *pStorage);
+        delete pStorage;
+    }
+
+    return combine_rvs(rv1, rv2, rv3);
 }
 
 int TesterStorage::test_ttl(const CacheItems& cache_items, Storage& storage)
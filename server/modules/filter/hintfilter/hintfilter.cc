@@ -14,6 +14,7 @@
 #define MXS_MODULE_NAME "hintfilter"
 
 #include <stdio.h>
+#include <new>
 #include <maxscale/filter.h>
 #include <maxscale/alloc.h>
 #include <maxscale/modinfo.h>
@@ -37,6 +38,7 @@ static int      routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, G
 static void     diagnostic(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, DCB* dcb);
 static json_t*  diagnostic_json(const MXS_FILTER* instance, const MXS_FILTER_SESSION* fsession);
 static uint64_t getCapabilities(MXS_FILTER* instance);
+static void     destroyInstance(MXS_FILTER* instance);
 
 extern "C"
 {
@@ -64,7 +66,7 @@ extern "C"
             diagnostic,
             diagnostic_json,
             getCapabilities,
-            NULL,   // No destroyInstance
+            destroyInstance,
         };
 
         static MXS_MODULE info =
@@ -106,10 +108,30 @@ static MXS_FILTER* createInstance(const char* name, MXS_CONFIG_PARAMETER* params
     if ((my_instance = static_cast<HINT_INSTANCE*>(MXS_CALLOC(1, sizeof(HINT_INSTANCE)))) != NULL)
     {
         my_instance->sessions = 0;
+        my_instance->cache = new(std::nothrow) mxs::rworker_local<HintCache>();
+
+        if (my_instance->cache == NULL)
+        {
+            MXS_FREE(my_instance);
+            my_instance = NULL;
+        }
     }
     return (MXS_FILTER*)my_instance;
 }
 
+/**
+ * Destroy an instance of the filter
+ *
+ * @param instance  The filter instance data
+ */
+static void destroyInstance(MXS_FILTER* instance)
+{
+    HINT_INSTANCE* my_instance = (HINT_INSTANCE*)instance;
+
+    delete my_instance->cache;
+    MXS_FREE(my_instance);
+}
+
 /**
  * Associate a new session with this instance of the filter.
  *
@@ -204,13 +226,14 @@ static void setDownstream(MXS_FILTER* instance, MXS_FILTER_SESSION* session, MXS
  */
 static int routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF* queue)
 {
+    HINT_INSTANCE* my_instance = (HINT_INSTANCE*)instance;
     HINT_SESSION* my_session = (HINT_SESSION*)session;
 
     if (modutil_is_SQL(queue))
     {
         my_session->request = NULL;
         my_session->query_len = 0;
-        HINT* new_hint = hint_parser(my_session, queue);
+        HINT* new_hint = hint_parser(my_session, &**my_instance->cache, queue);
         if (new_hint)
         {
             queue->hint = hint_splice(queue->hint, new_hint);
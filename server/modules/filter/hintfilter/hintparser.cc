@@ -28,6 +28,16 @@
  * hints in that comment.
  */
 
+/* The word every hint starts with */
+#define HINT_MARKER     "maxscale"
+#define HINT_MARKER_LEN 8
+
+/* The maximum number of hint comments cached by a worker */
+#define HINT_CACHE_SIZE 1024
+
+/* The maximum length of a cached hint comment */
+#define HINT_KEY_MAX_LEN 1024
+
 /**
  * The keywords in the hint syntax
  */
@@ -60,6 +70,8 @@ static void        create_named_hint(HINT_SESSION*, char*, HINT*);
 static void        hint_push(HINT_SESSION*, HINT*);
 static const char* token_get_keyword(HINT_TOKEN* token);
 static void        token_free(HINT_TOKEN* token);
+static bool        has_hint_marker(const char* ptr, int len);
+static bool        get_hint_key(const char* start, const char* end, bool multiline, std::string* key);
 
 typedef enum
 {
@@ -116,16 +128,156 @@ static const char* token_get_keyword(HINT_TOKEN* token)
     }
 }
 
+/**
+ * Check whether a statement contains the word that starts every hint. The
+ * statements without it are not searched for comments. The first letter is
+ * looked for with memchr, which compares many bytes at a time.
+ *
+ * @param ptr  The SQL
+ * @param len  The length of the SQL
+ * @return     True, if the statement may contain a hint
+ */
+static bool has_hint_marker(const char* ptr, int len)
+{
+    const char* end = ptr + len;
+    const char* lower = (const char*)memchr(ptr, 'm', len);
+    const char* upper = (const char*)memchr(ptr, 'M', len);
+
+    while (lower || upper)
+    {
+        const char* p;
+
+        if (lower && (!upper || lower < upper))
+        {
+            p = lower;
+            lower = (const char*)memchr(p + 1, 'm', end - p - 1);
+        }
+        else
+        {
+            p = upper;
+            upper = (const char*)memchr(p + 1, 'M', end - p - 1);
+        }
+
+        if (end - p >= HINT_MARKER_LEN && strncasecmp(p, HINT_MARKER, HINT_MARKER_LEN) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Get the text of a comment that decides which hints it contains. The hint
+ * parser stops at the end of the comment, so the hints of two comments with
+ * the same text are the same.
+ *
+ * @param start      The last character of the comment start
+ * @param end        The end of the SQL
+ * @param multiline  Whether the comment is a C style comment
+ * @param key        The text is stored here
+ * @return           False, if the comment should not be cached
+ */
+static bool get_hint_key(const char* start, const char* end, bool multiline, std::string* key)
+{
+    const char* stop;
+
+    if (multiline)
+    {
+        stop = (const char*)memmem(start + 1, end - start - 1, "*/", 2);
+        stop = stop ? stop + 2 : end;
+    }
+    else
+    {
+        stop = (const char*)memchr(start, '\n', end - start);
+        stop = stop ? stop : end;
+
+        if (memchr(start, '\'', stop - start))
+        {
+            // A quoted value can continue on the next line
+            return false;
+        }
+    }
+
+    if (stop - start > HINT_KEY_MAX_LEN)
+    {
+        return false;
+    }
+
+    key->assign(start, stop);
+    return true;
+}
+
+HintCache::HintCache()
+{
+}
+
+HintCache::HintCache(const HintCache&)
+{
+}
+
+HintCache::~HintCache()
+{
+    clear();
+}
+
+bool HintCache::get(const std::string& key, HINT** hints) const
+{
+    auto it = m_hints.find(key);
+
+    if (it == m_hints.end())
+    {
+        return false;
+    }
+
+    *hints = hint_dup(it->second);
+    return true;
+}
+
+void HintCache::put(const std::string& key, const HINT* hints)
+{
+    if (m_hints.size() >= HINT_CACHE_SIZE)
+    {
+        // The hints are expected to come from a small set of statements
+        clear();
+    }
+
+    HINT* copy = hint_dup(hints);
+
+    if (copy)
+    {
+        m_hints[key] = copy;
+    }
+}
+
+void HintCache::clear()
+{
+    for (auto& kv : m_hints)
+    {
+        HINT* hint = kv.second;
+
+        while (hint)
+        {
+            HINT* next = hint->next;
+            hint_free(hint);
+            hint = next;
+        }
+    }
+
+    m_hints.clear();
+}
+
 /**
  * Parse the hint comments in the MySQL statement passed in request.
  * Add any hints to the buffer for later processing.
  *
  * @param session   The filter session
+ * @param cache     The hint cache of the worker
  * @param request   The MySQL request buffer
  * @return      The hints parsed in this statement or active on the
  *          stack
  */
-HINT* hint_parser(HINT_SESSION* session, GWBUF* request)
+HINT* hint_parser(HINT_SESSION* session, HintCache* cache, GWBUF* request)
 {
     char* ptr, lastch = ' ';
     int len, residual, state;
@@ -136,8 +288,18 @@ HINT* hint_parser(HINT_SESSION* session, GWBUF* request)
     HINT_TOKEN* tok;
     HINT_MODE mode = HM_EXECUTE;
     bool multiline_comment = false;
+    bool cacheable = false;
+    bool popped = false;
+    std::string key;
     /* First look for any comment in the SQL */
     modutil_MySQL_Query(request, &ptr, &len, &residual);
+
+    /* Most statements carry no hints, so those are not looked at further */
+    if (residual == 0 && request->next == NULL && !has_hint_marker(ptr, len))
+    {
+        goto retblock;
+    }
+
     buf = request;
     found = 0;
     escape = 0;
@@ -244,6 +406,17 @@ HINT* hint_parser(HINT_SESSION* session, GWBUF* request)
         }
     }
 
+    /* A statement that is not split into several buffers can use the cache */
+    if (buf == request && buf->next == NULL)
+    {
+        cacheable = get_hint_key(ptr - 1, (char*)buf->end, multiline_comment, &key);
+
+        if (cacheable && cache->get(key, &rval))
+        {
+            goto retblock;
+        }
+    }
+
     tok = hint_next_token(&buf, &ptr);
 
     if (tok == NULL)
@@ -296,6 +469,7 @@ HINT* hint_parser(HINT_SESSION* session, GWBUF* request)
             case TOK_STOP:
                 /* Action: pop active hint */
                 hint_pop(session);
+                popped = true;
                 state = HS_INIT;
                 break;
 
@@ -523,6 +697,10 @@ HINT* hint_parser(HINT_SESSION* session, GWBUF* request)
          * We have a one-off hint for the statement we are
          * currently forwarding.
          */
+        if (cacheable && !popped && rval)
+        {
+            cache->put(key, rval);
+        }
         break;
     }
 
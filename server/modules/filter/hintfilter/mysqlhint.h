@@ -23,6 +23,48 @@
 
 #include <maxscale/cdefs.h>
 #include <maxscale/hint.h>
+#include <maxscale/routingworker.hh>
+
+#include <string>
+#include <unordered_map>
+
+/**
+ * The hints of statements with a one-off hint, keyed by the text of the hint
+ * comment. Such a hint does not depend on the session, so it needs to be
+ * parsed only once. Each routing worker has a cache of its own.
+ */
+class HintCache
+{
+public:
+    HintCache();
+    HintCache(const HintCache&);    // Creates an empty cache, used for the workers' copies
+    ~HintCache();
+
+    /**
+     * Look up the hints of a hint comment
+     *
+     * @param key    The text of the comment.
+     * @param hints  A copy of the cached hints is stored here.
+     *
+     * @return True, if the comment was in the cache.
+     */
+    bool get(const std::string& key, HINT** hints) const;
+
+    /**
+     * Store the hints of a hint comment
+     *
+     * @param key    The text of the comment.
+     * @param hints  The hints, which are copied.
+     */
+    void put(const std::string& key, const HINT* hints);
+
+private:
+    HintCache& operator=(const HintCache&);
+
+    void clear();
+
+    std::unordered_map<std::string, HINT*> m_hints;
+};
 
 MXS_BEGIN_DECLS
 
@@ -84,7 +126,8 @@ typedef struct hintstack
  */
 typedef struct
 {
-    int sessions;
+    int                            sessions;
+    mxs::rworker_local<HintCache>* cache;   /* The parsed one-off hints */
 } HINT_INSTANCE;
 
 /**
@@ -113,7 +156,7 @@ typedef struct
 #define HS_PVALUE       5
 #define HS_PREPARE      6
 
-extern HINT* hint_parser(HINT_SESSION* session, GWBUF* request);
+extern HINT* hint_parser(HINT_SESSION* session, HintCache* cache, GWBUF* request);
 NAMEDHINTS*  free_named_hint(NAMEDHINTS* named_hint);
 HINTSTACK*   free_hint_stack(HINTSTACK* hint_stack);
 
@@ -16,6 +16,8 @@
 #include <maxscale/cdefs.h>
 
 #include <strings.h>
+#include <time.h>
+#include <maxbase/atomic.hh>
 #include <maxscale/alloc.h>
 #include <maxscale/buffer.h>
 #include <maxscale/filter.h>
@@ -47,15 +49,20 @@ static uint64_t getCapabilities(MXS_FILTER* instance);
 static int32_t  clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF* reply);
 static bool     extract_insert_target(GWBUF* buffer, char* target, int len);
 static GWBUF*   create_load_data_command(const char* target);
-static GWBUF*   convert_to_stream(GWBUF* buffer, uint8_t packet_num);
+static GWBUF*   convert_to_stream(GWBUF* buffer, uint8_t packet_num, uint64_t* rows);
 
 /**
  * Instance structure
  */
 typedef struct
 {
-    char* source;   /**< Source address to restrict matches */
-    char* user;     /**< User name to restrict matches */
+    char*    source;        /**< Source address to restrict matches */
+    char*    user;          /**< User name to restrict matches */
+    uint64_t n_streams;     /**< Number of streams opened */
+    uint64_t n_inserts;     /**< Number of inserts converted into a stream */
+    uint64_t n_rows;        /**< Number of rows streamed */
+    int64_t  bytes_saved;   /**< Bytes saved by streaming, negative if more were sent */
+    uint64_t stream_us;     /**< Total time the streams have been open in microseconds */
 } DS_INSTANCE;
 
 enum ds_state
@@ -85,6 +92,8 @@ typedef struct
     enum ds_state state;                                            /**< The current state of the
                                                                      * stream */
     char target[MYSQL_TABLE_MAXLEN + MYSQL_DATABASE_MAXLEN + 1];    /**< Current target table */
+    uint64_t stream_start;                                          /**< When the stream was accepted,
+                                                                     * in microseconds */
 } DS_SESSION;
 
 extern "C"
@@ -155,6 +164,16 @@ void free_instance(DS_INSTANCE* instance)
     }
 }
 
+/**
+ * Get the current time in microseconds
+ */
+static uint64_t time_in_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 /**
  * This the SQL command that starts the streaming
  */
@@ -279,10 +298,11 @@ static void setUpstream(MXS_FILTER* instance, MXS_FILTER_SESSION* session, MXS_U
  */
 static int32_t routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF* queue)
 {
+    DS_INSTANCE* my_instance = (DS_INSTANCE*) instance;
     DS_SESSION* my_session = (DS_SESSION*) session;
     char target[MYSQL_TABLE_MAXLEN + MYSQL_DATABASE_MAXLEN + 1];
+    bool send_empty = false;
     bool send_ok = false;
-    bool send_error = false;
     int rc = 0;
     mxb_assert(GWBUF_IS_CONTIGUOUS(queue));
 
@@ -298,6 +318,14 @@ static int32_t routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWB
             my_session->state = DS_REQUEST_SENT;
             my_session->packet_num = 0;
             queue = create_load_data_command(target);
+
+            if (queue)
+            {
+                /** The command and the empty packet that ends the stream are the overhead */
+                int64_t overhead = gwbuf_length(queue) + MYSQL_HEADER_LEN;
+                mxb::atomic::add(&my_instance->n_streams, 1, mxb::atomic::RELAXED);
+                mxb::atomic::add(&my_instance->bytes_saved, -overhead, mxb::atomic::RELAXED);
+            }
             break;
 
         case DS_REQUEST_ACCEPTED:
@@ -312,18 +340,26 @@ static int32_t routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWB
                  * a data stream
                  */
                 uint8_t packet_num = ++my_session->packet_num;
+                uint64_t rows = 0;
+                int64_t orig_len = gwbuf_length(queue);
                 send_ok = true;
-                queue = convert_to_stream(queue, packet_num);
+                queue = convert_to_stream(queue, packet_num, &rows);
+
+                mxb::atomic::add(&my_instance->n_inserts, 1, mxb::atomic::RELAXED);
+                mxb::atomic::add(&my_instance->n_rows, rows, mxb::atomic::RELAXED);
+                mxb::atomic::add(&my_instance->bytes_saved,
+                                 orig_len - (int64_t)gwbuf_length(queue),
+                                 mxb::atomic::RELAXED);
             }
             else
             {
                 /**
-                 * Target mismatch
-                 *
-                 * TODO: Instead of sending an error, we could just open a new stream
+                 * Target mismatch, close the stream. Once it is closed, the insert
+                 * is routed again and it opens a new stream into its own target.
                  */
-                gwbuf_free(queue);
-                send_error = true;
+                my_session->state = DS_CLOSING_STREAM;
+                send_empty = true;
+                my_session->queue = queue;
             }
             break;
 
@@ -336,8 +372,6 @@ static int32_t routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWB
     else
     {
         /** Transaction is not active or this is not an insert */
-        bool send_empty = false;
-        uint8_t packet_num;
         *my_session->target = '\0';
 
         switch (my_session->state)
@@ -346,7 +380,6 @@ static int32_t routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWB
             /** Stream is open, we need to close it */
             my_session->state = DS_CLOSING_STREAM;
             send_empty = true;
-            packet_num = ++my_session->packet_num;
             my_session->queue = queue;
             break;
 
@@ -359,12 +392,12 @@ static int32_t routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWB
             mxb_assert(my_session->state == DS_STREAM_CLOSED);
             break;
         }
+    }
 
-        if (send_empty)
-        {
-            char empty_packet[] = {0, 0, 0, static_cast<char>(packet_num)};
-            queue = gwbuf_alloc_and_load(sizeof(empty_packet), &empty_packet[0]);
-        }
+    if (send_empty)
+    {
+        char empty_packet[] = {0, 0, 0, static_cast<char>(++my_session->packet_num)};
+        queue = gwbuf_alloc_and_load(sizeof(empty_packet), &empty_packet[0]);
     }
 
     if (send_ok)
@@ -372,16 +405,9 @@ static int32_t routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWB
         rc = mxs_mysql_send_ok(my_session->client_dcb, 1, 0, NULL);
     }
 
-    if (send_error)
-    {
-        rc = mysql_send_custom_error(my_session->client_dcb, 1, 0, "Invalid insert target");
-    }
-    else
-    {
-        rc = my_session->down.routeQuery(my_session->down.instance,
-                                         my_session->down.session,
-                                         queue);
-    }
+    rc = my_session->down.routeQuery(my_session->down.instance,
+                                     my_session->down.session,
+                                     queue);
 
     return rc;
 }
@@ -414,10 +440,11 @@ static char* get_value(char* data, uint32_t datalen, char** dest, uint32_t* dest
  *
  * @param buffer     Buffer containing the query
  * @param packet_num The current packet sequence number
+ * @param rows       The number of rows in the insert
  *
  * @return The modified buffer
  */
-static GWBUF* convert_to_stream(GWBUF* buffer, uint8_t packet_num)
+static GWBUF* convert_to_stream(GWBUF* buffer, uint8_t packet_num, uint64_t* rows)
 {
     /** Remove the INSERT INTO ... from the buffer */
     char* dataptr = (char*)GWBUF_DATA(buffer);
@@ -440,6 +467,7 @@ static GWBUF* convert_to_stream(GWBUF* buffer, uint8_t packet_num)
         memmove(store_end, value, valuesize);
         store_end += valuesize;
         *store_end++ = '\n';
+        ++*rows;
     }
 
     gwbuf_rtrim(buffer, (char*)buffer->end - store_end);
@@ -465,6 +493,7 @@ static GWBUF* convert_to_stream(GWBUF* buffer, uint8_t packet_num)
  */
 static int32_t clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF* reply)
 {
+    DS_INSTANCE* my_instance = (DS_INSTANCE*) instance;
     DS_SESSION* my_session = (DS_SESSION*) session;
     int rc = 1;
 
@@ -486,6 +515,13 @@ static int32_t clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GW
             /** The request is packet 0 and the response is packet 1 so we'll
              * have to send the data in packet number 2 */
             my_session->packet_num++;
+            my_session->stream_start = time_in_us();
+        }
+        else
+        {
+            mxb::atomic::add(&my_instance->stream_us,
+                             time_in_us() - my_session->stream_start,
+                             mxb::atomic::RELAXED);
         }
 
         poll_add_epollin_event_to_dcb(my_session->client_dcb, queue);
@@ -523,6 +559,19 @@ static void diagnostic(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, DCB*
     {
         dcb_printf(dcb, "\t\tReplacement limit to user           %s\n", my_instance->user);
     }
+
+    uint64_t rows = mxb::atomic::load(&my_instance->n_rows, mxb::atomic::RELAXED);
+    uint64_t stream_us = mxb::atomic::load(&my_instance->stream_us, mxb::atomic::RELAXED);
+
+    dcb_printf(dcb, "\t\tStreams opened                      %lu\n",
+               mxb::atomic::load(&my_instance->n_streams, mxb::atomic::RELAXED));
+    dcb_printf(dcb, "\t\tInserts streamed                    %lu\n",
+               mxb::atomic::load(&my_instance->n_inserts, mxb::atomic::RELAXED));
+    dcb_printf(dcb, "\t\tRows streamed                       %lu\n", rows);
+    dcb_printf(dcb, "\t\tRows per second while streaming     %.1f\n",
+               stream_us ? rows * 1000000.0 / stream_us : 0.0);
+    dcb_printf(dcb, "\t\tBytes saved                         %ld\n",
+               mxb::atomic::load(&my_instance->bytes_saved, mxb::atomic::RELAXED));
 }
 
 /**
@@ -551,6 +600,18 @@ static json_t* diagnostic_json(const MXS_FILTER* instance, const MXS_FILTER_SESS
         json_object_set_new(rval, "user", json_string(my_instance->user));
     }
 
+    uint64_t rows = mxb::atomic::load(&my_instance->n_rows, mxb::atomic::RELAXED);
+    uint64_t stream_us = mxb::atomic::load(&my_instance->stream_us, mxb::atomic::RELAXED);
+
+    json_object_set_new(rval, "streams",
+                        json_integer(mxb::atomic::load(&my_instance->n_streams, mxb::atomic::RELAXED)));
+    json_object_set_new(rval, "inserts",
+                        json_integer(mxb::atomic::load(&my_instance->n_inserts, mxb::atomic::RELAXED)));
+    json_object_set_new(rval, "rows", json_integer(rows));
+    json_object_set_new(rval, "rows_per_second", json_real(stream_us ? rows * 1000000.0 / stream_us : 0));
+    json_object_set_new(rval, "bytes_saved",
+                        json_integer(mxb::atomic::load(&my_instance->bytes_saved, mxb::atomic::RELAXED)));
+
     return rval;
 }
 
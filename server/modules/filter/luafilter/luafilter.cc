@@ -34,6 +34,10 @@
  * is defined and valid, the matching entry point function in Lua will be called.
  * The same holds true for session script apart from no calls to createInstance
  * or diagnostic being made for the session script.
+ *
+ * The global script is either run in one Lua state shared by all threads or, if
+ * global_script_per_thread is enabled, in a separate Lua state in each routing
+ * worker. Counters shared by all states are available to both scripts.
  */
 
 #define MXS_MODULE_NAME "luafilter"
@@ -43,12 +47,18 @@
 #include <lua.h>
 #include <lualib.h>
 #include <string.h>
+#include <map>
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <maxbase/atomic.hh>
+#include <maxbase/semaphore.hh>
 #include <maxscale/alloc.h>
 #include <maxscale/filter.h>
 #include <maxscale/log.h>
 #include <maxscale/modutil.h>
 #include <maxscale/query_classifier.h>
+#include <maxscale/routingworker.hh>
 #include <maxscale/session.h>
 
 /*
@@ -115,6 +125,7 @@ extern "C"
             {
                 {"global_script",      MXS_MODULE_PARAM_PATH,  NULL, MXS_MODULE_OPT_PATH_R_OK},
                 {"session_script",     MXS_MODULE_PARAM_PATH,  NULL, MXS_MODULE_OPT_PATH_R_OK},
+                {"global_script_per_thread", MXS_MODULE_PARAM_BOOL, "false"},
                 {MXS_END_MODULE_PARAMS}
             }
         };
@@ -124,7 +135,6 @@ extern "C"
 }
 
 static int id_pool = 0;
-static GWBUF* current_global_query = NULL;
 
 /**
  * Push an unique integer to the Lua state's stack
@@ -195,15 +205,81 @@ static int lua_get_canonical(lua_State* state)
     return 1;
 }
 
+/**
+ * A Lua state running the global script
+ *
+ * A copy does not share the Lua state of the original, it starts without one.
+ */
+struct LuaGlobalState
+{
+    LuaGlobalState()
+        : state(NULL)
+        , current_query(NULL)
+        , initialized(false)
+    {
+    }
+
+    LuaGlobalState(const LuaGlobalState&)
+        : state(NULL)
+        , current_query(NULL)
+        , initialized(false)
+    {
+    }
+
+    LuaGlobalState& operator=(const LuaGlobalState&) = delete;
+
+    ~LuaGlobalState()
+    {
+        if (state)
+        {
+            lua_close(state);
+        }
+    }
+
+    lua_State* state;           /**< The Lua state, NULL if the script could not be loaded */
+    GWBUF*     current_query;   /**< The query being processed by the state */
+    bool       initialized;     /**< Whether the creation of the state has been attempted */
+};
+
+/**
+ * Counters shared by all Lua states of a filter instance
+ *
+ * The lock is only needed to find a counter, the values are updated atomically.
+ */
+class LuaSharedCounters
+{
+public:
+    /**
+     * Get a counter, created with the value 0 if it does not exist
+     *
+     * @param name Name of the counter
+     * @return Pointer to the value of the counter, valid for the lifetime of the object
+     */
+    int64_t* get(const std::string& name)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return &m_counters[name];
+    }
+
+private:
+    std::mutex                     m_lock;
+    std::map<std::string, int64_t> m_counters;
+};
+
+typedef std::unordered_map<std::string, int64_t*> CounterCache;
+
 /**
  * The Lua filter instance.
  */
 typedef struct
 {
-    lua_State* global_lua_state;
-    char*      global_script;
-    char*      session_script;
-    std::mutex lock;
+    LuaGlobalState                      global_state;   /**< The global script state shared by all threads */
+    mxs::rworker_local<LuaGlobalState>* worker_states;  /**< The global script states of the workers */
+    char*                               global_script;
+    char*                               session_script;
+    std::mutex                          lock;           /**< Protects global_state */
+    LuaSharedCounters                   counters;
+    mxs::rworker_local<CounterCache>    counter_cache;  /**< The counters already used by each worker */
 } LUA_INSTANCE;
 
 /**
@@ -218,7 +294,81 @@ typedef struct
     MXS_UPSTREAM   up;
 } LUA_SESSION;
 
-void expose_functions(lua_State* state, GWBUF** active_buffer)
+/**
+ * Find the shared counter named by the first argument of a Lua function
+ *
+ * @param state Lua state, the filter instance must be the first upvalue
+ * @return The value of the counter
+ */
+static int64_t* get_shared_counter(lua_State* state)
+{
+    LUA_INSTANCE* my_instance = (LUA_INSTANCE*)lua_touserdata(state, lua_upvalueindex(1));
+    const char* name = luaL_checkstring(state, 1);
+    int64_t* rval;
+
+    if (mxs::RoutingWorker::get_current())
+    {
+        CounterCache& cache = *my_instance->counter_cache;
+        auto it = cache.find(name);
+
+        if (it == cache.end())
+        {
+            it = cache.emplace(name, my_instance->counters.get(name)).first;
+        }
+
+        rval = it->second;
+    }
+    else
+    {
+        // Called while the filter is being created
+        rval = my_instance->counters.get(name);
+    }
+
+    return rval;
+}
+
+/**
+ * Add to a shared counter
+ *
+ * @param state Lua state, the arguments are the name of the counter and the value to add
+ * @return Always 1, the new value of the counter
+ */
+static int lua_shared_add(lua_State* state)
+{
+    lua_Integer value = luaL_checkinteger(state, 2);
+    int64_t* counter = get_shared_counter(state);
+    lua_pushinteger(state, mxb::atomic::add(counter, value, mxb::atomic::RELAXED) + value);
+    return 1;
+}
+
+/**
+ * Set the value of a shared counter
+ *
+ * @param state Lua state, the arguments are the name of the counter and the new value
+ * @return Always 0
+ */
+static int lua_shared_set(lua_State* state)
+{
+    lua_Integer value = luaL_checkinteger(state, 2);
+    int64_t* counter = get_shared_counter(state);
+    mxb::atomic::store(counter, value, mxb::atomic::RELAXED);
+    return 0;
+}
+
+/**
+ * Get the value of a shared counter
+ *
+ * @param state Lua state, the argument is the name of the counter
+ * @return Always 1, the value of the counter
+ */
+static int lua_shared_get(lua_State* state)
+{
+    int64_t* counter = get_shared_counter(state);
+    lua_pushinteger(state, mxb::atomic::load(counter, mxb::atomic::RELAXED));
+    return 1;
+}
+
+void expose_functions(lua_State* state, GWBUF** active_buffer, LUA_INSTANCE* my_instance)
 {
     /** Expose an ID generation function */
     lua_pushcfunction(state, id_gen);
@@ -236,6 +386,136 @@ void expose_functions(lua_State* state, GWBUF** active_buffer)
     lua_pushlightuserdata(state, active_buffer);
     lua_pushcclosure(state, lua_get_canonical, 1);
     lua_setglobal(state, "lua_get_canonical");
+
+    /** Expose the counters shared by all Lua states of the instance */
+    lua_pushlightuserdata(state, my_instance);
+    lua_pushcclosure(state, lua_shared_add, 1);
+    lua_setglobal(state, "shared_add");
+
+    lua_pushlightuserdata(state, my_instance);
+    lua_pushcclosure(state, lua_shared_set, 1);
+    lua_setglobal(state, "shared_set");
+
+    lua_pushlightuserdata(state, my_instance);
+    lua_pushcclosure(state, lua_shared_get, 1);
+    lua_setglobal(state, "shared_get");
+}
+
+/**
+ * Create a Lua state for the global script
+ *
+ * The script is executed once on a global level before calling the createInstance
+ * function in the Lua script.
+ *
+ * @param my_instance   The filter instance
+ * @param current_query Where the query being processed by the state is stored
+ * @return The new Lua state or NULL on error
+ */
+static lua_State* create_global_state(LUA_INSTANCE* my_instance, GWBUF** current_query)
+{
+    lua_State* state = luaL_newstate();
+
+    if (state)
+    {
+        luaL_openlibs(state);
+        expose_functions(state, current_query, my_instance);
+
+        if (luaL_dofile(state, my_instance->global_script))
+        {
+            MXS_ERROR("Failed to execute global script at '%s':%s.",
+                      my_instance->global_script,
+                      lua_tostring(state, -1));
+            lua_close(state);
+            state = NULL;
+        }
+        else
+        {
+            lua_getglobal(state, "createInstance");
+
+            if (lua_pcall(state, 0, 0, 0))
+            {
+                MXS_WARNING("Failed to get global variable 'createInstance':  %s."
+                            " The createInstance entry point will not be called for the global script.",
+                            lua_tostring(state, -1));
+                lua_pop(state, -1);     // Pop the error off the stack
+            }
+        }
+    }
+    else
+    {
+        MXS_ERROR("Unable to initialize new Lua state.");
+    }
+
+    return state;
+}
+
+/**
+ * Check that the global script can be loaded, without executing it
+ *
+ * @param script Path to the script
+ * @return True if the script was compiled successfully
+ */
+static bool check_global_script(const char* script)
+{
+    bool rval = false;
+    lua_State* state = luaL_newstate();
+
+    if (state)
+    {
+        if (luaL_loadfile(state, script))
+        {
+            MXS_ERROR("Failed to load global script at '%s':%s.", script, lua_tostring(state, -1));
+        }
+        else
+        {
+            rval = true;
+        }
+
+        lua_close(state);
+    }
+    else
+    {
+        MXS_ERROR("Unable to initialize new Lua state.");
+    }
+
+    return rval;
+}
+
+/**
+ * Get the state of the global script for the calling thread
+ *
+ * With a state per thread, the state of the worker is created when it is first needed.
+ *
+ * @param my_instance The filter instance
+ * @param guard       Locked if the state is shared by all threads
+ * @return The state or NULL if there is no global script
+ */
+static LuaGlobalState* get_global_state(LUA_INSTANCE* my_instance, std::unique_lock<std::mutex>& guard)
+{
+    LuaGlobalState* rval = NULL;
+
+    if (my_instance->worker_states)
+    {
+        LuaGlobalState& global = **my_instance->worker_states;
+
+        if (!global.initialized)
+        {
+            global.initialized = true;
+            global.state = create_global_state(my_instance, &global.current_query);
+        }
+
+        if (global.state)
+        {
+            rval = &global;
+        }
+    }
+    else if (my_instance->global_state.state)
+    {
+        guard = std::unique_lock<std::mutex>(my_instance->lock);
+        rval = &my_instance->global_state;
+    }
+
+    return rval;
 }
 
 /**
@@ -258,43 +538,34 @@ static MXS_FILTER* createInstance(const char* name, MXS_CONFIG_PARAMETER* params
 
     my_instance->global_script = config_copy_string(params, "global_script");
     my_instance->session_script = config_copy_string(params, "session_script");
-    my_instance->global_lua_state = nullptr;
+    my_instance->worker_states = NULL;
 
     if (my_instance->global_script)
     {
-        if ((my_instance->global_lua_state = luaL_newstate()))
+        bool ok;
+
+        if (config_get_bool(params, "global_script_per_thread"))
         {
-            luaL_openlibs(my_instance->global_lua_state);
+            // The states are created by the workers when they are first needed
+            ok = check_global_script(my_instance->global_script);
 
-            if (luaL_dofile(my_instance->global_lua_state, my_instance->global_script))
+            if (ok)
             {
-                MXS_ERROR("Failed to execute global script at '%s':%s.",
-                          my_instance->global_script,
-                          lua_tostring(my_instance->global_lua_state, -1));
-                MXS_FREE(my_instance->global_script);
-                MXS_FREE(my_instance->session_script);
-                MXS_FREE(my_instance);
-                my_instance = NULL;
-            }
-            else if (my_instance->global_lua_state)
-            {
-                lua_getglobal(my_instance->global_lua_state, "createInstance");
-
-                if (lua_pcall(my_instance->global_lua_state, 0, 0, 0))
-                {
-                    MXS_WARNING("Failed to get global variable 'createInstance':  %s."
-                                " The createInstance entry point will not be called for the global script.",
-                                lua_tostring(my_instance->global_lua_state, -1));
-                    lua_pop(my_instance->global_lua_state, -1);     // Pop the error off the stack
-                }
-
-                expose_functions(my_instance->global_lua_state, &current_global_query);
+                my_instance->worker_states = new mxs::rworker_local<LuaGlobalState>();
             }
         }
         else
         {
-            MXS_ERROR("Unable to initialize new Lua state.");
-            MXS_FREE(my_instance);
+            my_instance->global_state.state = create_global_state(my_instance,
+                                                                  &my_instance->global_state.current_query);
+            ok = my_instance->global_state.state;
+        }
+
+        if (!ok)
+        {
+            MXS_FREE(my_instance->global_script);
+            MXS_FREE(my_instance->session_script);
+            delete my_instance;
             my_instance = NULL;
         }
     }
@@ -346,7 +617,7 @@ static MXS_FILTER_SESSION* newSession(MXS_FILTER* instance, MXS_SESSION* session
         }
         else
         {
-            expose_functions(my_session->lua_state, &my_session->current_query);
+            expose_functions(my_session->lua_state, &my_session->current_query, my_instance);
 
             /** Call the newSession entry point */
             lua_getglobal(my_session->lua_state, "newSession");
@@ -363,20 +634,21 @@ static MXS_FILTER_SESSION* newSession(MXS_FILTER* instance, MXS_SESSION* session
         }
     }
 
-    if (my_session && my_instance->global_lua_state)
-    {
-        std::lock_guard<std::mutex> guard(my_instance->lock);
+    std::unique_lock<std::mutex> guard;
+    LuaGlobalState* global;
 
-        lua_getglobal(my_instance->global_lua_state, "newSession");
-        lua_pushstring(my_instance->global_lua_state, session->client_dcb->user);
-        lua_pushstring(my_instance->global_lua_state, session->client_dcb->remote);
+    if (my_session && (global = get_global_state(my_instance, guard)))
+    {
+        lua_getglobal(global->state, "newSession");
+        lua_pushstring(global->state, session->client_dcb->user);
+        lua_pushstring(global->state, session->client_dcb->remote);
 
-        if (lua_pcall(my_instance->global_lua_state, 2, 0, 0))
+        if (lua_pcall(global->state, 2, 0, 0))
         {
             MXS_WARNING("Failed to get global variable 'newSession': '%s'."
                         " The newSession entry point will not be called for the global script.",
-                        lua_tostring(my_instance->global_lua_state, -1));
-            lua_pop(my_instance->global_lua_state, -1);     // Pop the error off the stack
+                        lua_tostring(global->state, -1));
+            lua_pop(global->state, -1);     // Pop the error off the stack
         }
     }
 
@@ -395,7 +667,7 @@ static void closeSession(MXS_FILTER* instance, MXS_FILTER_SESSION* session)
 {
     LUA_SESSION* my_session = (LUA_SESSION*) session;
     LUA_INSTANCE* my_instance = (LUA_INSTANCE*) instance;
-
+    std::unique_lock<std::mutex> guard;
 
     if (my_session->lua_state)
     {
@@ -410,18 +682,16 @@ static void closeSession(MXS_FILTER* instance, MXS_FILTER_SESSION* session)
         }
     }
 
-    if (my_instance->global_lua_state)
+    if (LuaGlobalState* global = get_global_state(my_instance, guard))
     {
-        std::lock_guard<std::mutex> guard(my_instance->lock);
-
-        lua_getglobal(my_instance->global_lua_state, "closeSession");
+        lua_getglobal(global->state, "closeSession");
 
-        if (lua_pcall(my_instance->global_lua_state, 0, 0, 0))
+        if (lua_pcall(global->state, 0, 0, 0))
         {
             MXS_WARNING("Failed to get global variable 'closeSession': '%s'."
                         " The closeSession entry point will not be called for the global script.",
-                        lua_tostring(my_instance->global_lua_state, -1));
-            lua_pop(my_instance->global_lua_state, -1);
+                        lua_tostring(global->state, -1));
+            lua_pop(global->state, -1);
         }
     }
 }
@@ -496,17 +766,19 @@ static int32_t clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GW
         }
     }
 
-    if (my_instance->global_lua_state)
     {
-        std::lock_guard<std::mutex> guard(my_instance->lock);
-
-        lua_getglobal(my_instance->global_lua_state, "clientReply");
+        std::unique_lock<std::mutex> guard;
 
-        if (lua_pcall(my_instance->global_lua_state, 0, 0, 0))
+        if (LuaGlobalState* global = get_global_state(my_instance, guard))
         {
-            MXS_ERROR("Global scope call to 'clientReply' failed: '%s'.",
-                      lua_tostring(my_session->lua_state, -1));
-            lua_pop(my_instance->global_lua_state, -1);
+            lua_getglobal(global->state, "clientReply");
+
+            if (lua_pcall(global->state, 0, 0, 0))
+            {
+                MXS_ERROR("Global scope call to 'clientReply' failed: '%s'.",
+                          lua_tostring(global->state, -1));
+                lua_pop(global->state, -1);
+            }
         }
     }
 
@@ -577,35 +849,37 @@ static int32_t routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWB
             my_session->current_query = NULL;
         }
 
-        if (my_instance->global_lua_state)
+        std::unique_lock<std::mutex> guard;
+        LuaGlobalState* global;
+
+        if (fullquery && (global = get_global_state(my_instance, guard)))
         {
-            std::lock_guard<std::mutex> guard(my_instance->lock);
-            current_global_query = queue;
+            global->current_query = queue;
 
-            lua_getglobal(my_instance->global_lua_state, "routeQuery");
+            lua_getglobal(global->state, "routeQuery");
 
-            lua_pushlstring(my_instance->global_lua_state, fullquery, strlen(fullquery));
+            lua_pushlstring(global->state, fullquery, strlen(fullquery));
 
-            if (lua_pcall(my_instance->global_lua_state, 1, 1, 0))
+            if (lua_pcall(global->state, 1, 1, 0))
             {
                 MXS_ERROR("Global scope call to 'routeQuery' failed: '%s'.",
-                          lua_tostring(my_instance->global_lua_state, -1));
-                lua_pop(my_instance->global_lua_state, -1);
+                          lua_tostring(global->state, -1));
+                lua_pop(global->state, -1);
             }
-            else if (lua_gettop(my_instance->global_lua_state))
+            else if (lua_gettop(global->state))
             {
-                if (lua_isstring(my_instance->global_lua_state, -1))
+                if (lua_isstring(global->state, -1))
                 {
                     gwbuf_free(forward);
-                    forward = modutil_create_query(lua_tostring(my_instance->global_lua_state, -1));
+                    forward = modutil_create_query(lua_tostring(global->state, -1));
                 }
-                else if (lua_isboolean(my_instance->global_lua_state, -1))
+                else if (lua_isboolean(global->state, -1))
                 {
-                    route = lua_toboolean(my_instance->global_lua_state, -1);
+                    route = lua_toboolean(global->state, -1);
                 }
             }
 
-            current_global_query = NULL;
+            global->current_query = NULL;
         }
 
         MXS_FREE(fullquery);
@@ -628,6 +902,93 @@ static int32_t routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWB
     return rc;
 }
 
+/**
+ * Call the diagnostic entry point of a global script state
+ *
+ * @param state  The Lua state
+ * @param output The string returned by the function or the error message
+ * @return True if the call succeeded
+ */
+static bool call_diagnostic(lua_State* state, std::string* output)
+{
+    bool rval = false;
+
+    lua_getglobal(state, "diagnostic");
+
+    if (lua_pcall(state, 0, 1, 0) == 0)
+    {
+        if (lua_isstring(state, -1))
+        {
+            *output = lua_tostring(state, -1);
+        }
+        rval = true;
+    }
+    else
+    {
+        *output = lua_tostring(state, -1);
+        lua_pop(state, -1);
+    }
+
+    return rval;
+}
+
+/**
+ * Call the diagnostic entry point of the global script
+ *
+ * With a state per thread, the entry point is called in every routing worker
+ * and the outputs are separated by newlines.
+ *
+ * @param my_instance The filter instance
+ * @param output      The output of the script or the error messages
+ * @return True if all calls succeeded
+ */
+static bool global_diagnostic(LUA_INSTANCE* my_instance, std::string* output)
+{
+    bool rval = true;
+
+    if (my_instance->worker_states)
+    {
+        std::mutex lock;
+        mxb::Semaphore sem;
+
+        auto n = mxs::RoutingWorker::broadcast([&]() {
+                                                   std::unique_lock<std::mutex> guard;
+                                                   LuaGlobalState* global = get_global_state(my_instance,
+                                                                                             guard);
+                                                   std::string worker_output;
+
+                                                   if (global)
+                                                   {
+                                                       bool ok = call_diagnostic(global->state,
+                                                                                 &worker_output);
+                                                       std::lock_guard<std::mutex> output_guard(lock);
+
+                                                       if (!output->empty() && !worker_output.empty())
+                                                       {
+                                                           *output += "\n";
+                                                       }
+
+                                                       *output += worker_output;
+                                                       rval = rval && ok;
+                                                   }
+                                               },
+                                               &sem,
+                                               mxs::RoutingWorker::EXECUTE_AUTO);
+        sem.wait_n(n);
+    }
+    else
+    {
+        std::unique_lock<std::mutex> guard;
+
+        if (LuaGlobalState* global = get_global_state(my_instance, guard))
+        {
+            rval = call_diagnostic(global->state, output);
+        }
+    }
+
+    return rval;
+}
+
 /**
  * Diagnostics routine.
  *
@@ -643,18 +1004,15 @@ static void diagnostic(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, DCB*
 
     if (my_instance)
     {
-        if (my_instance->global_lua_state)
+        if (my_instance->global_script)
         {
-            std::lock_guard<std::mutex> guard(my_instance->lock);
-
-            lua_getglobal(my_instance->global_lua_state, "diagnostic");
+            std::string output;
 
-            if (lua_pcall(my_instance->global_lua_state, 0, 1, 0) == 0)
+            if (global_diagnostic(my_instance, &output))
             {
-                lua_gettop(my_instance->global_lua_state);
-                if (lua_isstring(my_instance->global_lua_state, -1))
+                if (!output.empty())
                 {
-                    dcb_printf(dcb, "%s", lua_tostring(my_instance->global_lua_state, -1));
+                    dcb_printf(dcb, "%s", output.c_str());
                     dcb_printf(dcb, "\n");
                 }
             }
@@ -662,8 +1020,7 @@ static void diagnostic(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, DCB*
             {
                 dcb_printf(dcb,
                            "Global scope call to 'diagnostic' failed: '%s'.\n",
-                           lua_tostring(my_instance->global_lua_state, -1));
-                lua_pop(my_instance->global_lua_state, -1);
+                           output.c_str());
             }
         }
         if (my_instance->global_script)
@@ -693,30 +1050,16 @@ static json_t* diagnostic_json(const MXS_FILTER* instance, const MXS_FILTER_SESS
 
     if (my_instance)
     {
-        if (my_instance->global_lua_state)
-        {
-            std::lock_guard<std::mutex> guard(my_instance->lock);
+        std::string output;
 
-            lua_getglobal(my_instance->global_lua_state, "diagnostic");
-
-            if (lua_pcall(my_instance->global_lua_state, 0, 1, 0) == 0)
-            {
-                lua_gettop(my_instance->global_lua_state);
-                if (lua_isstring(my_instance->global_lua_state, -1))
-                {
-                    json_object_set_new(rval,
-                                        "script_output",
-                                        json_string(lua_tostring(my_instance->global_lua_state, -1)));
-                }
-            }
-            else
-            {
-                lua_pop(my_instance->global_lua_state, -1);
-            }
+        if (my_instance->global_script && global_diagnostic(my_instance, &output) && !output.empty())
+        {
+            json_object_set_new(rval, "script_output", json_string(output.c_str()));
         }
         if (my_instance->global_script)
         {
             json_object_set_new(rval, "global_script", json_string(my_instance->global_script));
+            json_object_set_new(rval, "global_script_per_thread", json_boolean(my_instance->worker_states));
         }
         if (my_instance->session_script)
         {
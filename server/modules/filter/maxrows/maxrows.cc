@@ -142,6 +142,11 @@ extern "C"
                     MXS_MODULE_OPT_ENUM_UNIQUE,
                     return_option_values
                 },
+                {
+                    "max_resultset_stream",
+                    MXS_MODULE_PARAM_BOOL,
+                    "false"
+                },
                 {MXS_END_MODULE_PARAMS}
             }
         };
@@ -158,6 +163,7 @@ typedef struct maxrows_config
     uint32_t                 max_resultset_size;
     uint32_t                 debug;
     enum maxrows_return_mode m_return;
+    bool                     stream;
 } MAXROWS_CONFIG;
 
 typedef struct maxrows_instance
@@ -184,6 +190,9 @@ typedef struct maxrows_response_state
     size_t offset;          /**< Where we are in the response buffer. */
     size_t length;          /**< Buffer size. */
     GWBUF* column_defs;     /**< Buffer with result set columns definitions */
+    size_t n_bytes;         /**< How many bytes have been streamed to the client. */
+    uint8_t last_seq;       /**< Sequence number of the last packet streamed to the client. */
+    uint16_t eof_status;    /**< Status flags of the EOF after the column definitions. */
 } MAXROWS_RESPONSE_STATE;
 
 static void maxrows_response_state_reset(MAXROWS_RESPONSE_STATE* state);
@@ -210,6 +219,7 @@ static int  handle_expecting_nothing(MAXROWS_SESSION_DATA* csdata);
 static int  handle_expecting_response(MAXROWS_SESSION_DATA* csdata);
 static int  handle_rows(MAXROWS_SESSION_DATA* csdata, GWBUF* buffer, size_t extra_offset);
 static int  handle_ignoring_response(MAXROWS_SESSION_DATA* csdata);
+static int  handle_streaming(MAXROWS_SESSION_DATA* csdata, GWBUF* data);
 static bool process_params(char** options,
                            MXS_CONFIG_PARAMETER* params,
                            MAXROWS_CONFIG* config);
@@ -219,6 +229,9 @@ static int send_eof_upstream(MAXROWS_SESSION_DATA* csdata);
 static int send_error_upstream(MAXROWS_SESSION_DATA* csdata);
 static int send_maxrows_reply_limit(MAXROWS_SESSION_DATA* csdata);
 
+static GWBUF* create_eof_packet(uint8_t seq, uint16_t status);
+static GWBUF* create_error_packet(MAXROWS_SESSION_DATA* csdata, uint8_t seq);
+
 /* API BEGIN */
 
 /**
@@ -247,6 +260,7 @@ static MXS_FILTER* createInstance(const char* name, MXS_CONFIG_PARAMETER* params
                                                              "max_resultset_return",
                                                              return_option_values));
         cinstance->config.debug = config_get_integer(params, "debug");
+        cinstance->config.stream = config_get_bool(params, "max_resultset_stream");
     }
 
     return (MXS_FILTER*)cinstance;
@@ -409,6 +423,11 @@ static int clientReply(MXS_FILTER* instance,
 
     int rv;
 
+    if (csdata->instance->config.stream)
+    {
+        return handle_streaming(csdata, data);
+    }
+
     if (csdata->res.data)
     {
         if (csdata->discard_resultset
@@ -542,6 +561,9 @@ static void maxrows_response_state_reset(MAXROWS_RESPONSE_STATE* state)
     state->n_rows = 0;
     state->offset = 0;
     state->column_defs = NULL;
+    state->n_bytes = 0;
+    state->last_seq = 0;
+    state->eof_status = SERVER_STATUS_AUTOCOMMIT;
 }
 
 /**
@@ -1020,6 +1042,229 @@ static int handle_rows(MAXROWS_SESSION_DATA* csdata, GWBUF* buffer, size_t extra
     return rv;
 }
 
+/**
+ * Terminate a streamed resultset because a limit was hit.
+ *
+ * The rows already streamed remain with the client. The resultset is ended with
+ * an EOF packet, or with an ERR packet if max_resultset_return is 'error', and
+ * the rest of the response is discarded.
+ *
+ * @param csdata The maxrows session data.
+ * @param reply  The data to be sent to the client, the terminating packet is appended to it.
+ */
+static void stream_cut(MAXROWS_SESSION_DATA* csdata, GWBUF** reply)
+{
+    if (csdata->instance->config.debug & MAXROWS_DEBUG_DISCARDING)
+    {
+        MXS_INFO("Limit reached after %lu rows and %lu bytes, not returning the rest of the resultset.",
+                 csdata->res.n_rows,
+                 csdata->res.n_bytes);
+    }
+
+    csdata->discard_resultset = true;
+
+    uint8_t seq = csdata->res.last_seq + 1;
+    GWBUF* terminator = csdata->instance->config.m_return == MAXROWS_RETURN_ERR ?
+        create_error_packet(csdata, seq) : create_eof_packet(seq, csdata->res.eof_status);
+
+    if (terminator)
+    {
+        *reply = gwbuf_append(*reply, terminator);
+    }
+    else
+    {
+        /* Abort client connection */
+        poll_fake_hangup_event(csdata->session->client_dcb);
+    }
+}
+
+/**
+ * Process one complete packet of a streamed response.
+ *
+ * @param csdata The maxrows session data.
+ * @param packet The packet, freed or appended to @c reply.
+ * @param reply  The data to be sent to the client.
+ */
+static void stream_packet(MAXROWS_SESSION_DATA* csdata, GWBUF* packet, GWBUF** reply)
+{
+    // Enough for the status flags of an OK packet
+    uint8_t header[MYSQL_HEADER_LEN + 1 + 9 + 9 + 2];
+    gwbuf_copy_data(packet, 0, sizeof(header), header);
+
+    size_t payload_len = MYSQL_GET_PAYLOAD_LEN(header);
+    int command = (int)MYSQL_GET_COMMAND(header);
+
+    // A packet following one of the maximum size continues it
+    bool continuation = csdata->large_packet;
+    csdata->large_packet = (payload_len == MYSQL_PACKET_LENGTH_MAX);
+
+    if (continuation)
+    {
+        // The packet is streamed or discarded like the packet it continues
+    }
+    else if (csdata->state == MAXROWS_EXPECTING_RESPONSE)
+    {
+        switch (command)
+        {
+        case 0x00:      // OK
+        case 0xff:      // ERR
+        case 0xfb:      // GET_MORE_CLIENT_DATA/SEND_MORE_CLIENT_DATA
+            if (command == 0x00)
+            {
+                // Skip the affected rows and the last insert id
+                uint8_t* ptr = header + MYSQL_HEADER_LEN + 1;
+                ptr += mxs_leint_bytes(ptr);
+                ptr += mxs_leint_bytes(ptr);
+
+                if (gw_mysql_get_byte2(ptr) & SERVER_MORE_RESULTS_EXIST)
+                {
+                    // More results follow, keep on checking them
+                    break;
+                }
+            }
+
+            csdata->state = MAXROWS_IGNORING_RESPONSE;
+
+            if (csdata->discard_resultset)
+            {
+                // The client already got the end of the response.
+                csdata->discard_resultset = false;
+                gwbuf_free(packet);
+                return;
+            }
+            break;
+
+        default:
+            csdata->res.n_totalfields = mxs_leint_value(&header[MYSQL_HEADER_LEN]);
+            csdata->res.n_fields = 0;
+            csdata->state = MAXROWS_EXPECTING_FIELDS;
+            break;
+        }
+    }
+    else if (csdata->state == MAXROWS_EXPECTING_FIELDS)
+    {
+        if (csdata->res.n_fields < csdata->res.n_totalfields)
+        {
+            ++csdata->res.n_fields;
+        }
+        else
+        {
+            // The EOF after the fields. Its status is what the server would end the
+            // resultset with, except that no further resultsets follow a cut one.
+            uint16_t flags = gw_mysql_get_byte2(header + MAXROWS_MYSQL_EOF_PACKET_FLAGS_OFFSET);
+            csdata->res.eof_status = flags & ~SERVER_MORE_RESULTS_EXIST;
+            csdata->state = MAXROWS_EXPECTING_ROWS;
+        }
+    }
+    else if ((command == 0xfe && payload_len < 9) || command == 0xff)
+    {
+        // EOF or ERR after the rows. A row starting with 0xfe is at least 9 bytes long.
+        int flags = command == 0xfe ? gw_mysql_get_byte2(header + MAXROWS_MYSQL_EOF_PACKET_FLAGS_OFFSET) : 0;
+
+        if (csdata->instance->config.debug & MAXROWS_DEBUG_DECISIONS)
+        {
+            MXS_NOTICE("End of streamed resultset with %lu rows.%s",
+                       csdata->res.n_rows,
+                       csdata->discard_resultset ? " [Cut]" : "");
+        }
+
+        if (flags & SERVER_MORE_RESULTS_EXIST)
+        {
+            csdata->state = MAXROWS_EXPECTING_RESPONSE;
+        }
+        else if (csdata->discard_resultset)
+        {
+            // The client already got the end of the response.
+            csdata->state = MAXROWS_IGNORING_RESPONSE;
+            csdata->discard_resultset = false;
+            gwbuf_free(packet);
+            return;
+        }
+        else
+        {
+            csdata->state = MAXROWS_IGNORING_RESPONSE;
+        }
+    }
+    else
+    {
+        // A row. The size of a row larger than a packet is checked against
+        // its first packet, a row is never split.
+        ++csdata->res.n_rows;
+
+        if (!csdata->discard_resultset
+            && (csdata->res.n_rows > csdata->instance->config.max_resultset_rows
+                || csdata->res.n_bytes + gwbuf_length(packet) > csdata->instance->config.max_resultset_size))
+        {
+            stream_cut(csdata, reply);
+        }
+    }
+
+    if (csdata->discard_resultset)
+    {
+        gwbuf_free(packet);
+    }
+    else
+    {
+        csdata->res.n_bytes += gwbuf_length(packet);
+        csdata->res.last_seq = header[MYSQL_SEQ_OFFSET];
+        *reply = gwbuf_append(*reply, packet);
+    }
+}
+
+/**
+ * Called when data is received from the server in streaming mode.
+ *
+ * Complete packets are sent to the client as they arrive, only an incomplete
+ * packet is kept until the rest of it arrives.
+ *
+ * @param csdata The maxrows session data.
+ * @param data   The received data.
+ *
+ * @return The return value of the upstream component
+ */
+static int handle_streaming(MAXROWS_SESSION_DATA* csdata, GWBUF* data)
+{
+    int rv = 1;
+    GWBUF* reply = NULL;
+
+    csdata->res.data = gwbuf_append(csdata->res.data, data);
+
+    while (csdata->state != MAXROWS_IGNORING_RESPONSE
+           && csdata->state != MAXROWS_EXPECTING_NOTHING)
+    {
+        GWBUF* packet = modutil_get_next_MySQL_packet(&csdata->res.data);
+
+        if (!packet)
+        {
+            // We need more data
+            break;
+        }
+
+        stream_packet(csdata, packet, &reply);
+    }
+
+    if (csdata->state == MAXROWS_IGNORING_RESPONSE
+        || csdata->state == MAXROWS_EXPECTING_NOTHING)
+    {
+        // The rest of the response is not inspected
+        reply = gwbuf_append(reply, csdata->res.data);
+        csdata->res.data = NULL;
+        csdata->large_packet = false;
+
+        gwbuf_free(csdata->input_sql);
+        csdata->input_sql = NULL;
+    }
+
+    if (reply)
+    {
+        rv = csdata->up.clientReply(csdata->up.instance,
+                                    csdata->up.session,
+                                    reply);
+    }
+
+    return rv;
+}
+
 /**
  * Called when all data from the server is ignored.
  *
@@ -1143,6 +1388,23 @@ static int send_eof_upstream(MAXROWS_SESSION_DATA* csdata)
     return rv;
 }
 
+/**
+ * Create an EOF packet.
+ *
+ * @param seq     The sequence number of the packet
+ * @param status  The server status flags of the packet
+ *
+ * @return        The packet or NULL on memory allocation failure
+ */
+static GWBUF* create_eof_packet(uint8_t seq, uint16_t status)
+{
+    uint8_t eof[MYSQL_EOF_PACKET_LEN] = {05, 00, 00, 01, 0xfe, 00, 00, 00, 00};
+    eof[MYSQL_SEQ_OFFSET] = seq;
+    gw_mysql_set_byte2(eof + MAXROWS_MYSQL_EOF_PACKET_FLAGS_OFFSET, status);
+
+    return gwbuf_alloc_and_load(MYSQL_EOF_PACKET_LEN, eof);
+}
+
 /**
  * Send OK packet data upstream.
  *
@@ -1194,9 +1456,51 @@ static int send_ok_upstream(MAXROWS_SESSION_DATA* csdata)
  * @return            Non-Zero if successful, 0 on errors
  */
 static int send_error_upstream(MAXROWS_SESSION_DATA* csdata)
+{
+    mxb_assert(csdata->res.data != NULL);
+
+    /* Note: sequence id is always 01 */
+    GWBUF* err_pkt = create_error_packet(csdata, 1);
+
+    if (!err_pkt)
+    {
+        /* Abort client connection */
+        poll_fake_hangup_event(csdata->session->client_dcb);
+        gwbuf_free(csdata->res.data);
+        gwbuf_free(csdata->input_sql);
+        csdata->res.data = NULL;
+        csdata->input_sql = NULL;
+
+        return 0;
+    }
+
+    int rv = csdata->up.clientReply(csdata->up.instance,
+                                    csdata->up.session,
+                                    err_pkt);
+
+    /* Free server result buffer */
+    gwbuf_free(csdata->res.data);
+    csdata->res.data = NULL;
+
+    /* Free input_sql buffer */
+    gwbuf_free(csdata->input_sql);
+    csdata->input_sql = NULL;
+
+    return rv;
+}
+
+/**
+ * Create the ERR packet sent when a limit is hit
+ *
+ * The error message consists of a prefix and the original SQL input.
+ *
+ * @param   csdata    Session data
+ * @param   seq       The sequence number of the packet
+ * @return            The packet or NULL on error
+ */
+static GWBUF* create_error_packet(MAXROWS_SESSION_DATA* csdata, uint8_t seq)
 {
     GWBUF* err_pkt;
-    uint8_t hdr_err[MYSQL_ERR_PACKET_MIN_LEN];
     unsigned long bytes_copied;
     const char* err_msg_prefix = "Row limit/size exceeded for query: ";
     int err_prefix_len = strlen(err_msg_prefix);
@@ -1211,8 +1515,6 @@ static int send_error_upstream(MAXROWS_SESSION_DATA* csdata)
         MAXROWS_INPUT_SQL_MAX_LEN : sql_len;
     uint8_t sql[sql_len];
 
-    mxb_assert(csdata->res.data != NULL);
-
     pkt_len += sql_len;
 
     bytes_copied = gwbuf_copy_data(csdata->input_sql,
@@ -1223,25 +1525,17 @@ static int send_error_upstream(MAXROWS_SESSION_DATA* csdata)
     if (!bytes_copied
         || (err_pkt = gwbuf_alloc(MYSQL_HEADER_LEN + pkt_len)) == NULL)
     {
-        /* Abort client connection */
-        poll_fake_hangup_event(csdata->session->client_dcb);
-        gwbuf_free(csdata->res.data);
-        gwbuf_free(csdata->input_sql);
-        csdata->res.data = NULL;
-        csdata->input_sql = NULL;
-
-        return 0;
+        return NULL;
     }
 
     uint8_t* ptr = GWBUF_DATA(err_pkt);
-    memcpy(ptr, &hdr_err, MYSQL_ERR_PACKET_MIN_LEN);
     unsigned int err_errno = 1415;
     char err_state[7] = "#0A000";
 
     /* Set the payload length of the whole error message */
     gw_mysql_set_byte3(&ptr[0], pkt_len);
-    /* Note: sequence id is always 01 (4th byte) */
-    ptr[3] = 1;
+    /* Sequence id */
+    ptr[3] = seq;
     /* Error indicator */
     ptr[4] = 0xff;
     /* MySQL error code: 2 bytes */
@@ -1253,19 +1547,7 @@ static int send_error_upstream(MAXROWS_SESSION_DATA* csdata)
     /* Copy SQL input */
     memcpy(&ptr[13 + err_prefix_len], sql, sql_len);
 
-    int rv = csdata->up.clientReply(csdata->up.instance,
-                                    csdata->up.session,
-                                    err_pkt);
-
-    /* Free server result buffer */
-    gwbuf_free(csdata->res.data);
-    csdata->res.data = NULL;
-
-    /* Free input_sql buffer */
-    gwbuf_free(csdata->input_sql);
-    csdata->input_sql = NULL;
-
-    return rv;
+    return err_pkt;
 }
 
 /**
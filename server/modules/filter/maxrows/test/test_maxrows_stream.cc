@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+// The streaming functions are internal to the filter
+#include "../maxrows.cc"
+
+#include <iostream>
+#include <vector>
+
+using std::cout;
+
+namespace
+{
+
+GWBUF* client_reply = NULL;
+
+int capture_reply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF* reply)
+{
+    client_reply = gwbuf_append(client_reply, reply);
+    return 1;
+}
+
+void add_packet(std::vector<uint8_t>* data, uint8_t seq, const std::vector<uint8_t>& payload)
+{
+    uint8_t header[MYSQL_HEADER_LEN];
+    gw_mysql_set_byte3(header, payload.size());
+    header[MYSQL_SEQ_OFFSET] = seq;
+
+    data->insert(data->end(), header, header + sizeof(header));
+    data->insert(data->end(), payload.begin(), payload.end());
+}
+
+std::vector<uint8_t> eof_payload(uint16_t status)
+{
+    return {0xfe, 0x00, 0x00, (uint8_t)(status & 0xff), (uint8_t)(status >> 8)};
+}
+
+/**
+ * Create a resultset with one column
+ *
+ * @param n_rows      Number of rows
+ * @param eof_status  Status of the EOF packets
+ *
+ * @return The resultset
+ */
+std::vector<uint8_t> create_resultset(int n_rows, uint16_t eof_status)
+{
+    std::vector<uint8_t> data;
+    uint8_t seq = 1;
+
+    add_packet(&data, seq++, {0x01});
+    add_packet(&data, seq++, {0x03, 'd', 'e', 'f', 0x00, 0x00, 0x00, 0x01, 'a', 0x00});
+    add_packet(&data, seq++, eof_payload(eof_status));
+
+    for (int i = 0; i < n_rows; i++)
+    {
+        add_packet(&data, seq++, {0x01, '1'});
+    }
+
+    add_packet(&data, seq++, eof_payload(eof_status));
+
+    return data;
+}
+
+/**
+ * Stream a resultset through the filter
+ *
+ * @param max_rows  The max_resultset_rows of the filter
+ * @param data      The response of the server
+ * @param split     Into how many parts the response is split
+ *
+ * @return The response sent to the client, as individual packets
+ */
+std::vector<std::vector<uint8_t>> stream(uint32_t max_rows, const std::vector<uint8_t>& data, size_t split)
+{
+    MAXROWS_INSTANCE instance = {};
+    instance.name = "maxrows";
+    instance.config.max_resultset_rows = max_rows;
+    instance.config.max_resultset_size = 65536;
+    instance.config.m_return = MAXROWS_RETURN_EMPTY;
+    instance.config.stream = true;
+
+    MAXROWS_SESSION_DATA csdata = {};
+    csdata.instance = &instance;
+    csdata.up.clientReply = capture_reply;
+    maxrows_response_state_reset(&csdata.res);
+    csdata.state = MAXROWS_EXPECTING_RESPONSE;
+
+    size_t part = data.size() / split + 1;
+
+    for (size_t offset = 0; offset < data.size(); offset += part)
+    {
+        size_t len = std::min(part, data.size() - offset);
+        handle_streaming(&csdata, gwbuf_alloc_and_load(len, &data[offset]));
+    }
+
+    std::vector<std::vector<uint8_t>> packets;
+
+    while (GWBUF* packet = modutil_get_next_MySQL_packet(&client_reply))
+    {
+        packet = gwbuf_make_contiguous(packet);
+        packets.emplace_back(GWBUF_DATA(packet), GWBUF_DATA(packet) + gwbuf_length(packet));
+        gwbuf_free(packet);
+    }
+
+    gwbuf_free(client_reply);
+    client_reply = NULL;
+
+    return packets;
+}
+
+int check_cut(const char* name, uint16_t eof_status, size_t split)
+{
+    int errors = 0;
+    uint32_t max_rows = 3;
+    auto packets = stream(max_rows, create_resultset(10, eof_status), split);
+
+    // Column count, column definition, EOF, the rows and the terminating EOF
+    if (packets.size() != 3 + max_rows + 1)
+    {
+        cout << name << ": expected " << 3 + max_rows + 1 << " packets, got " << packets.size() << "\n";
+        return 1;
+    }
+
+    const auto& eof = packets.back();
+    uint16_t expected = eof_status & ~SERVER_MORE_RESULTS_EXIST;
+
+    if (eof.size() != MYSQL_EOF_PACKET_LEN || eof[MYSQL_HEADER_LEN] != 0xfe)
+    {
+        cout << name << ": the resultset does not end with an EOF packet\n";
+        ++errors;
+    }
+    else if (eof[MYSQL_SEQ_OFFSET] != 3 + max_rows + 1)
+    {
+        cout << name << ": wrong sequence number " << (int)eof[MYSQL_SEQ_OFFSET] << "\n";
+        ++errors;
+    }
+    else if (gw_mysql_get_byte2(&eof[MAXROWS_MYSQL_EOF_PACKET_FLAGS_OFFSET]) != expected)
+    {
+        cout << name << ": expected status " << expected << ", got "
+             << gw_mysql_get_byte2(&eof[MAXROWS_MYSQL_EOF_PACKET_FLAGS_OFFSET]) << "\n";
+        ++errors;
+    }
+
+    return errors;
+}
+
+int test_cut_status()
+{
+    int errors = 0;
+
+    for (size_t split : {1, 7})
+    {
+        errors += check_cut("autocommit", SERVER_STATUS_AUTOCOMMIT, split);
+        errors += check_cut("transaction", SERVER_STATUS_IN_TRANS, split);
+        errors += check_cut("multiple resultsets",
+                            SERVER_STATUS_IN_TRANS | SERVER_MORE_RESULTS_EXIST,
+                            split);
+    }
+
+    return errors;
+}
+
+int test_not_cut()
+{
+    int errors = 0;
+    auto data = create_resultset(3, SERVER_STATUS_IN_TRANS);
+    auto packets = stream(3, data, 1);
+
+    std::vector<uint8_t> reply;
+
+    for (const auto& p : packets)
+    {
+        reply.insert(reply.end(), p.begin(), p.end());
+    }
+
+    if (reply != data)
+    {
+        cout << "A resultset within the limits was modified\n";
+        ++errors;
+    }
+
+    return errors;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    int errors = 0;
+
+    errors += test_cut_status();
+    errors += test_not_cut();
+
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
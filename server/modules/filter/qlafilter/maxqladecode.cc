@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * @file maxqladecode.cc Print a binary QLA filter log as text
+ *
+ * Each record is printed on a line of its own, with the fields in the order
+ * Service, Session, Date, User@Host, Reply_time and Query. Newlines in the
+ * queries are replaced with spaces.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "qlabinary.hh"
+
+namespace
+{
+
+// How much is read from the file at a time
+const size_t READ_SIZE = 64 * 1024;
+
+/**
+ * Read more data from a file
+ *
+ * @param pFile  The file.
+ * @param pData  The buffer to append the data to.
+ *
+ * @return The number of bytes read, 0 at the end of the file and -1 on error.
+ */
+int64_t read_more(FILE* pFile, std::vector<uint8_t>* pData)
+{
+    size_t size = pData->size();
+    pData->resize(size + READ_SIZE);
+    size_t n = fread(pData->data() + size, 1, READ_SIZE, pFile);
+    pData->resize(size + n);
+
+    return n == 0 && ferror(pFile) ? -1 : n;
+}
+
+void print_record(const QlaBinaryRecord& record, const char* zSeparator)
+{
+    char date[32] = "";
+    time_t time = record.time;
+    tm local_time;
+
+    if (localtime_r(&time, &local_time))
+    {
+        strftime(date, sizeof(date), "%F %T", &local_time);
+    }
+
+    printf("%.*s%s%lu%s%s%s%.*s@%.*s%s%d%s",
+           (int)record.service_len, record.service, zSeparator,
+           (unsigned long)record.session, zSeparator,
+           date, zSeparator,
+           (int)record.user_len, record.user,
+           (int)record.remote_len, record.remote, zSeparator,
+           record.reply_time, zSeparator);
+
+    for (uint32_t i = 0; i < record.query_len; ++i)
+    {
+        char c = record.query[i];
+        putchar(c == '\n' || c == '\r' ? ' ' : c);
+    }
+
+    putchar('\n');
+}
+}
+
+int main(int argc, char** argv)
+{
+    int rval = 1;
+
+    if (argc < 2 || argc > 3)
+    {
+        printf("Usage: maxqladecode FILE [SEPARATOR]\n");
+    }
+    else
+    {
+        const char* zSeparator = argc > 2 ? argv[2] : ",";
+        FILE* pFile = fopen(argv[1], "rb");
+
+        if (pFile)
+        {
+            // The records are decoded as the file is read, so only the record
+            // being decoded is kept in memory.
+            std::vector<uint8_t> data;
+            char magic[QLA_BINARY_MAGIC_LEN];
+
+            if (fread(magic, 1, sizeof(magic), pFile) != sizeof(magic)
+                || memcmp(magic, QLA_BINARY_MAGIC, QLA_BINARY_MAGIC_LEN) != 0)
+            {
+                if (ferror(pFile))
+                {
+                    fprintf(stderr, "Failed to read file '%s': %d, %s\n", argv[1], errno, strerror(errno));
+                }
+                else
+                {
+                    fprintf(stderr, "File '%s' is not a binary QLA filter log.\n", argv[1]);
+                }
+            }
+            else
+            {
+                uint64_t offset = QLA_BINARY_MAGIC_LEN;     // The offset of data[0] in the file
+                size_t pos = 0;
+                int64_t len = 0;
+                int64_t n;
+                QlaBinaryRecord record;
+
+                while ((n = read_more(pFile, &data)) > 0)
+                {
+                    while ((len = qla_binary::decode(data.data() + pos, data.size() - pos, &record)) > 0)
+                    {
+                        print_record(record, zSeparator);
+                        pos += len;
+                    }
+
+                    if (len < 0)
+                    {
+                        break;
+                    }
+
+                    // Keep the incomplete record at the start of the buffer
+                    data.erase(data.begin(), data.begin() + pos);
+                    offset += pos;
+                    pos = 0;
+                }
+
+                if (n < 0)
+                {
+                    fprintf(stderr, "Failed to read file '%s': %d, %s\n", argv[1], errno, strerror(errno));
+                }
+                else if (pos == data.size())
+                {
+                    rval = 0;
+                }
+                else
+                {
+                    fprintf(stderr, "%s record at offset %lu.\n",
+                            len == 0 ? "Incomplete" : "Malformed", (unsigned long)(offset + pos));
+                }
+            }
+
+            fclose(pFile);
+        }
+        else
+        {
+            fprintf(stderr, "Failed to open file '%s': %d, %s\n", argv[1], errno, strerror(errno));
+        }
+    }
+
+    return rval;
+}
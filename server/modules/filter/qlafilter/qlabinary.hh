@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+/**
+ * @file qlabinary.hh The binary record format of the QLA filter
+ *
+ * A binary log file starts with the 8 byte magic QLA_BINARY_MAGIC, followed
+ * by any number of records. All integers are little-endian.
+ *
+ *   u32  Length of the record, excluding this field.
+ *   u64  Session id.
+ *   u64  Time the query was received, in seconds since the epoch.
+ *   i32  Reply time in milliseconds, -1 if not measured.
+ *   u16  Length of the service name, followed by the name.
+ *   u16  Length of the user name, followed by the name.
+ *   u16  Length of the client address, followed by the address.
+ *   u32  Length of the query, followed by the query.
+ *
+ * The strings are not NULL terminated.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+#define QLA_BINARY_MAGIC     "MXSQLA1\n"
+#define QLA_BINARY_MAGIC_LEN 8
+
+struct QlaBinaryRecord
+{
+    uint64_t    session;
+    uint64_t    time;
+    int32_t     reply_time;
+    const char* service;
+    uint16_t    service_len;
+    const char* user;
+    uint16_t    user_len;
+    const char* remote;
+    uint16_t    remote_len;
+    const char* query;
+    uint32_t    query_len;
+};
+
+namespace qla_binary
+{
+
+inline void append_int(std::string* pOut, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+    {
+        pOut->push_back((char)((value >> (8 * i)) & 0xff));
+    }
+}
+
+inline uint64_t read_int(const uint8_t* pData, int bytes)
+{
+    uint64_t value = 0;
+
+    for (int i = 0; i < bytes; ++i)
+    {
+        value |= (uint64_t)pData[i] << (8 * i);
+    }
+
+    return value;
+}
+
+/**
+ * Append a record to a buffer
+ *
+ * @param record  The record. Strings longer than their length fields allow are truncated.
+ * @param pOut    The buffer to append the encoded record to.
+ */
+inline void encode(const QlaBinaryRecord& record, std::string* pOut)
+{
+    uint32_t length = 8 + 8 + 4 + 2 + record.service_len + 2 + record.user_len
+        + 2 + record.remote_len + 4 + record.query_len;
+
+    append_int(pOut, length, 4);
+    append_int(pOut, record.session, 8);
+    append_int(pOut, record.time, 8);
+    append_int(pOut, (uint32_t)record.reply_time, 4);
+    append_int(pOut, record.service_len, 2);
+    pOut->append(record.service, record.service_len);
+    append_int(pOut, record.user_len, 2);
+    pOut->append(record.user, record.user_len);
+    append_int(pOut, record.remote_len, 2);
+    pOut->append(record.remote, record.remote_len);
+    append_int(pOut, record.query_len, 4);
+    pOut->append(record.query, record.query_len);
+}
+
+/**
+ * Decode a record
+ *
+ * @param pData    Pointer to the start of a record.
+ * @param len      The number of bytes available.
+ * @param pRecord  On successful return, the record. The strings point into @c pData.
+ *
+ * @return The length of the record, 0 if the data does not contain a complete record
+ *         and -1 if the record is malformed.
+ */
+inline int64_t decode(const uint8_t* pData, size_t len, QlaBinaryRecord* pRecord)
+{
+    int64_t rv = 0;
+
+    if (len >= 4)
+    {
+        uint64_t length = read_int(pData, 4);
+
+        if (len - 4 >= length)
+        {
+            const uint8_t* pEnd = pData + 4 + length;
+            const uint8_t* p = pData + 4;
+            bool ok = (pEnd - p >= 8 + 8 + 4 + 2);
+
+            if (ok)
+            {
+                pRecord->session = read_int(p, 8);
+                p += 8;
+                pRecord->time = read_int(p, 8);
+                p += 8;
+                pRecord->reply_time = (int32_t)read_int(p, 4);
+                p += 4;
+                pRecord->service_len = read_int(p, 2);
+                p += 2;
+                pRecord->service = (const char*)p;
+                p += pRecord->service_len;
+                ok = (pEnd - p >= 2);
+            }
+
+            if (ok)
+            {
+                pRecord->user_len = read_int(p, 2);
+                p += 2;
+                pRecord->user = (const char*)p;
+                p += pRecord->user_len;
+                ok = (pEnd - p >= 2);
+            }
+
+            if (ok)
+            {
+                pRecord->remote_len = read_int(p, 2);
+                p += 2;
+                pRecord->remote = (const char*)p;
+                p += pRecord->remote_len;
+                ok = (pEnd - p >= 4);
+            }
+
+            if (ok)
+            {
+                pRecord->query_len = read_int(p, 4);
+                p += 4;
+                pRecord->query = (const char*)p;
+                p += pRecord->query_len;
+                ok = (p == pEnd);
+            }
+
+            rv = ok ? (int64_t)(4 + length) : -1;
+        }
+    }
+
+    return rv;
+}
+}
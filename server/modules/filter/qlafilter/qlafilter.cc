@@ -49,6 +49,9 @@
 #include <maxscale/modulecmd.h>
 #include <maxscale/json_api.h>
 
+#include "qlabinary.hh"
+#include "qlaworkerlog.hh"
+
 using std::string;
 
 class QlaFilterSession;
@@ -60,6 +63,11 @@ class QlaInstance;
 /* Log file save mode flags */
 #define CONFIG_FILE_SESSION (1 << 0)    // Default value, session specific files
 #define CONFIG_FILE_UNIFIED (1 << 1)    // One file shared by all sessions
+#define CONFIG_FILE_WORKER  (1 << 2)    // One file per routing worker, written asynchronously
+
+/* Log file formats */
+#define CONFIG_FORMAT_TEXT   0
+#define CONFIG_FORMAT_BINARY 1
 
 /* Default values for logged data */
 #define LOG_DATA_DEFAULT "date,user,query"
@@ -76,6 +84,8 @@ static const char PARAM_FLUSH[] = "flush";
 static const char PARAM_APPEND[] = "append";
 static const char PARAM_NEWLINE[] = "newline_replacement";
 static const char PARAM_SEPARATOR[] = "separator";
+static const char PARAM_LOG_FORMAT[] = "log_format";
+static const char PARAM_SEGMENT_SIZE[] = "segment_size";
 
 /* Flags for controlling extra log entry contents */
 enum log_options
@@ -106,7 +116,10 @@ static json_t*  diagnostic_json(const MXS_FILTER* instance, const MXS_FILTER_SES
 static uint64_t getCapabilities(MXS_FILTER* instance);
 
 
-static FILE* open_log_file(QlaInstance*, uint32_t, const char*);
+static FILE*  open_log_file(QlaInstance*, uint32_t, const char*);
+static string create_header(QlaInstance*, uint32_t);
+static string format_log_entry(QlaInstance*, QlaFilterSession*, uint32_t,
+                               const char*, const char*, size_t, int);
 static int write_log_entry(FILE*, QlaInstance*, QlaFilterSession*, uint32_t,
                            const char*, const char*, size_t, int);
 static bool cb_log(const MODULECMD_ARG* argv, json_t** output);
@@ -123,6 +136,14 @@ static const MXS_ENUM_VALUE log_type_values[] =
 {
     {"session", CONFIG_FILE_SESSION},
     {"unified", CONFIG_FILE_UNIFIED},
+    {"worker",  CONFIG_FILE_WORKER },
+    {NULL}
+};
+
+static const MXS_ENUM_VALUE log_format_values[] =
+{
+    {"text",   CONFIG_FORMAT_TEXT  },
+    {"binary", CONFIG_FORMAT_BINARY},
     {NULL}
 };
 
@@ -150,6 +171,7 @@ public:
     LogEventData()
         : has_message(false)
         , query_clone(NULL)
+        , query_time(0)
         , begin_time(
     {
         0, 0
@@ -173,12 +195,14 @@ public:
         gwbuf_free(query_clone);
         query_clone = NULL;
         query_date[0] = '\0';
+        query_time = 0;
         begin_time = {0, 0};
     }
 
     bool     has_message;                       // Does message data exist?
     GWBUF*   query_clone;                       // Clone of the query buffer.
     char     query_date[QLA_DATE_BUFFER_SIZE];  // Text representation of date.
+    time_t   query_time;                        // The time the query was received.
     timespec begin_time;                        // Timer value at the moment of receiving query.
 };
 
@@ -209,6 +233,9 @@ public:
     string unified_filename;    /* Filename of the unified log file */
     FILE*  unified_fp;          /* Unified log file. The pointer needs to be shared here
                                  * to avoid garbled printing. */
+    QlaWorkerLog* worker_log;   /* The per-worker log files */
+    uint32_t      log_format;   /* The format of the per-worker log files */
+    uint64_t      segment_size; /* The size after which a per-worker log file is rotated */
     bool   flush_writes;        /* Flush log file after every write? */
     bool   append;              /* Open files in append-mode? */
     string query_newline;       /* Character(s) used to replace a newline within a query */
@@ -231,6 +258,9 @@ QlaInstance::QlaInstance(const char* name, MXS_CONFIG_PARAMETER* params)
     , log_file_data_flags(config_get_enum(params, PARAM_LOG_DATA, log_data_values))
     , filebase(config_get_string(params, PARAM_FILEBASE))
     , unified_fp(NULL)
+    , worker_log(NULL)
+    , log_format(config_get_enum(params, PARAM_LOG_FORMAT, log_format_values))
+    , segment_size(config_get_size(params, PARAM_SEGMENT_SIZE))
     , flush_writes(config_get_bool(params, PARAM_FLUSH))
     , append(config_get_bool(params, PARAM_APPEND))
     , query_newline(config_get_string(params, PARAM_NEWLINE))
@@ -254,6 +284,7 @@ QlaInstance::~QlaInstance()
     {
         fclose(unified_fp);
     }
+    delete worker_log;
 }
 
 /* The session structure for this QLA filter. */
@@ -442,6 +473,18 @@ MXS_MODULE* MXS_CREATE_MODULE()
                 MXS_MODULE_PARAM_BOOL,
                 "false"
             },
+            {
+                PARAM_LOG_FORMAT,
+                MXS_MODULE_PARAM_ENUM,
+                "text",
+                MXS_MODULE_OPT_ENUM_UNIQUE,
+                log_format_values
+            },
+            {
+                PARAM_SEGMENT_SIZE,
+                MXS_MODULE_PARAM_SIZE,
+                "0"
+            },
             {MXS_END_MODULE_PARAMS}
         }
     };
@@ -508,6 +551,32 @@ static MXS_FILTER* createInstance(const char* name, MXS_CONFIG_PARAMETER* params
                     my_instance = NULL;
                 }
             }
+
+            // Start the writer of the per-worker log files
+            if (my_instance && (my_instance->log_mode_flags & CONFIG_FILE_WORKER))
+            {
+                string header;
+
+                if (my_instance->log_format == CONFIG_FORMAT_BINARY)
+                {
+                    header.assign(QLA_BINARY_MAGIC, QLA_BINARY_MAGIC_LEN);
+                }
+                else if (my_instance->log_file_data_flags != 0)
+                {
+                    header = create_header(my_instance, my_instance->log_file_data_flags);
+                }
+
+                my_instance->worker_log = QlaWorkerLog::create(my_instance->filebase,
+                                                               header,
+                                                               my_instance->append,
+                                                               my_instance->segment_size);
+
+                if (!my_instance->worker_log)
+                {
+                    delete my_instance;
+                    my_instance = NULL;
+                }
+            }
         }
         else
         {
@@ -677,11 +746,64 @@ static void setUpstream(MXS_FILTER* instance, MXS_FILTER_SESSION* session, MXS_U
     my_session->up = *upstream;
 }
 
+/**
+ * Write QLA log entry to the log of the current worker
+ *
+ * @param my_instance Filter instance
+ * @param my_session Filter session
+ * @param query_time The time the query was received
+ * @param date_string Date string
+ * @param query Query string, not 0-terminated
+ * @param querylen Query string length
+ * @param elapsed_ms Query execution time, in milliseconds
+ */
+static void write_worker_log_entry(QlaInstance* my_instance,
+                                   QlaFilterSession* my_session,
+                                   time_t query_time,
+                                   const char* date_string,
+                                   const char* query,
+                                   int querylen,
+                                   int elapsed_ms)
+{
+    string entry;
+
+    if (my_instance->log_format == CONFIG_FORMAT_BINARY)
+    {
+        QlaBinaryRecord record;
+        record.session = my_session->m_ses_id;
+        record.time = query_time;
+        record.reply_time = elapsed_ms;
+        record.service = my_session->m_service;
+        record.service_len = std::min(strlen(my_session->m_service), (size_t)UINT16_MAX);
+        record.user = my_session->m_user;
+        record.user_len = std::min(strlen(my_session->m_user), (size_t)UINT16_MAX);
+        record.remote = my_session->m_remote;
+        record.remote_len = std::min(strlen(my_session->m_remote), (size_t)UINT16_MAX);
+        record.query = query ? query : "";
+        record.query_len = query ? querylen : 0;
+
+        qla_binary::encode(record, &entry);
+    }
+    else
+    {
+        entry = format_log_entry(my_instance,
+                                 my_session,
+                                 my_instance->log_file_data_flags,
+                                 date_string,
+                                 query,
+                                 querylen,
+                                 elapsed_ms);
+    }
+
+    my_instance->worker_log->write(entry, my_instance->flush_writes);
+}
+
 /**
  * Write QLA log entry/entries to disk
  *
  * @param my_instance Filter instance
  * @param my_session Filter session
+ * @param query_time The time the query was received
  * @param date_string Date string
  * @param query Query string, not 0-terminated
  * @param querylen Query string length
@@ -689,11 +811,23 @@ static void setUpstream(MXS_FILTER* instance, MXS_FILTER_SESSION* session, MXS_U
  */
 void write_log_entries(QlaInstance* my_instance,
                        QlaFilterSession* my_session,
+                       time_t query_time,
                        const char* date_string,
                        const char* query,
                        int querylen,
                        int elapsed_ms)
 {
+    if (my_instance->log_mode_flags & CONFIG_FILE_WORKER)
+    {
+        write_worker_log_entry(my_instance,
+                               my_session,
+                               query_time,
+                               date_string,
+                               query,
+                               querylen,
+                               elapsed_ms);
+    }
+
     bool write_error = false;
     if (my_instance->log_mode_flags & CONFIG_FILE_SESSION)
     {
@@ -764,11 +898,11 @@ static int routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
     {
         const uint32_t data_flags = my_instance->log_file_data_flags;
         LogEventData& event = my_session->m_event_data;
+        const time_t utc_seconds = time(NULL);
         if (data_flags & LOG_DATA_DATE)
         {
             // Print current date to a buffer. Use the buffer in the event data struct even if execution time
             // is not needed.
-            const time_t utc_seconds = time(NULL);
             tm local_time;
             localtime_r(&utc_seconds, &local_time);
             strftime(event.query_date, QLA_DATE_BUFFER_SIZE, "%F %T", &local_time);
@@ -784,6 +918,7 @@ static int routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
                 event.clear();
             }
             clock_gettime(CLOCK_MONOTONIC, &event.begin_time);
+            event.query_time = utc_seconds;
             if (data_flags & LOG_DATA_QUERY)
             {
                 event.query_clone = gwbuf_clone(queue);
@@ -793,7 +928,13 @@ static int routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
         else
         {
             // If execution times are not logged, write the log entry now.
-            write_log_entries(my_instance, my_session, event.query_date, query, query_len, -1);
+            write_log_entries(my_instance,
+                              my_session,
+                              utc_seconds,
+                              event.query_date,
+                              query,
+                              query_len,
+                              -1);
         }
     }
     /* Pass the query downstream */
@@ -831,6 +972,7 @@ static int clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
             + (now.tv_nsec - event.begin_time.tv_nsec) / (double)1E6;
         write_log_entries(my_instance,
                           my_session,
+                          event.query_time,
                           event.query_date,
                           query,
                           query_len,
@@ -892,6 +1034,15 @@ static void diagnostic(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, DCB*
     dcb_printf(dcb,
                "\t\tNewline replacement     %s\n",
                my_instance->query_newline.c_str());
+    if (my_instance->worker_log)
+    {
+        dcb_printf(dcb,
+                   "\t\tBytes written to worker logs     %lu\n",
+                   my_instance->worker_log->bytes_written());
+        dcb_printf(dcb,
+                   "\t\tBytes dropped from worker logs     %lu\n",
+                   my_instance->worker_log->bytes_dropped());
+    }
 }
 
 /**
@@ -938,6 +1089,13 @@ static json_t* diagnostic_json(const MXS_FILTER* instance, const MXS_FILTER_SESS
     json_object_set_new(rval, PARAM_SEPARATOR, json_string(my_instance->separator.c_str()));
     json_object_set_new(rval, PARAM_NEWLINE, json_string(my_instance->query_newline.c_str()));
 
+    if (my_instance->worker_log)
+    {
+        json_object_set_new(rval, "worker_log_bytes", json_integer(my_instance->worker_log->bytes_written()));
+        json_object_set_new(rval, "worker_log_dropped_bytes",
+                            json_integer(my_instance->worker_log->bytes_dropped()));
+    }
+
     return rval;
 }
 
@@ -951,6 +1109,60 @@ static uint64_t getCapabilities(MXS_FILTER* instance)
     return RCAP_TYPE_NONE;
 }
 
+/**
+ * Create the header line of a log file.
+ *
+ * @param   instance    The filter instance
+ * @param   data_flags  Data save settings flags
+ * @return  The header, including the newline
+ */
+static string create_header(QlaInstance* instance, uint32_t data_flags)
+{
+    const char SERVICE[] = "Service";
+    const char SESSION[] = "Session";
+    const char DATE[] = "Date";
+    const char USERHOST[] = "User@Host";
+    const char QUERY[] = "Query";
+    const char REPLY_TIME[] = "Reply_time";
+
+    std::stringstream header;
+    string curr_sep;    // Use empty string as the first separator
+    const string& real_sep = instance->separator;
+
+    if (data_flags & LOG_DATA_SERVICE)
+    {
+        header << SERVICE;
+        curr_sep = real_sep;
+    }
+    if (data_flags & LOG_DATA_SESSION)
+    {
+        header << curr_sep << SESSION;
+        curr_sep = real_sep;
+    }
+    if (data_flags & LOG_DATA_DATE)
+    {
+        header << curr_sep << DATE;
+        curr_sep = real_sep;
+    }
+    if (data_flags & LOG_DATA_USER)
+    {
+        header << curr_sep << USERHOST;
+        curr_sep = real_sep;
+    }
+    if (data_flags & LOG_DATA_REPLY_TIME)
+    {
+        header << curr_sep << REPLY_TIME;
+        curr_sep = real_sep;
+    }
+    if (data_flags & LOG_DATA_QUERY)
+    {
+        header << curr_sep << QUERY;
+    }
+    header << '\n';
+
+    return header.str();
+}
+
 /**
  * Open the log file and print a header if appropriate.
  *
@@ -989,51 +1201,8 @@ static FILE* open_log_file(QlaInstance* instance, uint32_t data_flags, const cha
 
     if (fp && !file_existed && data_flags != 0)
     {
-        // Print a header.
-        const char SERVICE[] = "Service";
-        const char SESSION[] = "Session";
-        const char DATE[] = "Date";
-        const char USERHOST[] = "User@Host";
-        const char QUERY[] = "Query";
-        const char REPLY_TIME[] = "Reply_time";
-
-        std::stringstream header;
-        string curr_sep;    // Use empty string as the first separator
-        const string& real_sep = instance->separator;
-
-        if (data_flags & LOG_DATA_SERVICE)
-        {
-            header << SERVICE;
-            curr_sep = real_sep;
-        }
-        if (data_flags & LOG_DATA_SESSION)
-        {
-            header << curr_sep << SESSION;
-            curr_sep = real_sep;
-        }
-        if (data_flags & LOG_DATA_DATE)
-        {
-            header << curr_sep << DATE;
-            curr_sep = real_sep;
-        }
-        if (data_flags & LOG_DATA_USER)
-        {
-            header << curr_sep << USERHOST;
-            curr_sep = real_sep;
-        }
-        if (data_flags & LOG_DATA_REPLY_TIME)
-        {
-            header << curr_sep << REPLY_TIME;
-            curr_sep = real_sep;
-        }
-        if (data_flags & LOG_DATA_QUERY)
-        {
-            header << curr_sep << QUERY;
-        }
-        header << '\n';
-
         // Finally, write the log header.
-        int written = fprintf(fp, "%s", header.str().c_str());
+        int written = fprintf(fp, "%s", create_header(instance, data_flags).c_str());
 
         if ((written <= 0) || ((instance->flush_writes) && (fflush(fp) < 0)))
         {
@@ -1099,9 +1268,8 @@ static void print_string_replace_newlines(const char* sql_string,
 }
 
 /**
- * Write an entry to the log file.
+ * Format a log entry.
  *
- * @param   logfile       Target file
  * @param   instance      Filter instance
  * @param   session       Filter session
  * @param   data_flags    Controls what to write
@@ -1109,26 +1277,22 @@ static void print_string_replace_newlines(const char* sql_string,
  * @param   sql_string    SQL-query, *not* NULL terminated
  * @param   sql_str_len   Length of SQL-string
  * @param   elapsed_ms    Query execution time, in milliseconds
- * @return  The number of characters written, or a negative value on failure
+ * @return  The entry, including the newline, or an empty string if there is nothing to write
  */
-static int write_log_entry(FILE* logfile,
-                           QlaInstance* instance,
-                           QlaFilterSession* session,
-                           uint32_t data_flags,
-                           const char* time_string,
-                           const char* sql_string,
-                           size_t sql_str_len,
-                           int elapsed_ms)
+static string format_log_entry(QlaInstance* instance,
+                               QlaFilterSession* session,
+                               uint32_t data_flags,
+                               const char* time_string,
+                               const char* sql_string,
+                               size_t sql_str_len,
+                               int elapsed_ms)
 {
-    mxb_assert(logfile != NULL);
     if (data_flags == 0)
     {
         // Nothing to print
-        return 0;
+        return string();
     }
 
-    /* Printing to the file in parts would likely cause garbled printing if several threads write
-     * simultaneously, so we have to first print to a string. */
     std::stringstream output;
     string curr_sep;    // Use empty string as the first separator
     const string& real_sep = instance->separator;
@@ -1173,8 +1337,50 @@ static int write_log_entry(FILE* logfile,
     }
     output << "\n";
 
+    return output.str();
+}
+
+/**
+ * Write an entry to the log file.
+ *
+ * @param   logfile       Target file
+ * @param   instance      Filter instance
+ * @param   session       Filter session
+ * @param   data_flags    Controls what to write
+ * @param   time_string   Date entry
+ * @param   sql_string    SQL-query, *not* NULL terminated
+ * @param   sql_str_len   Length of SQL-string
+ * @param   elapsed_ms    Query execution time, in milliseconds
+ * @return  The number of characters written, or a negative value on failure
+ */
+static int write_log_entry(FILE* logfile,
+                           QlaInstance* instance,
+                           QlaFilterSession* session,
+                           uint32_t data_flags,
+                           const char* time_string,
+                           const char* sql_string,
+                           size_t sql_str_len,
+                           int elapsed_ms)
+{
+    mxb_assert(logfile != NULL);
+    if (data_flags == 0)
+    {
+        // Nothing to print
+        return 0;
+    }
+
+    /* Printing to the file in parts would likely cause garbled printing if several threads write
+     * simultaneously, so we have to first print to a string. */
+    string output = format_log_entry(instance,
+                                     session,
+                                     data_flags,
+                                     time_string,
+                                     sql_string,
+                                     sql_str_len,
+                                     elapsed_ms);
+
     // Finally, write the log event.
-    int written = fprintf(logfile, "%s", output.str().c_str());
+    int written = fprintf(logfile, "%s", output.c_str());
 
     if ((!instance->flush_writes) || (written <= 0))
     {
@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "qlafilter"
+
+#include "qlaworkerlog.hh"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <maxbase/atomic.hh>
+#include <maxbase/semaphore.hh>
+#include <maxscale/config.h>
+#include <maxscale/log.h>
+
+namespace
+{
+
+// A buffer larger than this is handed over to the writer thread at once.
+const size_t QLA_WORKER_BUFFER_SIZE = 64 * 1024;
+
+// How often, in milliseconds, the buffers are handed over at the latest.
+const int QLA_WORKER_FLUSH_INTERVAL = 1000;
+
+// How many bytes may wait for the writer thread before buffers are dropped.
+const size_t QLA_WORKER_MAX_QUEUED = 64 * 1024 * 1024;
+
+bool write_all(int fd, const char* pData, size_t len)
+{
+    bool rv = true;
+
+    while (rv && len > 0)
+    {
+        ssize_t rc = ::write(fd, pData, len);
+
+        if (rc > 0)
+        {
+            pData += rc;
+            len -= rc;
+        }
+        else if (rc == -1 && errno != EINTR)
+        {
+            rv = false;
+        }
+    }
+
+    return rv;
+}
+}
+
+QlaWorkerLog::QlaWorkerLog(const std::string& filebase,
+                           const std::string& header,
+                           bool append,
+                           uint64_t segment_size)
+    : m_filebase(filebase)
+    , m_header(header)
+    , m_append(append)
+    , m_segment_size(segment_size)
+    , m_buffers(config_threadcount())
+    , m_queued(0)
+    , m_stop(false)
+    , m_error_logged(false)
+    , m_bytes_written(0)
+    , m_bytes_dropped(0)
+    , m_thread(&QlaWorkerLog::run, this)
+{
+}
+
+// static
+QlaWorkerLog* QlaWorkerLog::create(const std::string& filebase,
+                                   const std::string& header,
+                                   bool append,
+                                   uint64_t segment_size)
+{
+    return new(std::nothrow) QlaWorkerLog(filebase, header, append, segment_size);
+}
+
+QlaWorkerLog::~QlaWorkerLog()
+{
+    if (mxb::Worker::get_current())
+    {
+        // The workers are running, so each one stops its own delayed call.
+        mxb::Semaphore sem;
+        auto n = mxs::RoutingWorker::broadcast([this]() {
+                                                   stop_worker(mxs::RoutingWorker::get_current_id());
+                                               },
+                                               &sem,
+                                               mxs::RoutingWorker::EXECUTE_AUTO);
+        sem.wait_n(n);
+    }
+    else
+    {
+        // MaxScale is shutting down and the workers have stopped.
+        for (size_t i = 0; i < m_buffers.size(); ++i)
+        {
+            stop_worker(i);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stop = true;
+    }
+
+    m_cond.notify_one();
+    m_thread.join();
+
+    for (auto& kv : m_files)
+    {
+        if (kv.second.fd != -1)
+        {
+            ::close(kv.second.fd);
+        }
+    }
+}
+
+void QlaWorkerLog::write(const std::string& entry, bool flush)
+{
+    mxb_assert(mxs::RoutingWorker::get_current());
+
+    int worker_id = mxs::RoutingWorker::get_current_id();
+    Buffer& buffer = m_buffers[worker_id];
+
+    if (buffer.call_id == 0)
+    {
+        // The first entry logged by this worker.
+        buffer.call_id = mxs::RoutingWorker::get_current()->delayed_call(QLA_WORKER_FLUSH_INTERVAL,
+                                                                          &QlaWorkerLog::flush_buffer,
+                                                                          this);
+    }
+
+    buffer.data += entry;
+
+    if (flush || buffer.data.length() >= QLA_WORKER_BUFFER_SIZE)
+    {
+        hand_over(worker_id, buffer);
+    }
+}
+
+uint64_t QlaWorkerLog::bytes_written() const
+{
+    return mxb::atomic::load(&m_bytes_written, mxb::atomic::RELAXED);
+}
+
+uint64_t QlaWorkerLog::bytes_dropped() const
+{
+    return mxb::atomic::load(&m_bytes_dropped, mxb::atomic::RELAXED);
+}
+
+void QlaWorkerLog::hand_over(int worker_id, Buffer& buffer)
+{
+    Batch batch;
+    batch.worker_id = worker_id;
+    batch.data.swap(buffer.data);
+
+    // The capacity of the handed over buffer goes with it, so the next
+    // buffer is allocated for the expected size right away.
+    buffer.data.reserve(QLA_WORKER_BUFFER_SIZE);
+
+    size_t len = batch.data.length();
+    bool queued = false;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        if (m_queued + len <= QLA_WORKER_MAX_QUEUED)
+        {
+            m_queued += len;
+            m_batches.push_back(std::move(batch));
+            queued = true;
+        }
+    }
+
+    if (queued)
+    {
+        m_cond.notify_one();
+    }
+    else if (mxb::atomic::add(&m_bytes_dropped, len, mxb::atomic::RELAXED) == 0)
+    {
+        MXS_WARNING("The worker logs of '%s' cannot be written as fast as queries are logged, "
+                    "log entries are dropped.", m_filebase.c_str());
+    }
+}
+
+bool QlaWorkerLog::flush_buffer(mxb::Worker::Call::action_t action)
+{
+    if (action == mxb::Worker::Call::EXECUTE)
+    {
+        int worker_id = mxs::RoutingWorker::get_current_id();
+        Buffer& buffer = m_buffers[worker_id];
+
+        if (!buffer.data.empty())
+        {
+            hand_over(worker_id, buffer);
+        }
+    }
+
+    return true;
+}
+
+void QlaWorkerLog::stop_worker(int worker_id)
+{
+    Buffer& buffer = m_buffers[worker_id];
+
+    if (buffer.call_id != 0)
+    {
+        mxs::RoutingWorker::get(worker_id)->cancel_delayed_call(buffer.call_id);
+        buffer.call_id = 0;
+    }
+
+    if (!buffer.data.empty())
+    {
+        hand_over(worker_id, buffer);
+    }
+}
+
+void QlaWorkerLog::run()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+
+    while (!m_stop || !m_batches.empty())
+    {
+        m_cond.wait(guard, [this]() {
+                        return m_stop || !m_batches.empty();
+                    });
+
+        std::deque<Batch> batches;
+        batches.swap(m_batches);
+        guard.unlock();
+
+        size_t written = 0;
+
+        for (const Batch& batch : batches)
+        {
+            write_batch(batch);
+            written += batch.data.length();
+        }
+
+        guard.lock();
+        m_queued -= written;
+    }
+}
+
+QlaWorkerLog::File& QlaWorkerLog::get_file(int worker_id)
+{
+    File& file = m_files[worker_id];
+
+    if (file.fd == -1)
+    {
+        std::string filename = m_filebase + ".worker." + std::to_string(worker_id);
+        int flags = O_WRONLY | O_CREAT | (m_append ? O_APPEND : O_TRUNC);
+
+        file.fd = open(filename.c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+
+        if (file.fd != -1)
+        {
+            struct stat st;
+            file.size = (fstat(file.fd, &st) == 0) ? st.st_size : 0;
+
+            if (file.size == 0 && write_all(file.fd, m_header.data(), m_header.length()))
+            {
+                file.size = m_header.length();
+            }
+        }
+        else if (!m_error_logged)
+        {
+            MXS_ERROR("Failed to open '%s': %d, %s", filename.c_str(), errno, mxs_strerror(errno));
+            m_error_logged = true;
+        }
+    }
+
+    return file;
+}
+
+void QlaWorkerLog::write_batch(const Batch& batch)
+{
+    File& file = get_file(batch.worker_id);
+
+    if (file.fd != -1)
+    {
+        if (write_all(file.fd, batch.data.data(), batch.data.length()))
+        {
+            file.size += batch.data.length();
+            mxb::atomic::add(&m_bytes_written, batch.data.length(), mxb::atomic::RELAXED);
+
+            if (m_segment_size != 0 && file.size >= m_segment_size)
+            {
+                rotate(batch.worker_id, file);
+            }
+        }
+        else if (!m_error_logged)
+        {
+            MXS_ERROR("Failed to write to the log of worker %d: %d, %s",
+                      batch.worker_id, errno, mxs_strerror(errno));
+            m_error_logged = true;
+        }
+    }
+}
+
+void QlaWorkerLog::rotate(int worker_id, File& file)
+{
+    std::string filename = m_filebase + ".worker." + std::to_string(worker_id);
+    std::string rotated = filename + "." + std::to_string(time(NULL));
+
+    // Several rotations may take place during the same second.
+    for (int i = 1; access(rotated.c_str(), F_OK) == 0; ++i)
+    {
+        rotated = filename + "." + std::to_string(time(NULL)) + "." + std::to_string(i);
+    }
+
+    if (rename(filename.c_str(), rotated.c_str()) == 0)
+    {
+        // The next write opens a new file.
+        ::close(file.fd);
+        file.fd = -1;
+        file.size = 0;
+    }
+    else
+    {
+        MXS_ERROR("Failed to rename '%s' to '%s': %d, %s",
+                  filename.c_str(), rotated.c_str(), errno, mxs_strerror(errno));
+    }
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <maxbase/worker.hh>
+#include <maxscale/routingworker.hh>
+
+/**
+ * A log written to one file per routing worker.
+ *
+ * The entries are appended to a buffer of the worker that logs them. The
+ * buffer is handed over to a writer thread once it grows large enough or
+ * at the latest after a second, so a routing worker never writes to a file
+ * itself. If the writer thread falls behind, the data handed over to it is
+ * dropped once too much of it is waiting. The file of a worker is rotated,
+ * once it exceeds the segment size.
+ */
+class QlaWorkerLog
+{
+    QlaWorkerLog(const QlaWorkerLog&);
+    QlaWorkerLog& operator=(const QlaWorkerLog&);
+
+public:
+    /**
+     * Create a worker log
+     *
+     * @param filebase      The base of the file names. The file of worker N
+     *                      is called <filebase>.worker.N.
+     * @param header        Written at the beginning of each new file.
+     * @param append        Whether existing files should be appended to.
+     * @param segment_size  The size after which a file is rotated, 0 for never.
+     *
+     * @return New worker log or NULL on error
+     */
+    static QlaWorkerLog* create(const std::string& filebase,
+                                const std::string& header,
+                                bool append,
+                                uint64_t segment_size);
+
+    /**
+     * Destroy the log. The buffers of all workers are handed over and written
+     * before the destructor returns.
+     */
+    ~QlaWorkerLog();
+
+    /**
+     * Log an entry. Must be called from a routing worker.
+     *
+     * @param entry  The entry to log.
+     * @param flush  Whether the entry should be handed over to the writer
+     *               thread immediately.
+     */
+    void write(const std::string& entry, bool flush);
+
+    /**
+     * @return The number of bytes written to files.
+     */
+    uint64_t bytes_written() const;
+
+    /**
+     * @return The number of bytes dropped because the writer thread fell behind.
+     */
+    uint64_t bytes_dropped() const;
+
+private:
+    // The buffer of a worker.
+    struct Buffer
+    {
+        Buffer()
+            : call_id(0)
+        {
+        }
+
+        std::string data;       // Entries not yet handed over.
+        uint32_t    call_id;    // The id of the delayed call flushing the buffer.
+    };
+
+    // The data of a worker, handed over to the writer thread.
+    struct Batch
+    {
+        int         worker_id;
+        std::string data;
+    };
+
+    // A file of a worker, only accessed by the writer thread.
+    struct File
+    {
+        File()
+            : fd(-1)
+            , size(0)
+        {
+        }
+
+        int      fd;
+        uint64_t size;
+    };
+
+    QlaWorkerLog(const std::string& filebase,
+                 const std::string& header,
+                 bool append,
+                 uint64_t segment_size);
+
+    void  hand_over(int worker_id, Buffer& buffer);
+    bool  flush_buffer(mxb::Worker::Call::action_t action);
+    void  stop_worker(int worker_id);
+    void  run();
+    File& get_file(int worker_id);
+    void  write_batch(const Batch& batch);
+    void  rotate(int worker_id, File& file);
+
+    std::string                  m_filebase;
+    std::string                  m_header;
+    bool                         m_append;
+    uint64_t                     m_segment_size;
+    std::vector<Buffer>          m_buffers;         // Indexed by worker id, only accessed by the worker.
+    std::mutex                   m_lock;            // Protects m_batches, m_queued and m_stop.
+    std::condition_variable      m_cond;
+    std::deque<Batch>            m_batches;
+    size_t                       m_queued;          // The bytes in m_batches and being written.
+    bool                         m_stop;
+    std::map<int, File>          m_files;           // Only accessed by the writer thread.
+    bool                         m_error_logged;    // Only accessed by the writer thread.
+    uint64_t                     m_bytes_written;   // Updated atomically.
+    uint64_t                     m_bytes_dropped;   // Updated atomically.
+    std::thread                  m_thread;
+};
@@ -19,6 +19,7 @@
 
 #include <maxscale/ccdefs.hh>
 
+#include <maxbase/atomic.hh>
 #include <maxscale/alloc.h>
 #include <maxscale/modinfo.h>
 #include <maxscale/log.h>
@@ -41,7 +42,9 @@ Tee::Tee(SERVICE* service,
          pcre2_code* match,
          std::string match_string,
          pcre2_code* exclude,
-         std::string exclude_string)
+         std::string exclude_string,
+         uint64_t sample,
+         uint64_t max_queued)
     : m_service(service)
     , m_user(user)
     , m_source(remote)
@@ -50,6 +53,8 @@ Tee::Tee(SERVICE* service,
     , m_match(match_string)
     , m_exclude(exclude_string)
     , m_enabled(true)
+    , m_sample(sample)
+    , m_max_queued(max_queued)
 {
 }
 
@@ -73,14 +78,28 @@ Tee* Tee::create(const char* name, MXS_CONFIG_PARAMETER* params)
     pcre2_code* exclude = config_get_compiled_regex(params, "exclude", cflags, NULL);
     const char* match_str = config_get_string(params, "match");
     const char* exclude_str = config_get_string(params, "exclude");
+    uint64_t sample = config_get_integer(params, "sample");
+    uint64_t max_queued = config_get_size(params, "max_queued");
 
-    Tee* my_instance = new(std::nothrow) Tee(service,
-                                             source,
-                                             user,
-                                             match,
-                                             match_str,
-                                             exclude,
-                                             exclude_str);
+    Tee* my_instance = NULL;
+
+    if (sample > 100)
+    {
+        MXS_ERROR("The value of 'sample' must be a percentage between 0 and 100, not %lu.",
+                  (unsigned long)sample);
+    }
+    else
+    {
+        my_instance = new(std::nothrow) Tee(service,
+                                            source,
+                                            user,
+                                            match,
+                                            match_str,
+                                            exclude,
+                                            exclude_str,
+                                            sample,
+                                            max_queued);
+    }
 
     if (my_instance == NULL)
     {
@@ -96,6 +115,37 @@ TeeSession* Tee::newSession(MXS_SESSION* pSession)
     return TeeSession::create(this, pSession);
 }
 
+void Tee::count(event_t event)
+{
+    uint64_t* counter = NULL;
+
+    switch (event)
+    {
+    case SESSION_SAMPLED:
+        counter = &m_stats.sessions_sampled;
+        break;
+
+    case SESSION_SKIPPED:
+        counter = &m_stats.sessions_skipped;
+        break;
+
+    case STATEMENT_QUEUED:
+        counter = &m_stats.queued;
+        break;
+
+    case STATEMENT_DROPPED:
+        counter = &m_stats.dropped;
+        break;
+
+    case STATEMENT_FAILED:
+        counter = &m_stats.failed;
+        break;
+    }
+
+    mxb_assert(counter);
+    mxb::atomic::add(counter, 1, mxb::atomic::RELAXED);
+}
+
 /**
  * Diagnostics routine
  *
@@ -137,6 +187,26 @@ void Tee::diagnostics(DCB* dcb)
                    m_exclude.c_str());
     }
     dcb_printf(dcb, "\t\tFilter enabled: %s\n", m_enabled ? "yes" : "no");
+    dcb_printf(dcb, "\t\tSampled sessions: %lu%%\n", (unsigned long)m_sample);
+
+    if (m_max_queued)
+    {
+        dcb_printf(dcb, "\t\tMaximum queued bytes: %lu\n", (unsigned long)m_max_queued);
+    }
+
+    using mxb::atomic::load;
+    using mxb::atomic::RELAXED;
+
+    dcb_printf(dcb, "\t\tSessions duplicated: %lu\n",
+               (unsigned long)load(&m_stats.sessions_sampled, RELAXED));
+    dcb_printf(dcb, "\t\tSessions skipped: %lu\n",
+               (unsigned long)load(&m_stats.sessions_skipped, RELAXED));
+    dcb_printf(dcb, "\t\tStatements queued: %lu\n",
+               (unsigned long)load(&m_stats.queued, RELAXED));
+    dcb_printf(dcb, "\t\tStatements dropped: %lu\n",
+               (unsigned long)load(&m_stats.dropped, RELAXED));
+    dcb_printf(dcb, "\t\tStatements failed: %lu\n",
+               (unsigned long)load(&m_stats.failed, RELAXED));
 }
 
 /**
@@ -176,6 +246,20 @@ json_t* Tee::diagnostics_json() const
     }
 
     json_object_set_new(rval, "enabled", json_boolean(m_enabled));
+    json_object_set_new(rval, "sample", json_integer(m_sample));
+    json_object_set_new(rval, "max_queued", json_integer(m_max_queued));
+
+    using mxb::atomic::load;
+    using mxb::atomic::RELAXED;
+
+    json_t* stats = json_object();
+    json_object_set_new(stats, "sessions_duplicated",
+                        json_integer(load(&m_stats.sessions_sampled, RELAXED)));
+    json_object_set_new(stats, "sessions_skipped", json_integer(load(&m_stats.sessions_skipped, RELAXED)));
+    json_object_set_new(stats, "queued", json_integer(load(&m_stats.queued, RELAXED)));
+    json_object_set_new(stats, "dropped", json_integer(load(&m_stats.dropped, RELAXED)));
+    json_object_set_new(stats, "failed", json_integer(load(&m_stats.failed, RELAXED)));
+    json_object_set_new(rval, "statistics", stats);
 
     return rval;
 }
@@ -248,6 +332,8 @@ MXS_MODULE* MXS_CREATE_MODULE()
             {"exclude",                      MXS_MODULE_PARAM_REGEX},
             {"source",                       MXS_MODULE_PARAM_STRING},
             {"user",                         MXS_MODULE_PARAM_STRING},
+            {"sample",                       MXS_MODULE_PARAM_COUNT, "100"},
+            {"max_queued",                   MXS_MODULE_PARAM_SIZE, "0"},
             {
                 "options",
                 MXS_MODULE_PARAM_ENUM,
@@ -77,6 +77,39 @@ public:
         return m_enabled;
     }
 
+    /**
+     * Whether statements of a session should be duplicated
+     *
+     * @param session The session
+     *
+     * @return True if the session belongs to the sampled percentage of sessions
+     */
+    bool session_sampled(const MXS_SESSION* session) const
+    {
+        return session->ses_id % 100 < m_sample;
+    }
+
+    /**
+     * @return The maximum number of bytes not yet read by the service,
+     *         per session. 0 means no limit.
+     */
+    uint64_t get_max_queued() const
+    {
+        return m_max_queued;
+    }
+
+    /** Events counted by the filter */
+    enum event_t
+    {
+        SESSION_SAMPLED,        // Statements of a session are duplicated
+        SESSION_SKIPPED,        // Statements of a session are not duplicated due to sampling
+        STATEMENT_QUEUED,       // A statement was queued for the service
+        STATEMENT_DROPPED,      // A statement was dropped since the queue was full
+        STATEMENT_FAILED        // A statement could not be queued
+    };
+
+    void count(event_t event);
+
 private:
     Tee(SERVICE* service,
         std::string user,
@@ -84,7 +117,27 @@ private:
         pcre2_code* match,
         std::string match_string,
         pcre2_code* exclude,
-        std::string exclude_string);
+        std::string exclude_string,
+        uint64_t sample,
+        uint64_t max_queued);
+
+    struct Stats
+    {
+        Stats()
+            : sessions_sampled(0)
+            , sessions_skipped(0)
+            , queued(0)
+            , dropped(0)
+            , failed(0)
+        {
+        }
+
+        uint64_t sessions_sampled;
+        uint64_t sessions_skipped;
+        uint64_t queued;
+        uint64_t dropped;
+        uint64_t failed;
+    };
 
     SERVICE*    m_service;
     std::string m_user;         /* The user name to filter on */
@@ -94,4 +147,7 @@ private:
     std::string m_match;        /* Pattern for matching queries */
     std::string m_exclude;      /* Pattern for excluding queries */
     bool        m_enabled;
+    uint64_t    m_sample;       /* Percentage of sessions to duplicate */
+    uint64_t    m_max_queued;   /* Maximum number of bytes not yet read by the service, per session */
+    Stats       m_stats;        /* Updated atomically */
 };
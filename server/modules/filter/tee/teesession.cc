@@ -20,17 +20,21 @@
 #include <maxscale/modutil.h>
 
 TeeSession::TeeSession(MXS_SESSION* session,
+                       Tee* instance,
                        LocalClient* client,
                        pcre2_code*  match,
                        pcre2_match_data* md_match,
                        pcre2_code* exclude,
                        pcre2_match_data* md_exclude)
     : mxs::FilterSession(session)
+    , m_instance(instance)
     , m_client(client)
     , m_match(match)
     , m_md_match(md_match)
     , m_exclude(exclude)
     , m_md_exclude(md_exclude)
+    , m_large(false)
+    , m_duplicate(false)
 {
 }
 
@@ -42,9 +46,24 @@ TeeSession* TeeSession::create(Tee* my_instance, MXS_SESSION* session)
     pcre2_match_data* md_match = NULL;
     pcre2_match_data* md_exclude = NULL;
 
-    if (my_instance->is_enabled()
+    bool duplicate = my_instance->is_enabled()
         && my_instance->user_matches(session_get_user(session))
-        && my_instance->remote_matches(session_get_remote(session)))
+        && my_instance->remote_matches(session_get_remote(session));
+
+    if (duplicate)
+    {
+        if (my_instance->session_sampled(session))
+        {
+            my_instance->count(Tee::SESSION_SAMPLED);
+        }
+        else
+        {
+            my_instance->count(Tee::SESSION_SKIPPED);
+            duplicate = false;
+        }
+    }
+
+    if (duplicate)
     {
         match = my_instance->get_match();
         exclude = my_instance->get_exclude();
@@ -67,7 +86,13 @@ TeeSession* TeeSession::create(Tee* my_instance, MXS_SESSION* session)
         }
     }
 
-    TeeSession* tee = new(std::nothrow) TeeSession(session, client, match, md_match, exclude, md_exclude);
+    TeeSession* tee = new(std::nothrow) TeeSession(session,
+                                                   my_instance,
+                                                   client,
+                                                   match,
+                                                   md_match,
+                                                   exclude,
+                                                   md_exclude);
 
     if (!tee)
     {
@@ -94,14 +119,49 @@ void TeeSession::close()
 
 int TeeSession::routeQuery(GWBUF* queue)
 {
-    if (m_client && query_matches(queue))
+    bool first_packet = !m_large;
+
+    if (m_client && should_duplicate(queue))
     {
-        m_client->queue_query(queue);
+        if (!m_client->queue_query(queue))
+        {
+            m_instance->count(Tee::STATEMENT_FAILED);
+        }
+        else if (first_packet)
+        {
+            m_instance->count(Tee::STATEMENT_QUEUED);
+        }
     }
 
     return mxs::FilterSession::routeQuery(queue);
 }
 
+bool TeeSession::should_duplicate(GWBUF* buffer)
+{
+    // A statement larger than 16MB arrives as several packets. The decision made
+    // for its first packet applies to the rest, so that only whole statements
+    // are duplicated or dropped.
+    bool first = !m_large;
+    m_large = MYSQL_GET_PAYLOAD_LEN(GWBUF_DATA(buffer)) == GW_MYSQL_MAX_PACKET_LEN;
+
+    if (first)
+    {
+        m_duplicate = query_matches(buffer);
+
+        uint64_t max_queued = m_instance->get_max_queued();
+
+        if (m_duplicate && max_queued && m_client->pending_bytes() >= max_queued)
+        {
+            // The service is not keeping up. Rather than letting the queue grow
+            // without bounds, the statement is not duplicated at all.
+            m_instance->count(Tee::STATEMENT_DROPPED);
+            m_duplicate = false;
+        }
+    }
+
+    return m_duplicate;
+}
+
 void TeeSession::diagnostics(DCB* pDcb)
 {
 }
@@ -38,16 +38,21 @@ public:
 
 private:
     TeeSession(MXS_SESSION* session,
+               Tee* instance,
                LocalClient* client,
                pcre2_code*  match,
                pcre2_match_data* md_match,
                pcre2_code* exclude,
                pcre2_match_data* md_exclude);
     bool query_matches(GWBUF* buffer);
+    bool should_duplicate(GWBUF* buffer);
 
-    LocalClient*      m_client; /**< The client connection to the local service */
+    Tee*              m_instance;   /**< The filter instance */
+    LocalClient*      m_client;     /**< The client connection to the local service */
     pcre2_code*       m_match;
     pcre2_match_data* m_md_match;
     pcre2_code*       m_exclude;
     pcre2_match_data* m_md_exclude;
+    bool              m_large;      /**< The next packet continues a statement larger than 16MB */
+    bool              m_duplicate;  /**< Whether the statement being continued is duplicated */
 };
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "../tokenbucket.hh"
+
+#include <iostream>
+#include <string>
+
+using std::cout;
+using std::string;
+using throttle::TokenBucketTable;
+using namespace std::chrono;
+
+namespace
+{
+
+const int RATE = 10;    // One token per 100 milliseconds
+const maxbase::Duration BURST = seconds(1);
+
+int64_t ms(maxbase::Duration d)
+{
+    return duration_cast<milliseconds>(d + microseconds(500)).count();
+}
+
+int expect(const string& what, int64_t value, int64_t expected)
+{
+    if (value != expected)
+    {
+        cout << what << ": " << value << ", expected " << expected << ".\n";
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Test that a full bucket lets a burst through and that the queries that
+ * follow it are spread out at the rate
+ *
+ * @return Number of errors
+ */
+int test_burst()
+{
+    int errors = 0;
+    TokenBucketTable table(RATE, BURST, 4);
+    maxbase::TimePoint now = maxbase::Clock::now();
+
+    for (int i = 0; i < RATE; i++)
+    {
+        errors += expect("Delay within burst", ms(table.take("a", now)), 0);
+    }
+
+    errors += expect("Delay of 1st query after burst", ms(table.take("a", now)), 100);
+    errors += expect("Delay of 2nd query after burst", ms(table.take("a", now)), 200);
+
+    // Other keys have buckets of their own
+    errors += expect("Delay of another key", ms(table.take("b", now)), 0);
+
+    return errors;
+}
+
+/**
+ * Test that a bucket refills at the rate, but not beyond its capacity
+ *
+ * @return Number of errors
+ */
+int test_refill()
+{
+    int errors = 0;
+    TokenBucketTable table(RATE, BURST, 1);
+    maxbase::TimePoint now = maxbase::Clock::now();
+
+    for (int i = 0; i <= RATE; i++)
+    {
+        table.take("a", now);
+    }
+
+    // The borrowed token has been refilled and one more is available
+    now += milliseconds(200);
+    errors += expect("Delay after partial refill", ms(table.take("a", now)), 0);
+    errors += expect("Delay after using refilled token", ms(table.take("a", now)), 100);
+
+    // An idle bucket holds no more than the burst
+    now += seconds(10);
+
+    for (int i = 0; i < RATE; i++)
+    {
+        errors += expect("Delay after idling", ms(table.take("a", now)), 0);
+    }
+
+    errors += expect("Delay after idle burst", ms(table.take("a", now)), 100);
+
+    return errors;
+}
+
+/**
+ * Test the statistics and the removal of idle buckets
+ *
+ * @return Number of errors
+ */
+int test_stats()
+{
+    int errors = 0;
+    TokenBucketTable table(RATE, BURST, 1);
+    maxbase::TimePoint now = maxbase::Clock::now();
+
+    for (int i = 0; i < RATE + 2; i++)
+    {
+        table.take("a", now);
+    }
+
+    auto stats = table.stats();
+    errors += expect("Number of keys", stats.size(), 1);
+
+    if (!stats.empty())
+    {
+        errors += expect("Queries", stats[0].queries, RATE + 2);
+        errors += expect("Delayed queries", stats[0].delayed, 2);
+        errors += expect("Total delay", ms(stats[0].delay), 300);
+    }
+
+    // Once the shard is large, the buckets that have refilled are removed. The
+    // new buckets are in use and stay.
+    now += seconds(10);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        table.take("key" + std::to_string(i), now);
+    }
+
+    stats = table.stats();
+    errors += expect("Number of keys after purge", stats.size(), 2000);
+
+    for (const auto& s : stats)
+    {
+        if (s.key == "a")
+        {
+            cout << "Idle key was not removed.\n";
+            errors++;
+        }
+    }
+
+    return errors;
+}
+}
+
+int main()
+{
+    int errors = 0;
+
+    errors += test_burst();
+    errors += test_refill();
+    errors += test_stats();
+
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -10,6 +10,7 @@
 #include <maxscale/utils.h>
 #include <maxscale/json_api.h>
 #include <maxscale/jansson.hh>
+#include <maxscale/modutil.hh>
 
 #include "throttlefilter.hh"
 
@@ -25,6 +26,40 @@ const char* const MAX_QPS_CFG = "max_qps";
 const char* const SAMPLING_DURATION_CFG = "sampling_duration";
 const char* const THROTTLE_DURATION_CFG = "throttling_duration";
 const char* const CONTINUOUS_DURATION_CFG = "continuous_duration";
+const char* const USER_MAX_QPS_CFG = "user_max_qps";
+const char* const HOST_MAX_QPS_CFG = "host_max_qps";
+const char* const STATEMENT_MAX_QPS_CFG = "statement_max_qps";
+const char* const BURST_DURATION_CFG = "burst_duration";
+
+json_t* bucket_stats_json(const throttle::TokenBucketTable& table)
+{
+    json_t* arr = json_array();
+
+    for (const auto& stats : table.stats())
+    {
+        json_t* obj = json_object();
+        json_object_set_new(obj, "key", json_string(stats.key.c_str()));
+        json_object_set_new(obj, "queries", json_integer(stats.queries));
+        json_object_set_new(obj, "delayed", json_integer(stats.delayed));
+        json_object_set_new(obj, "delay_time",
+                            json_real(std::chrono::duration<double>(stats.delay).count()));
+        json_array_append_new(arr, obj);
+    }
+
+    return arr;
+}
+
+void bucket_stats_print(DCB* pDcb, const char* zName, const throttle::TokenBucketTable& table)
+{
+    dcb_printf(pDcb, "\t\t%s limits:\n", zName);
+
+    for (const auto& stats : table.stats())
+    {
+        dcb_printf(pDcb, "\t\t\t%s: %lu queries, %lu delayed for %.3f seconds\n",
+                   stats.key.c_str(), stats.queries, stats.delayed,
+                   std::chrono::duration<double>(stats.delay).count());
+    }
+}
 }
 
 extern "C" MXS_MODULE* MXS_CREATE_MODULE()
@@ -43,10 +78,14 @@ extern "C" MXS_MODULE* MXS_CREATE_MODULE()
         NULL,                                                           /* Thread init. */
         NULL,                                                           /* Thread finish. */
         {
-            {MAX_QPS_CFG,                                               MXS_MODULE_PARAM_INT },
+            {MAX_QPS_CFG,                                               MXS_MODULE_PARAM_INT, "0"},
             {SAMPLING_DURATION_CFG,                                     MXS_MODULE_PARAM_INT, "250"},
             {THROTTLE_DURATION_CFG,                                     MXS_MODULE_PARAM_INT },
             {CONTINUOUS_DURATION_CFG,                                   MXS_MODULE_PARAM_INT, "2000"},
+            {USER_MAX_QPS_CFG,                                          MXS_MODULE_PARAM_INT, "0"},
+            {HOST_MAX_QPS_CFG,                                          MXS_MODULE_PARAM_INT, "0"},
+            {STATEMENT_MAX_QPS_CFG,                                     MXS_MODULE_PARAM_INT, "0"},
+            {BURST_DURATION_CFG,                                        MXS_MODULE_PARAM_INT, "1000"},
             {MXS_END_MODULE_PARAMS}
         }
     };
@@ -59,6 +98,24 @@ namespace throttle
 
 ThrottleFilter::ThrottleFilter(const ThrottleConfig& config) : m_config(config)
 {
+    int n_shards = config_threadcount();
+
+    if (m_config.user_max_qps > 0)
+    {
+        m_user_buckets.reset(new TokenBucketTable(m_config.user_max_qps, m_config.burst_duration, n_shards));
+    }
+
+    if (m_config.host_max_qps > 0)
+    {
+        m_host_buckets.reset(new TokenBucketTable(m_config.host_max_qps, m_config.burst_duration, n_shards));
+    }
+
+    if (m_config.statement_max_qps > 0)
+    {
+        m_statement_buckets.reset(new TokenBucketTable(m_config.statement_max_qps,
+                                                       m_config.burst_duration,
+                                                       n_shards));
+    }
 }
 
 ThrottleFilter* ThrottleFilter::create(const char* zName, MXS_CONFIG_PARAMETER* pParams)
@@ -67,21 +124,45 @@ ThrottleFilter* ThrottleFilter::create(const char* zName, MXS_CONFIG_PARAMETER*
     int sample_msecs = config_get_integer(pParams, SAMPLING_DURATION_CFG);
     int throttle_msecs = config_get_integer(pParams, THROTTLE_DURATION_CFG);
     int cont_msecs = config_get_integer(pParams, CONTINUOUS_DURATION_CFG);
+    int user_max_qps = config_get_integer(pParams, USER_MAX_QPS_CFG);
+    int host_max_qps = config_get_integer(pParams, HOST_MAX_QPS_CFG);
+    int statement_max_qps = config_get_integer(pParams, STATEMENT_MAX_QPS_CFG);
+    int burst_msecs = config_get_integer(pParams, BURST_DURATION_CFG);
     bool config_ok = true;
 
-    if (max_qps < 2)
+    if (max_qps == 0 && user_max_qps == 0 && host_max_qps == 0 && statement_max_qps == 0)
+    {
+        MXS_ERROR("At least one of %s, %s, %s and %s must be defined",
+                  MAX_QPS_CFG, USER_MAX_QPS_CFG, HOST_MAX_QPS_CFG, STATEMENT_MAX_QPS_CFG);
+        config_ok = false;
+    }
+
+    if (max_qps != 0 && max_qps < 2)
     {
         MXS_ERROR("Config value %s must be > 1", MAX_QPS_CFG);
         config_ok = false;
     }
 
+    if (user_max_qps < 0 || host_max_qps < 0 || statement_max_qps < 0)
+    {
+        MXS_ERROR("Config values %s, %s and %s must be >= 0",
+                  USER_MAX_QPS_CFG, HOST_MAX_QPS_CFG, STATEMENT_MAX_QPS_CFG);
+        config_ok = false;
+    }
+
+    if (burst_msecs < 0)
+    {
+        MXS_ERROR("Config value %s must be >= 0", BURST_DURATION_CFG);
+        config_ok = false;
+    }
+
     if (sample_msecs < 0)
     {
         MXS_ERROR("Config value %s must be >= 0", SAMPLING_DURATION_CFG);
         config_ok = false;
     }
 
-    if (throttle_msecs <= 0)
+    if (max_qps != 0 && throttle_msecs <= 0)
     {
         MXS_ERROR("Config value %s must be > 0", THROTTLE_DURATION_CFG);
         config_ok = false;
@@ -99,9 +180,12 @@ ThrottleFilter* ThrottleFilter::create(const char* zName, MXS_CONFIG_PARAMETER*
         maxbase::Duration sampling_duration {std::chrono::milliseconds(sample_msecs)};
         maxbase::Duration throttling_duration {std::chrono::milliseconds(throttle_msecs)};
         maxbase::Duration continuous_duration {std::chrono::milliseconds(cont_msecs)};
+        maxbase::Duration burst_duration {std::chrono::milliseconds(burst_msecs)};
 
         ThrottleConfig config = {max_qps,             sampling_duration,
-                                 throttling_duration, continuous_duration};
+                                 throttling_duration, continuous_duration,
+                                 user_max_qps,        host_max_qps,
+                                 statement_max_qps,   burst_duration};
 
         filter = new ThrottleFilter(config);
     }
@@ -116,20 +200,75 @@ ThrottleSession* ThrottleFilter::newSession(MXS_SESSION* mxsSession)
 
 void ThrottleFilter::diagnostics(DCB* pDcb)
 {
+    if (m_user_buckets)
+    {
+        bucket_stats_print(pDcb, "User", *m_user_buckets);
+    }
+
+    if (m_host_buckets)
+    {
+        bucket_stats_print(pDcb, "Host", *m_host_buckets);
+    }
+
+    if (m_statement_buckets)
+    {
+        bucket_stats_print(pDcb, "Statement", *m_statement_buckets);
+    }
 }
 
 json_t* ThrottleFilter::diagnostics_json() const
 {
-    return NULL;
+    json_t* rval = json_object();
+
+    if (m_user_buckets)
+    {
+        json_object_set_new(rval, "users", bucket_stats_json(*m_user_buckets));
+    }
+
+    if (m_host_buckets)
+    {
+        json_object_set_new(rval, "hosts", bucket_stats_json(*m_host_buckets));
+    }
+
+    if (m_statement_buckets)
+    {
+        json_object_set_new(rval, "statements", bucket_stats_json(*m_statement_buckets));
+    }
+
+    return rval;
 }
 
 uint64_t ThrottleFilter::getCapabilities()
 {
-    return RCAP_TYPE_NONE;
+    // The statement buckets are keyed by the canonical form of complete statements
+    return m_statement_buckets ? RCAP_TYPE_STMT_INPUT : RCAP_TYPE_NONE;
 }
 
 const ThrottleConfig& ThrottleFilter::config() const
 {
     return m_config;
 }
+
+maxbase::Duration ThrottleFilter::take_tokens(const std::string& user, const std::string& host, GWBUF* buffer)
+{
+    maxbase::TimePoint now = maxbase::Clock::now();
+    maxbase::Duration delay(0);
+
+    if (m_user_buckets)
+    {
+        delay = std::max(delay, m_user_buckets->take(user, now));
+    }
+
+    if (m_host_buckets)
+    {
+        delay = std::max(delay, m_host_buckets->take(host, now));
+    }
+
+    if (m_statement_buckets && modutil_is_SQL(buffer))
+    {
+        delay = std::max(delay, m_statement_buckets->take(mxs::get_canonical(buffer), now));
+    }
+
+    return delay;
+}
 }   // throttle
@@ -14,6 +14,7 @@
 
 #include <maxscale/filter.hh>
 #include "throttlesession.hh"
+#include "tokenbucket.hh"
 #include <maxbase/eventcount.hh>
 #include <maxbase/stopwatch.hh>
 #include <iostream>
@@ -39,6 +40,15 @@ struct ThrottleConfig
     // is stopped if the qps stays below max_qps for continuous_duration. If throttling continues
     // for more than throttling_duration, the session is disconnected.
 
+    int               user_max_qps;         // Max qps of all sessions of a user, 0 for no limit.
+    int               host_max_qps;         // Max qps of all sessions from a host, 0 for no limit.
+    int               statement_max_qps;    // Max qps of a canonical statement, 0 for no limit.
+    maxbase::Duration burst_duration;       // How long these can be exceeded by an idle key.
+
+    // The user, host and statement limits are shared by all sessions, see TokenBucketTable.
+    // A query is delayed until all the limits that apply to it allow it to proceed, and
+    // is then subject to the per session limit max_qps, if that is set.
+
     // TODO: this should probably depend on overall activity. If this is to protect the
     // database, multiple sessions gone haywire will still cause problems. It would be quite
     // easy to add a counter into the filter to measure overall qps. On the other hand, if
@@ -60,9 +70,24 @@ public:
     uint64_t              getCapabilities();
     const ThrottleConfig& config() const;
     void                  sessionClose(ThrottleSession* session);
+
+    /**
+     * Take a token from each bucket that applies to a query
+     *
+     * @param user    The user of the session.
+     * @param host    The client host of the session.
+     * @param buffer  The query.
+     *
+     * @return How long the query must be delayed, zero if not at all.
+     */
+    maxbase::Duration take_tokens(const std::string& user, const std::string& host, GWBUF* buffer);
+
 private:
     ThrottleFilter(const ThrottleConfig& config);
 
-    ThrottleConfig m_config;
+    ThrottleConfig                    m_config;
+    std::unique_ptr<TokenBucketTable> m_user_buckets;
+    std::unique_ptr<TokenBucketTable> m_host_buckets;
+    std::unique_ptr<TokenBucketTable> m_statement_buckets;
 };
 }   // throttle
@@ -31,6 +31,8 @@ namespace throttle
 ThrottleSession::ThrottleSession(MXS_SESSION* mxsSession, ThrottleFilter& filter)
     : maxscale::FilterSession(mxsSession)
     , m_filter(filter)
+    , m_user(session_get_user(mxsSession) ? session_get_user(mxsSession) : "")
+    , m_host(session_get_remote(mxsSession) ? session_get_remote(mxsSession) : "")
     , m_query_count("num-queries", filter.config().sampling_duration)
     , m_delayed_call_id(0)
     , m_state(State::MEASURING)
@@ -45,6 +47,11 @@ ThrottleSession::~ThrottleSession()
         mxb_assert(worker);
         worker->cancel_delayed_call(m_delayed_call_id);
     }
+
+    for (const auto& p : m_pending)
+    {
+        gwbuf_free(p.buffer);
+    }
 }
 
 int ThrottleSession::real_routeQuery(GWBUF* buffer, bool is_delayed)
@@ -57,16 +64,14 @@ int ThrottleSession::real_routeQuery(GWBUF* buffer, bool is_delayed)
     float secs = micro / 1000000.0;
     float qps = count / secs;   // not instantaneous, but over so many seconds
 
-    if (!is_delayed && qps >= m_filter.config().max_qps)    // trigger
+    if (!is_delayed && m_filter.config().max_qps && qps >= m_filter.config().max_qps)    // trigger
     {
         // delay the current routeQuery for at least one cycle at stated max speed.
+        // It goes first, as the queries queued behind it arrived after it.
         int32_t delay = 1 + std::ceil(1000.0 / m_filter.config().max_qps);
-        maxbase::Worker* worker = maxbase::Worker::get_current();
-        mxb_assert(worker);
-        m_delayed_call_id = worker->delayed_call(delay,
-                                                 &ThrottleSession::delayed_routeQuery,
-                                                 this,
-                                                 buffer);
+        m_pending.push_front({buffer, maxbase::Clock::now() + milliseconds(delay), true});
+        schedule_pending();
+
         if (m_state == State::MEASURING)
         {
             MXS_INFO("Query throttling STARTED session %ld user %s",
@@ -105,28 +110,70 @@ int ThrottleSession::real_routeQuery(GWBUF* buffer, bool is_delayed)
     return mxs::FilterSession::routeQuery(buffer);
 }
 
-bool ThrottleSession::delayed_routeQuery(maxbase::Worker::Call::action_t action, GWBUF* buffer)
+void ThrottleSession::schedule_pending()
+{
+    using namespace std::chrono;
+
+    if (m_delayed_call_id == 0 && !m_pending.empty())
+    {
+        maxbase::Duration wait = m_pending.front().ready - maxbase::Clock::now();
+        int32_t delay_ms = std::max<int32_t>(1, std::ceil(duration<double, std::milli>(wait).count()));
+        maxbase::Worker* worker = maxbase::Worker::get_current();
+        mxb_assert(worker);
+        m_delayed_call_id = worker->delayed_call(delay_ms, &ThrottleSession::delayed_routeQuery, this);
+    }
+}
+
+bool ThrottleSession::delayed_routeQuery(maxbase::Worker::Call::action_t action)
 {
     m_delayed_call_id = 0;
-    switch (action)
+
+    if (action == maxbase::Worker::Call::EXECUTE)
     {
-    case maxbase::Worker::Call::EXECUTE:
-        if (!real_routeQuery(buffer, true))
+        maxbase::TimePoint now = maxbase::Clock::now();
+
+        // Route the queries whose delay has passed in the order they arrived. The
+        // session limit may put the first one back, which also stops the loop.
+        while (!m_pending.empty() && m_pending.front().ready <= now)
         {
-            poll_fake_hangup_event(m_pSession->client_dcb);
+            Pending p = m_pending.front();
+            m_pending.pop_front();
+
+            if (!real_routeQuery(p.buffer, p.is_delayed))
+            {
+                poll_fake_hangup_event(m_pSession->client_dcb);
+                return false;
+            }
         }
-        break;
 
-    case maxbase::Worker::Call::CANCEL:
-        gwbuf_free(buffer);
-        break;
+        schedule_pending();
     }
 
+    // When the call is cancelled, the session is being closed and frees the queries.
     return false;
 }
 
 int ThrottleSession::routeQuery(GWBUF* buffer)
 {
+    // The tokens are taken when the query arrives, so that the delay reflects
+    // the rate at which the client sends queries.
+    maxbase::Duration delay = m_filter.take_tokens(m_user, m_host, buffer);
+
+    if (delay > maxbase::Duration(0) || !m_pending.empty())
+    {
+        // A query is never routed before the queries that arrived before it
+        maxbase::TimePoint ready = maxbase::Clock::now() + delay;
+
+        if (!m_pending.empty())
+        {
+            ready = std::max(ready, m_pending.back().ready);
+        }
+
+        m_pending.push_back({buffer, ready, false});
+        schedule_pending();
+        return true;
+    }
+
     return real_routeQuery(buffer, false);
 }
 }   // throttle
@@ -15,6 +15,9 @@
 #include <maxbase/worker.hh>
 #include <maxscale/filter.hh>
 #include <maxbase/eventcount.hh>
+#include <maxbase/stopwatch.hh>
+#include <deque>
+#include <string>
 
 namespace throttle
 {
@@ -31,14 +34,26 @@ public:
 
     int routeQuery(GWBUF* buffer);
 private:
-    bool delayed_routeQuery(maxbase::Worker::Call::action_t action,
-                            GWBUF* buffer);
-    int real_routeQuery(GWBUF* buffer, bool is_delayed);
+    // A query waiting to be routed
+    struct Pending
+    {
+        GWBUF*             buffer;
+        maxbase::TimePoint ready;       // When the query can be routed
+        bool               is_delayed;  // Whether the session limit has already delayed it
+    };
+
+    bool delayed_routeQuery(maxbase::Worker::Call::action_t action);
+    void schedule_pending();
+    int  real_routeQuery(GWBUF* buffer, bool is_delayed);
+
     ThrottleFilter&     m_filter;
+    std::string         m_user;
+    std::string         m_host;
     maxbase::EventCount m_query_count;
     maxbase::StopWatch  m_first_sample;
     maxbase::StopWatch  m_last_sample;
-    uint32_t            m_delayed_call_id;  // there can be only one in flight
+    std::deque<Pending> m_pending;          // Delayed queries and the queries queued behind them
+    uint32_t            m_delayed_call_id;  // The call that routes m_pending, only one in flight
 
     enum class State {MEASURING,
                       THROTTLING};
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "throttlefilter"
+
+#include "tokenbucket.hh"
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+// A shard is checked for idle buckets once it has this many buckets
+const size_t PURGE_SIZE = 1024;
+}
+
+namespace throttle
+{
+
+TokenBucketTable::Shard::Shard()
+    : purge_size(PURGE_SIZE)
+{
+}
+
+TokenBucketTable::TokenBucketTable(int rate, maxbase::Duration burst, int n_shards)
+    : m_rate(rate)
+    , m_capacity(std::max(1.0, rate * std::chrono::duration<double>(burst).count()))
+    , m_shards(std::max(n_shards, 1))
+{
+}
+
+maxbase::Duration TokenBucketTable::take(const std::string& key, maxbase::TimePoint now)
+{
+    Shard& shard = m_shards[std::hash<std::string>()(key) % m_shards.size()];
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    auto it = shard.buckets.find(key);
+
+    if (it == shard.buckets.end())
+    {
+        if (shard.buckets.size() >= shard.purge_size)
+        {
+            purge(shard, now);
+        }
+
+        Bucket bucket = {m_capacity, now, 0, 0, maxbase::Duration(0)};
+        it = shard.buckets.emplace(key, bucket).first;
+    }
+
+    Bucket& bucket = it->second;
+    refill(bucket, now);
+
+    bucket.tokens -= 1;
+    ++bucket.queries;
+
+    maxbase::Duration delay(0);
+
+    if (bucket.tokens < 0)
+    {
+        // The token is borrowed from the refill that follows
+        delay = maxbase::Duration(-bucket.tokens / m_rate);
+        ++bucket.delayed;
+        bucket.delay += delay;
+    }
+
+    return delay;
+}
+
+std::vector<TokenBucketTable::Stats> TokenBucketTable::stats() const
+{
+    std::vector<Stats> rval;
+
+    for (const Shard& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+
+        for (const auto& kv : shard.buckets)
+        {
+            rval.push_back({kv.first, kv.second.queries, kv.second.delayed, kv.second.delay});
+        }
+    }
+
+    return rval;
+}
+
+void TokenBucketTable::refill(Bucket& bucket, maxbase::TimePoint now) const
+{
+    double elapsed = std::chrono::duration<double>(now - bucket.last).count();
+
+    if (elapsed > 0)
+    {
+        bucket.tokens = std::min(m_capacity, bucket.tokens + elapsed * m_rate);
+        bucket.last = now;
+    }
+}
+
+void TokenBucketTable::purge(Shard& shard, maxbase::TimePoint now) const
+{
+    // A bucket that has refilled completely behaves like a new one
+    for (auto it = shard.buckets.begin(); it != shard.buckets.end();)
+    {
+        Bucket bucket = it->second;
+        refill(bucket, now);
+
+        if (bucket.tokens >= m_capacity)
+        {
+            it = shard.buckets.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // If most of the buckets are in use, the next purge is done only after
+    // the shard has doubled in size.
+    shard.purge_size = std::max(PURGE_SIZE, 2 * shard.buckets.size());
+}
+}   // throttle
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+#include <maxbase/stopwatch.hh>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace throttle
+{
+
+/**
+ * Token buckets shared by all sessions of a filter, one bucket per key.
+ *
+ * A bucket holds at most rate * burst tokens and gains rate tokens per second.
+ * The tokens are added when the bucket is next used, so no timers are needed.
+ * Each query takes a token. A query that finds the bucket empty reserves a token
+ * in advance and is to be delayed until the bucket has refilled that far, so the
+ * queries of all sessions sharing a key are spread out at the rate.
+ *
+ * The buckets are split into shards by the hash of the key, one per routing
+ * worker. Each shard has a lock of its own, so the workers seldom wait for each
+ * other.
+ */
+class TokenBucketTable
+{
+public:
+    TokenBucketTable(const TokenBucketTable&) = delete;
+    TokenBucketTable& operator=(const TokenBucketTable&) = delete;
+
+    struct Stats
+    {
+        std::string       key;
+        uint64_t          queries;      // Queries that have taken a token
+        uint64_t          delayed;      // Queries that had to be delayed
+        maxbase::Duration delay;        // The total delay
+    };
+
+    /**
+     * @param rate      Tokens per second.
+     * @param burst     How many seconds worth of tokens a bucket holds.
+     * @param n_shards  Number of shards.
+     */
+    TokenBucketTable(int rate, maxbase::Duration burst, int n_shards);
+
+    /**
+     * Take a token from the bucket of a key
+     *
+     * @param key  The key.
+     * @param now  The current time.
+     *
+     * @return How long the query must be delayed, zero if not at all.
+     */
+    maxbase::Duration take(const std::string& key, maxbase::TimePoint now);
+
+    /**
+     * @return The statistics of the keys in the table. A key whose bucket has
+     *         been full for a while may have been removed.
+     */
+    std::vector<Stats> stats() const;
+
+private:
+    struct Bucket
+    {
+        double             tokens;
+        maxbase::TimePoint last;        // When tokens was last updated
+        uint64_t           queries;
+        uint64_t           delayed;
+        maxbase::Duration  delay;
+    };
+
+    struct Shard
+    {
+        Shard();
+
+        mutable std::mutex                      lock;
+        std::unordered_map<std::string, Bucket> buckets;
+        size_t                                  purge_size;     // Purge when this large
+    };
+
+    void refill(Bucket& bucket, maxbase::TimePoint now) const;
+    void purge(Shard& shard, maxbase::TimePoint now) const;
+
+    double             m_rate;
+    double             m_capacity;
+    std::vector<Shard> m_shards;
+};
+}   // throttle
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "topfilter"
+
+#include "topdigest.hh"
+
+#include <algorithm>
+
+namespace
+{
+
+// The upper bounds of the histogram buckets in microseconds, the last bucket has none
+const uint64_t bucket_limits[TopDigest::N_BUCKETS - 1] =
+{
+    100, 1000, 10000, 100000, 1000000, 10000000
+};
+
+const char* bucket_names[TopDigest::N_BUCKETS] =
+{
+    "<0.1ms", "<1ms", "<10ms", "<100ms", "<1s", "<10s", ">=10s"
+};
+}
+
+TopDigest::TopDigest()
+    : count(0)
+    , error(0)
+    , total_us(0)
+    , min_us(UINT64_MAX)
+    , max_us(0)
+    , histogram()
+{
+}
+
+void TopDigest::add(uint64_t duration_us)
+{
+    ++count;
+    total_us += duration_us;
+    min_us = std::min(min_us, duration_us);
+    max_us = std::max(max_us, duration_us);
+
+    int i = 0;
+
+    while (i < N_BUCKETS - 1 && duration_us >= bucket_limits[i])
+    {
+        ++i;
+    }
+
+    ++histogram[i];
+}
+
+void TopDigest::merge(const TopDigest& other)
+{
+    count += other.count;
+    error += other.error;
+    total_us += other.total_us;
+    min_us = std::min(min_us, other.min_us);
+    max_us = std::max(max_us, other.max_us);
+
+    for (int i = 0; i < N_BUCKETS; ++i)
+    {
+        histogram[i] += other.histogram[i];
+    }
+}
+
+json_t* TopDigest::to_json() const
+{
+    // Only the executions after the statement was last added to a table are timed
+    uint64_t timed = 0;
+
+    for (int i = 0; i < N_BUCKETS; ++i)
+    {
+        timed += histogram[i];
+    }
+
+    json_t* obj = json_object();
+    json_object_set_new(obj, "sql", json_string(statement.c_str()));
+    json_object_set_new(obj, "count", json_integer(count));
+    json_object_set_new(obj, "count_error", json_integer(error));
+    json_object_set_new(obj, "total_time", json_real(total_us / 1000000.0));
+    json_object_set_new(obj, "min_time", json_real(timed ? min_us / 1000000.0 : 0));
+    json_object_set_new(obj, "max_time", json_real(max_us / 1000000.0));
+    json_object_set_new(obj, "avg_time", json_real(timed ? total_us / 1000000.0 / timed : 0));
+
+    json_t* hist = json_object();
+
+    for (int i = 0; i < N_BUCKETS; ++i)
+    {
+        json_object_set_new(hist, bucket_names[i], json_integer(histogram[i]));
+    }
+
+    json_object_set_new(obj, "histogram", hist);
+
+    return obj;
+}
+
+TopDigestTable::TopDigestTable(size_t capacity)
+    : m_capacity(capacity)
+{
+}
+
+void TopDigestTable::add(size_t hash, const char* statement, uint64_t duration_us)
+{
+    auto it = m_digests.find(hash);
+
+    if (it == m_digests.end())
+    {
+        TopDigest digest;
+
+        if (m_digests.size() >= m_capacity)
+        {
+            // Replace the least frequently executed statement, the new one may have
+            // been executed as many times while it was not in the table.
+            auto least = m_by_count.begin();
+            digest.count = least->first;
+            digest.error = least->first;
+            m_digests.erase(least->second);
+            m_by_count.erase(least);
+        }
+
+        digest.statement = statement;
+        it = m_digests.emplace(hash, std::move(digest)).first;
+    }
+    else
+    {
+        m_by_count.erase(std::make_pair(it->second.count, hash));
+    }
+
+    it->second.add(duration_us);
+    m_by_count.emplace(it->second.count, hash);
+}
+
+// static
+std::vector<TopDigest> TopDigestTable::combine(const std::vector<TopDigestTable>& tables, size_t n)
+{
+    std::unordered_map<size_t, TopDigest> combined;
+
+    for (const TopDigestTable& table : tables)
+    {
+        for (const auto& kv : table.m_digests)
+        {
+            auto it = combined.find(kv.first);
+
+            if (it == combined.end())
+            {
+                combined.emplace(kv.first, kv.second);
+            }
+            else
+            {
+                it->second.merge(kv.second);
+            }
+        }
+    }
+
+    std::vector<TopDigest> rval;
+    rval.reserve(combined.size());
+
+    for (auto& kv : combined)
+    {
+        rval.push_back(std::move(kv.second));
+    }
+
+    std::sort(rval.begin(), rval.end(), [](const TopDigest& a, const TopDigest& b) {
+                  return a.count > b.count;
+              });
+
+    if (rval.size() > n)
+    {
+        rval.resize(n);
+    }
+
+    return rval;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <maxscale/jansson.hh>
+
+/**
+ * The statistics of one canonical statement
+ */
+struct TopDigest
+{
+    /** The number of buckets in the latency histogram */
+    static const int N_BUCKETS = 7;
+
+    TopDigest();
+
+    /**
+     * Add an execution of the statement
+     *
+     * @param duration_us The execution time in microseconds
+     */
+    void add(uint64_t duration_us);
+
+    /**
+     * Add the statistics of the same statement from another table
+     *
+     * @param other The statistics to add
+     */
+    void merge(const TopDigest& other);
+
+    /**
+     * @return The statistics as JSON
+     */
+    json_t* to_json() const;
+
+    std::string statement;              /**< The canonical statement */
+    uint64_t    count;                  /**< Number of executions */
+    uint64_t    error;                  /**< How much the count may be overestimated */
+    uint64_t    total_us;               /**< Total execution time */
+    uint64_t    min_us;                 /**< Shortest execution time */
+    uint64_t    max_us;                 /**< Longest execution time */
+    uint64_t    histogram[N_BUCKETS];   /**< Executions by execution time */
+};
+
+/**
+ * The most frequently executed statements
+ *
+ * The statements are tracked with the Space-Saving algorithm. At most @c capacity
+ * statements are tracked at a time. When a statement that is not tracked is
+ * executed and the table is full, it replaces the least frequently executed
+ * statement and inherits its count as the error of its own count. Any statement
+ * executed more often than once per @c capacity executions is always in the table.
+ *
+ * A table is not thread-safe, each routing worker updates a table of its own.
+ */
+class TopDigestTable
+{
+public:
+    TopDigestTable(size_t capacity = 0);
+
+    /**
+     * Add an execution of a statement
+     *
+     * @param hash        The hash of the canonical statement
+     * @param statement   The canonical statement
+     * @param duration_us The execution time in microseconds
+     */
+    void add(size_t hash, const char* statement, uint64_t duration_us);
+
+    /**
+     * Combine the tables of all workers
+     *
+     * @param tables The tables to combine
+     * @param n      How many statements to return
+     *
+     * @return The @c n most frequently executed statements, most frequent first
+     */
+    static std::vector<TopDigest> combine(const std::vector<TopDigestTable>& tables, size_t n);
+
+private:
+    typedef std::unordered_map<size_t, TopDigest>   DigestMap;
+    typedef std::set<std::pair<uint64_t, size_t>>   CountSet;
+
+    size_t    m_capacity;   /**< Maximum number of tracked statements */
+    DigestMap m_digests;    /**< The tracked statements by hash */
+    CountSet  m_by_count;   /**< The count and hash of each tracked statement */
+};
@@ -46,6 +46,12 @@
 #include <regex.h>
 #include <maxbase/atomic.h>
 #include <maxscale/alloc.h>
+#include <maxscale/routingworker.hh>
+
+#include <functional>
+#include <string>
+
+#include "topdigest.hh"
 
 /*
  * The filter entry points
@@ -76,15 +82,17 @@ static uint64_t getCapabilities(MXS_FILTER* instance);
  */
 typedef struct
 {
-    int     sessions;   /* Session count */
-    int     topN;       /* Number of queries to store */
-    char*   filebase;   /* Base of fielname to log into */
-    char*   source;     /* The source of the client connection */
-    char*   user;       /* A user name to filter on */
-    char*   match;      /* Optional text to match against */
-    regex_t re;         /* Compiled regex text */
-    char*   exclude;    /* Optional text to match against for exclusion */
-    regex_t exre;       /* Compiled regex nomatch text */
+    int                                 sessions;       /* Session count */
+    int                                 topN;           /* Number of queries to store */
+    char*                               filebase;       /* Base of fielname to log into */
+    char*                               source;         /* The source of the client connection */
+    char*                               user;           /* A user name to filter on */
+    char*                               match;          /* Optional text to match against */
+    regex_t                             re;             /* Compiled regex text */
+    char*                               exclude;        /* Optional text to match against for exclusion */
+    regex_t                             exre;           /* Compiled regex nomatch text */
+    int                                 digest_size;    /* Statements in the service digest, 0 if disabled */
+    mxs::rworker_local<TopDigestTable>* digests;        /* The service digest of each worker */
 } TOPN_INSTANCE;
 
 /**
@@ -115,6 +123,8 @@ typedef struct
     int            fd;
     struct timeval start;
     char*          current;
+    char*          canonical;       /* Canonical form of current, NULL if not in the digest */
+    size_t         canonical_hash;  /* Hash of canonical */
     TOPNQ**        top;
     int            n_statements;
     struct timeval total;
@@ -180,6 +190,7 @@ extern "C"
                 {"exclude",               MXS_MODULE_PARAM_STRING},
                 {"source",                MXS_MODULE_PARAM_STRING},
                 {"user",                  MXS_MODULE_PARAM_STRING},
+                {"digest_size",           MXS_MODULE_PARAM_COUNT,   "0"                    },
                 {
                     "options",
                     MXS_MODULE_PARAM_ENUM,
@@ -218,6 +229,8 @@ static MXS_FILTER* createInstance(const char* name, MXS_CONFIG_PARAMETER* params
         my_instance->source = config_copy_string(params, "source");
         my_instance->user = config_copy_string(params, "user");
         my_instance->filebase = MXS_STRDUP_A(config_get_string(params, "filebase"));
+        my_instance->digest_size = config_get_integer(params, "digest_size");
+        my_instance->digests = NULL;
 
         int cflags = config_get_enum(params, "options", option_values);
         bool error = false;
@@ -263,6 +276,11 @@ static MXS_FILTER* createInstance(const char* name, MXS_CONFIG_PARAMETER* params
             MXS_FREE(my_instance);
             my_instance = NULL;
         }
+        else if (my_instance->digest_size > 0)
+        {
+            my_instance->digests =
+                new mxs::rworker_local<TopDigestTable>(TopDigestTable(my_instance->digest_size));
+        }
     }
 
     return (MXS_FILTER*) my_instance;
@@ -307,6 +325,7 @@ static MXS_FILTER_SESSION* newSession(MXS_FILTER* instance, MXS_SESSION* session
         my_session->total.tv_sec = 0;
         my_session->total.tv_usec = 0;
         my_session->current = NULL;
+        my_session->canonical = NULL;
         if ((remote = session_get_remote(session)) != NULL)
         {
             my_session->clientHost = MXS_STRDUP_A(remote);
@@ -434,6 +453,7 @@ static void freeSession(MXS_FILTER* instance, MXS_FILTER_SESSION* session)
     TOPN_SESSION* my_session = (TOPN_SESSION*) session;
 
     MXS_FREE(my_session->filename);
+    MXS_FREE(my_session->canonical);
     MXS_FREE(session);
     return;
 }
@@ -500,6 +520,16 @@ static int routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
                 }
                 gettimeofday(&my_session->start, NULL);
                 my_session->current = ptr;
+
+                if (my_instance->digests)
+                {
+                    MXS_FREE(my_session->canonical);
+
+                    if ((my_session->canonical = modutil_get_canonical(queue)) != NULL)
+                    {
+                        my_session->canonical_hash = std::hash<std::string>()(my_session->canonical);
+                    }
+                }
             }
             else
             {
@@ -539,6 +569,15 @@ static int clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
 
         timeradd(&(my_session->total), &diff, &(my_session->total));
 
+        if (my_session->canonical)
+        {
+            (*my_instance->digests)->add(my_session->canonical_hash,
+                                         my_session->canonical,
+                                         diff.tv_sec * 1000000 + diff.tv_usec);
+            MXS_FREE(my_session->canonical);
+            my_session->canonical = NULL;
+        }
+
         inserted = 0;
         for (i = 0; i < my_instance->topN; i++)
         {
@@ -626,6 +665,21 @@ static void diagnostic(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, DCB*
                    "\t\tExclude queries that match     %s\n",
                    my_instance->exclude);
     }
+    if (my_instance->digests && !my_session)
+    {
+        std::vector<TopDigest> digests = TopDigestTable::combine(my_instance->digests->values(),
+                                                                 my_instance->topN);
+
+        dcb_printf(dcb, "\t\tMost frequent statements of the service:\n");
+        for (const TopDigest& digest : digests)
+        {
+            dcb_printf(dcb,
+                       "\t\t\t%lu executions, %.3f seconds: %s\n",
+                       (unsigned long)digest.count,
+                       digest.total_us / 1000000.0,
+                       digest.statement.c_str());
+        }
+    }
     if (my_session)
     {
         dcb_printf(dcb,
@@ -687,6 +741,21 @@ static json_t* diagnostic_json(const MXS_FILTER* instance, const MXS_FILTER_SESS
         json_object_set_new(rval, "exclude", json_string(my_instance->exclude));
     }
 
+    if (my_instance->digests && !my_session)
+    {
+        std::vector<TopDigest> digests = TopDigestTable::combine(my_instance->digests->values(),
+                                                                 my_instance->topN);
+        json_t* arr = json_array();
+
+        for (const TopDigest& digest : digests)
+        {
+            json_array_append_new(arr, digest.to_json());
+        }
+
+        json_object_set_new(rval, "digest_size", json_integer(my_instance->digest_size));
+        json_object_set_new(rval, "top_digests", arr);
+    }
+
     if (my_session)
     {
         json_object_set_new(rval, "session_filename", json_string(my_session->filename));
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * @file maxtpmdecode.cc Print a binary TPM filter log as text
+ *
+ * The records still in the file are printed from the oldest to the newest, each
+ * on a line of its own, with the fields in the order Timestamp, Server, Session,
+ * Latency in milliseconds, Statements and Hash. The file may be read while
+ * MaxScale is writing to it.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tpmbinary.hh"
+
+namespace
+{
+
+void print_record(const TpmBinaryRecord& record, const char* zSeparator)
+{
+    printf("%lu%s%.*s%s%lu%s%.3f%s%u%s%016lx\n",
+           (unsigned long)(record.end / 1000000), zSeparator,
+           TPM_BINARY_SERVER_LEN, record.server, zSeparator,
+           (unsigned long)record.session, zSeparator,
+           (record.end - record.start) / 1000.0, zSeparator,
+           record.statements, zSeparator,
+           (unsigned long)record.hash);
+}
+}
+
+int main(int argc, char** argv)
+{
+    int rval = 1;
+
+    if (argc < 2 || argc > 3)
+    {
+        printf("Usage: maxtpmdecode FILE [SEPARATOR]\n");
+    }
+    else
+    {
+        const char* zSeparator = argc > 2 ? argv[2] : ",";
+        int fd = open(argv[1], O_RDONLY);
+        struct stat st;
+
+        if (fd != -1 && fstat(fd, &st) == 0)
+        {
+            void* ptr = st.st_size > 0 ? mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+
+            if (ptr == MAP_FAILED)
+            {
+                fprintf(stderr, "Failed to map file '%s': %d, %s\n", argv[1], errno, strerror(errno));
+            }
+            else
+            {
+                const uint8_t* pData = (const uint8_t*)ptr;
+
+                if (!tpm_binary::check_header(pData, st.st_size))
+                {
+                    fprintf(stderr, "File '%s' is not a binary TPM filter log.\n", argv[1]);
+                }
+                else
+                {
+                    uint64_t end = tpm_binary::record_count(pData);
+                    uint64_t lost = 0;
+                    TpmBinaryRecord record;
+
+                    for (uint64_t n = tpm_binary::first_record(pData); n < end; ++n)
+                    {
+                        if (tpm_binary::read_record(pData, n, &record))
+                        {
+                            print_record(record, zSeparator);
+                        }
+                        else
+                        {
+                            ++lost;
+                        }
+                    }
+
+                    if (lost > 0)
+                    {
+                        fprintf(stderr, "%lu records were overwritten while the file was read.\n",
+                                (unsigned long)lost);
+                    }
+
+                    rval = 0;
+                }
+
+                munmap(ptr, st.st_size);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Failed to open file '%s': %d, %s\n", argv[1], errno, strerror(errno));
+        }
+
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+
+    return rval;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "../tpmbinary.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using std::cout;
+
+namespace
+{
+
+const uint32_t CAPACITY = 4;
+
+std::vector<uint8_t> create_file()
+{
+    std::vector<uint8_t> file(sizeof(TpmBinaryHeader) + CAPACITY * sizeof(TpmBinaryRecord));
+    TpmBinaryHeader* pHeader = reinterpret_cast<TpmBinaryHeader*>(file.data());
+
+    memcpy(pHeader->magic, TPM_BINARY_MAGIC, TPM_BINARY_MAGIC_LEN);
+    pHeader->record_size = sizeof(TpmBinaryRecord);
+    pHeader->capacity = CAPACITY;
+
+    return file;
+}
+
+TpmBinaryRecord make_record(uint64_t n)
+{
+    TpmBinaryRecord record = {};
+    record.session = n;
+    record.statements = n + 1;
+    return record;
+}
+
+/**
+ * Test the validation of the header
+ *
+ * @return Number of errors
+ */
+int test_header()
+{
+    int errors = 0;
+    std::vector<uint8_t> file = create_file();
+
+    if (!tpm_binary::check_header(file.data(), file.size()))
+    {
+        cout << "A valid header was rejected.\n";
+        errors++;
+    }
+
+    if (tpm_binary::check_header(file.data(), file.size() - 1))
+    {
+        cout << "A file without room for all slots was accepted.\n";
+        errors++;
+    }
+
+    file[0] = 'X';
+
+    if (tpm_binary::check_header(file.data(), file.size()))
+    {
+        cout << "A header with a wrong magic was accepted.\n";
+        errors++;
+    }
+
+    return errors;
+}
+
+/**
+ * Test that records can be read back until their slot is reused
+ *
+ * @return Number of errors
+ */
+int test_overwrite()
+{
+    int errors = 0;
+    std::vector<uint8_t> file = create_file();
+    uint8_t* pData = file.data();
+
+    for (uint64_t n = 0; n < CAPACITY + 2; n++)
+    {
+        if (tpm_binary::write_record(pData, make_record(n)) != (n >= CAPACITY))
+        {
+            cout << "Record " << n << " should " << (n >= CAPACITY ? "" : "not ")
+                 << "have overwritten an older one.\n";
+            errors++;
+        }
+    }
+
+    if (tpm_binary::record_count(pData) != CAPACITY + 2 || tpm_binary::first_record(pData) != 2)
+    {
+        cout << "Wrong count or first record: " << tpm_binary::record_count(pData) << ", "
+             << tpm_binary::first_record(pData) << "\n";
+        errors++;
+    }
+
+    for (uint64_t n = 0; n < CAPACITY + 2; n++)
+    {
+        TpmBinaryRecord record;
+        bool intact = tpm_binary::read_record(pData, n, &record);
+
+        if (intact != (n >= 2))
+        {
+            cout << "Record " << n << " should " << (n >= 2 ? "" : "not ") << "be intact.\n";
+            errors++;
+        }
+        else if (intact && (record.session != n || record.statements != n + 1))
+        {
+            cout << "Record " << n << " has wrong contents.\n";
+            errors++;
+        }
+    }
+
+    // A writer that has started to store the next record is reusing the slot
+    // of the oldest one, which must no longer be reported as intact.
+    TpmBinaryHeader* pHeader = reinterpret_cast<TpmBinaryHeader*>(pData);
+    pHeader->started = pHeader->count + 1;
+    TpmBinaryRecord record;
+
+    if (tpm_binary::read_record(pData, 2, &record))
+    {
+        cout << "A record being overwritten was reported as intact.\n";
+        errors++;
+    }
+
+    if (!tpm_binary::read_record(pData, 3, &record) || record.session != 3)
+    {
+        cout << "A record not being overwritten was not reported as intact.\n";
+        errors++;
+    }
+
+    return errors;
+}
+}
+
+int main()
+{
+    int errors = 0;
+
+    errors += test_header();
+    errors += test_overwrite();
+
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+/**
+ * @file tpmbinary.hh The binary transaction log format of the TPM filter
+ *
+ * Each routing worker writes the transactions of its sessions to a file of its
+ * own. The file has a fixed size and is used as a ring: once it is full, each
+ * new record overwrites the oldest one. The file starts with a header, which is
+ * followed by the record slots. All integers are in host byte order.
+ *
+ * Header (TpmBinaryHeader, 64 bytes):
+ *   u8[8]  The magic TPM_BINARY_MAGIC.
+ *   u32    Size of a record slot.
+ *   u32    Number of record slots.
+ *   u64    Total number of records written. Record N is in slot N % slots.
+ *   u64    Number of records whose writing has started.
+ *   u8[32] Reserved.
+ *
+ * Record (TpmBinaryRecord, 64 bytes):
+ *   u64    Time of the first statement, in microseconds since the epoch.
+ *   u64    Time the COMMIT was replied to, in microseconds since the epoch.
+ *   u64    Session id.
+ *   u64    Hash of the canonical forms of the statements, in order. The
+ *          canonical forms are concatenated, each followed by a NUL byte,
+ *          and the hash is the first 64 bits of the 128-bit MurmurHash3
+ *          (x64 variant, seed 0) of the result.
+ *   u32    Number of statements, excluding the COMMIT.
+ *   u32    Reserved.
+ *   u8[24] Name of the server that replied to the COMMIT. The name is
+ *          truncated if it is longer and padded with NULs if it is shorter.
+ *
+ * The file is written without locks while it is being read. The writer
+ * increments the number of started records before it stores a record in its
+ * slot and the total number of records after it. A reader reads the total,
+ * copies the records it wants and then uses the number of started records to
+ * check that the slots were not reused while it copied them. The functions
+ * below do that.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define TPM_BINARY_MAGIC      "MXSTPM1\n"
+#define TPM_BINARY_MAGIC_LEN  8
+#define TPM_BINARY_SERVER_LEN 24
+
+struct TpmBinaryHeader
+{
+    char     magic[TPM_BINARY_MAGIC_LEN];
+    uint32_t record_size;
+    uint32_t capacity;
+    uint64_t count;
+    uint64_t started;
+    uint8_t  reserved[32];
+};
+
+struct TpmBinaryRecord
+{
+    uint64_t start;
+    uint64_t end;
+    uint64_t session;
+    uint64_t hash;
+    uint32_t statements;
+    uint32_t reserved;
+    char     server[TPM_BINARY_SERVER_LEN];
+};
+
+static_assert(sizeof(TpmBinaryHeader) == 64, "The binary header must be 64 bytes");
+static_assert(sizeof(TpmBinaryRecord) == 64, "A binary record must be 64 bytes");
+
+namespace tpm_binary
+{
+
+/**
+ * Check that a mapped file is a binary TPM log
+ *
+ * @param pData  The start of the file.
+ * @param len    The length of the file.
+ *
+ * @return True, if the header is valid and the file holds all the slots.
+ */
+inline bool check_header(const uint8_t* pData, size_t len)
+{
+    const TpmBinaryHeader* pHeader = reinterpret_cast<const TpmBinaryHeader*>(pData);
+
+    return len >= sizeof(TpmBinaryHeader)
+           && memcmp(pHeader->magic, TPM_BINARY_MAGIC, TPM_BINARY_MAGIC_LEN) == 0
+           && pHeader->record_size == sizeof(TpmBinaryRecord)
+           && pHeader->capacity > 0
+           && len >= sizeof(TpmBinaryHeader) + (uint64_t)pHeader->capacity * pHeader->record_size;
+}
+
+/**
+ * @param pData  The start of a file accepted by check_header().
+ *
+ * @return The total number of records written to the file.
+ */
+inline uint64_t record_count(const uint8_t* pData)
+{
+    const TpmBinaryHeader* pHeader = reinterpret_cast<const TpmBinaryHeader*>(pData);
+
+    return __atomic_load_n(&pHeader->count, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @param pData  The start of a file accepted by check_header().
+ *
+ * @return The number of the oldest record that is still in the file.
+ */
+inline uint64_t first_record(const uint8_t* pData)
+{
+    const TpmBinaryHeader* pHeader = reinterpret_cast<const TpmBinaryHeader*>(pData);
+    uint64_t count = record_count(pData);
+
+    return count > pHeader->capacity ? count - pHeader->capacity : 0;
+}
+
+/**
+ * Copy a record out of a file
+ *
+ * @param pData    The start of a file accepted by check_header().
+ * @param n        The number of the record, less than record_count().
+ * @param pRecord  The record is copied here.
+ *
+ * @return True, if the record was copied intact. False, if it has been or
+ *         is being overwritten.
+ */
+inline bool read_record(const uint8_t* pData, uint64_t n, TpmBinaryRecord* pRecord)
+{
+    const TpmBinaryHeader* pHeader = reinterpret_cast<const TpmBinaryHeader*>(pData);
+    const uint8_t* pSlot = pData + sizeof(TpmBinaryHeader)
+        + (n % pHeader->capacity) * pHeader->record_size;
+
+    memcpy(pRecord, pSlot, sizeof(*pRecord));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    // The slot is reused by record n + capacity
+    return __atomic_load_n(&pHeader->started, __ATOMIC_RELAXED) <= n + pHeader->capacity;
+}
+
+/**
+ * Store a record in a file. The file must have a single writer.
+ *
+ * @param pData    The start of a file with a valid header.
+ * @param record   The record to store.
+ *
+ * @return True, if an older record was overwritten.
+ */
+inline bool write_record(uint8_t* pData, const TpmBinaryRecord& record)
+{
+    TpmBinaryHeader* pHeader = reinterpret_cast<TpmBinaryHeader*>(pData);
+    uint64_t n = pHeader->count;
+    uint8_t* pSlot = pData + sizeof(TpmBinaryHeader) + (n % pHeader->capacity) * pHeader->record_size;
+
+    __atomic_store_n(&pHeader->started, n + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(pSlot, &record, sizeof(record));
+    __atomic_store_n(&pHeader->count, n + 1, __ATOMIC_RELEASE);
+
+    return n >= pHeader->capacity;
+}
+}
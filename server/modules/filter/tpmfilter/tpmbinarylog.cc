@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "tpmfilter"
+
+#include "tpmbinarylog.hh"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <new>
+
+#include <maxbase/atomic.hh>
+#include <maxscale/log.h>
+
+TpmBinaryLog::File::File()
+    : fd(-1)
+    , map(NULL)
+    , size(0)
+    , failed(false)
+{
+}
+
+TpmBinaryLog::File::File(const File&)
+    : fd(-1)
+    , map(NULL)
+    , size(0)
+    , failed(false)
+{
+}
+
+TpmBinaryLog::File::~File()
+{
+    if (map)
+    {
+        munmap(map, size);
+    }
+
+    if (fd != -1)
+    {
+        close(fd);
+    }
+}
+
+TpmBinaryLog::TpmBinaryLog(const std::string& filebase, uint64_t file_size)
+    : m_filebase(filebase)
+    , m_file_size(file_size)
+    , m_written(0)
+    , m_overwritten(0)
+{
+}
+
+// static
+TpmBinaryLog* TpmBinaryLog::create(const std::string& filebase, uint64_t file_size)
+{
+    TpmBinaryLog* rval = NULL;
+    uint64_t capacity = file_size > sizeof(TpmBinaryHeader) ?
+        (file_size - sizeof(TpmBinaryHeader)) / sizeof(TpmBinaryRecord) : 0;
+
+    if (capacity == 0 || capacity > UINT32_MAX)
+    {
+        MXS_ERROR("The size of a binary log file must be between %lu and %lu bytes.",
+                  (unsigned long)(sizeof(TpmBinaryHeader) + sizeof(TpmBinaryRecord)),
+                  (unsigned long)(sizeof(TpmBinaryHeader) + UINT32_MAX * sizeof(TpmBinaryRecord)));
+    }
+    else
+    {
+        // The slots are counted from the size, so it is exact
+        rval = new(std::nothrow) TpmBinaryLog(filebase,
+                                              sizeof(TpmBinaryHeader)
+                                              + capacity * sizeof(TpmBinaryRecord));
+    }
+
+    return rval;
+}
+
+void TpmBinaryLog::write(const TpmBinaryRecord& record)
+{
+    mxb_assert(mxs::RoutingWorker::get_current());
+
+    File& file = *m_files;
+
+    if (file.map || (!file.failed && open_file(file)))
+    {
+        if (tpm_binary::write_record(file.map, record))
+        {
+            mxb::atomic::add(&m_overwritten, 1, mxb::atomic::RELAXED);
+        }
+
+        mxb::atomic::add(&m_written, 1, mxb::atomic::RELAXED);
+    }
+}
+
+uint64_t TpmBinaryLog::records_written() const
+{
+    return mxb::atomic::load(&m_written, mxb::atomic::RELAXED);
+}
+
+uint64_t TpmBinaryLog::records_overwritten() const
+{
+    return mxb::atomic::load(&m_overwritten, mxb::atomic::RELAXED);
+}
+
+bool TpmBinaryLog::open_file(File& file)
+{
+    std::string filename = m_filebase + ".worker." + std::to_string(mxs::RoutingWorker::get_current_id());
+
+    // A new file is created at each start, the records of an earlier run would
+    // otherwise be mixed with the new ones.
+    file.fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+    if (file.fd != -1 && ftruncate(file.fd, m_file_size) == 0)
+    {
+        void* ptr = mmap(NULL, m_file_size, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0);
+
+        if (ptr != MAP_FAILED)
+        {
+            file.map = (uint8_t*)ptr;
+            file.size = m_file_size;
+
+            TpmBinaryHeader* pHeader = reinterpret_cast<TpmBinaryHeader*>(file.map);
+            pHeader->record_size = sizeof(TpmBinaryRecord);
+            pHeader->capacity = (m_file_size - sizeof(TpmBinaryHeader)) / sizeof(TpmBinaryRecord);
+            pHeader->count = 0;
+            pHeader->started = 0;
+            // The magic is written last, a reader ignores the file until then
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            memcpy(pHeader->magic, TPM_BINARY_MAGIC, TPM_BINARY_MAGIC_LEN);
+        }
+    }
+
+    if (!file.map)
+    {
+        MXS_ERROR("Failed to create binary log file '%s': %d, %s",
+                  filename.c_str(), errno, mxs_strerror(errno));
+        file.failed = true;
+    }
+
+    return file.map;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+
+#include <string>
+
+#include <maxscale/routingworker.hh>
+
+#include "tpmbinary.hh"
+
+/**
+ * A binary transaction log written to one memory mapped file per routing worker.
+ *
+ * The file of a worker is created when the worker logs its first transaction
+ * and has a fixed size. Only the worker writes to its file, so writing a
+ * record is a copy to memory that needs no locks. See tpmbinary.hh for the
+ * format of the files.
+ */
+class TpmBinaryLog
+{
+    TpmBinaryLog(const TpmBinaryLog&);
+    TpmBinaryLog& operator=(const TpmBinaryLog&);
+
+public:
+    /**
+     * Create a binary log
+     *
+     * @param filebase   The base of the file names. The file of worker N
+     *                   is called <filebase>.worker.N.
+     * @param file_size  The size of a file.
+     *
+     * @return New binary log or NULL, if the file size is too small
+     */
+    static TpmBinaryLog* create(const std::string& filebase, uint64_t file_size);
+
+    /**
+     * Log a transaction. Must be called from a routing worker.
+     *
+     * @param record  The transaction to log.
+     */
+    void write(const TpmBinaryRecord& record);
+
+    /**
+     * @return The number of records written.
+     */
+    uint64_t records_written() const;
+
+    /**
+     * @return The number of records that were overwritten before being read.
+     *         As the files are read by other processes, all records that were
+     *         overwritten are counted.
+     */
+    uint64_t records_overwritten() const;
+
+private:
+    // The file of a worker.
+    struct File
+    {
+        File();
+        File(const File&);      // Creates an unopened file, used for the workers' copies.
+        ~File();
+
+        int      fd;
+        uint8_t* map;
+        uint64_t size;
+        bool     failed;        // Whether opening the file failed, it is not retried.
+
+    private:
+        File& operator=(const File&);
+    };
+
+    TpmBinaryLog(const std::string& filebase, uint64_t file_size);
+
+    bool open_file(File& file);
+
+    std::string              m_filebase;
+    uint64_t                 m_file_size;
+    mxs::rworker_local<File> m_files;
+    uint64_t                 m_written;         // Updated atomically.
+    uint64_t                 m_overwritten;     // Updated atomically.
+};
@@ -32,6 +32,8 @@
  *  query_delimiter=<delimiter for query statements in a transaction (default='@@@')>
  *  source=<source address to limit filter>
  *  user=<username to limit filter>
+ *  binary_log=<base name of the binary log files, one per routing worker>
+ *  binary_log_size=<size of a binary log file (default=16Mi)>
  *
  * Date         Who             Description
  * 06/12/2015   Dong Young Yoon Initial implementation
@@ -53,6 +55,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <regex.h>
+#include <functional>
+#include <string>
 #include <thread>
 
 #include <maxscale/alloc.h>
@@ -61,9 +65,12 @@
 #include <maxscale/modutil.h>
 #include <maxscale/log.h>
 #include <maxscale/server.h>
+#include <maxscale/utils.hh>
 #include <maxbase/atomic.h>
 #include <maxscale/query_classifier.h>
 
+#include "tpmbinarylog.hh"
+
 /* The maximum size for query statements in a transaction (64MB) */
 static size_t sql_size_limit = 64 * 1024 * 1024;
 /* The size of the buffer for recording latency of individual statements */
@@ -74,6 +81,7 @@ static const int default_sql_size = 4 * 1024;
 #define DEFAULT_LOG_DELIMITER   ":::"
 #define DEFAULT_FILE_NAME       "tpm.log"
 #define DEFAULT_NAMED_PIPE      "/tmp/tpmfilter"
+#define DEFAULT_BINARY_LOG_SIZE "16Mi"
 
 /*
  * The filter entry points
@@ -115,9 +123,11 @@ struct TPM_INSTANCE
     bool  log_enabled;
 
     int         query_delimiter_size;   /* the length of the query delimiter */
-    FILE*       fp;
-    std::thread thread;
-    bool        shutdown;
+    FILE*         fp;
+    std::thread   thread;
+    bool          shutdown;
+    char*         binary_log;       /* base name of the binary log files */
+    TpmBinaryLog* binary_writer;    /* the binary log, NULL if not configured */
 };
 
 /**
@@ -148,6 +158,8 @@ typedef struct
     int            sql_index;
     int            latency_index;
     size_t         max_sql_size;
+    uint64_t       ses_id;
+    mxs::Murmur3Checksum* trx_checksum; /* checksum of the canonical statements, for the binary log */
 } TPM_SESSION;
 
 extern "C"
@@ -200,6 +212,8 @@ extern "C"
                 {"query_delimiter",    MXS_MODULE_PARAM_STRING,  DEFAULT_QUERY_DELIMITER},
                 {"source",             MXS_MODULE_PARAM_STRING},
                 {"user",               MXS_MODULE_PARAM_STRING},
+                {"binary_log",         MXS_MODULE_PARAM_STRING},
+                {"binary_log_size",    MXS_MODULE_PARAM_SIZE,    DEFAULT_BINARY_LOG_SIZE},
                 {MXS_END_MODULE_PARAMS}
             }
         };
@@ -232,9 +246,21 @@ static MXS_FILTER* createInstance(const char* name, MXS_CONFIG_PARAMETER* params
         my_instance->named_pipe = MXS_STRDUP_A(config_get_string(params, "named_pipe"));
         my_instance->source = config_copy_string(params, "source");
         my_instance->user = config_copy_string(params, "user");
+        my_instance->binary_log = config_copy_string(params, "binary_log");
 
         bool error = false;
 
+        if (my_instance->binary_log)
+        {
+            my_instance->binary_writer = TpmBinaryLog::create(my_instance->binary_log,
+                                                              config_get_size(params, "binary_log_size"));
+
+            if (!my_instance->binary_writer)
+            {
+                error = true;
+            }
+        }
+
         // check if the file exists first.
         if (access(my_instance->named_pipe, F_OK) == 0)
         {
@@ -305,6 +331,8 @@ static MXS_FILTER* createInstance(const char* name, MXS_CONFIG_PARAMETER* params
             MXS_FREE(my_instance->query_delimiter);
             MXS_FREE(my_instance->source);
             MXS_FREE(my_instance->user);
+            MXS_FREE(my_instance->binary_log);
+            delete my_instance->binary_writer;
             if (my_instance->fp)
             {
                 fclose(my_instance->fp);
@@ -346,6 +374,11 @@ static MXS_FILTER_SESSION* newSession(MXS_FILTER* instance, MXS_SESSION* session
         my_session->total.tv_sec = 0;
         my_session->total.tv_usec = 0;
         my_session->current = NULL;
+        my_session->ses_id = session->ses_id;
+        if (my_instance->binary_writer)
+        {
+            my_session->trx_checksum = new mxs::Murmur3Checksum;
+        }
         if ((remote = session_get_remote(session)) != NULL)
         {
             my_session->clientHost = MXS_STRDUP_A(remote);
@@ -410,6 +443,7 @@ static void freeSession(MXS_FILTER* instance, MXS_FILTER_SESSION* session)
     MXS_FREE(my_session->userName);
     MXS_FREE(my_session->sql);
     MXS_FREE(my_session->latency);
+    delete my_session->trx_checksum;
     MXS_FREE(session);
     return;
 }
@@ -519,6 +553,12 @@ static int routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
                 {
                     memcpy(my_session->sql, ptr, strlen(ptr));
                     my_session->sql_index += strlen(ptr);
+                    my_session->n_statements = 0;
+                    if (my_session->trx_checksum)
+                    {
+                        // A rolled back transaction may have been hashed
+                        my_session->trx_checksum->reset();
+                    }
                     gettimeofday(&my_session->current_start, NULL);
                 }
                 /* otherwise, append the statement with semicolon as a statement delimiter */
@@ -535,6 +575,22 @@ static int routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
                     /* set new pointer for the buffer */
                     my_session->sql_index += (my_instance->query_delimiter_size + strlen(ptr));
                 }
+
+                my_session->n_statements++;
+
+                if (my_instance->binary_writer)
+                {
+                    char* canonical = modutil_get_canonical(queue);
+
+                    if (canonical)
+                    {
+                        // The terminating NUL separates the statements
+                        my_session->trx_checksum->update(reinterpret_cast<uint8_t*>(canonical),
+                                                         strlen(canonical) + 1);
+                        MXS_FREE(canonical);
+                    }
+                }
+
                 gettimeofday(&my_session->last_statement_start, NULL);
             }
         }
@@ -613,6 +669,25 @@ static int clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
                     my_session->sql);
         }
 
+        if (my_instance->binary_writer)
+        {
+            TpmBinaryRecord record = {};
+            record.start = my_session->current_start.tv_sec * (uint64_t)1000000
+                + my_session->current_start.tv_usec;
+            record.end = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
+            record.session = my_session->ses_id;
+            my_session->trx_checksum->finalize();
+            record.hash = my_session->trx_checksum->value()[0];
+            record.statements = my_session->n_statements;
+
+            if (reply->server)
+            {
+                strncpy(record.server, reply->server->name, sizeof(record.server));
+            }
+
+            my_instance->binary_writer->write(record);
+        }
+
         my_session->sql_index = 0;
         my_session->latency_index = 0;
     }
@@ -670,6 +745,14 @@ static void diagnostic(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, DCB*
                    "\t\tLogging with query delimiter %s.\n",
                    my_instance->query_delimiter);
     }
+    if (my_instance->binary_writer)
+    {
+        dcb_printf(dcb,
+                   "\t\tBinary log %s, %lu transactions logged, %lu overwritten.\n",
+                   my_instance->binary_log,
+                   my_instance->binary_writer->records_written(),
+                   my_instance->binary_writer->records_overwritten());
+    }
 }
 
 /**
@@ -713,6 +796,15 @@ static json_t* diagnostic_json(const MXS_FILTER* instance, const MXS_FILTER_SESS
         json_object_set_new(rval, "query_delimiter", json_string(my_instance->query_delimiter));
     }
 
+    if (my_instance->binary_writer)
+    {
+        json_object_set_new(rval, "binary_log", json_string(my_instance->binary_log));
+        json_object_set_new(rval, "binary_records",
+                            json_integer(my_instance->binary_writer->records_written()));
+        json_object_set_new(rval, "binary_records_overwritten",
+                            json_integer(my_instance->binary_writer->records_overwritten()));
+    }
+
     return rval;
 }
 
@@ -736,6 +828,9 @@ static void destroyInstance(MXS_FILTER* instance)
     {
         my_instance->thread.join();
     }
+
+    delete my_instance->binary_writer;
+    my_instance->binary_writer = NULL;
 }
 
 static void checkNamedPipe(TPM_INSTANCE* inst)
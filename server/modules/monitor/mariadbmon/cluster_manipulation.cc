@@ -14,8 +14,11 @@
 #include "mariadbmon.hh"
 
 #include <inttypes.h>
+#include <functional>
 #include <set>
 #include <sstream>
+#include <system_error>
+#include <thread>
 #include <maxbase/stopwatch.hh>
 #include <maxscale/clock.h>
 #include <maxscale/mysql_utils.h>
@@ -39,6 +42,92 @@ static void print_redirect_errors(MariaDBServer* first_server,
                                   const ServerArray& servers,
                                   json_t** err_out);
 
+/**
+ * Run a function concurrently for each server, in a thread of its own. Each server has its own connection,
+ * so the functions may run queries on their server. Returns once all the calls have completed.
+ *
+ * @param servers The servers
+ * @param func The function to run. Is given the index of the server in the array.
+ */
+static void run_on_servers_parallel(const ServerArray& servers, const std::function<void(size_t)>& func)
+{
+    auto thread_func = [&func](size_t i) {
+            mysql_thread_init();
+            func(i);
+            mysql_thread_end();
+        };
+
+    std::vector<std::thread> threads;
+    threads.reserve(servers.size());
+    for (size_t i = 0; i < servers.size(); i++)
+    {
+        try
+        {
+            threads.emplace_back(thread_func, i);
+        }
+        catch (const std::system_error& e)
+        {
+            // Could not start a thread, run in the monitor thread instead.
+            MXS_WARNING("Could not start thread for %s: %s", servers[i]->name(), e.what());
+            func(i);
+        }
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/**
+ * Move the json errors of a part of an operation to the operation error output.
+ *
+ * @param err_out Operation error output
+ * @param errors Errors of the part, freed by this function
+ */
+static void merge_json_errors(json_t** err_out, json_t* errors)
+{
+    if (errors && err_out)
+    {
+        if (*err_out)
+        {
+            json_array_extend(json_object_get(*err_out, "errors"), json_object_get(errors, "errors"));
+            json_decref(errors);
+        }
+        else
+        {
+            *err_out = errors;
+        }
+    }
+    else
+    {
+        json_decref(errors);
+    }
+}
+
+/**
+ * Add the phase timings and slave results of an operation to the command output.
+ *
+ * @param op The operation
+ * @param output Command output
+ */
+static void add_operation_report(const ClusterOperation& op, json_t** output)
+{
+    if (output)
+    {
+        json_t* report = op.report_to_json();
+        if (*output)
+        {
+            json_object_update(*output, report);
+            json_decref(report);
+        }
+        else
+        {
+            *output = report;
+        }
+    }
+}
+
 /**
  * Run a manual switchover, promoting a new master server and demoting the existing master.
  *
@@ -77,6 +166,7 @@ bool MariaDBMonitor::manual_switchover(SERVER* promotion_server, SERVER* demotio
             msg += ".";
             PRINT_MXS_JSON_ERROR(error_out, "%s", msg.c_str());
         }
+        add_operation_report(*op, error_out);
     }
     else
     {
@@ -101,6 +191,7 @@ bool MariaDBMonitor::manual_failover(json_t** output)
             PRINT_MXS_JSON_ERROR(output, FAILOVER_FAIL,
                                  op->demotion_target->name(), op->promotion_target->name());
         }
+        add_operation_report(*op, output);
     }
     else
     {
@@ -409,13 +500,19 @@ int MariaDBMonitor::redirect_slaves(MariaDBServer* new_master,
     MXS_NOTICE("Redirecting slaves to new master.");
     string change_cmd = generate_change_master_cmd(new_master->m_server_base->server->address,
                                                    new_master->m_server_base->server->port);
+    // The slaves are independent of each other, so redirect them all at once.
+    std::vector<char> results(slaves.size(), false);
+    run_on_servers_parallel(slaves, [&slaves, &change_cmd, &results](size_t i) {
+                                results[i] = slaves[i]->redirect_one_slave(change_cmd);
+                            });
+
     int successes = 0;
-    for (MariaDBServer* slave : slaves)
+    for (size_t i = 0; i < slaves.size(); i++)
     {
-        if (slave->redirect_one_slave(change_cmd))
+        if (results[i])
         {
             successes++;
-            redirected_slaves->push_back(slave);
+            redirected_slaves->push_back(slaves[i]);
         }
     }
     return successes;
@@ -442,15 +539,39 @@ int MariaDBMonitor::redirect_slaves_ex(ClusterOperation& op, const ServerArray&
     string slave_names = monitored_servers_to_string(slaves);
     MXS_NOTICE("Redirecting %s to replicate from %s instead of %s.",
                slave_names.c_str(), op.promotion_target->name(), op.demotion_target->name());
+    StopWatch timer;
+    // Each slave is redirected in its own thread with its own part of the operation. The parts share the
+    // time limit of the operation.
+    size_t n_slaves = slaves.size();
+    std::vector<json_t*> errors(n_slaves, NULL);
+    std::vector<unique_ptr<ClusterOperation>> parts;
+    parts.reserve(n_slaves);
+    for (size_t i = 0; i < n_slaves; i++)
+    {
+        parts.emplace_back(new ClusterOperation(op, &errors[i]));
+    }
+
+    std::vector<char> results(n_slaves, false);
+    run_on_servers_parallel(slaves, [&slaves, &parts, &results](size_t i) {
+                                results[i] = slaves[i]->redirect_existing_slave_conn(*parts[i]);
+                            });
+
     int successes = 0;
-    for (MariaDBServer* redirectable : slaves)
+    for (size_t i = 0; i < n_slaves; i++)
     {
-        if (redirectable->redirect_existing_slave_conn(op))
+        merge_json_errors(op.error_out, errors[i]);
+        if (results[i])
         {
             successes++;
-            redirected_slaves->push_back(redirectable);
+            redirected_slaves->push_back(slaves[i]);
+        }
+        else
+        {
+            op.slave_results[slaves[i]->name()] = "redirect_failed";
         }
     }
+    op.time_remaining -= timer.lap();
+
     if (size_t(successes) == slaves.size())
     {
         MXS_NOTICE("All redirects successful.");
@@ -733,8 +854,11 @@ bool MariaDBMonitor::switchover_perform(ClusterOperation& op)
     ServerArray redirectable_slaves = get_redirectables(promotion_target, demotion_target);
 
     bool rval = false;
+    StopWatch phase_timer;
     // Step 2: Set read-only to on, flush logs, update gtid:s.
-    if (demotion_target->demote(op))
+    bool demoted = demotion_target->demote(op);
+    op.add_phase_time("demotion", phase_timer.restart());
+    if (demoted)
     {
         m_cluster_modified = true;
         bool catchup_and_promote_success = false;
@@ -742,11 +866,15 @@ bool MariaDBMonitor::switchover_perform(ClusterOperation& op)
         // Step 3: Wait for the promotion target to catch up with the demotion target. Disregard the other
         // slaves of the promotion target to avoid needless waiting.
         // The gtid:s of the demotion target were updated at the end of demotion.
-        if (promotion_target->catchup_to_master(op))
+        bool caught_up = promotion_target->catchup_to_master(op);
+        op.add_phase_time("catchup", phase_timer.restart());
+        if (caught_up)
         {
             MXS_INFO("Switchover: Catchup took %.1f seconds.", timer.lap().secs());
             // Step 4: On new master: remove slave connections, set read-only to OFF etc.
-            if (promotion_target->promote(op))
+            bool promoted = promotion_target->promote(op);
+            op.add_phase_time("promotion", phase_timer.restart());
+            if (promoted)
             {
                 // Point of no return. Even if following steps fail, do not try to undo.
                 // Switchover considered at least partially successful.
@@ -769,6 +897,7 @@ bool MariaDBMonitor::switchover_perform(ClusterOperation& op)
                 op.time_remaining -= timer.lap();
 
                 int redirects = redirect_slaves_ex(op, redirectable_slaves, &redirected_slaves);
+                op.add_phase_time("redirection", phase_timer.restart());
 
                 bool success = redirectable_slaves.empty() ? start_ok : start_ok || redirects > 0;
                 if (success)
@@ -777,6 +906,7 @@ bool MariaDBMonitor::switchover_perform(ClusterOperation& op)
                     // Step 6: Finally, check that slaves are replicating.
                     wait_cluster_stabilization(op, redirected_slaves);
                     auto step6_duration = timer.lap();
+                    op.add_phase_time("stabilization", step6_duration);
                     MXS_INFO("Switchover: slave replication confirmation took %.1f seconds with "
                              "%.1f seconds to spare.",
                              step6_duration.secs(), op.time_remaining.secs());
@@ -825,8 +955,11 @@ bool MariaDBMonitor::failover_perform(ClusterOperation& op)
     ServerArray redirectable_slaves = get_redirectables(promotion_target, op.demotion_target);
 
     bool rval = false;
+    StopWatch phase_timer;
     // Step 2: Stop and reset slave, set read-only to OFF.
-    if (promotion_target->promote(op))
+    bool promoted = promotion_target->promote(op);
+    op.add_phase_time("promotion", phase_timer.restart());
+    if (promoted)
     {
         // Point of no return. Even if following steps fail, do not try to undo. Failover considered
         // at least partially successful.
@@ -841,6 +974,7 @@ bool MariaDBMonitor::failover_perform(ClusterOperation& op)
         // Step 3: Redirect slaves.
         ServerArray redirected_slaves;
         redirect_slaves_ex(op, redirectable_slaves, &redirected_slaves);
+        op.add_phase_time("redirection", phase_timer.restart());
         if (!redirected_slaves.empty())
         {
             StopWatch timer;
@@ -848,9 +982,11 @@ bool MariaDBMonitor::failover_perform(ClusterOperation& op)
              * time is out at this point, wait_cluster_stabilization() will check the slaves
              * once so that latest status is printed. */
             wait_cluster_stabilization(op, redirected_slaves);
+            auto step4_duration = timer.lap();
+            op.add_phase_time("stabilization", step4_duration);
             MXS_INFO("Failover: slave replication confirmation took %.1f seconds with "
                      "%.1f seconds to spare.",
-                     timer.lap().secs(), op.time_remaining.secs());
+                     step4_duration.secs(), op.time_remaining.secs());
         }
     }
     return rval;
@@ -882,11 +1018,18 @@ void MariaDBMonitor::wait_cluster_stabilization(ClusterOperation& op, const Serv
 
     while (!unconfirmed.empty() && !time_is_up)
     {
-        auto iter = unconfirmed.begin();
-        while (iter != unconfirmed.end())
+        // Query the slave status of all unconfirmed slaves at once, then go through the results.
+        ServerArray checked(unconfirmed.begin(), unconfirmed.end());
+        std::vector<char> query_ok(checked.size(), false);
+        run_on_servers_parallel(checked, [&checked, &query_ok](size_t i) {
+                                    query_ok[i] = checked[i]->do_show_slave_status();
+                                });
+
+        for (size_t i = 0; i < checked.size(); i++)
         {
-            MariaDBServer* slave = *iter;
-            if (slave->do_show_slave_status())
+            MariaDBServer* slave = checked[i];
+            auto iter = unconfirmed.find(slave);
+            if (query_ok[i])
             {
                 auto slave_conn = slave->slave_connection_status_host_port(new_master);
                 if (slave_conn == NULL)
@@ -895,15 +1038,15 @@ void MariaDBMonitor::wait_cluster_stabilization(ClusterOperation& op, const Serv
                     MXS_WARNING("%s does not have a slave connection to %s although one should have "
                                 "been created.",
                                 slave->name(), new_master->name());
-                    repl_fails.push_back(*iter);
-                    iter = unconfirmed.erase(iter);
+                    repl_fails.push_back(slave);
+                    unconfirmed.erase(iter);
                 }
                 else if (slave_conn->slave_io_running == SlaveStatus::SLAVE_IO_YES
                          && slave_conn->slave_sql_running == true)
                 {
                     // This slave has connected to master and replication seems to be ok.
-                    successes.push_back(*iter);
-                    iter = unconfirmed.erase(iter);
+                    successes.push_back(slave);
+                    unconfirmed.erase(iter);
                 }
                 else if (slave_conn->slave_io_running == SlaveStatus::SLAVE_IO_NO)
                 {
@@ -911,8 +1054,8 @@ void MariaDBMonitor::wait_cluster_stabilization(ClusterOperation& op, const Serv
                     MXS_WARNING("%s cannot start replication because of IO thread error: '%s'.",
                                 slave_conn->to_short_string(slave->name()).c_str(),
                                 slave_conn->last_error.c_str());
-                    repl_fails.push_back(*iter);
-                    iter = unconfirmed.erase(iter);
+                    repl_fails.push_back(slave);
+                    unconfirmed.erase(iter);
                 }
                 else if (slave_conn->slave_sql_running == false)
                 {
@@ -920,19 +1063,15 @@ void MariaDBMonitor::wait_cluster_stabilization(ClusterOperation& op, const Serv
                     MXS_WARNING("%s cannot start replication because of SQL thread error: '%s'.",
                                 slave_conn->to_short_string(slave->name()).c_str(),
                                 slave_conn->last_error.c_str());
-                    repl_fails.push_back(*iter);
-                    iter = unconfirmed.erase(iter);
-                }
-                else
-                {
-                    // Slave IO is still connecting, must wait.
-                    ++iter;
+                    repl_fails.push_back(slave);
+                    unconfirmed.erase(iter);
                 }
+                // Otherwise slave IO is still connecting, must wait.
             }
             else
             {
-                query_fails.push_back(*iter);
-                iter = unconfirmed.erase(iter);
+                query_fails.push_back(slave);
+                unconfirmed.erase(iter);
             }
         }
 
@@ -979,6 +1118,23 @@ void MariaDBMonitor::wait_cluster_stabilization(ClusterOperation& op, const Serv
         MXS_WARNING(MSG, fails, new_master->name(), repl_fails.size(), query_fails.size(),
                     unconfirmed.size(), new_master->name());
     }
+
+    for (MariaDBServer* slave : successes)
+    {
+        op.slave_results[slave->name()] = "replicating";
+    }
+    for (MariaDBServer* slave : repl_fails)
+    {
+        op.slave_results[slave->name()] = "replication_error";
+    }
+    for (MariaDBServer* slave : query_fails)
+    {
+        op.slave_results[slave->name()] = "query_failed";
+    }
+    for (MariaDBServer* slave : unconfirmed)
+    {
+        op.slave_results[slave->name()] = "timeout";
+    }
     op.time_remaining -= timer.lap();
 }
 
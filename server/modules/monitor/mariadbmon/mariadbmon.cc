@@ -483,6 +483,9 @@ void MariaDBMonitor::tick()
         SERVER* srv = server->m_server_base->server;
         srv->rlag = server->m_replication_lag;
         srv->status = server->m_server_base->pending_status;
+        // Published for the routers, which use it for causal reads
+        string gtid_pos = server->is_running() ? server->m_gtid_current_pos.to_string() : "";
+        server_set_gtid_pos(srv, gtid_pos.c_str());
     }
 
     log_master_changes();
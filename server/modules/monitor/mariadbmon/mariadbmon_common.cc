@@ -52,3 +52,43 @@ ClusterOperation::ClusterOperation(OperationType type,
     , time_remaining(time_remaining)
 {
 }
+
+ClusterOperation::ClusterOperation(const ClusterOperation& op, json_t** error)
+    : type(op.type)
+    , promotion_target(op.promotion_target)
+    , demotion_target(op.demotion_target)
+    , demotion_target_is_master(op.demotion_target_is_master)
+    , handle_events(op.handle_events)
+    , promotion_sql_file(op.promotion_sql_file)
+    , demotion_sql_file(op.demotion_sql_file)
+    , replication_user(op.replication_user)
+    , replication_password(op.replication_password)
+    , error_out(error)
+    , time_remaining(op.time_remaining)
+{
+}
+
+void ClusterOperation::add_phase_time(const string& phase, maxbase::Duration duration)
+{
+    phase_times.emplace_back(phase, duration.secs());
+}
+
+json_t* ClusterOperation::report_to_json() const
+{
+    json_t* phases = json_object();
+    for (const auto& elem : phase_times)
+    {
+        json_object_set_new(phases, elem.first.c_str(), json_real(elem.second));
+    }
+
+    json_t* slaves = json_object();
+    for (const auto& elem : slave_results)
+    {
+        json_object_set_new(slaves, elem.first.c_str(), json_string(elem.second.c_str()));
+    }
+
+    json_t* rval = json_object();
+    json_object_set_new(rval, "phase_times", phases);
+    json_object_set_new(rval, "slaves", slaves);
+    return rval;
+}
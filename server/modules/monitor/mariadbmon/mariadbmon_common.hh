@@ -20,7 +20,9 @@
 
 #include <maxscale/ccdefs.hh>
 
+#include <map>
 #include <string>
+#include <vector>
 #include <maxscale/json_api.h>
 #include <maxbase/stopwatch.hh>
 
@@ -105,10 +107,37 @@ public:
     json_t** const       error_out;                     // Json error output
     maxbase::Duration    time_remaining;                // How much time remains to complete the operation
 
+    std::vector<std::pair<std::string, double>> phase_times;    // Duration of each phase in seconds
+    std::map<std::string, std::string>          slave_results;  // Outcome for each slave
+
     ClusterOperation(OperationType type,
                      MariaDBServer* promotion_target, MariaDBServer* demotion_target,
                      bool demo_target_is_master, bool handle_events,
                      std::string& promotion_sql_file, std::string& demotion_sql_file,
                      std::string& replication_user, std::string& replication_password,
                      json_t** error, maxbase::Duration time_remaining);
+
+    /**
+     * Create a part of an operation, to be run on one server concurrently with the other parts.
+     * The part has the same settings and time limit as the operation, but its own error output.
+     *
+     * @param op The operation
+     * @param error Json error output of the part
+     */
+    ClusterOperation(const ClusterOperation& op, json_t** error);
+
+    /**
+     * Record how long a phase of the operation took.
+     *
+     * @param phase Name of the phase
+     * @param duration Duration of the phase
+     */
+    void add_phase_time(const std::string& phase, maxbase::Duration duration);
+
+    /**
+     * Get the phase timings and slave results as json.
+     *
+     * @return Json object
+     */
+    json_t* report_to_json() const;
 };
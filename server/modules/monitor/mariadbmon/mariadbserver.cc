@@ -54,6 +54,7 @@ MariaDBServer::MariaDBServer(MXS_MONITORED_SERVER* monitored_server, int config_
     , m_topology_changed(true)
     , m_replication_lag(MXS_RLAG_UNDEFINED)
     , m_print_update_errormsg(true)
+    , m_multi_stmt(MultiStmt::UNKNOWN)
 {
     mxb_assert(monitored_server);
 }
@@ -108,6 +109,43 @@ std::unique_ptr<QueryResult> MariaDBServer::execute_query(const string& query, s
     return rval;
 }
 
+bool MariaDBServer::execute_multi_query(const string& query, QueryResultArray* results_out,
+                                        string* errmsg_out)
+{
+    auto conn = m_server_base->con;
+    bool rval = false;
+    if (mxs_mysql_query(conn, query.c_str()) == 0)
+    {
+        rval = true;
+        int next = 0;
+        // Read all the result sets, even after an error, so that the connection stays usable.
+        while (next == 0)
+        {
+            MYSQL_RES* result = mysql_store_result(conn);
+            if (result)
+            {
+                results_out->emplace_back(new QueryResult(result));
+            }
+            else
+            {
+                rval = false;
+            }
+            next = mysql_next_result(conn);
+        }
+
+        if (next > 0)
+        {
+            rval = false;
+        }
+    }
+
+    if (!rval && errmsg_out)
+    {
+        *errmsg_out = string_printf("Query '%s' failed: '%s'.", query.c_str(), mysql_error(conn));
+    }
+    return rval;
+}
+
 /**
  * Execute a query which does not return data. If the query returns data, an error is returned.
  *
@@ -227,55 +265,72 @@ bool MariaDBServer::execute_cmd_time_limit(const std::string& cmd, maxbase::Dura
     return cmd_success;
 }
 
-bool MariaDBServer::do_show_slave_status(string* errmsg_out)
+const char* MariaDBServer::slave_status_query() const
 {
-    unsigned int columns = 0;
-    string query;
-    bool all_slaves_status = false;
+    const char* query = NULL;
     switch (m_version)
     {
     case version::MARIADB_100:
     case version::BINLOG_ROUTER:
-        columns = 42;
-        all_slaves_status = true;
         query = "SHOW ALL SLAVES STATUS";
         break;
 
     case version::MARIADB_MYSQL_55:
-        columns = 40;
         query = "SHOW SLAVE STATUS";
         break;
 
     default:
-        mxb_assert(!true);      // This method should not be called for versions < 5.5
-        return false;
+        break;
     }
+    return query;
+}
 
-    auto result = execute_query(query, errmsg_out);
-    if (result.get() == NULL)
+bool MariaDBServer::do_show_slave_status(string* errmsg_out)
+{
+    const char* query = slave_status_query();
+    if (query == NULL)
     {
+        mxb_assert(!true);      // This method should not be called for versions < 5.5
         return false;
     }
-    else if (result->get_col_count() < columns)
+
+    auto result = execute_query(query, errmsg_out);
+    return result.get() != NULL && process_slave_status(*result);
+}
+
+bool MariaDBServer::process_slave_status(QueryResult& result)
+{
+    string query = slave_status_query();
+    bool all_slaves_status = (m_version != version::MARIADB_MYSQL_55);
+    unsigned int columns = all_slaves_status ? 42 : 40;
+
+    if (result.get_col_count() < columns)
     {
         MXS_ERROR("'%s' returned less than the expected amount of columns. Expected %u columns, "
                   "got %" PRId64 ".",
                   query.c_str(),
                   columns,
-                  result->get_col_count());
+                  result.get_col_count());
         return false;
     }
 
+    // If nothing has changed since the previous update, there is nothing to parse.
+    string raw = result.to_raw_string();
+    if (raw == m_slave_status_raw)
+    {
+        return true;
+    }
+
     // Fields common to all server versions
-    auto i_master_host = result->get_col_index("Master_Host");
-    auto i_master_port = result->get_col_index("Master_Port");
-    auto i_slave_io_running = result->get_col_index("Slave_IO_Running");
-    auto i_slave_sql_running = result->get_col_index("Slave_SQL_Running");
-    auto i_master_server_id = result->get_col_index("Master_Server_Id");
-    auto i_last_io_errno = result->get_col_index("Last_IO_Errno");
-    auto i_last_io_error = result->get_col_index("Last_IO_Error");
-    auto i_last_sql_error = result->get_col_index("Last_SQL_Error");
-    auto i_seconds_behind_master = result->get_col_index("Seconds_Behind_Master");
+    auto i_master_host = result.get_col_index("Master_Host");
+    auto i_master_port = result.get_col_index("Master_Port");
+    auto i_slave_io_running = result.get_col_index("Slave_IO_Running");
+    auto i_slave_sql_running = result.get_col_index("Slave_SQL_Running");
+    auto i_master_server_id = result.get_col_index("Master_Server_Id");
+    auto i_last_io_errno = result.get_col_index("Last_IO_Errno");
+    auto i_last_io_error = result.get_col_index("Last_IO_Error");
+    auto i_last_sql_error = result.get_col_index("Last_SQL_Error");
+    auto i_seconds_behind_master = result.get_col_index("Seconds_Behind_Master");
 
     const char INVALID_DATA[] = "'%s' returned invalid data.";
     if (i_master_host < 0 || i_master_port < 0 || i_slave_io_running < 0 || i_slave_sql_running < 0
@@ -290,11 +345,11 @@ bool MariaDBServer::do_show_slave_status(string* errmsg_out)
     int64_t i_using_gtid = -1, i_gtid_io_pos = -1;
     if (all_slaves_status)
     {
-        i_connection_name = result->get_col_index("Connection_name");
-        i_slave_rec_hbs = result->get_col_index("Slave_received_heartbeats");
-        i_slave_hb_period = result->get_col_index("Slave_heartbeat_period");
-        i_using_gtid = result->get_col_index("Using_Gtid");
-        i_gtid_io_pos = result->get_col_index("Gtid_IO_Pos");
+        i_connection_name = result.get_col_index("Connection_name");
+        i_slave_rec_hbs = result.get_col_index("Slave_received_heartbeats");
+        i_slave_hb_period = result.get_col_index("Slave_heartbeat_period");
+        i_using_gtid = result.get_col_index("Using_Gtid");
+        i_gtid_io_pos = result.get_col_index("Gtid_IO_Pos");
         if (i_connection_name < 0 || i_slave_rec_hbs < 0 || i_slave_hb_period < 0
             || i_using_gtid < 0 || i_gtid_io_pos < 0)
         {
@@ -304,32 +359,32 @@ bool MariaDBServer::do_show_slave_status(string* errmsg_out)
     }
 
     SlaveStatusArray slave_status_new;
-    while (result->next_row())
+    while (result.next_row())
     {
         SlaveStatus new_row;
-        new_row.master_host = result->get_string(i_master_host);
-        new_row.master_port = result->get_uint(i_master_port);
-        string last_io_error = result->get_string(i_last_io_error);
-        string last_sql_error = result->get_string(i_last_sql_error);
+        new_row.master_host = result.get_string(i_master_host);
+        new_row.master_port = result.get_uint(i_master_port);
+        string last_io_error = result.get_string(i_last_io_error);
+        string last_sql_error = result.get_string(i_last_sql_error);
         new_row.last_error = !last_io_error.empty() ? last_io_error : last_sql_error;
 
         new_row.slave_io_running =
-            SlaveStatus::slave_io_from_string(result->get_string(i_slave_io_running));
-        new_row.slave_sql_running = (result->get_string(i_slave_sql_running) == "Yes");
-        new_row.master_server_id = result->get_uint(i_master_server_id);
+            SlaveStatus::slave_io_from_string(result.get_string(i_slave_io_running));
+        new_row.slave_sql_running = (result.get_string(i_slave_sql_running) == "Yes");
+        new_row.master_server_id = result.get_uint(i_master_server_id);
 
-        auto rlag = result->get_uint(i_seconds_behind_master);
+        auto rlag = result.get_uint(i_seconds_behind_master);
         // If slave connection is stopped, the value given by the backend is null -> -1.
         new_row.seconds_behind_master = (rlag < 0) ? MXS_RLAG_UNDEFINED :
             (rlag > INT_MAX) ? INT_MAX : rlag;
 
         if (all_slaves_status)
         {
-            new_row.name = result->get_string(i_connection_name);
-            new_row.received_heartbeats = result->get_uint(i_slave_rec_hbs);
+            new_row.name = result.get_string(i_connection_name);
+            new_row.received_heartbeats = result.get_uint(i_slave_rec_hbs);
 
-            string using_gtid = result->get_string(i_using_gtid);
-            string gtid_io_pos = result->get_string(i_gtid_io_pos);
+            string using_gtid = result.get_string(i_using_gtid);
+            string gtid_io_pos = result.get_string(i_gtid_io_pos);
             if (!gtid_io_pos.empty() && (using_gtid == "Current_Pos" || using_gtid == "Slave_Pos"))
             {
                 new_row.gtid_io_pos = GtidList::from_string(gtid_io_pos);
@@ -380,6 +435,7 @@ bool MariaDBServer::do_show_slave_status(string* errmsg_out)
     // Always write to m_slave_status. Even if the new status is equal by topology,
     // gtid:s etc may have changed.
     m_slave_status = std::move(slave_status_new);
+    m_slave_status_raw = std::move(raw);
     return true;
 }
 
@@ -393,31 +449,30 @@ bool MariaDBServer::update_gtids(string* errmsg_out)
     auto result = execute_query(query, errmsg_out);
     if (result.get() != NULL && result->next_row())
     {
-        auto current_str = result->get_string(i_current_pos);
-        auto binlog_str = result->get_string(i_binlog_pos);
-        bool current_ok = false;
-        if (current_str.empty())
-        {
-            m_gtid_current_pos = GtidList();
-        }
-        else
-        {
-            m_gtid_current_pos = GtidList::from_string(current_str);
-            current_ok = !m_gtid_current_pos.empty();
-        }
+        rval = process_gtids(*result, i_current_pos, i_binlog_pos);
+    }
+    return rval;
+}
 
-        if (binlog_str.empty())
-        {
-            m_gtid_binlog_pos = GtidList();
-        }
-        else
-        {
-            m_gtid_binlog_pos = GtidList::from_string(binlog_str);
-        }
+bool MariaDBServer::process_gtids(const QueryResult& result, int64_t i_current_pos, int64_t i_binlog_pos)
+{
+    auto current_str = result.get_string(i_current_pos);
+    auto binlog_str = result.get_string(i_binlog_pos);
 
-        rval = current_ok;
+    // Only parse the gtid lists that have changed.
+    if (current_str != m_gtid_current_pos_raw || current_str.empty())
+    {
+        m_gtid_current_pos = current_str.empty() ? GtidList() : GtidList::from_string(current_str);
+        m_gtid_current_pos_raw = current_str;
     }
-    return rval;
+
+    if (binlog_str != m_gtid_binlog_pos_raw || binlog_str.empty())
+    {
+        m_gtid_binlog_pos = binlog_str.empty() ? GtidList() : GtidList::from_string(binlog_str);
+        m_gtid_binlog_pos_raw = binlog_str;
+    }
+
+    return !current_str.empty() && !m_gtid_current_pos.empty();
 }
 
 bool MariaDBServer::update_replication_settings(std::string* errmsg_out)
@@ -438,58 +493,63 @@ bool MariaDBServer::update_replication_settings(std::string* errmsg_out)
 
 bool MariaDBServer::read_server_variables(string* errmsg_out)
 {
-    MXS_MONITORED_SERVER* database = m_server_base;
     string query = "SELECT @@global.server_id, @@read_only;";
-    int columns = 2;
+    int64_t i_domain = -1;
     if (m_version == version::MARIADB_100)
     {
         query.erase(query.end() - 1);
         query += ", @@global.gtid_domain_id;";
-        columns = 3;
+        i_domain = 2;
     }
 
-    int i_id = 0;
-    int i_ro = 1;
-    int i_domain = 2;
     bool rval = false;
     auto result = execute_query(query, errmsg_out);
     if (result.get() != NULL && result->next_row())
     {
-        rval = true;
-        int64_t server_id_parsed = result->get_uint(i_id);
-        if (server_id_parsed < 0)   // This is very unlikely, requiring an error in server or connector.
-        {
-            server_id_parsed = SERVER_ID_UNKNOWN;
-            rval = false;
-        }
-        if (server_id_parsed != m_server_id)
-        {
-            m_server_id = server_id_parsed;
-            m_topology_changed = true;
-        }
-        database->server->node_id = server_id_parsed;
+        rval = process_server_variables(*result, i_domain);
+    }
+    return rval;
+}
 
-        bool read_only_parsed = result->get_bool(i_ro);
-        if (read_only_parsed != m_read_only)
-        {
-            m_read_only = read_only_parsed;
-            m_topology_changed = true;
-        }
+bool MariaDBServer::process_server_variables(const QueryResult& result, int64_t i_domain)
+{
+    MXS_MONITORED_SERVER* database = m_server_base;
+    int i_id = 0;
+    int i_ro = 1;
+    bool rval = true;
+    int64_t server_id_parsed = result.get_uint(i_id);
+    if (server_id_parsed < 0)   // This is very unlikely, requiring an error in server or connector.
+    {
+        server_id_parsed = SERVER_ID_UNKNOWN;
+        rval = false;
+    }
+    if (server_id_parsed != m_server_id)
+    {
+        m_server_id = server_id_parsed;
+        m_topology_changed = true;
+    }
+    database->server->node_id = server_id_parsed;
 
-        if (columns == 3)
-        {
-            int64_t domain_id_parsed = result->get_uint(i_domain);
-            if (domain_id_parsed < 0)   // Same here.
-            {
-                domain_id_parsed = GTID_DOMAIN_UNKNOWN;
-                rval = false;
-            }
-            m_gtid_domain_id = domain_id_parsed;
-        }
-        else
+    bool read_only_parsed = result.get_bool(i_ro);
+    if (read_only_parsed != m_read_only)
+    {
+        m_read_only = read_only_parsed;
+        m_topology_changed = true;
+    }
+
+    if (i_domain >= 0)
+    {
+        int64_t domain_id_parsed = result.get_uint(i_domain);
+        if (domain_id_parsed < 0)   // Same here.
         {
-            m_gtid_domain_id = GTID_DOMAIN_UNKNOWN;
+            domain_id_parsed = GTID_DOMAIN_UNKNOWN;
+            rval = false;
         }
+        m_gtid_domain_id = domain_id_parsed;
+    }
+    else
+    {
+        m_gtid_domain_id = GTID_DOMAIN_UNKNOWN;
     }
     return rval;
 }
@@ -867,12 +927,26 @@ void MariaDBServer::monitor_server()
     switch (m_version)
     {
     case version::MARIADB_MYSQL_55:
-        query_ok = read_server_variables(&errmsg) && update_slave_status(&errmsg);
+        if (enable_multi_statements())
+        {
+            query_ok = update_status_batched(&errmsg);
+        }
+        else
+        {
+            query_ok = read_server_variables(&errmsg) && update_slave_status(&errmsg);
+        }
         break;
 
     case version::MARIADB_100:
-        query_ok = read_server_variables(&errmsg) && update_gtids(&errmsg)
-            && update_slave_status(&errmsg);
+        if (enable_multi_statements())
+        {
+            query_ok = update_status_batched(&errmsg);
+        }
+        else
+        {
+            query_ok = read_server_variables(&errmsg) && update_gtids(&errmsg)
+                && update_slave_status(&errmsg);
+        }
         break;
 
     case version::BINLOG_ROUTER:
@@ -912,9 +986,77 @@ bool MariaDBServer::update_slave_status(string* errmsg_out)
     bool rval = do_show_slave_status(errmsg_out);
     if (rval)
     {
-        /** Store master_id of current node. */
-        m_server_base->server->master_id = !m_slave_status.empty() ?
-            m_slave_status[0].master_server_id : SERVER_ID_UNKNOWN;
+        update_master_id();
+    }
+    return rval;
+}
+
+void MariaDBServer::update_master_id()
+{
+    /** Store master_id of current node. */
+    m_server_base->server->master_id = !m_slave_status.empty() ?
+        m_slave_status[0].master_server_id : SERVER_ID_UNKNOWN;
+}
+
+/**
+ * Enable multi-statements on the monitor connection, unless already tried on the current connection.
+ *
+ * @return True if multi-statements are enabled
+ */
+bool MariaDBServer::enable_multi_statements()
+{
+    if (m_multi_stmt == MultiStmt::UNKNOWN)
+    {
+        auto conn = m_server_base->con;
+        if (mysql_set_server_option(conn, MYSQL_OPTION_MULTI_STATEMENTS_ON) == 0)
+        {
+            m_multi_stmt = MultiStmt::ON;
+        }
+        else
+        {
+            MXS_INFO("Could not enable multi-statements on '%s', querying the server with separate "
+                     "queries: '%s'.", name(), mysql_error(conn));
+            m_multi_stmt = MultiStmt::OFF;
+        }
+    }
+    return m_multi_stmt == MultiStmt::ON;
+}
+
+/**
+ * Update server variables, gtid:s and slave status with one multi-statement query.
+ *
+ * @param errmsg_out Where to store an error message if query fails
+ * @return True on success
+ */
+bool MariaDBServer::update_status_batched(string* errmsg_out)
+{
+    bool is_mariadb = (m_version == version::MARIADB_100);
+    string query = is_mariadb ?
+        "SELECT @@global.server_id, @@read_only, @@global.gtid_domain_id, "
+        "@@gtid_current_pos, @@gtid_binlog_pos;" :
+        "SELECT @@global.server_id, @@read_only;";
+    query += slave_status_query();
+
+    bool rval = false;
+    QueryResultArray results;
+    if (execute_multi_query(query, &results, errmsg_out))
+    {
+        if (results.size() == 2 && results[0]->next_row())
+        {
+            rval = process_server_variables(*results[0], is_mariadb ? 2 : -1)
+                && (!is_mariadb || process_gtids(*results[0], 3, 4))
+                && process_slave_status(*results[1]);
+            if (rval)
+            {
+                update_master_id();
+            }
+        }
+    }
+    else
+    {
+        /* The connection may have been silently reconnected, losing the multi-statement setting. Enable it
+         * again before the next update. */
+        m_multi_stmt = MultiStmt::UNKNOWN;
     }
     return rval;
 }
@@ -922,6 +1064,8 @@ bool MariaDBServer::update_slave_status(string* errmsg_out)
 void MariaDBServer::update_server_version()
 {
     m_version = version::UNKNOWN;
+    // A new connection, multi-statements are not enabled.
+    m_multi_stmt = MultiStmt::UNKNOWN;
     auto conn = m_server_base->con;
     auto srv = m_server_base->server;
 
@@ -2233,3 +2377,27 @@ bool QueryResult::get_bool(int64_t column_ind) const
     char* data = m_rowdata[column_ind];
     return data ? (strcmp(data, "Y") == 0 || strcmp(data, "1") == 0) : false;
 }
+
+string QueryResult::to_raw_string()
+{
+    mxb_assert(m_resultset);
+    string rval;
+    auto columns = mysql_num_fields(m_resultset);
+    mysql_data_seek(m_resultset, 0);
+    while (MYSQL_ROW row = mysql_fetch_row(m_resultset))
+    {
+        auto lengths = mysql_fetch_lengths(m_resultset);
+        for (unsigned int i = 0; i < columns; i++)
+        {
+            // Separate the values so that the boundaries are preserved. NULL is marked separately.
+            rval += row[i] ? std::to_string(lengths[i]) + ':' : string("N:");
+            rval.append(row[i] ? row[i] : "", lengths[i]);
+        }
+        rval += '\n';
+    }
+
+    mysql_data_seek(m_resultset, 0);
+    m_rowdata = NULL;
+    m_current_row_ind = -1;
+    return rval;
+}
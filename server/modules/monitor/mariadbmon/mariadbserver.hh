@@ -23,6 +23,8 @@ class QueryResult;
 class MariaDBServer;
 // Server pointer array
 typedef std::vector<MariaDBServer*> ServerArray;
+// Results of a multi-statement query
+typedef std::vector<std::unique_ptr<QueryResult>> QueryResultArray;
 
 // Contains data returned by one row of SHOW ALL SLAVES STATUS
 class SlaveStatus
@@ -209,6 +211,18 @@ public:
      */
     std::unique_ptr<QueryResult> execute_query(const std::string& query, std::string* errmsg_out = NULL);
 
+    /**
+     * Execute a multi-statement query. Multi-statements must be enabled on the connection and every
+     * statement must return a result set.
+     *
+     * @param query The statements, separated by semicolons
+     * @param results_out Where to add the results, one for each statement
+     * @param errmsg_out Where to store an error message if query fails. Can be null.
+     * @return True if every statement returned a result set
+     */
+    bool execute_multi_query(const std::string& query, QueryResultArray* results_out,
+                             std::string* errmsg_out = NULL);
+
     /**
      * execute_cmd_ex with query retry ON.
      */
@@ -549,7 +563,26 @@ private:
         DISABLE
     };
 
+    enum class MultiStmt
+    {
+        UNKNOWN,    /* Not yet tried on the current connection */
+        ON,         /* Enabled on the current connection */
+        OFF         /* Not supported by the server */
+    };
+
+    MultiStmt   m_multi_stmt;           /* Are multi-statements enabled on the monitor connection */
+    std::string m_slave_status_raw;     /* Slave status result of the previous update, unparsed */
+    std::string m_gtid_current_pos_raw; /* Unparsed gtid_current_pos of the previous update */
+    std::string m_gtid_binlog_pos_raw;  /* Unparsed gtid_binlog_pos of the previous update */
+
     bool               update_slave_status(std::string* errmsg_out = NULL);
+    void               update_master_id();
+    bool               enable_multi_statements();
+    bool               update_status_batched(std::string* errmsg_out);
+    const char*        slave_status_query() const;
+    bool               process_slave_status(QueryResult& result);
+    bool               process_gtids(const QueryResult& result, int64_t i_current_pos, int64_t i_binlog_pos);
+    bool               process_server_variables(const QueryResult& result, int64_t i_domain);
     bool               sstatus_array_topology_equal(const SlaveStatusArray& new_slave_status);
     const SlaveStatus* sstatus_find_previous_row(const SlaveStatus& new_row, size_t guess);
     void               warn_event_scheduler();
@@ -647,6 +680,14 @@ public:
      */
     bool get_bool(int64_t column_ind) const;
 
+    /**
+     * Get all the values of the result set as one string, e.g. to check if the result has changed.
+     * Resets the current row, next_row() must be called before reading values.
+     *
+     * @return The values of the result set
+     */
+    std::string to_raw_string();
+
 private:
     MYSQL_RES*                               m_resultset = NULL;    // Underlying result set, freed at dtor.
     std::unordered_map<std::string, int64_t> m_col_indexes;         // Map of column name -> index
@@ -12,6 +12,9 @@
  */
 
 #include <maxscale/protocol/mariadb_client.hh>
+
+#include <sys/ioctl.h>
+
 #include <maxscale/routingworker.hh>
 #include <maxscale/utils.h>
 
@@ -27,6 +30,7 @@ LocalClient::LocalClient(MYSQL_session* session, MySQLProtocol* proto, int fd)
     : m_state(VC_WAITING_HANDSHAKE)
     , m_sock(fd)
     , m_expected_bytes(0)
+    , m_queued_bytes(0)
     , m_client(*session)
     , m_protocol(*proto)
     , m_self_destruct(false)
@@ -48,6 +52,7 @@ bool LocalClient::queue_query(GWBUF* buffer)
 
     if (m_state != VC_ERROR && (my_buf = gwbuf_deep_clone(buffer)))
     {
+        m_queued_bytes += gwbuf_length(my_buf);
         m_queue.push_back(my_buf);
 
         if (m_state == VC_OK)
@@ -59,12 +64,33 @@ bool LocalClient::queue_query(GWBUF* buffer)
     return my_buf != NULL;
 }
 
+size_t LocalClient::pending_bytes() const
+{
+    int unsent = 0;
+
+    if (m_state == VC_ERROR || ioctl(m_sock, TIOCOUTQ, &unsent) != 0)
+    {
+        unsent = 0;
+    }
+
+    return m_queued_bytes + unsent;
+}
+
 void LocalClient::self_destruct()
 {
     GWBUF* buffer = mysql_create_com_quit(NULL, 0);
     queue_query(buffer);
     gwbuf_free(buffer);
-    m_self_destruct = true;
+
+    if (m_state == VC_ERROR)
+    {
+        // The socket has been closed, so no event will delete the client.
+        delete this;
+    }
+    else
+    {
+        m_self_destruct = true;
+    }
 }
 
 void LocalClient::close()
@@ -98,6 +124,7 @@ void LocalClient::process(uint32_t events)
                 if (gw_decode_mysql_server_handshake(&m_protocol, GWBUF_DATA(buf) + MYSQL_HEADER_LEN) == 0)
                 {
                     GWBUF* response = gw_generate_auth_response(&m_client, &m_protocol, false, false, 0);
+                    m_queued_bytes += gwbuf_length(response);
                     m_queue.push_front(response);
                     m_state = VC_RESPONSE_SENT;
                 }
@@ -205,6 +232,7 @@ void LocalClient::drain_queue()
             if (rc > 0)
             {
                 buf = gwbuf_consume(buf, rc);
+                m_queued_bytes -= rc;
             }
             else
             {
@@ -264,9 +264,11 @@ int MySQLSendHandshake(DCB* dcb)
         memcpy(mysql_filler_ten + 6, &new_flags, sizeof(new_flags));
     }
 
-    // Get the equivalent of the server thread id.
+    // Get the equivalent of the server thread id. The session ids fit in the
+    // 32 bits of the handshake, so KILL finds the session with the id the
+    // client sees.
     protocol->thread_id = session_get_next_id();
-    // Send only the low 32bits in the handshake.
+    mxb_assert(protocol->thread_id <= UINT32_MAX);
     gw_mysql_set_byte4(mysql_thread_id_num, (uint32_t)(protocol->thread_id));
     memcpy(mysql_scramble_buf, server_scramble, 8);
 
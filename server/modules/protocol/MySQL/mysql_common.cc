@@ -1434,9 +1434,12 @@ void mxs_mysql_execute_kill(MXS_SESSION* issuer, uint64_t target_id, kill_type_t
     std::stringstream ss;
     ss << "KILL " << hard << query;
 
-    for (int i = 0; i < config_threadcount(); i++)
+    int worker_id = session_get_worker_id(target_id);
+
+    if (worker_id < config_threadcount())
     {
-        MXB_WORKER* worker = mxs_rworker_get(i);
+        // The session can only be handled by the worker its id was generated for.
+        MXB_WORKER* worker = mxs_rworker_get(worker_id);
         mxb_assert(worker);
         mxb_worker_post_message(worker,
                                 MXB_WORKER_MSG_CALL,
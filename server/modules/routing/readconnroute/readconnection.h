@@ -31,17 +31,43 @@
 #include <maxscale/dcb.h>
 #include <maxscale/service.h>
 #include <maxscale/router.h>
+#include <maxscale/routingworker.hh>
+#include <maxscale/protocol/rwbackend.hh>
+
+#include <unordered_map>
+
+/**
+ * The backend connections of a session whose statements are balanced.
+ */
+struct ROUTER_BALANCER
+{
+    mxs::SRWBackendList backends;   /*< The connections of the session */
+    mxs::SRWBackend     current;    /*< The connection the last statement was routed to */
+    bool                pinned;     /*< Session state was modified, only current is used */
+    bool                large_query;/*< The next packet continues a large statement */
+    uint64_t            n_sescmd;   /*< Number of session commands executed */
+    GWBUF*              query_queue;/*< Statements waiting for the reply of current */
+};
+
+/**
+ * The number of statements waiting for a reply, per server. Each routing worker
+ * counts the statements of its own sessions. A connection has at most one
+ * statement waiting for a reply, as the statements of a balanced session are
+ * queued until the previous one has been replied to.
+ */
+typedef std::unordered_map<SERVER*, int> OUTSTANDING_REQUESTS;
 
 /**
  * The client session structure used within this router.
  */
 struct ROUTER_CLIENT_SES : MXS_ROUTER_SESSION
 {
-    SERVER_REF* backend;    /*< Backend used by the client session */
-    DCB*        backend_dcb;/*< DCB Connection to the backend      */
-    DCB*        client_dcb; /**< Client DCB */
-    uint32_t    bitmask;    /*< Bitmask to apply to server->status */
-    uint32_t    bitvalue;   /*< Session specific required value of server->status */
+    SERVER_REF*      backend;    /*< Backend used by the client session */
+    DCB*             backend_dcb;/*< DCB Connection to the backend      */
+    DCB*             client_dcb; /**< Client DCB */
+    uint32_t         bitmask;    /*< Bitmask to apply to server->status */
+    uint32_t         bitvalue;   /*< Session specific required value of server->status */
+    ROUTER_BALANCER* balancer;   /*< The connections, if statements are balanced */
 };
 
 /**
@@ -51,6 +77,7 @@ struct ROUTER_STATS
 {
     int n_sessions;     /*< Number sessions created     */
     int n_queries;      /*< Number of queries forwarded */
+    int n_switches;     /*< Number of statements balanced to another server */
 };
 
 /**
@@ -61,4 +88,8 @@ struct ROUTER_INSTANCE : public MXS_ROUTER
     SERVICE*     service;               /*< Pointer to the service using this router */
     uint64_t     bitmask_and_bitvalue;  /*< Lower 32-bits for bitmask and upper for bitvalue */
     ROUTER_STATS stats;                 /*< Statistics for this router               */
+    bool         balance_statements;    /*< Whether statements are balanced */
+    int          balance_connections;   /*< Connections per session when balancing */
+
+    mxs::rworker_local<OUTSTANDING_REQUESTS>* outstanding; /*< Requests per server */
 };
@@ -33,6 +33,10 @@
  * as slaves. If neither option is specified the router will connect to either
  * masters or slaves.
  *
+ * With balance_statements enabled, a session opens connections to several servers
+ * and routes each autocommit read to the one with the fewest outstanding requests.
+ * Other statements go to the server used for the previous statement.
+ *
  * @verbatim
  * Revision History
  *
@@ -76,8 +80,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <float.h>
+#include <new>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <maxscale/alloc.h>
 #include <maxscale/server.hh>
 #include <maxscale/router.h>
@@ -87,6 +94,7 @@
 #include <maxscale/log.h>
 #include <maxscale/protocol/mysql.h>
 #include <maxscale/modutil.h>
+#include <maxscale/query_classifier.h>
 #include <maxscale/utils.hh>
 
 /* The router entry points */
@@ -153,6 +161,8 @@ extern "C" MXS_MODULE* MXS_CREATE_MODULE()
         NULL,   /* Thread init. */
         NULL,   /* Thread finish. */
         {
+            {"balance_statements",  MXS_MODULE_PARAM_BOOL,  "false"},
+            {"balance_connections", MXS_MODULE_PARAM_COUNT, "2"},
             {MXS_END_MODULE_PARAMS}
         }
     };
@@ -164,6 +174,7 @@ static inline void free_readconn_instance(ROUTER_INSTANCE* router)
 {
     if (router)
     {
+        delete router->outstanding;
         MXS_FREE(router);
     }
 }
@@ -246,8 +257,16 @@ static MXS_ROUTER* createInstance(SERVICE* service, MXS_CONFIG_PARAMETER* params
 
         inst->service = service;
         inst->bitmask_and_bitvalue = 0;
+        inst->balance_statements = config_get_bool(params, "balance_statements");
+        inst->balance_connections = config_get_integer(params, "balance_connections");
+
+        if (inst->balance_statements)
+        {
+            inst->outstanding = new(std::nothrow) mxs::rworker_local<OUTSTANDING_REQUESTS>();
+        }
 
-        if (!configureInstance((MXS_ROUTER*)inst, params))
+        if ((inst->balance_statements && !inst->outstanding)
+            || !configureInstance((MXS_ROUTER*)inst, params))
         {
             free_readconn_instance(inst);
             inst = nullptr;
@@ -258,48 +277,21 @@ static MXS_ROUTER* createInstance(SERVICE* service, MXS_CONFIG_PARAMETER* params
 }
 
 /**
- * Associate a new session with this instance of the router.
+ * Find the server with the least connections
  *
- * @param instance  The router instance data
- * @param session   The session itself
- * @return Session specific data for this session
+ * @param inst         The router instance
+ * @param client_rses  The router session
+ * @param master_host  The root master, if there is one
+ * @param exclude      Servers that are not considered
+ *
+ * @return The best server, or NULL if none qualifies
  */
-static MXS_ROUTER_SESSION* newSession(MXS_ROUTER* instance, MXS_SESSION* session)
+static SERVER_REF* select_candidate(ROUTER_INSTANCE* inst,
+                                    ROUTER_CLIENT_SES* client_rses,
+                                    SERVER_REF* master_host,
+                                    const std::vector<SERVER_REF*>& exclude)
 {
-    ROUTER_INSTANCE* inst = (ROUTER_INSTANCE*) instance;
-    ROUTER_CLIENT_SES* client_rses;
     SERVER_REF* candidate = NULL;
-    SERVER_REF* master_host = NULL;
-
-    MXS_DEBUG("%lu [newSession] new router session with session "
-              "%p, and inst %p.",
-              pthread_self(),
-              session,
-              inst);
-
-    client_rses = (ROUTER_CLIENT_SES*) MXS_CALLOC(1, sizeof(ROUTER_CLIENT_SES));
-
-    if (client_rses == NULL)
-    {
-        return NULL;
-    }
-
-    client_rses->client_dcb = session->client_dcb;
-
-    uint64_t mask = atomic_load_uint64(&inst->bitmask_and_bitvalue);
-    client_rses->bitmask = mask;
-    client_rses->bitvalue = mask >> 32;
-
-    /**
-     * Find the Master host from available servers
-     */
-    master_host = get_root_master(inst->service->dbref);
-
-    /**
-     * Find a backend server to connect to. This is the extent of the
-     * load balancing algorithm we need to implement for this simple
-     * connection router.
-     */
 
     /*
      * Loop over all the servers and find any that have fewer connections
@@ -315,7 +307,8 @@ static MXS_ROUTER_SESSION* newSession(MXS_ROUTER* instance, MXS_SESSION* session
      */
     for (SERVER_REF* ref = inst->service->dbref; ref; ref = ref->next)
     {
-        if (!SERVER_REF_IS_ACTIVE(ref) || server_is_in_maint(ref->server))
+        if (!SERVER_REF_IS_ACTIVE(ref) || server_is_in_maint(ref->server)
+            || std::find(exclude.begin(), exclude.end(), ref) != exclude.end())
         {
             continue;
         }
@@ -376,6 +369,134 @@ static MXS_ROUTER_SESSION* newSession(MXS_ROUTER* instance, MXS_SESSION* session
         }
     }
 
+    return candidate;
+}
+
+/**
+ * Open the connections of a session whose statements are balanced
+ *
+ * @param inst         The router instance
+ * @param client_rses  The router session
+ * @param session      The session
+ * @param candidate    The server with the least connections
+ * @param master_host  The root master, if there is one
+ *
+ * @return True, if at least the connection to the candidate was opened
+ */
+static bool connect_balancer(ROUTER_INSTANCE* inst,
+                             ROUTER_CLIENT_SES* client_rses,
+                             MXS_SESSION* session,
+                             SERVER_REF* candidate,
+                             SERVER_REF* master_host)
+{
+    ROUTER_BALANCER* balancer = new(std::nothrow) ROUTER_BALANCER;
+
+    if (balancer == NULL)
+    {
+        return false;
+    }
+
+    balancer->pinned = false;
+    balancer->large_query = false;
+    balancer->n_sescmd = 0;
+    balancer->query_queue = NULL;
+
+    std::vector<SERVER_REF*> servers {candidate};
+
+    // A session that uses the master has only one server to choose from
+    if ((client_rses->bitvalue & SERVER_MASTER) == 0)
+    {
+        while ((int)servers.size() < inst->balance_connections)
+        {
+            SERVER_REF* ref = select_candidate(inst, client_rses, master_host, servers);
+
+            if (ref == NULL)
+            {
+                break;
+            }
+
+            servers.push_back(ref);
+        }
+    }
+
+    for (SERVER_REF* ref : servers)
+    {
+        mxs::SRWBackend backend = std::make_shared<mxs::RWBackend>(ref);
+
+        // Only the connection to the candidate is required, the failure is reported in dcb_connect()
+        if (backend->connect(session))
+        {
+            balancer->backends.push_back(backend);
+        }
+        else if (ref == candidate)
+        {
+            break;
+        }
+    }
+
+    if (balancer->backends.empty() || balancer->backends.front()->backend() != candidate)
+    {
+        for (const auto& backend : balancer->backends)
+        {
+            backend->close();
+        }
+
+        delete balancer;
+        return false;
+    }
+
+    balancer->current = balancer->backends.front();
+    client_rses->balancer = balancer;
+    client_rses->backend_dcb = balancer->current->dcb();
+
+    return true;
+}
+
+/**
+ * Associate a new session with this instance of the router.
+ *
+ * @param instance  The router instance data
+ * @param session   The session itself
+ * @return Session specific data for this session
+ */
+static MXS_ROUTER_SESSION* newSession(MXS_ROUTER* instance, MXS_SESSION* session)
+{
+    ROUTER_INSTANCE* inst = (ROUTER_INSTANCE*) instance;
+    ROUTER_CLIENT_SES* client_rses;
+    SERVER_REF* candidate = NULL;
+    SERVER_REF* master_host = NULL;
+
+    MXS_DEBUG("%lu [newSession] new router session with session "
+              "%p, and inst %p.",
+              pthread_self(),
+              session,
+              inst);
+
+    client_rses = (ROUTER_CLIENT_SES*) MXS_CALLOC(1, sizeof(ROUTER_CLIENT_SES));
+
+    if (client_rses == NULL)
+    {
+        return NULL;
+    }
+
+    client_rses->client_dcb = session->client_dcb;
+
+    uint64_t mask = atomic_load_uint64(&inst->bitmask_and_bitvalue);
+    client_rses->bitmask = mask;
+    client_rses->bitvalue = mask >> 32;
+
+    /**
+     * Find the Master host from available servers
+     */
+    master_host = get_root_master(inst->service->dbref);
+
+    /**
+     * Find a backend server to connect to. This is the extent of the
+     * load balancing algorithm we need to implement for this simple
+     * connection router.
+     */
+    candidate = select_candidate(inst, client_rses, master_host, std::vector<SERVER_REF*>());
+
     /* If we haven't found a proper candidate yet but a master server is available, we'll pick that
      * with the assumption that it is "better" than a slave.
      */
@@ -411,19 +532,31 @@ static MXS_ROUTER_SESSION* newSession(MXS_ROUTER* instance, MXS_SESSION* session
      */
     client_rses->backend = candidate;
 
-    /** Open the backend connection */
-    client_rses->backend_dcb = dcb_connect(candidate->server,
-                                           session,
-                                           candidate->server->protocol);
-
-    if (client_rses->backend_dcb == NULL)
+    if (inst->balance_statements)
     {
-        /** The failure is reported in dcb_connect() */
-        MXS_FREE(client_rses);
-        return NULL;
+        /** Open the backend connections, the connection counts are bumped by them */
+        if (!connect_balancer(inst, client_rses, session, candidate, master_host))
+        {
+            MXS_FREE(client_rses);
+            return NULL;
+        }
     }
+    else
+    {
+        /** Open the backend connection */
+        client_rses->backend_dcb = dcb_connect(candidate->server,
+                                               session,
+                                               candidate->server->protocol);
 
-    mxb::atomic::add(&candidate->connections, 1, mxb::atomic::RELAXED);
+        if (client_rses->backend_dcb == NULL)
+        {
+            /** The failure is reported in dcb_connect() */
+            MXS_FREE(client_rses);
+            return NULL;
+        }
+
+        mxb::atomic::add(&candidate->connections, 1, mxb::atomic::RELAXED);
+    }
 
     inst->stats.n_sessions++;
 
@@ -456,10 +589,19 @@ static void freeSession(MXS_ROUTER* router_instance, MXS_ROUTER_SESSION* router_
     ROUTER_INSTANCE* router = (ROUTER_INSTANCE*) router_instance;
     ROUTER_CLIENT_SES* router_cli_ses = (ROUTER_CLIENT_SES*) router_client_ses;
 
-    MXB_AT_DEBUG(int prev_val = ) mxb::atomic::add(&router_cli_ses->backend->connections,
-                                                   -1,
-                                                   mxb::atomic::RELAXED);
-    mxb_assert(prev_val > 0);
+    if (router_cli_ses->balancer)
+    {
+        // The connection counts were decremented when the connections were closed
+        gwbuf_free(router_cli_ses->balancer->query_queue);
+        delete router_cli_ses->balancer;
+    }
+    else
+    {
+        MXB_AT_DEBUG(int prev_val = ) mxb::atomic::add(&router_cli_ses->backend->connections,
+                                                       -1,
+                                                       mxb::atomic::RELAXED);
+        mxb_assert(prev_val > 0);
+    }
 
     MXS_FREE(router_cli_ses);
 }
@@ -473,9 +615,29 @@ static void freeSession(MXS_ROUTER* router_instance, MXS_ROUTER_SESSION* router_
  */
 static void closeSession(MXS_ROUTER* instance, MXS_ROUTER_SESSION* router_session)
 {
+    ROUTER_INSTANCE* inst = (ROUTER_INSTANCE*) instance;
     ROUTER_CLIENT_SES* router_cli_ses = (ROUTER_CLIENT_SES*) router_session;
     mxb_assert(router_cli_ses->backend_dcb);
-    dcb_close(router_cli_ses->backend_dcb);
+
+    if (router_cli_ses->balancer)
+    {
+        for (const auto& backend : router_cli_ses->balancer->backends)
+        {
+            if (backend->in_use())
+            {
+                if (backend->is_waiting_result())
+                {
+                    (**inst->outstanding)[backend->server()]--;
+                }
+
+                backend->close();
+            }
+        }
+    }
+    else
+    {
+        dcb_close(router_cli_ses->backend_dcb);
+    }
 }
 
 /** Log routing failure due to closed session */
@@ -500,14 +662,15 @@ static void log_closed_session(mxs_mysql_cmd_t mysql_command, SERVER_REF* ref)
 }
 
 /**
- * Check if the server we're connected to is still valid
+ * Check if a server is still valid for a session
  *
  * @param inst           Router instance
  * @param router_cli_ses Router session
+ * @param ref            The server
  *
- * @return True if the backend connection is still valid
+ * @return True if the server is still valid
  */
-static inline bool connection_is_valid(ROUTER_INSTANCE* inst, ROUTER_CLIENT_SES* router_cli_ses)
+static inline bool server_is_valid(ROUTER_INSTANCE* inst, ROUTER_CLIENT_SES* router_cli_ses, SERVER_REF* ref)
 {
     bool rval = false;
 
@@ -515,16 +678,16 @@ static inline bool connection_is_valid(ROUTER_INSTANCE* inst, ROUTER_CLIENT_SES*
     // 'router_options=slave' in the configuration file and there was only
     // the sole master available at session creation time.
 
-    if (server_is_usable(router_cli_ses->backend->server)
-        && (router_cli_ses->backend->server->status & router_cli_ses->bitmask & router_cli_ses->bitvalue))
+    if (server_is_usable(ref->server)
+        && (ref->server->status & router_cli_ses->bitmask & router_cli_ses->bitvalue))
     {
         // Note the use of '==' and not '|'. We must use the former to exclude a
         // 'router_options=slave' that uses the master due to no slave having been
         // available at session creation time. Its bitvalue is (SERVER_MASTER | SERVER_SLAVE).
-        if ((router_cli_ses->bitvalue == SERVER_MASTER) && router_cli_ses->backend->active)
+        if ((router_cli_ses->bitvalue == SERVER_MASTER) && ref->active)
         {
             // If we're using an active master server, verify that it is still a master
-            rval = router_cli_ses->backend == get_root_master(inst->service->dbref);
+            rval = ref == get_root_master(inst->service->dbref);
         }
         else
         {
@@ -542,6 +705,431 @@ static inline bool connection_is_valid(ROUTER_INSTANCE* inst, ROUTER_CLIENT_SES*
     return rval;
 }
 
+/**
+ * Check if the server we're connected to is still valid
+ *
+ * @param inst           Router instance
+ * @param router_cli_ses Router session
+ *
+ * @return True if the backend connection is still valid
+ */
+static inline bool connection_is_valid(ROUTER_INSTANCE* inst, ROUTER_CLIENT_SES* router_cli_ses)
+{
+    return server_is_valid(inst, router_cli_ses, router_cli_ses->backend);
+}
+
+/**
+ * Check whether a command leaves the state of the connection unchanged
+ *
+ * @param cmd  The command
+ *
+ * @return True, if the command can be sent to any connection
+ */
+static bool is_stateless_command(mxs_mysql_cmd_t cmd)
+{
+    switch (cmd)
+    {
+    case MXS_COM_QUERY:
+    case MXS_COM_PING:
+    case MXS_COM_STATISTICS:
+    case MXS_COM_FIELD_LIST:
+    case MXS_COM_PROCESS_INFO:
+    case MXS_COM_PROCESS_KILL:
+    case MXS_COM_QUIT:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Check whether a command changes the state of the connection in a way that can
+ * be repeated on the other connections of the session
+ *
+ * @param cmd  The command
+ *
+ * @return True, if the command is executed on all connections
+ */
+static bool is_session_command(mxs_mysql_cmd_t cmd)
+{
+    return cmd == MXS_COM_INIT_DB || cmd == MXS_COM_SET_OPTION;
+}
+
+/**
+ * Make a session stay on its current connection
+ *
+ * @param balancer  The connections of the session
+ * @param what      What modified the session state
+ */
+static void pin_session(ROUTER_BALANCER* balancer, const char* what)
+{
+    MXS_INFO("%s modifies the session state in a way that cannot be repeated, staying on '%s'.",
+             what, balancer->current->name());
+    balancer->pinned = true;
+}
+
+/**
+ * Check whether a statement uses a function whose value depends on the statements
+ * previously executed on the same connection
+ *
+ * @param queue  The statement
+ *
+ * @return True, if the statement must be executed on the current connection
+ */
+static bool uses_connection_local_function(GWBUF* queue)
+{
+    static const char* functions[] =
+    {
+        "connection_id",
+        "found_rows",
+        "last_insert_id",
+        "row_count"
+    };
+
+    const QC_FUNCTION_INFO* infos;
+    size_t n_infos;
+    qc_get_function_info(queue, &infos, &n_infos);
+
+    for (size_t i = 0; i < n_infos; i++)
+    {
+        for (auto f : functions)
+        {
+            if (strcasecmp(infos[i].name, f) == 0)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Check whether a read returns something only the current connection knows
+ *
+ * The classifier marks e.g. LAST_INSERT_ID() as a master read. System variables
+ * such as @@last_insert_id and @@warning_count as well as SHOW WARNINGS depend on
+ * the previous statements of the connection.
+ *
+ * @param queue  The statement
+ * @param type   The type of the statement
+ *
+ * @return True, if the statement must be executed on the current connection
+ */
+static bool is_connection_local_read(GWBUF* queue, uint32_t type)
+{
+    return (type & (QUERY_TYPE_MASTER_READ | QUERY_TYPE_SYSVAR_READ))
+           || qc_get_operation(queue) == QUERY_OP_SHOW
+           || uses_connection_local_function(queue);
+}
+
+/**
+ * Choose the connection a statement is routed to
+ *
+ * An autocommit read goes to the server with the fewest outstanding requests
+ * on this worker, weighted like the connections. Everything else goes to the
+ * connection used for the previous statement. Session commands, e.g. SET NAMES
+ * or USE, are also executed on the other connections so that all of them have
+ * the same state. If a statement modifies the session state in a way that
+ * cannot be repeated, e.g. by creating a temporary table or by preparing a
+ * statement, the session stays on its current connection.
+ *
+ * @param inst           Router instance
+ * @param router_cli_ses Router session
+ * @param queue          The statement
+ * @param cmd            The command of the statement
+ *
+ * @return True, if the statement is a session command
+ */
+static bool balance_statement(ROUTER_INSTANCE* inst,
+                              ROUTER_CLIENT_SES* router_cli_ses,
+                              GWBUF* queue,
+                              mxs_mysql_cmd_t cmd)
+{
+    ROUTER_BALANCER* balancer = router_cli_ses->balancer;
+
+    if (balancer->pinned)
+    {
+        return false;
+    }
+    else if (balancer->current->local_infile_requested())
+    {
+        // The packet is a part of the file of LOAD DATA LOCAL INFILE
+        return false;
+    }
+    else if (gwbuf_length(queue) == MYSQL_HEADER_LEN + GW_MYSQL_MAX_PACKET_LEN)
+    {
+        // Only the first part of the statement is available
+        pin_session(balancer, "Statement larger than 16MB");
+        return false;
+    }
+    else if (is_session_command(cmd))
+    {
+        return true;
+    }
+    else if (cmd != MXS_COM_QUERY)
+    {
+        if (!is_stateless_command(cmd))
+        {
+            pin_session(balancer, STRPACKETTYPE(cmd));
+        }
+
+        return false;
+    }
+
+    uint32_t type = qc_get_type_mask(queue);
+
+    if (type & (QUERY_TYPE_CREATE_TMP_TABLE | QUERY_TYPE_PREPARE_NAMED_STMT | QUERY_TYPE_PREPARE_STMT))
+    {
+        pin_session(balancer, "Statement");
+        return false;
+    }
+    else if (type & (QUERY_TYPE_ENABLE_AUTOCOMMIT | QUERY_TYPE_DISABLE_AUTOCOMMIT))
+    {
+        // Autocommit only matters on the connection the transactions are executed on
+        return false;
+    }
+    else if (type & (QUERY_TYPE_SESSION_WRITE | QUERY_TYPE_USERVAR_WRITE))
+    {
+        if (uses_connection_local_function(queue))
+        {
+            // E.g. SET @id = LAST_INSERT_ID() would assign a different value on the other connections
+            pin_session(balancer, "Statement");
+            return false;
+        }
+
+        return true;
+    }
+
+    MXS_SESSION* session = router_cli_ses->client_dcb->session;
+
+    if (!qc_query_is_type(type, QUERY_TYPE_READ)
+        || qc_query_is_type(type, QUERY_TYPE_WRITE)
+        || is_connection_local_read(queue, type)
+        || !session_is_autocommit(session)
+        || session_trx_is_active(session))
+    {
+        return false;
+    }
+
+    OUTSTANDING_REQUESTS& outstanding = **inst->outstanding;
+    mxs::SRWBackend best;
+    double best_score = DBL_MAX;
+
+    for (const auto& backend : balancer->backends)
+    {
+        SERVER_REF* ref = backend->backend();
+
+        // A connection that is still executing session commands does not yet have the session state
+        if (backend->in_use() && !backend->has_session_commands()
+            && server_is_valid(inst, router_cli_ses, ref))
+        {
+            double score = ref->server_weight ?
+                (outstanding[backend->server()] + 1) / ref->server_weight : DBL_MAX;
+
+            // The current connection wins ties
+            if (!best || score < best_score || (score == best_score && backend == balancer->current))
+            {
+                best = backend;
+                best_score = score;
+            }
+        }
+    }
+
+    if (best && best != balancer->current)
+    {
+        balancer->current = best;
+        router_cli_ses->backend = best->backend();
+        router_cli_ses->backend_dcb = best->dcb();
+        mxb::atomic::add(&inst->stats.n_switches, 1, mxb::atomic::RELAXED);
+    }
+
+    return false;
+}
+
+/**
+ * Execute the next queued session command of a connection
+ *
+ * @param inst     Router instance
+ * @param backend  The connection
+ */
+static void execute_session_command(ROUTER_INSTANCE* inst, const mxs::SRWBackend& backend)
+{
+    if (!backend->execute_session_command())
+    {
+        MXS_INFO("Failed to execute session command on '%s', closing the connection.", backend->name());
+        backend->close();
+    }
+    else if (backend->is_waiting_result())
+    {
+        (**inst->outstanding)[backend->server()]++;
+    }
+}
+
+/**
+ * Process the reply to a session command executed on a connection other than
+ * the current one
+ *
+ * @param inst     Router instance
+ * @param backend  The connection
+ * @param reply    The complete reply
+ */
+static void complete_session_command(ROUTER_INSTANCE* inst, const mxs::SRWBackend& backend, GWBUF* reply)
+{
+    backend->complete_session_command();
+
+    if (MYSQL_GET_COMMAND(GWBUF_DATA(reply)) == MYSQL_REPLY_ERR)
+    {
+        // The state of the connection differs from the one of the current connection
+        MXS_INFO("Session command failed on '%s', closing the connection.", backend->name());
+        backend->close();
+    }
+    else if (backend->has_session_commands())
+    {
+        execute_session_command(inst, backend);
+    }
+}
+
+/**
+ * Queue a session command on the connections other than the current one
+ *
+ * The client gets the reply of the current connection, the replies of the
+ * other connections are discarded.
+ *
+ * @param inst           Router instance
+ * @param router_cli_ses Router session
+ * @param queue          The session command
+ */
+static void broadcast_session_command(ROUTER_INSTANCE* inst, ROUTER_CLIENT_SES* router_cli_ses, GWBUF* queue)
+{
+    ROUTER_BALANCER* balancer = router_cli_ses->balancer;
+    uint64_t id = ++balancer->n_sescmd;
+
+    for (const auto& backend : balancer->backends)
+    {
+        if (backend != balancer->current && backend->in_use())
+        {
+            bool is_idle = !backend->has_session_commands();
+            backend->append_session_command(gwbuf_clone(queue), id);
+
+            if (is_idle)
+            {
+                execute_session_command(inst, backend);
+            }
+        }
+    }
+}
+
+/**
+ * Write a statement to the current connection of a balanced session
+ *
+ * @param inst           Router instance
+ * @param router_cli_ses Router session
+ * @param queue          The statement
+ * @param cmd            The command of the statement
+ *
+ * @return True if writing was successful
+ */
+static bool write_balanced(ROUTER_INSTANCE* inst,
+                           ROUTER_CLIENT_SES* router_cli_ses,
+                           GWBUF* queue,
+                           mxs_mysql_cmd_t cmd)
+{
+    ROUTER_BALANCER* balancer = router_cli_ses->balancer;
+    mxs::SRWBackend backend = balancer->current;
+    bool continued = balancer->large_query;
+    bool was_waiting = backend->is_waiting_result();
+    bool rval;
+
+    balancer->large_query = gwbuf_length(queue) == MYSQL_HEADER_LEN + GW_MYSQL_MAX_PACKET_LEN;
+
+    if (continued)
+    {
+        rval = backend->continue_write(queue);
+    }
+    else if (backend->local_infile_requested())
+    {
+        // The server replies to the empty packet that ends the file
+        rval = backend->write(queue,
+                              gwbuf_length(queue) == MYSQL_HEADER_LEN ?
+                              mxs::Backend::EXPECT_RESPONSE : mxs::Backend::NO_RESPONSE);
+    }
+    else
+    {
+        rval = backend->write(queue,
+                              mxs_mysql_command_will_respond(cmd) ?
+                              mxs::Backend::EXPECT_RESPONSE : mxs::Backend::NO_RESPONSE);
+    }
+
+    if (!was_waiting && backend->is_waiting_result())
+    {
+        (**inst->outstanding)[backend->server()]++;
+    }
+
+    return rval;
+}
+
+/**
+ * Check whether a statement must wait for the reply of the current connection
+ *
+ * Only one statement of a balanced session is executed at a time. Otherwise a
+ * read moved to another connection could be replied to before the statements
+ * before it, and the reply tracking of a connection only follows the latest
+ * statement written to it.
+ *
+ * @param balancer  The connections of the session
+ *
+ * @return True, if the statement must be queued
+ */
+static bool must_wait_reply(ROUTER_BALANCER* balancer)
+{
+    return balancer->query_queue
+           || (!balancer->large_query && balancer->current->is_waiting_result());
+}
+
+/**
+ * Route the statements queued while the current connection was executing one
+ *
+ * @param inst           Router instance
+ * @param router_cli_ses Router session
+ *
+ * @return False, if routing a statement failed
+ */
+static bool route_queued_statements(ROUTER_INSTANCE* inst, ROUTER_CLIENT_SES* router_cli_ses)
+{
+    ROUTER_BALANCER* balancer = router_cli_ses->balancer;
+    bool ok = true;
+
+    while (ok && balancer->query_queue)
+    {
+        GWBUF* rest = balancer->query_queue;
+        balancer->query_queue = NULL;
+
+        if (must_wait_reply(balancer))
+        {
+            balancer->query_queue = rest;
+            break;
+        }
+
+        GWBUF* queue = gwbuf_make_contiguous(modutil_get_next_MySQL_packet(&rest));
+        mxb_assert(queue);
+
+        if (!balancer->large_query)
+        {
+            // The client protocol has already moved on to the statements after this one
+            mysql_protocol_set_current_command(router_cli_ses->client_dcb,
+                                               (mxs_mysql_cmd_t)mxs_mysql_get_command(queue));
+        }
+
+        ok = routeQuery(inst, router_cli_ses, queue);
+        mxb_assert(!balancer->query_queue);
+        balancer->query_queue = rest;
+    }
+
+    return ok;
+}
+
 /**
  * We have data from the client, we must route it to the backend.
  * This is simply a case of sending it to the connection that was
@@ -559,9 +1147,23 @@ static int routeQuery(MXS_ROUTER* instance, MXS_ROUTER_SESSION* router_session,
     int rc = 0;
     MySQLProtocol* proto = (MySQLProtocol*)router_cli_ses->client_dcb->protocol;
     mxs_mysql_cmd_t mysql_command = proto->current_command;
+    bool is_sescmd = false;
+
+    if (router_cli_ses->balancer && must_wait_reply(router_cli_ses->balancer))
+    {
+        MXS_INFO("Queuing statement until '%s' has replied to the previous one.",
+                 router_cli_ses->balancer->current->name());
+        router_cli_ses->balancer->query_queue = gwbuf_append(router_cli_ses->balancer->query_queue, queue);
+        return 1;
+    }
 
     mxb::atomic::add(&inst->stats.n_queries, 1, mxb::atomic::RELAXED);
 
+    if (router_cli_ses->balancer && !router_cli_ses->balancer->large_query)
+    {
+        is_sescmd = balance_statement(inst, router_cli_ses, queue, mysql_command);
+    }
+
     // Due to the streaming nature of readconnroute, this is not accurate
     mxb::atomic::add(&router_cli_ses->backend->server->stats.packets, 1, mxb::atomic::RELAXED);
 
@@ -592,7 +1194,19 @@ static int routeQuery(MXS_ROUTER* instance, MXS_ROUTER_SESSION* router_session,
         }
 
     default:
-        rc = backend_dcb->func.write(backend_dcb, queue);
+        if (router_cli_ses->balancer)
+        {
+            if (is_sescmd)
+            {
+                broadcast_session_command(inst, router_cli_ses, queue);
+            }
+
+            rc = write_balanced(inst, router_cli_ses, queue, mysql_command);
+        }
+        else
+        {
+            rc = backend_dcb->func.write(backend_dcb, queue);
+        }
         break;
     }
 
@@ -626,6 +1240,12 @@ static void diagnostics(MXS_ROUTER* router, DCB* dcb)
     dcb_printf(dcb,
                "\tNumber of queries forwarded:      %d\n",
                router_inst->stats.n_queries);
+    if (router_inst->balance_statements)
+    {
+        dcb_printf(dcb,
+                   "\tNumber of queries balanced to another server: %d\n",
+                   router_inst->stats.n_switches);
+    }
     if (*weightby)
     {
         dcb_printf(dcb,
@@ -660,6 +1280,11 @@ static json_t* diagnostics_json(const MXS_ROUTER* router)
     json_object_set_new(rval, "current_connections", json_integer(router_inst->service->stats.n_current));
     json_object_set_new(rval, "queries", json_integer(router_inst->stats.n_queries));
 
+    if (router_inst->balance_statements)
+    {
+        json_object_set_new(rval, "server_switches", json_integer(router_inst->stats.n_switches));
+    }
+
     const char* weightby = serviceGetWeightingParameter(router_inst->service);
 
     if (*weightby)
@@ -685,8 +1310,45 @@ static void clientReply(MXS_ROUTER* instance,
                         GWBUF* queue,
                         DCB*   backend_dcb)
 {
+    ROUTER_INSTANCE* inst = (ROUTER_INSTANCE*) instance;
+    ROUTER_CLIENT_SES* router_cli_ses = (ROUTER_CLIENT_SES*) router_session;
     mxb_assert(backend_dcb->session->client_dcb != NULL);
+
+    if (router_cli_ses->balancer)
+    {
+        for (const auto& backend : router_cli_ses->balancer->backends)
+        {
+            if (backend->in_use() && backend->dcb() == backend_dcb && backend->is_waiting_result())
+            {
+                backend->process_reply(queue);
+
+                if (!backend->is_waiting_result())
+                {
+                    (**inst->outstanding)[backend->server()]--;
+                }
+
+                if (backend->has_session_commands())
+                {
+                    // The client got the reply from the current connection
+                    if (!backend->is_waiting_result())
+                    {
+                        complete_session_command(inst, backend, queue);
+                    }
+
+                    gwbuf_free(queue);
+                    return;
+                }
+                break;
+            }
+        }
+    }
+
     MXS_SESSION_ROUTE_REPLY(backend_dcb->session, queue);
+
+    if (router_cli_ses->balancer && !route_queued_statements(inst, router_cli_ses))
+    {
+        poll_fake_hangup_event(router_cli_ses->client_dcb);
+    }
 }
 
 /**
@@ -712,6 +1374,31 @@ static void handleError(MXS_ROUTER* instance,
 {
     mxb_assert(problem_dcb->dcb_role == DCB_ROLE_BACKEND_HANDLER);
     mxb_assert(problem_dcb->session->state == SESSION_STATE_ROUTER_READY);
+    ROUTER_INSTANCE* inst = (ROUTER_INSTANCE*) instance;
+    ROUTER_CLIENT_SES* router_cli_ses = (ROUTER_CLIENT_SES*) router_session;
+
+    if (router_cli_ses && router_cli_ses->balancer)
+    {
+        for (const auto& backend : router_cli_ses->balancer->backends)
+        {
+            if (backend->in_use() && backend->dcb() == problem_dcb
+                && backend != router_cli_ses->balancer->current)
+            {
+                // The client is not waiting for replies from the other connections, they can be dropped
+                MXS_INFO("Closing failed connection to '%s'.", backend->name());
+
+                if (backend->is_waiting_result())
+                {
+                    (**inst->outstanding)[backend->server()]--;
+                }
+
+                backend->close(mxs::Backend::CLOSE_FATAL);
+                *succp = true;
+                return;
+            }
+        }
+    }
+
     DCB* client_dcb = problem_dcb->session->client_dcb;
     client_dcb->func.write(client_dcb, gwbuf_clone(errbuf));
 
@@ -721,7 +1408,16 @@ static void handleError(MXS_ROUTER* instance,
 
 static uint64_t getCapabilities(MXS_ROUTER* instance)
 {
-    return RCAP_TYPE_RUNTIME_CONFIG;
+    ROUTER_INSTANCE* inst = (ROUTER_INSTANCE*) instance;
+    uint64_t rval = RCAP_TYPE_RUNTIME_CONFIG;
+
+    if (inst && inst->balance_statements)
+    {
+        // The statements are classified and the replies are tracked
+        rval |= RCAP_TYPE_TRANSACTION_TRACKING | RCAP_TYPE_PACKET_OUTPUT;
+    }
+
+    return rval;
 }
 
 /*
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <algorithm>
 #include <cmath>
 #include <new>
 #include <sstream>
@@ -50,6 +51,12 @@ using namespace maxscale;
 /** Maximum number of slaves */
 #define MAX_SLAVE_COUNT "255"
 
+/** Session commands longer than this are not interned */
+#define MAX_INTERNED_SESCMD_LEN 1024
+
+/** Maximum number of interned session commands per worker */
+#define MAX_INTERNED_SESCMD_COUNT 1000
+
 // TODO: Don't process parameters in readwritesplit
 static bool handle_max_slaves(Config& config, const char* str)
 {
@@ -112,6 +119,73 @@ ServerStats& RWSplit::server_stats(SERVER* server)
     return (*m_server_stats)[server];
 }
 
+void RWSplit::intern_session_command(mxs::SSessionCommand& sescmd)
+{
+    if (sescmd->length() <= MAX_INTERNED_SESCMD_LEN)
+    {
+        SescmdInternTable& table = *m_sescmd_intern;
+        size_t hash = sescmd->hash();
+        auto range = table.equal_range(hash);
+        auto it = std::find_if(range.first, range.second, [&](const SescmdInternTable::value_type& a) {
+                                   return a.second->eq(*sescmd);
+                               });
+
+        if (it != range.second)
+        {
+            // Duplicate command, use a reference of the old command instead of duplicating it
+            sescmd->mark_as_duplicate(*it->second);
+        }
+        else
+        {
+            if (table.size() >= MAX_INTERNED_SESCMD_COUNT)
+            {
+                // The commands in the histories of the sessions are not affected
+                table.clear();
+            }
+
+            table.emplace(hash, sescmd);
+        }
+    }
+}
+
+bool RWSplit::gtid_is_replicated(SERVER* server, uint32_t domain, uint64_t sequence)
+{
+    uint64_t monitor_sequence = server_get_gtid_sequence(server, domain);
+    bool rval = monitor_sequence >= sequence;
+
+    if (!rval)
+    {
+        ReplicatedGtidMap& gtids = *m_replicated_gtids;
+        auto it = gtids.find(std::make_pair(server, domain));
+
+        if (it != gtids.end())
+        {
+            if (monitor_sequence < it->second.monitor_sequence)
+            {
+                // The server is no longer where it was, e.g. it is down or it was restored from a backup
+                gtids.erase(it);
+            }
+            else
+            {
+                rval = it->second.sequence >= sequence;
+            }
+        }
+    }
+
+    return rval;
+}
+
+void RWSplit::set_gtid_replicated(SERVER* server, uint32_t domain, uint64_t sequence)
+{
+    ReplicatedGtid& gtid = (*m_replicated_gtids)[std::make_pair(server, domain)];
+
+    if (sequence > gtid.sequence)
+    {
+        gtid.sequence = sequence;
+        gtid.monitor_sequence = server_get_gtid_sequence(server, domain);
+    }
+}
+
 RWSplit::SrvStatMap RWSplit::all_server_stats() const
 {
     SrvStatMap stats;
@@ -228,6 +302,14 @@ RWSplit* RWSplit::create(SERVICE* service, MXS_CONFIG_PARAMETER* params)
         return NULL;
     }
 
+    if (config.lazy_connect && config.disable_sescmd_history)
+    {
+        MXS_ERROR("'lazy_connect' cannot be used together with 'disable_sescmd_history', "
+                  "as the servers connected later are brought up to date with the "
+                  "session command history.");
+        return NULL;
+    }
+
     /** These options cancel each other out */
     if (config.disable_sescmd_history && config.max_sescmd_history > 0)
     {
@@ -294,6 +376,9 @@ void RWSplit::diagnostics(DCB* dcb)
     dcb_printf(dcb,
                "\tmax_sescmd_history:        %lu\n",
                cnf.max_sescmd_history);
+    dcb_printf(dcb,
+               "\tcompact_sescmd_history:    %s\n",
+               cnf.compact_sescmd_history ? "true" : "false");
     dcb_printf(dcb,
                "\tmaster_accept_reads:       %s\n",
                cnf.master_accept_reads ? "true" : "false");
@@ -315,6 +400,9 @@ void RWSplit::diagnostics(DCB* dcb)
     dcb_printf(dcb,
                "\tdelayed_retry_timeout:       %lu\n",
                cnf.delayed_retry_timeout);
+    dcb_printf(dcb,
+               "\tlazy_connect:       %s\n",
+               cnf.lazy_connect ? "true" : "false");
 
     dcb_printf(dcb, "\n");
 
@@ -355,6 +443,9 @@ void RWSplit::diagnostics(DCB* dcb)
     dcb_printf(dcb,
                "\tNumber of replayed transactions:        %" PRIu64 "\n",
                stats().n_trx_replay);
+    dcb_printf(dcb,
+               "\tNumber of cached prepared statement routes: %" PRIu64 "\n",
+               stats().n_ps_cached);
 
     if (*weightby)
     {
@@ -409,6 +500,7 @@ json_t* RWSplit::diagnostics_json() const
     json_object_set_new(rval, "rw_transactions", json_integer(stats().n_rw_trx));
     json_object_set_new(rval, "ro_transactions", json_integer(stats().n_ro_trx));
     json_object_set_new(rval, "replayed_transactions", json_integer(stats().n_trx_replay));
+    json_object_set_new(rval, "ps_cached_routes", json_integer(stats().n_ps_cached));
 
     const char* weightby = serviceGetWeightingParameter(service());
 
@@ -447,7 +539,11 @@ bool RWSplit::configure(MXS_CONFIG_PARAMETER* params)
     bool rval = false;
     Config cnf(params);
 
-    if (handle_max_slaves(cnf, config_get_string(params, "max_slave_connections")))
+    if (cnf.lazy_connect && cnf.disable_sescmd_history)
+    {
+        MXS_ERROR("'lazy_connect' cannot be used together with 'disable_sescmd_history'.");
+    }
+    else if (handle_max_slaves(cnf, config_get_string(params, "max_slave_connections")))
     {
         m_config.assign(cnf);
         rval = true;
@@ -509,6 +605,7 @@ extern "C" MXS_MODULE* MXS_CREATE_MODULE()
             {"retry_failed_reads",         MXS_MODULE_PARAM_BOOL,    "true"         },
             {"disable_sescmd_history",     MXS_MODULE_PARAM_BOOL,    "false"        },
             {"max_sescmd_history",         MXS_MODULE_PARAM_COUNT,   "50"           },
+            {"compact_sescmd_history",     MXS_MODULE_PARAM_BOOL,    "true"         },
             {"strict_multi_stmt",          MXS_MODULE_PARAM_BOOL,    "false"        },
             {"strict_sp_calls",            MXS_MODULE_PARAM_BOOL,    "false"        },
             {"master_accept_reads",        MXS_MODULE_PARAM_BOOL,    "false"        },
@@ -520,7 +617,9 @@ extern "C" MXS_MODULE* MXS_CREATE_MODULE()
             {"delayed_retry_timeout",      MXS_MODULE_PARAM_COUNT,   "10"           },
             {"transaction_replay",         MXS_MODULE_PARAM_BOOL,    "false"        },
             {"transaction_replay_max_size",MXS_MODULE_PARAM_SIZE,    "1Mi"          },
+            {"transaction_replay_spill_size",MXS_MODULE_PARAM_SIZE,  "0"            },
             {"optimistic_trx",             MXS_MODULE_PARAM_BOOL,    "false"        },
+            {"lazy_connect",               MXS_MODULE_PARAM_BOOL,    "false"        },
             {MXS_END_MODULE_PARAMS}
         }
     };
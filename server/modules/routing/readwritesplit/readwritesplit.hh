@@ -151,6 +151,7 @@ struct Config
                 params, "master_failure_mode", master_failure_mode_values))
         , max_sescmd_history(config_get_integer(params, "max_sescmd_history"))
         , disable_sescmd_history(config_get_bool(params, "disable_sescmd_history"))
+        , compact_sescmd_history(config_get_bool(params, "compact_sescmd_history"))
         , master_accept_reads(config_get_bool(params, "master_accept_reads"))
         , strict_multi_stmt(config_get_bool(params, "strict_multi_stmt"))
         , strict_sp_calls(config_get_bool(params, "strict_sp_calls"))
@@ -166,12 +167,20 @@ struct Config
         , delayed_retry_timeout(config_get_integer(params, "delayed_retry_timeout"))
         , transaction_replay(config_get_bool(params, "transaction_replay"))
         , trx_max_size(config_get_size(params, "transaction_replay_max_size"))
+        , trx_max_spill_size(config_get_size(params, "transaction_replay_spill_size"))
         , optimistic_trx(config_get_bool(params, "optimistic_trx"))
+        , lazy_connect(config_get_bool(params, "lazy_connect"))
     {
         if (causal_reads)
         {
             retry_failed_reads = true;
         }
+
+        if (lazy_connect)
+        {
+            // The master is connected only when it is first needed
+            master_reconnection = true;
+        }
     }
 
     select_criteria_t     slave_selection_criteria;     /**< The slave selection criteria */
@@ -182,6 +191,7 @@ struct Config
     failure_mode master_failure_mode;   /**< Master server failure handling mode */
     uint64_t     max_sescmd_history;    /**< Maximum amount of session commands to store */
     bool         disable_sescmd_history;/**< Disable session command history */
+    bool         compact_sescmd_history;/**< Remove overridden commands from the history */
     bool         master_accept_reads;   /**< Use master for reads */
     bool         strict_multi_stmt;     /**< Force non-multistatement queries to be routed to
                                          * the master after a multistatement query. */
@@ -200,7 +210,9 @@ struct Config
     uint64_t    delayed_retry_timeout;  /**< How long to delay until an error is returned */
     bool        transaction_replay;     /**< Replay failed transactions */
     size_t      trx_max_size;           /**< Max transaction size for replaying */
+    size_t      trx_max_spill_size;     /**< Max size of the part stored in a file */
     bool        optimistic_trx;         /**< Enable optimistic transactions */
+    bool        lazy_connect;           /**< Connect to servers only when they are needed */
 };
 
 /**
@@ -216,6 +228,7 @@ struct Stats
     uint64_t n_trx_replay = 0;      /**< Number of replayed transactions */
     uint64_t n_ro_trx = 0;          /**< Read-only transaction count */
     uint64_t n_rw_trx = 0;          /**< Read-write transaction count */
+    uint64_t n_ps_cached = 0;       /**< Prepared statements routed by cached decision */
 };
 
 // Statistics for one server
@@ -233,6 +246,25 @@ struct ServerStats
     }
 };
 
+/**
+ * Session commands executed on one worker, by the hash of their contents
+ */
+using SescmdInternTable = std::unordered_multimap<size_t, mxs::SSessionCommand>;
+
+/**
+ * A GTID that a server is known to have replicated
+ */
+struct ReplicatedGtid
+{
+    uint64_t sequence = 0;          /**< The sequence number of the GTID */
+    uint64_t monitor_sequence = 0;  /**< The sequence number the monitor reported at the time */
+};
+
+/**
+ * The GTIDs replicated by each server, by server and replication domain
+ */
+using ReplicatedGtidMap = std::map<std::pair<SERVER*, uint32_t>, ReplicatedGtid>;
+
 class RWSplitSession;
 
 /**
@@ -257,6 +289,40 @@ public:
     ServerStats&  server_stats(SERVER* server);
     SrvStatMap    all_server_stats() const;
 
+    /**
+     * Share the buffer of a session command with an identical command
+     *
+     * Identical commands executed by the sessions of the current worker use
+     * the same buffer, which keeps the session command histories small.
+     *
+     * @param sescmd The command to intern
+     */
+    void intern_session_command(mxs::SSessionCommand& sescmd);
+
+    /**
+     * Check whether a server has replicated a GTID
+     *
+     * The position reported by the monitor is used first. If the server has not
+     * reached the GTID according to it, the positions found by the causal reads
+     * done on the current worker are used.
+     *
+     * @param server   The server to check
+     * @param domain   The replication domain of the GTID
+     * @param sequence The sequence number of the GTID
+     *
+     * @return True if the server is known to have replicated the GTID
+     */
+    bool gtid_is_replicated(SERVER* server, uint32_t domain, uint64_t sequence);
+
+    /**
+     * Record that a server has replicated a GTID
+     *
+     * @param server   The server where a causal read waited for the GTID
+     * @param domain   The replication domain of the GTID
+     * @param sequence The sequence number of the GTID
+     */
+    void set_gtid_replicated(SERVER* server, uint32_t domain, uint64_t sequence);
+
     int  max_slave_count() const;
     bool have_enough_servers() const;
     bool select_connect_backend_servers(MXS_SESSION* session,
@@ -331,10 +397,12 @@ private:
     // Called when worker local data needs to be updated
     static void update_config(void* data);
 
-    SERVICE*                       m_service;   /**< Service where the router belongs*/
-    mxs::rworker_local<Config>     m_config;
-    Stats                          m_stats;
-    mxs::rworker_local<SrvStatMap> m_server_stats;
+    SERVICE*                              m_service;    /**< Service where the router belongs*/
+    mxs::rworker_local<Config>            m_config;
+    Stats                                 m_stats;
+    mxs::rworker_local<SrvStatMap>        m_server_stats;
+    mxs::rworker_local<SescmdInternTable> m_sescmd_intern;
+    mxs::rworker_local<ReplicatedGtidMap> m_replicated_gtids;
 };
 
 static inline const char* select_criteria_to_str(select_criteria_t type)
@@ -410,6 +478,26 @@ SRWBackendVector::iterator find_best_backend(SRWBackendVector& backends,
                                              BackendSelectFunction select,
                                              bool masters_accepts_reads);
 
+/**
+ * Get the setting a session command assigns
+ *
+ * Only commands that assign a constant value to a single setting can be
+ * compacted from the history: the latest such command for a setting makes the
+ * earlier ones redundant, provided that nothing between them depends on the
+ * setting.
+ *
+ * @param command       The command byte of the session command
+ * @param sql           The SQL of the session command
+ * @param key           The assigned setting: "schema" for the default database,
+ *                      "names" for SET NAMES, "@name" for user variables and
+ *                      the variable name for system variables
+ * @param string_value  Set to true if a string is assigned to a user variable,
+ *                      which makes the value depend on the connection character set
+ *
+ * @return True if the command can be compacted
+ */
+bool get_sescmd_key(uint8_t command, const std::string& sql, std::string* key, bool* string_value);
+
 /*
  * The following are implemented in rwsplit_tmp_table_multi.c
  */
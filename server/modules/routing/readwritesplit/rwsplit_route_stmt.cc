@@ -108,6 +108,38 @@ void replace_binary_ps_id(GWBUF* buffer, uint32_t id)
 }
 }
 
+bool RWSplitSession::have_open_connections() const
+{
+    for (const auto& b : m_backends)
+    {
+        if (b->in_use())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void RWSplitSession::connect_for_session_command()
+{
+    // Prefer the server reads would be routed to, so that a read-only client
+    // only ever connects to one server.
+    SRWBackend target = get_slave_backend(get_max_replication_lag());
+    route_target_t route_target = TARGET_SLAVE;
+
+    if (!target)
+    {
+        target = get_master_backend();
+        route_target = TARGET_MASTER;
+    }
+
+    if (target && !prepare_target(target, route_target))
+    {
+        MXS_ERROR("Failed to connect to '%s' for a session command.", target->name());
+    }
+}
+
 bool RWSplitSession::have_connected_slaves() const
 {
     for (const auto& b : m_backends)
@@ -180,6 +212,11 @@ bool RWSplitSession::route_single_stmt(GWBUF* querybuf)
     route_target_t route_target = info.target();
     bool not_locked_to_master = !is_locked_to_master();
 
+    if (info.ps_cached())
+    {
+        mxb::atomic::add(&m_router->stats().n_ps_cached, 1, mxb::atomic::RELAXED);
+    }
+
     if (not_locked_to_master && mxs_mysql_is_ps_command(command) && !m_qc.large_query())
     {
         /** Replace the client statement ID with our internal one only if the
@@ -342,30 +379,6 @@ bool RWSplitSession::route_single_stmt(GWBUF* querybuf)
     return succp;
 }
 
-/**
- * Compress session command history
- *
- * This function removes data duplication by sharing buffers between session
- * commands that have identical data. Only one copy of the actual data is stored
- * for each unique session command.
- *
- * @param sescmd Executed session command
- */
-void RWSplitSession::compress_history(mxs::SSessionCommand& sescmd)
-{
-    auto eq = [&](mxs::SSessionCommand& scmd) {
-            return scmd->eq(*sescmd);
-        };
-
-    auto first = std::find_if(m_sescmd_list.begin(), m_sescmd_list.end(), eq);
-
-    if (first != m_sescmd_list.end())
-    {
-        // Duplicate command, use a reference of the old command instead of duplicating it
-        sescmd->mark_as_duplicate(**first);
-    }
-}
-
 void RWSplitSession::continue_large_session_write(GWBUF* querybuf, uint32_t type)
 {
     for (auto it = m_backends.begin(); it != m_backends.end(); it++)
@@ -422,6 +435,26 @@ bool RWSplitSession::route_session_write(GWBUF* querybuf, uint8_t command, uint3
         m_qc.ps_erase(querybuf);
     }
 
+    if (m_config.lazy_connect && !have_open_connections())
+    {
+        // The other servers execute the command from the history when they are connected
+        connect_for_session_command();
+    }
+
+    if (m_config.lazy_connect && m_config.max_sescmd_history > 0
+        && m_sescmd_list.size() >= m_config.max_sescmd_history)
+    {
+        // This command exceeds the history limit, after which no servers can be
+        // connected. The master must be connected while the history still exists.
+        SRWBackend master = get_master_backend();
+
+        if (master && !master->in_use() && !prepare_target(master, TARGET_MASTER))
+        {
+            MXS_ERROR("Failed to connect to master '%s' before the session command "
+                      "history was disabled.", master->name());
+        }
+    }
+
     MXS_INFO("Session write, routing to all servers.");
     bool attempted_write = false;
 
@@ -432,6 +465,7 @@ bool RWSplitSession::route_session_write(GWBUF* querybuf, uint8_t command, uint3
         if (backend->in_use())
         {
             attempted_write = true;
+            bool executing = backend->has_session_commands();
             backend->append_session_command(sescmd);
 
             uint64_t current_pos = backend->next_session_command()->get_position();
@@ -441,7 +475,16 @@ bool RWSplitSession::route_session_write(GWBUF* querybuf, uint8_t command, uint3
                 lowest_pos = current_pos;
             }
 
-            if (backend->execute_session_command())
+            if (executing)
+            {
+                // The server is still executing earlier session commands, it
+                // executes this one when it has replied to them
+                nsucc += 1;
+                MXS_INFO("Queued session command on %s, %lu commands pending",
+                         backend->name(),
+                         backend->session_command_count());
+            }
+            else if (backend->execute_session_command())
             {
                 nsucc += 1;
                 mxb::atomic::add(&backend->server()->stats.packets, 1, mxb::atomic::RELAXED);
@@ -487,21 +530,18 @@ bool RWSplitSession::route_session_write(GWBUF* querybuf, uint8_t command, uint3
         m_config.disable_sescmd_history = true;
         m_config.max_sescmd_history = 0;
         m_sescmd_list.clear();
+        m_sescmd_tail.clear();
     }
 
-    if (m_config.disable_sescmd_history)
+    if (m_config.disable_sescmd_history || m_config.compact_sescmd_history)
     {
-        /** Prune stored responses */
-        ResponseMap::iterator it = m_sescmd_responses.lower_bound(lowest_pos);
-
-        if (it != m_sescmd_responses.end())
-        {
-            m_sescmd_responses.erase(m_sescmd_responses.begin(), it);
-        }
+        /** Prune stored responses, the history no longer has every command */
+        prune_sescmd_responses(&m_sescmd_responses, m_sescmd_list, lowest_pos);
     }
-    else
+
+    if (!m_config.disable_sescmd_history)
     {
-        compress_history(sescmd);
+        m_router->intern_session_command(sescmd);
         m_sescmd_list.push_back(sescmd);
     }
 
@@ -568,8 +608,15 @@ SRWBackend RWSplitSession::get_slave_backend(int max_rlag)
             && backend->can_connect()
             && counts.second < m_router->max_slave_count();
 
+        // Without lazy_connect, the master is connected when the session starts
+        bool can_take_master_into_use = m_config.lazy_connect
+            && backend->is_master()
+            && !backend->in_use()
+            && can_recover_servers()
+            && backend->can_connect();
+
         bool master_or_slave = backend->is_master() || backend->is_slave();
-        bool is_useable = backend->in_use() || can_take_slave_into_use;
+        bool is_useable = backend->in_use() || can_take_slave_into_use || can_take_master_into_use;
         bool not_a_slacker = rpl_lag_is_ok(backend, max_rlag);
 
         bool server_is_candidate = master_or_slave && is_useable && not_a_slacker;
@@ -580,6 +627,26 @@ SRWBackend RWSplitSession::get_slave_backend(int max_rlag)
         }
     }
 
+    if (m_config.causal_reads && !m_gtid_pos.empty())
+    {
+        // Prefer the slaves that already have the latest write of the session, the
+        // reads need not wait for the GTID on them
+        SRWBackendVector replicated;
+
+        for (auto& candidate : candidates)
+        {
+            if ((*candidate)->is_slave() && gtid_is_replicated(*candidate))
+            {
+                replicated.push_back(candidate);
+            }
+        }
+
+        if (!replicated.empty())
+        {
+            candidates.swap(replicated);
+        }
+    }
+
     SRWBackendVector::const_iterator rval = find_best_backend(candidates,
                                                               m_config.backend_select_fct,
                                                               m_config.master_accept_reads);
@@ -1070,9 +1137,10 @@ bool RWSplitSession::handle_got_target(GWBUF* querybuf, SRWBackend& target, bool
     GWBUF* send_buf = gwbuf_clone(querybuf);
 
     if (m_config.causal_reads && cmd == COM_QUERY && !m_gtid_pos.empty()
-        && target->is_slave())
+        && target->is_slave() && !gtid_is_replicated(target))
     {
-        // Perform the causal read only when the query is routed to a slave
+        // Perform the causal read only when the query is routed to a slave that
+        // may not have the latest write of the session
         send_buf = add_prefix_wait_gtid(target->server(), send_buf);
         m_wait_gtid = WAITING_FOR_HEADER;
     }
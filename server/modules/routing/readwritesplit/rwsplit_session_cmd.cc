@@ -14,12 +14,16 @@
 #include "readwritesplit.hh"
 #include "rwsplitsession.hh"
 
+#include <ctype.h>
 #include <stdio.h>
 #include <strings.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <maxscale/router.h>
 
 using namespace maxscale;
@@ -76,6 +80,263 @@ static void discard_if_response_differs(SRWBackend backend,
     }
 }
 
+/**
+ * Split a statement into tokens
+ *
+ * Quoted strings and identifiers are returned with their quotes and words are
+ * converted to lower case. Statements that contain comments or constructs
+ * that are not recognized are not split.
+ *
+ * @param sql     The statement
+ * @param tokens  The tokens of the statement
+ *
+ * @return True if the statement was split
+ */
+static bool tokenize(const std::string& sql, std::vector<std::string>* tokens)
+{
+    bool ok = true;
+    size_t i = 0;
+
+    while (ok && i < sql.length())
+    {
+        char c = sql[i];
+        size_t start = i;
+
+        if (isspace(c))
+        {
+            ++i;
+            continue;
+        }
+        else if (c == '\'' || c == '"' || c == '`')
+        {
+            // Quoted string or identifier, closed by an undoubled quote. Whether a
+            // backslash escapes the next character depends on NO_BACKSLASH_ESCAPES
+            // in the sql_mode of the connection, so strings with backslashes are
+            // not split.
+            bool done = false;
+
+            for (++i; !done && i < sql.length(); ++i)
+            {
+                if (sql[i] == '\\' && c != '`')
+                {
+                    break;
+                }
+                else if (sql[i] == c)
+                {
+                    if (i + 1 < sql.length() && sql[i + 1] == c)
+                    {
+                        ++i;
+                    }
+                    else
+                    {
+                        done = true;
+                    }
+                }
+            }
+
+            ok = done;
+
+            if (ok)
+            {
+                tokens->push_back(sql.substr(start, i - start));
+            }
+        }
+        else if (isalnum(c) || c == '_' || c == '$' || c == '@')
+        {
+            while (i < sql.length() && (isalnum(sql[i]) || strchr("_$.@", sql[i])))
+            {
+                ++i;
+            }
+
+            std::string word = sql.substr(start, i - start);
+            std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+            tokens->push_back(word);
+        }
+        else if (c == ':' && i + 1 < sql.length() && sql[i + 1] == '=')
+        {
+            tokens->push_back(":=");
+            i += 2;
+        }
+        else if (c == '=' || c == ';' || c == '-')
+        {
+            tokens->push_back(std::string(1, c));
+            ++i;
+        }
+        else
+        {
+            // Comments, expressions and everything else
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+bool get_sescmd_key(uint8_t command, const std::string& sql, std::string* key, bool* string_value)
+{
+    std::vector<std::string> tokens;
+    bool rval = false;
+    *string_value = false;
+
+    if (command == MXS_COM_INIT_DB)
+    {
+        *key = "schema";
+        rval = true;
+    }
+    else if (command == MXS_COM_QUERY && tokenize(sql, &tokens))
+    {
+        while (!tokens.empty() && tokens.back() == ";")
+        {
+            tokens.pop_back();
+        }
+
+        auto is_value = [](const std::string& token) {
+                return token[0] == '\'' || token[0] == '"'
+                       || (token[0] != '`' && token.find('@') == std::string::npos);
+            };
+
+        if (tokens.size() == 2 && tokens[0] == "use" && tokens[1][0] != '\'' && tokens[1][0] != '"')
+        {
+            *key = "schema";
+            rval = true;
+        }
+        else if (tokens.size() >= 3 && tokens[0] == "set" && tokens[1] == "names")
+        {
+            if ((tokens.size() == 3 && is_value(tokens[2]))
+                || (tokens.size() == 5 && is_value(tokens[2])
+                    && tokens[3] == "collate" && is_value(tokens[4])))
+            {
+                *key = "names";
+                rval = true;
+            }
+        }
+        else if (tokens.size() >= 4 && tokens[0] == "set")
+        {
+            size_t i = (tokens[1] == "session" || tokens[1] == "local") ? 2 : 1;
+            std::string name = tokens[i];
+            std::string value;
+
+            if (tokens.size() == i + 3)
+            {
+                value = tokens[i + 2];
+            }
+            else if (tokens.size() == i + 4 && tokens[i + 2] == "-" && isdigit(tokens[i + 3][0]))
+            {
+                value = tokens[i + 3];
+            }
+
+            bool user_var = name[0] == '@' && name[1] != '@';
+
+            if (user_var)
+            {
+                *string_value = value[0] == '\'' || value[0] == '"';
+            }
+            else
+            {
+                if (name.compare(0, 2, "@@") == 0)
+                {
+                    name = name.substr(2);
+                }
+
+                for (const char* scope : {"session.", "local."})
+                {
+                    if (name.compare(0, strlen(scope), scope) == 0)
+                    {
+                        name = name.substr(strlen(scope));
+                    }
+                }
+            }
+
+            bool valid_name = user_var ?
+                name.length() > 1 && name.find_first_of("@.", 1) == std::string::npos :
+                (isalpha(name[0]) || name[0] == '_') && name.find_first_of("@.") == std::string::npos
+                && name != "password";
+
+            if (valid_name && !value.empty() && is_value(value)
+                && (tokens[i + 1] == "=" || tokens[i + 1] == ":="))
+            {
+                *key = name;
+                rval = true;
+            }
+        }
+    }
+
+    return rval;
+}
+
+void compact_sescmd_history(mxs::SessionCommandList* history,
+                            SescmdTail* tail,
+                            const SSessionCommand& sescmd,
+                            bool succeeded)
+{
+    // The command is usually at the end of the history
+    auto rit = std::find(history->rbegin(), history->rend(), sescmd);
+    std::string key;
+    bool string_value;
+
+    if (rit == history->rend())
+    {
+        // Not in the history
+    }
+    else if (succeeded && get_sescmd_key(sescmd->get_command(), sescmd->to_string(), &key, &string_value))
+    {
+        auto it = std::prev(rit.base());
+        auto old = tail->find(key);
+
+        if (old != tail->end())
+        {
+            MXS_INFO("Removing session command no. %lu from the history, overridden by no. %lu",
+                     (*old->second)->get_position(), sescmd->get_position());
+            history->erase(old->second);
+            old->second = it;
+        }
+        else
+        {
+            tail->emplace(key, it);
+        }
+
+        if (string_value)
+        {
+            // The value depends on the character set and collation of the connection
+            for (const char* setting : {"names", "character_set_client",
+                                        "character_set_connection", "collation_connection"})
+            {
+                tail->erase(setting);
+            }
+        }
+    }
+    else
+    {
+        tail->clear();
+    }
+}
+
+void prune_sescmd_responses(ResponseMap* responses,
+                            const mxs::SessionCommandList& history,
+                            uint64_t lowest_pos)
+{
+    auto cmd = history.begin();
+    auto it = responses->begin();
+
+    while (it != responses->end() && it->first < lowest_pos)
+    {
+        while (cmd != history.end() && (*cmd)->get_position() < it->first)
+        {
+            ++cmd;
+        }
+
+        if (cmd != history.end() && (*cmd)->get_position() == it->first)
+        {
+            // Still in the history
+            ++it;
+        }
+        else
+        {
+            it = responses->erase(it);
+        }
+    }
+}
+
 void RWSplitSession::process_sescmd_response(SRWBackend& backend, GWBUF** ppPacket)
 {
     if (backend->has_session_commands())
@@ -110,6 +371,11 @@ void RWSplitSession::process_sescmd_response(SRWBackend& backend, GWBUF** ppPack
                  * be compared to it */
                 m_sescmd_responses[id] = cmd;
 
+                if (m_config.compact_sescmd_history && !m_config.disable_sescmd_history)
+                {
+                    compact_sescmd_history(&m_sescmd_list, &m_sescmd_tail, sescmd, cmd != MYSQL_REPLY_ERR);
+                }
+
                 if (cmd == MYSQL_REPLY_ERR)
                 {
                     MXS_INFO("Session command no. %lu failed: %s",
@@ -38,6 +38,8 @@ RWSplitSession::RWSplitSession(RWSplit* instance,
     , m_sent_sescmd(0)
     , m_recv_sescmd(0)
     , m_gtid_pos("")
+    , m_gtid_domain(0)
+    , m_gtid_sequence(0)
     , m_wait_gtid(NONE)
     , m_next_seq(0)
     , m_qc(this, session, m_config.use_sql_variables_in)
@@ -69,12 +71,30 @@ RWSplitSession* RWSplitSession::create(RWSplit* router, MXS_SESSION* session)
 
         SRWBackend master;
 
-        if (router->select_connect_backend_servers(session,
-                                                   backends,
-                                                   master,
-                                                   NULL,
-                                                   NULL,
-                                                   connection_type::ALL))
+        if (router->config().lazy_connect)
+        {
+            /**
+             * No connections are created until they are needed. The master is
+             * only remembered so that it is connected when the first write is
+             * routed to it.
+             */
+            master = get_root_master(backends);
+
+            if (!master && router->config().master_failure_mode == RW_FAIL_INSTANTLY)
+            {
+                MXS_ERROR("Couldn't find suitable Master from %lu candidates.", backends.size());
+            }
+            else if ((rses = new RWSplitSession(router, session, backends, master)))
+            {
+                router->stats().n_sessions += 1;
+            }
+        }
+        else if (router->select_connect_backend_servers(session,
+                                                        backends,
+                                                        master,
+                                                        NULL,
+                                                        NULL,
+                                                        connection_type::ALL))
         {
             if ((rses = new RWSplitSession(router, session, backends, master)))
             {
@@ -118,12 +138,31 @@ void RWSplitSession::close()
     }
 }
 
+bool RWSplitSession::is_waiting_replies() const
+{
+    int background_replies = 0;
+
+    if (m_recv_sescmd == m_sent_sescmd)
+    {
+        // The client has the replies to all session commands, the remaining ones are discarded
+        for (const auto& backend : m_backends)
+        {
+            if (backend->in_use() && backend->has_session_commands() && backend->is_waiting_result())
+            {
+                ++background_replies;
+            }
+        }
+    }
+
+    return m_expected_responses > background_replies;
+}
+
 int32_t RWSplitSession::routeQuery(GWBUF* querybuf)
 {
     int rval = 0;
 
     if (m_query_queue == NULL
-        && (m_expected_responses == 0
+        && (!is_waiting_replies()
             || m_qc.load_data_state() == QueryClassifier::LOAD_DATA_ACTIVE
             || m_qc.large_query()))
     {
@@ -161,7 +200,7 @@ int32_t RWSplitSession::routeQuery(GWBUF* querybuf)
          * We are already processing a request from the client. Store the
          * new query and wait for the previous one to complete.
          */
-        mxb_assert(m_expected_responses > 0 || m_query_queue);
+        mxb_assert(is_waiting_replies() || m_query_queue);
         MXS_INFO("Storing query (len: %d cmd: %0x), expecting %d replies to current command",
                  gwbuf_length(querybuf),
                  GWBUF_DATA(querybuf)[4],
@@ -170,7 +209,7 @@ int32_t RWSplitSession::routeQuery(GWBUF* querybuf)
         querybuf = NULL;
         rval = 1;
 
-        if (m_expected_responses == 0 && !route_stored_query())
+        if (!is_waiting_replies() && !route_stored_query())
         {
             rval = 0;
         }
@@ -382,6 +421,12 @@ static void log_unexpected_response(SRWBackend& backend, GWBUF* buffer, GWBUF* c
     }
 }
 
+bool RWSplitSession::gtid_is_replicated(const SRWBackend& backend)
+{
+    return m_gtid_sequence
+           && m_router->gtid_is_replicated(backend->server(), m_gtid_domain, m_gtid_sequence);
+}
+
 GWBUF* RWSplitSession::handle_causal_read_reply(GWBUF* writebuf, SRWBackend& backend)
 {
     if (m_config.causal_reads)
@@ -391,12 +436,32 @@ GWBUF* RWSplitSession::handle_causal_read_reply(GWBUF* writebuf, SRWBackend& bac
             if (char* tmp = gwbuf_get_property(writebuf, MXS_LAST_GTID))
             {
                 m_gtid_pos = std::string(tmp);
+                unsigned int domain;
+                unsigned long long server_id;
+                unsigned long long sequence;
+
+                // Only MariaDB GTIDs can be compared with the positions of the servers
+                if (sscanf(tmp, "%u-%llu-%llu", &domain, &server_id, &sequence) == 3)
+                {
+                    m_gtid_domain = domain;
+                    m_gtid_sequence = sequence;
+                }
+                else
+                {
+                    m_gtid_sequence = 0;
+                }
             }
         }
 
         if (m_wait_gtid == WAITING_FOR_HEADER)
         {
             writebuf = discard_master_wait_gtid_result(writebuf);
+
+            if (m_wait_gtid == UPDATING_PACKETS && m_gtid_sequence)
+            {
+                // The wait succeeded, the other sessions need not wait on this server
+                m_router->set_gtid_replicated(backend->server(), m_gtid_domain, m_gtid_sequence);
+            }
         }
 
         if (m_wait_gtid == UPDATING_PACKETS && writebuf)
@@ -410,13 +475,26 @@ GWBUF* RWSplitSession::handle_causal_read_reply(GWBUF* writebuf, SRWBackend& bac
 
 void RWSplitSession::trx_replay_next_stmt()
 {
-    if (m_replayed_trx.have_stmts())
+    GWBUF* buf = NULL;
+
+    if (m_replayed_trx.have_stmts() && (buf = m_replayed_trx.pop_stmt()))
     {
         // More statements to replay, pop the oldest one and execute it
-        GWBUF* buf = m_replayed_trx.pop_stmt();
         MXS_INFO("Replaying: %s", mxs::extract_sql(buf, 1024).c_str());
         retry_query(buf, 0);
     }
+    else if (m_replayed_trx.have_stmts())
+    {
+        // The spilled part of the transaction could not be read
+        m_is_replay_active = false;
+        modutil_send_mysql_err_packet(m_client,
+                                      0,
+                                      0,
+                                      1927,
+                                      "08S01",
+                                      "Failed to read the transaction when replaying it.");
+        poll_fake_hangup_event(m_client);
+    }
     else
     {
         // No more statements to execute
@@ -426,7 +504,7 @@ void RWSplitSession::trx_replay_next_stmt()
         if (!m_replayed_trx.empty())
         {
             // Check that the checksums match.
-            SHA1Checksum chksum = m_trx.checksum();
+            Murmur3Checksum chksum = m_trx.checksum();
             chksum.finalize();
 
             if (chksum == m_replayed_trx.checksum())
@@ -499,7 +577,7 @@ void RWSplitSession::manage_transactions(SRWBackend& backend, GWBUF* writebuf)
 
             size_t size {m_trx.size() + m_current_query.length()};
             // A transaction is open and it is eligible for replaying
-            if (size < m_config.trx_max_size)
+            if (size < m_config.trx_max_size + m_config.trx_max_spill_size)
             {
                 /** Transaction size is OK, store the statement for replaying and
                  * update the checksum of the result */
@@ -512,7 +590,16 @@ void RWSplitSession::manage_transactions(SRWBackend& backend, GWBUF* writebuf)
 
                     // Add the statement to the transaction once the first part
                     // of the result is received.
-                    m_trx.add_stmt(m_current_query.release());
+                    if (size < m_config.trx_max_size && !m_trx.is_spilled())
+                    {
+                        m_trx.add_stmt(m_current_query.release());
+                    }
+                    else if (!m_trx.spill_stmt(m_current_query.release()))
+                    {
+                        MXS_INFO("Failed to store the transaction, can't replay if it fails.");
+                        m_trx.close();
+                        m_can_replay_trx = false;
+                    }
                 }
             }
             else
@@ -618,9 +705,10 @@ void RWSplitSession::clientReply(GWBUF* writebuf, DCB* backend_dcb)
     {
         mxb_assert(m_config.transaction_replay);
 
-        if (m_expected_responses == 0)
+        if (!is_waiting_replies())
         {
-            // Current statement is complete, continue with the next one
+            // Current statement is complete, continue with the next one. Slaves
+            // may still be executing session commands the client has a reply to.
             trx_replay_next_stmt();
         }
 
@@ -670,7 +758,7 @@ void RWSplitSession::clientReply(GWBUF* writebuf, DCB* backend_dcb)
             m_expected_responses++;
         }
     }
-    else if (m_expected_responses == 0 && m_query_queue
+    else if (!is_waiting_replies() && m_query_queue
              && (!m_is_replay_active || processed_sescmd))
     {
         /**
@@ -740,7 +828,7 @@ bool RWSplitSession::start_trx_replay()
             if (m_replayed_trx.have_stmts())
             {
                 // Pop the first statement and start replaying the transaction
-                retry_query(m_replayed_trx.pop_stmt(), 0);
+                trx_replay_next_stmt();
             }
             else
             {
@@ -934,7 +1022,19 @@ bool RWSplitSession::handle_error_new_connection(DCB* backend_dcb, GWBUF* errmsg
     MXS_SESSION* ses = backend_dcb->session;
     bool route_stored = false;
 
-    if (backend->is_waiting_result())
+    if (backend->is_waiting_result() && backend->has_session_commands()
+        && m_recv_sescmd == m_sent_sescmd)
+    {
+        /**
+         * The client already has the replies to the session commands the server
+         * was executing. Nothing needs to be retried and the client is not waiting
+         * for an error.
+         */
+        mxb_assert(m_expected_responses > 0);
+        m_expected_responses--;
+        route_stored = true;
+    }
+    else if (backend->is_waiting_result())
     {
         mxb_assert(m_expected_responses > 0);
         m_expected_responses--;
@@ -962,7 +1062,7 @@ bool RWSplitSession::handle_error_new_connection(DCB* backend_dcb, GWBUF* errmsg
                 m_client->func.write(m_client, gwbuf_clone(errmsg));
             }
 
-            if (m_expected_responses == 0)
+            if (!is_waiting_replies())
             {
                 // This was the last response, try to route pending queries
                 route_stored = true;
@@ -976,7 +1076,7 @@ bool RWSplitSession::handle_error_new_connection(DCB* backend_dcb, GWBUF* errmsg
      * server as the target. */
     backend->close();
 
-    if (route_stored)
+    if (route_stored && !is_waiting_replies())
     {
         route_stored_query();
     }
@@ -986,8 +1086,9 @@ bool RWSplitSession::handle_error_new_connection(DCB* backend_dcb, GWBUF* errmsg
      * Try to get replacement slave or at least the minimum
      * number of slave connections for router session.
      */
-    if (m_recv_sescmd > 0 && m_config.disable_sescmd_history)
+    if ((m_recv_sescmd > 0 && m_config.disable_sescmd_history) || m_config.lazy_connect)
     {
+        // With lazy_connect, replacement connections are created when they are needed
         succp = m_router->have_enough_servers();
     }
     else
@@ -40,6 +40,9 @@ typedef std::list<std::pair<mxs::SRWBackend, uint8_t>> SlaveResponseList;
 /** Map of COM_STMT_EXECUTE targets by internal ID */
 typedef std::unordered_map<uint32_t, mxs::SRWBackend> ExecMap;
 
+/** The latest session command for each setting, as positions in the history */
+typedef std::unordered_map<std::string, mxs::SessionCommandList::iterator> SescmdTail;
+
 /**
  * The client session of a RWSplit instance
  */
@@ -143,6 +146,8 @@ public:
     GWBUF*                  m_query_queue;      /**< Queued commands waiting to be executed */
     RWSplit*                m_router;           /**< The router instance */
     mxs::SessionCommandList m_sescmd_list;      /**< List of executed session commands */
+    SescmdTail              m_sescmd_tail;      /**< Latest command for each setting that can be
+                                                 * compacted from the history */
     ResponseMap             m_sescmd_responses; /**< Response to each session command */
     SlaveResponseList       m_slave_responses;  /**< Slaves that replied before the master */
     uint64_t                m_sent_sescmd;      /**< ID of the last sent session command*/
@@ -152,6 +157,8 @@ public:
     ExecMap         m_exec_map;                 /**< Map of COM_STMT_EXECUTE statement IDs to
                                                  * Backends */
     std::string          m_gtid_pos;            /**< Gtid position for causal read */
+    uint32_t             m_gtid_domain;         /**< Replication domain of m_gtid_pos */
+    uint64_t             m_gtid_sequence;       /**< Sequence number of m_gtid_pos, 0 if unknown */
     wait_gtid_state      m_wait_gtid;           /**< State of MASTER_GTID_WAIT reply */
     uint32_t             m_next_seq;            /**< Next packet's sequence number */
     mxs::QueryClassifier m_qc;                  /**< The query classifier. */
@@ -173,7 +180,6 @@ private:
                    const mxs::SRWBackend& master);
 
     void process_sescmd_response(mxs::SRWBackend& backend, GWBUF** ppPacket);
-    void compress_history(mxs::SSessionCommand& sescmd);
 
     bool route_session_write(GWBUF* querybuf, uint8_t command, uint32_t type);
     void continue_large_session_write(GWBUF* querybuf, uint32_t type);
@@ -207,6 +213,17 @@ private:
 
     GWBUF* handle_causal_read_reply(GWBUF* writebuf, mxs::SRWBackend& backend);
     GWBUF* add_prefix_wait_gtid(SERVER* server, GWBUF* origin);
+
+    /**
+     * Check whether a server has replicated the latest write of the session
+     *
+     * Causal reads can be done on such servers without waiting for the GTID.
+     *
+     * @param backend The server to check
+     *
+     * @return True if the server is known to have the latest write
+     */
+    bool gtid_is_replicated(const mxs::SRWBackend& backend);
     void   correct_packet_sequence(GWBUF* buffer);
     GWBUF* discard_master_wait_gtid_result(GWBUF* buffer);
 
@@ -219,6 +236,12 @@ private:
 
     void trx_replay_next_stmt();
 
+    // Do we have at least one open connection
+    bool have_open_connections() const;
+
+    // Connect to the server that should execute the first session command
+    void connect_for_session_command();
+
     // Do we have at least one open slave connection
     bool have_connected_slaves() const;
 
@@ -274,6 +297,17 @@ private:
         return !m_config.disable_sescmd_history || m_recv_sescmd == 0;
     }
 
+    /**
+     * Check whether replies the client waits for are still pending
+     *
+     * Once the client has the replies to all session commands, the servers that
+     * are still executing them do not prevent queries from being routed to the
+     * servers that have completed them.
+     *
+     * @return True if the next query must wait for the current one to complete
+     */
+    bool is_waiting_replies() const;
+
     inline bool is_large_query(GWBUF* buf)
     {
         uint32_t buflen = gwbuf_length(buf);
@@ -309,6 +343,37 @@ private:
  */
 uint32_t get_internal_ps_id(RWSplitSession* rses, GWBUF* buffer);
 
+/**
+ * Remove the commands made redundant by a session command from the history
+ *
+ * Called in the order the commands complete. A command that cannot be
+ * compacted, or that fails, may depend on the commands before it, so none of
+ * them are removed afterwards.
+ *
+ * @param history   The session command history
+ * @param tail      The latest command of each setting in the history
+ * @param sescmd    The completed session command
+ * @param succeeded Whether the command succeeded
+ */
+void compact_sescmd_history(mxs::SessionCommandList* history,
+                            SescmdTail* tail,
+                            const mxs::SSessionCommand& sescmd,
+                            bool succeeded);
+
+/**
+ * Remove the stored responses that are no longer needed
+ *
+ * A response is needed as long as a server may still reply to the command, or
+ * the command is in the history and can be executed on a new connection.
+ *
+ * @param responses  The responses of the session commands
+ * @param history    The session command history, ordered by position
+ * @param lowest_pos The position of the oldest command a server has not replied to
+ */
+void prune_sescmd_responses(ResponseMap* responses,
+                            const mxs::SessionCommandList& history,
+                            uint64_t lowest_pos);
+
 #define STRTARGET(t) \
     (t == TARGET_ALL ? "TARGET_ALL"                 \
                      : (t == TARGET_MASTER ? "TARGET_MASTER"          \
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "../rwsplitsession.hh"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <maxscale/modutil.h>
+
+using std::string;
+using std::cout;
+
+namespace
+{
+
+/**
+ * Simulate a session that executes session commands one at a time
+ */
+class History
+{
+public:
+    /**
+     * Execute a session command and process the reply of the master
+     *
+     * @param sql The statement
+     * @param ok  Whether the statement succeeds
+     */
+    void execute(const string& sql, bool ok = true)
+    {
+        uint64_t id = ++m_id;
+        mxs::SSessionCommand sescmd(new mxs::SessionCommand(modutil_create_query(sql.c_str()), id));
+
+        // As done in RWSplitSession::route_session_write, the command is the
+        // only one no server has replied to
+        prune_sescmd_responses(&m_responses, m_history, id);
+        m_history.push_back(sescmd);
+
+        // As done in RWSplitSession::process_sescmd_response
+        m_responses[id] = ok ? MYSQL_REPLY_OK : MYSQL_REPLY_ERR;
+        compact_sescmd_history(&m_history, &m_tail, sescmd, ok);
+    }
+
+    std::vector<string> statements() const
+    {
+        std::vector<string> rval;
+
+        for (const auto& cmd : m_history)
+        {
+            rval.push_back(cmd->to_string());
+        }
+
+        return rval;
+    }
+
+    size_t responses() const
+    {
+        return m_responses.size();
+    }
+
+private:
+    uint64_t                m_id = 0;
+    mxs::SessionCommandList m_history;
+    SescmdTail              m_tail;
+    ResponseMap             m_responses;
+};
+
+string join(const std::vector<string>& statements)
+{
+    string rval;
+
+    for (const auto& s : statements)
+    {
+        rval += rval.empty() ? s : " | " + s;
+    }
+
+    return rval;
+}
+
+/**
+ * Test that repeating a command keeps the history and the responses bounded
+ *
+ * @return Number of errors
+ */
+int test_repeat()
+{
+    int errors = 0;
+    History history;
+
+    history.execute("USE test");
+
+    for (int i = 0; i < 10000; i++)
+    {
+        history.execute("SET NAMES utf8");
+    }
+
+    if (join(history.statements()) != "USE test | SET NAMES utf8")
+    {
+        cout << "Wrong history after repeated commands: " << join(history.statements()) << "\n";
+        errors++;
+    }
+
+    // The responses of the commands in the history and of the latest one
+    if (history.responses() > 3)
+    {
+        cout << "The responses of " << history.responses() << " commands are stored.\n";
+        errors++;
+    }
+
+    return errors;
+}
+
+/**
+ * Test the commands that stop the compaction
+ *
+ * @return Number of errors
+ */
+int test_dependencies()
+{
+    struct TestCase
+    {
+        std::vector<string> statements;
+        string              history;
+    };
+
+    std::vector<TestCase> cases = {
+        {{"SET @a = 1", "SET @b = 2", "SET @a = 3"}, "SET @b = 2 | SET @a = 3"},
+        {{"SET @a = 1", "SELECT @a INTO @b", "SET @a = 3"}, "SET @a = 1 | SELECT @a INTO @b | SET @a = 3"},
+        {{"SET NAMES latin1", "SET @s = 'x'", "SET NAMES utf8"},
+         "SET NAMES latin1 | SET @s = 'x' | SET NAMES utf8"},
+        {{"SET character_set_client = latin1", "SET @s = 'x'", "SET character_set_client = utf8"},
+         "SET character_set_client = latin1 | SET @s = 'x' | SET character_set_client = utf8"},
+        {{"SET NAMES latin1", "SET @s = 1", "SET NAMES utf8"}, "SET @s = 1 | SET NAMES utf8"},
+    };
+
+    int errors = 0;
+
+    for (const auto& tc : cases)
+    {
+        History history;
+
+        for (const auto& sql : tc.statements)
+        {
+            history.execute(sql);
+        }
+
+        if (join(history.statements()) != tc.history)
+        {
+            cout << "Wrong history for '" << join(tc.statements) << "': '"
+                 << join(history.statements()) << "'\n";
+            errors++;
+        }
+    }
+
+    return errors;
+}
+}
+
+int main()
+{
+    int errors = 0;
+
+    errors += test_repeat();
+    errors += test_dependencies();
+
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
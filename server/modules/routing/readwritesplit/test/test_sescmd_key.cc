@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "../readwritesplit.hh"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::cout;
+
+namespace
+{
+
+/**
+ * Test detection of the settings assigned by session commands
+ *
+ * @return Number of errors
+ */
+int test_query_key()
+{
+    struct TestCase
+    {
+        string sql;
+        bool   ok;
+        string key;
+        bool   string_value;
+    };
+
+    std::vector<TestCase> cases = {
+        {"USE test", true, "schema", false},
+        {"use `my db`;", true, "schema", false},
+        {"USE 'test'", false},
+        {"SET NAMES utf8", true, "names", false},
+        {"SET NAMES 'utf8mb4' COLLATE 'utf8mb4_bin'", true, "names", false},
+        {"SET NAMES @cs", false},
+        {"SET autocommit = 1", true, "autocommit", false},
+        {"SET SESSION sql_mode = 'ANSI'", true, "sql_mode", false},
+        {"SET @@session.wait_timeout = 10", true, "wait_timeout", false},
+        {"set local character_set_client = utf8", true, "character_set_client", false},
+        {"SET @@collation_connection = 'utf8_bin'", true, "collation_connection", false},
+        {"SET @a = 1", true, "@a", false},
+        {"SET @a := -1;", true, "@a", false},
+        {"SET @a = 'x'", true, "@a", true},
+        {"SET @a = \"x\"", true, "@a", true},
+        {"SET @a = 'it''s'", true, "@a", true},
+        {"SET @a = 'x\\'", false},
+        {"SET @a = 'x\\';", false},
+        {"SET @a = 'x\\\\'", false},
+        {"SET @a = @b", false},
+        {"SET @a = `b`", false},
+        {"SET @a = 1 + 1", false},
+        {"SET @a = NOW()", false},
+        {"SET @a = 1, @b = 2", false},
+        {"SET @a = 'x", false},
+        {"SET @a = 1 /* comment */", false},
+        {"SET @a.b = 1", false},
+        {"SET password = 'secret'", false},
+        {"SET @@global.max_connections = 10", false},
+        {"SET CHARACTER SET utf8", false},
+        {"SELECT 1", false},
+    };
+
+    int errors = 0;
+
+    for (const auto& tc : cases)
+    {
+        string key;
+        bool string_value = false;
+        bool ok = get_sescmd_key(MXS_COM_QUERY, tc.sql, &key, &string_value);
+
+        if (ok != tc.ok)
+        {
+            cout << "'" << tc.sql << "' should " << (tc.ok ? "" : "not ") << "be compacted.\n";
+            errors++;
+        }
+        else if (ok && (key != tc.key || string_value != tc.string_value))
+        {
+            cout << "Wrong result for '" << tc.sql << "': '" << key << "'"
+                 << (string_value ? ", string value" : "") << "\n";
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+/**
+ * Test the commands that are not queries
+ *
+ * @return Number of errors
+ */
+int test_command_key()
+{
+    int errors = 0;
+    string key;
+    bool string_value = true;
+
+    if (!get_sescmd_key(MXS_COM_INIT_DB, "", &key, &string_value) || key != "schema" || string_value)
+    {
+        cout << "COM_INIT_DB should assign the default database.\n";
+        errors++;
+    }
+
+    if (get_sescmd_key(MXS_COM_STMT_PREPARE, "SET @a = 1", &key, &string_value))
+    {
+        cout << "COM_STMT_PREPARE should not be compacted.\n";
+        errors++;
+    }
+
+    return errors;
+}
+}
+
+int main()
+{
+    int errors = 0;
+
+    errors += test_query_key();
+    errors += test_command_key();
+
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
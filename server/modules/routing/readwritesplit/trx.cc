@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "readwritesplit"
+
+#include "trx.hh"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <maxscale/log.h>
+#include <maxscale/paths.h>
+#include <maxscale/protocol/mysql.h>
+
+#include <new>
+
+namespace
+{
+
+// The buffered statements are written to the file once they exceed this
+const size_t SPILL_BUFFER_SIZE = 64 * 1024;
+
+// The part of the mapping that has been read is released in chunks of this size
+const uint64_t SPILL_RELEASE_SIZE = 16 * 1024 * 1024;
+
+// Length of the length prefix of a statement
+const size_t SPILL_LEN_BYTES = 4;
+}
+
+TrxSpill::TrxSpill(int fd)
+    : m_fd(fd)
+    , m_size(0)
+    , m_map(NULL)
+    , m_read_pos(0)
+    , m_released(0)
+{
+}
+
+TrxSpill::~TrxSpill()
+{
+    if (m_map)
+    {
+        munmap(m_map, m_size);
+    }
+
+    close(m_fd);
+}
+
+// static
+TrxSpill* TrxSpill::create()
+{
+    TrxSpill* rval = NULL;
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/rwsplit_trx_XXXXXX", get_datadir());
+    int fd = mkstemp(path);
+
+    if (fd != -1)
+    {
+        // The file is removed as soon as it is closed
+        unlink(path);
+        rval = new(std::nothrow) TrxSpill(fd);
+
+        if (!rval)
+        {
+            close(fd);
+        }
+    }
+    else
+    {
+        MXS_ERROR("Failed to create transaction spill file '%s': %d, %s",
+                  path, errno, mxs_strerror(errno));
+    }
+
+    return rval;
+}
+
+bool TrxSpill::append(GWBUF* buffer)
+{
+    mxb_assert(!m_map);
+    uint32_t len = gwbuf_length(buffer);
+    uint8_t header[SPILL_LEN_BYTES];
+    gw_mysql_set_byte4(header, len);
+
+    m_buffer.append((char*)header, sizeof(header));
+
+    for (GWBUF* b = buffer; b; b = b->next)
+    {
+        m_buffer.append((char*)GWBUF_DATA(b), GWBUF_LENGTH(b));
+    }
+
+    m_size += sizeof(header) + len;
+
+    return m_buffer.length() < SPILL_BUFFER_SIZE || flush();
+}
+
+bool TrxSpill::flush()
+{
+    const char* ptr = m_buffer.data();
+    size_t len = m_buffer.length();
+    bool rval = true;
+
+    while (rval && len > 0)
+    {
+        ssize_t rc = write(m_fd, ptr, len);
+
+        if (rc > 0)
+        {
+            ptr += rc;
+            len -= rc;
+        }
+        else if (rc == -1 && errno != EINTR)
+        {
+            MXS_ERROR("Failed to write to transaction spill file: %d, %s",
+                      errno, mxs_strerror(errno));
+            rval = false;
+        }
+    }
+
+    m_buffer.clear();
+    return rval;
+}
+
+bool TrxSpill::map()
+{
+    if (flush())
+    {
+        void* ptr = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+
+        if (ptr != MAP_FAILED)
+        {
+            m_map = (uint8_t*)ptr;
+            madvise(m_map, m_size, MADV_SEQUENTIAL);
+        }
+        else
+        {
+            MXS_ERROR("Failed to map transaction spill file: %d, %s", errno, mxs_strerror(errno));
+        }
+    }
+
+    return m_map;
+}
+
+GWBUF* TrxSpill::read()
+{
+    mxb_assert(have_stmts());
+    GWBUF* rval = NULL;
+
+    if (m_map || map())
+    {
+        uint8_t* ptr = m_map + m_read_pos;
+        uint32_t len = gw_mysql_get_byte4(ptr);
+        rval = gwbuf_alloc_and_load(len, ptr + SPILL_LEN_BYTES);
+        m_read_pos += SPILL_LEN_BYTES + len;
+
+        if (m_read_pos - m_released >= SPILL_RELEASE_SIZE)
+        {
+            // The statements are read only once, release the pages that have been read
+            uint64_t end = m_read_pos - m_read_pos % getpagesize();
+            madvise(m_map + m_released, end - m_released, MADV_DONTNEED);
+            m_released = end;
+        }
+    }
+
+    return rval;
+}
@@ -15,11 +15,77 @@
 #include <maxscale/ccdefs.hh>
 
 #include <list>
+#include <memory>
+#include <string>
 
 #include <maxscale/buffer.hh>
 #include <maxscale/utils.hh>
 #include <maxscale/modutil.hh>
 
+/**
+ * Statements of a transaction stored in a file
+ *
+ * The statements are appended to an unlinked temporary file in the data
+ * directory. When the transaction is replayed, the file is memory mapped
+ * and the statements are read from it in order.
+ */
+class TrxSpill
+{
+    TrxSpill(const TrxSpill&);
+    TrxSpill& operator=(const TrxSpill&);
+
+public:
+    /**
+     * Create a new spill file
+     *
+     * @return New spill file or NULL on error
+     */
+    static TrxSpill* create();
+
+    ~TrxSpill();
+
+    /**
+     * Append a statement to the file
+     *
+     * Statements can only be appended before the first one is read.
+     *
+     * @param buffer The statement
+     *
+     * @return True if the statement was appended
+     */
+    bool append(GWBUF* buffer);
+
+    /**
+     * Read the next statement from the file
+     *
+     * @return The next statement or NULL on error
+     */
+    GWBUF* read();
+
+    /**
+     * Check whether there are statements left to read
+     *
+     * @return True if there are statements left
+     */
+    bool have_stmts() const
+    {
+        return m_read_pos < m_size;
+    }
+
+private:
+    TrxSpill(int fd);
+
+    bool flush();
+    bool map();
+
+    int         m_fd;           /**< The spill file */
+    uint64_t    m_size;         /**< Size of the contents, including the unwritten ones */
+    std::string m_buffer;       /**< Contents not yet written to the file */
+    uint8_t*    m_map;          /**< The contents of the file, once mapped */
+    uint64_t    m_read_pos;     /**< Offset of the next statement to read */
+    uint64_t    m_released;     /**< Offset up to which the mapping has been released */
+};
+
 // A transaction
 class Trx
 {
@@ -50,6 +116,47 @@ public:
         m_log.emplace_back(buf);
     }
 
+    /**
+     * Add a statement to the spill file of the transaction
+     *
+     * Once a statement has been spilled, all subsequent statements must be
+     * spilled as well.
+     *
+     * @param buf Statement to add
+     *
+     * @return True if the statement was added
+     */
+    bool spill_stmt(GWBUF* buf)
+    {
+        mxb_assert_message(buf, "Trx::spill_stmt: Buffer must not be empty");
+        size_t len = gwbuf_length(buf);
+
+        if (!m_spill)
+        {
+            m_spill.reset(TrxSpill::create());
+        }
+
+        bool rval = m_spill && m_spill->append(buf);
+
+        if (rval)
+        {
+            m_size += len;
+        }
+
+        gwbuf_free(buf);
+        return rval;
+    }
+
+    /**
+     * Check whether statements have been spilled to a file
+     *
+     * @return True if the transaction has a spill file
+     */
+    bool is_spilled() const
+    {
+        return m_spill.get();
+    }
+
     /**
      * Add a result to the transaction
      *
@@ -68,13 +175,25 @@ public:
      * This reduces the size of the transaction by one and should only be used
      * to replay a transaction.
      *
-     * @return The oldest statement in this transaction
+     * @return The oldest statement in this transaction or NULL if the spill
+     *         file could not be read
      */
     GWBUF* pop_stmt()
     {
-        mxb_assert(!m_log.empty());
-        GWBUF* rval = m_log.front().release();
-        m_log.pop_front();
+        mxb_assert(have_stmts());
+        GWBUF* rval;
+
+        if (!m_log.empty())
+        {
+            rval = m_log.front().release();
+            m_log.pop_front();
+        }
+        else
+        {
+            // The statements in the spill file come after the ones in memory
+            rval = m_spill->read();
+        }
+
         return rval;
     }
 
@@ -101,7 +220,7 @@ public:
      */
     bool have_stmts() const
     {
-        return !m_log.empty();
+        return !m_log.empty() || (m_spill && m_spill->have_stmts());
     }
 
     /**
@@ -133,6 +252,7 @@ public:
     {
         m_checksum.reset();
         m_log.clear();
+        m_spill.reset();
         m_size = 0;
     }
 
@@ -143,13 +263,14 @@ public:
      *
      * @return The checksum of the transaction
      */
-    const mxs::SHA1Checksum& checksum() const
+    const mxs::Murmur3Checksum& checksum() const
     {
         return m_checksum;
     }
 
 private:
-    mxs::SHA1Checksum m_checksum;   /**< Checksum of the transaction */
-    TrxLog            m_log;        /**< The transaction contents */
-    size_t            m_size;       /**< Transaction size in bytes */
+    mxs::Murmur3Checksum      m_checksum;   /**< Checksum of the transaction */
+    TrxLog                    m_log;        /**< The transaction contents */
+    std::shared_ptr<TrxSpill> m_spill;      /**< Contents that did not fit into memory */
+    size_t                    m_size;       /**< Transaction size in bytes */
 };
@@ -0,0 +1,1333 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "scatter_gather.hh"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <strings.h>
+
+#include <mysqld_error.h>
+
+#include <maxscale/alloc.h>
+#include <maxscale/modutil.h>
+#include <maxscale/mysql_utils.h>
+#include <maxscale/protocol/mysql.h>
+
+namespace
+{
+
+using std::string;
+
+/** A top-level token of an SQL statement */
+struct Token
+{
+    size_t begin;
+    size_t end;
+};
+
+bool is_word_char(char c)
+{
+    return isalnum(c) || c == '_' || c == '$' || c == '.' || c == '@';
+}
+
+/**
+ * Skip a comment
+ *
+ * @return The offset after the comment or @c pos if there is no comment at @c pos
+ */
+size_t skip_comment(const string& sql, size_t pos)
+{
+    size_t len = sql.length();
+
+    if (sql[pos] == '#'
+        || (sql[pos] == '-' && pos + 1 < len && sql[pos + 1] == '-'
+            && (pos + 2 == len || isspace(sql[pos + 2]))))
+    {
+        pos = sql.find('\n', pos);
+        return pos == string::npos ? len : pos + 1;
+    }
+    else if (sql[pos] == '/' && pos + 1 < len && sql[pos + 1] == '*')
+    {
+        pos = sql.find("*/", pos + 2);
+        return pos == string::npos ? string::npos : pos + 2;
+    }
+
+    return pos;
+}
+
+size_t skip_quoted(const string& sql, size_t pos)
+{
+    char quote = sql[pos++];
+
+    while (pos < sql.length())
+    {
+        if (sql[pos] == '\\' && quote != '`')
+        {
+            pos += 2;
+        }
+        else if (sql[pos] == quote)
+        {
+            if (pos + 1 < sql.length() && sql[pos + 1] == quote)
+            {
+                pos += 2;
+            }
+            else
+            {
+                return pos + 1;
+            }
+        }
+        else
+        {
+            ++pos;
+        }
+    }
+
+    return string::npos;
+}
+
+size_t skip_group(const string& sql, size_t pos)
+{
+    int depth = 0;
+
+    while (pos < sql.length())
+    {
+        char c = sql[pos];
+        size_t next = skip_comment(sql, pos);
+
+        if (next != pos)
+        {
+            pos = next;
+        }
+        else if (c == '\'' || c == '"' || c == '`')
+        {
+            pos = skip_quoted(sql, pos);
+        }
+        else
+        {
+            if (c == '(')
+            {
+                ++depth;
+            }
+            else if (c == ')' && --depth == 0)
+            {
+                return pos + 1;
+            }
+
+            ++pos;
+        }
+
+        if (pos == string::npos)
+        {
+            break;
+        }
+    }
+
+    return string::npos;
+}
+
+/**
+ * Split an SQL statement into top-level tokens
+ *
+ * Comments are skipped and quoted strings as well as parenthesized expressions
+ * are returned as single tokens.
+ */
+bool tokenize(const string& sql, std::vector<Token>* tokens)
+{
+    size_t pos = 0;
+
+    while (pos < sql.length())
+    {
+        char c = sql[pos];
+
+        if (isspace(c))
+        {
+            ++pos;
+            continue;
+        }
+
+        if (sql.compare(pos, 3, "/*!") == 0 || sql.compare(pos, 4, "/*M!") == 0)
+        {
+            // Executable comments contain SQL that we can't see
+            return false;
+        }
+
+        size_t next = skip_comment(sql, pos);
+
+        if (next == pos)
+        {
+            if (c == '\'' || c == '"' || c == '`')
+            {
+                next = skip_quoted(sql, pos);
+            }
+            else if (c == '(')
+            {
+                next = skip_group(sql, pos);
+            }
+            else if (is_word_char(c))
+            {
+                while (next < sql.length() && is_word_char(sql[next]))
+                {
+                    ++next;
+                }
+            }
+            else
+            {
+                ++next;
+            }
+
+            if (next != string::npos)
+            {
+                Token token = {pos, next};
+                tokens->push_back(token);
+            }
+        }
+
+        if (next == string::npos)
+        {
+            return false;
+        }
+
+        pos = next;
+    }
+
+    return true;
+}
+
+bool token_is(const string& sql, const Token& token, const char* word)
+{
+    size_t len = strlen(word);
+    return token.end - token.begin == len && strncasecmp(sql.c_str() + token.begin, word, len) == 0;
+}
+
+/** Aggregate functions */
+const char* aggregate_functions[] =
+{
+    "AVG",
+    "BIT_AND",
+    "BIT_OR",
+    "BIT_XOR",
+    "COUNT",
+    "GROUP_CONCAT",
+    "JSON_ARRAYAGG",
+    "JSON_OBJECTAGG",
+    "MAX",
+    "MIN",
+    "STD",
+    "STDDEV",
+    "STDDEV_POP",
+    "STDDEV_SAMP",
+    "SUM",
+    "VARIANCE",
+    "VAR_POP",
+    "VAR_SAMP"
+};
+
+bool is_aggregate_function(const string& sql, const Token& token)
+{
+    for (auto name : aggregate_functions)
+    {
+        if (token_is(sql, token, name))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool token_to_number(const string& sql, const Token& token, uint64_t* value)
+{
+    string str = sql.substr(token.begin, token.end - token.begin);
+    char* end;
+    *value = strtoull(str.c_str(), &end, 10);
+    return !str.empty() && isdigit(str[0]) && *end == '\0';
+}
+
+/**
+ * Parse the trailing ORDER BY and LIMIT clauses of the last branch
+ *
+ * @param sql    The SQL statement
+ * @param tokens Top-level tokens
+ * @param begin  The first token of the last branch
+ * @param end    The end of the last branch, updated to exclude the clauses
+ * @param spec   The merge specification
+ *
+ * @return True if the clauses can be applied to the merged result
+ */
+bool parse_merge_spec(const string& sql, const std::vector<Token>& tokens,
+                      size_t begin, size_t* end, schemarouter::MergeSpec* spec)
+{
+    size_t n = *end;
+    size_t order = n;
+    size_t limit = n;
+
+    for (size_t i = begin; i < n; i++)
+    {
+        if (token_is(sql, tokens[i], "ORDER") && i + 1 < n && token_is(sql, tokens[i + 1], "BY"))
+        {
+            order = i;
+        }
+        else if (token_is(sql, tokens[i], "LIMIT"))
+        {
+            limit = i;
+        }
+    }
+
+    if (limit < order && order != n)
+    {
+        return false;
+    }
+
+    if (order != n)
+    {
+        size_t i = order + 2;
+
+        if (i >= limit)
+        {
+            return false;
+        }
+
+        string column = sql.substr(tokens[i].begin, tokens[i].end - tokens[i].begin);
+        uint64_t position;
+
+        if (token_to_number(sql, tokens[i], &position))
+        {
+            // The sort key of the column is requested by name
+            return false;
+        }
+        else if (column[0] == '`')
+        {
+            column = column.substr(1, column.length() - 2);
+
+            for (size_t pos = column.find("``"); pos != string::npos; pos = column.find("``", pos + 1))
+            {
+                column.erase(pos, 1);
+            }
+        }
+        else if (column.find('.') != string::npos)
+        {
+            column = column.substr(column.rfind('.') + 1);
+        }
+
+        spec->order_column = column;
+        ++i;
+
+        if (i < limit && token_is(sql, tokens[i], "DESC"))
+        {
+            spec->descending = true;
+            ++i;
+        }
+        else if (i < limit && token_is(sql, tokens[i], "ASC"))
+        {
+            ++i;
+        }
+
+        if (i != limit || spec->order_column.empty())
+        {
+            // Multi-column ordering or ordering by an expression
+            return false;
+        }
+
+        *end = order;
+    }
+
+    if (limit != n)
+    {
+        size_t i = limit + 1;
+        uint64_t first = 0;
+        uint64_t second = 0;
+
+        if (i >= n || !token_to_number(sql, tokens[i], &first))
+        {
+            return false;
+        }
+
+        ++i;
+
+        if (i + 1 < n && token_is(sql, tokens[i], ",") && token_to_number(sql, tokens[i + 1], &second))
+        {
+            spec->offset = first;
+            spec->limit = second;
+            i += 2;
+        }
+        else if (i + 1 < n && token_is(sql, tokens[i], "OFFSET")
+                 && token_to_number(sql, tokens[i + 1], &second))
+        {
+            spec->offset = second;
+            spec->limit = first;
+            i += 2;
+        }
+        else
+        {
+            spec->limit = first;
+        }
+
+        if (i != n)
+        {
+            return false;
+        }
+
+        spec->has_limit = true;
+
+        if (order == n)
+        {
+            *end = limit;
+        }
+    }
+
+    return true;
+}
+
+/** A column value of a text protocol row */
+struct Value
+{
+    const char* data;
+    size_t      len;
+    bool        is_null;
+};
+
+/**
+ * Find a column value of a row
+ *
+ * @param pRow  A text protocol row
+ * @param index The index of the column
+ * @param value If not NULL, the value is stored here
+ *
+ * @return The offset of the value in the row
+ */
+size_t find_value(GWBUF* pRow, uint64_t index, Value* value)
+{
+    uint8_t* start = GWBUF_DATA(pRow);
+    uint8_t* ptr = start + MYSQL_HEADER_LEN;
+    uint8_t* end = start + GWBUF_LENGTH(pRow);
+
+    for (uint64_t i = 0; i < index && ptr < end; i++)
+    {
+        if (*ptr == 0xfb)
+        {
+            ++ptr;
+        }
+        else
+        {
+            size_t len = mxs_leint_consume(&ptr);
+            ptr += len;
+        }
+    }
+
+    if (value)
+    {
+        value->data = NULL;
+        value->len = 0;
+        value->is_null = true;
+
+        if (ptr < end && *ptr != 0xfb)
+        {
+            uint8_t* data = ptr;
+            value->len = mxs_leint_consume(&data);
+            value->data = (const char*)data;
+            value->is_null = false;
+        }
+    }
+
+    return ptr - start;
+}
+
+Value get_value(GWBUF* pRow, uint64_t index)
+{
+    Value value;
+    find_value(pRow, index, &value);
+    return value;
+}
+
+bool is_numeric_type(uint8_t type)
+{
+    switch (type)
+    {
+    case MYSQL_TYPE_TINY:
+    case MYSQL_TYPE_SHORT:
+    case MYSQL_TYPE_INT24:
+    case MYSQL_TYPE_LONG:
+    case MYSQL_TYPE_LONGLONG:
+    case MYSQL_TYPE_YEAR:
+    case MYSQL_TYPE_DECIMAL:
+    case MYSQL_TYPE_NEWDECIMAL:
+    case MYSQL_TYPE_FLOAT:
+    case MYSQL_TYPE_DOUBLE:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+int compare_bytes(const Value& lhs, const Value& rhs)
+{
+    int rc = memcmp(lhs.data, rhs.data, std::min(lhs.len, rhs.len));
+    return rc != 0 ? rc : (lhs.len < rhs.len ? -1 : (lhs.len > rhs.len ? 1 : 0));
+}
+
+/**
+ * Compare two exact numbers, e.g. -12.50 and 3, without converting them
+ */
+int compare_decimals(Value lhs, Value rhs)
+{
+    bool lhs_negative = lhs.len > 0 && lhs.data[0] == '-';
+    bool rhs_negative = rhs.len > 0 && rhs.data[0] == '-';
+
+    if (lhs_negative != rhs_negative)
+    {
+        return lhs_negative ? -1 : 1;
+    }
+
+    Value* values[] = {&lhs, &rhs};
+    size_t int_len[2];
+
+    for (int i = 0; i < 2; i++)
+    {
+        Value& v = *values[i];
+
+        // Skip the sign and the leading zeros of the integer part
+        while (v.len > 0 && (v.data[0] == '-' || v.data[0] == '+'
+                             || (v.data[0] == '0' && v.len > 1 && v.data[1] != '.')))
+        {
+            ++v.data;
+            --v.len;
+        }
+
+        const char* dot = (const char*)memchr(v.data, '.', v.len);
+        int_len[i] = dot ? dot - v.data : v.len;
+    }
+
+    int rc = 0;
+
+    if (int_len[0] != int_len[1])
+    {
+        rc = int_len[0] < int_len[1] ? -1 : 1;
+    }
+    else
+    {
+        // The integer parts are equally long, missing decimals are zeros
+        for (size_t i = 0; rc == 0 && (i < lhs.len || i < rhs.len); i++)
+        {
+            char l = i < lhs.len ? lhs.data[i] : '0';
+            char r = i < rhs.len ? rhs.data[i] : '0';
+            rc = l < r ? -1 : (l > r ? 1 : 0);
+        }
+    }
+
+    return lhs_negative ? -rc : rc;
+}
+
+int compare_doubles(const Value& lhs, const Value& rhs)
+{
+    double l = strtod(string(lhs.data, lhs.len).c_str(), NULL);
+    double r = strtod(string(rhs.data, rhs.len).c_str(), NULL);
+    return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+/**
+ * Compare two column values
+ *
+ * NULL values sort first. Numeric values are compared as numbers and everything
+ * else, i.e. the sort keys returned by WEIGHT_STRING(), byte by byte.
+ *
+ * @param lhs  The first value
+ * @param rhs  The second value
+ * @param type The column type
+ *
+ * @return Negative if lhs sorts first, positive if rhs sorts first and 0 if they are equal
+ */
+int compare_values(const Value& lhs, const Value& rhs, uint8_t type)
+{
+    if (lhs.is_null || rhs.is_null)
+    {
+        return (int)rhs.is_null - (int)lhs.is_null;
+    }
+    else if (type == MYSQL_TYPE_FLOAT || type == MYSQL_TYPE_DOUBLE)
+    {
+        return compare_doubles(lhs, rhs);
+    }
+    else if (is_numeric_type(type))
+    {
+        return compare_decimals(lhs, rhs);
+    }
+
+    return compare_bytes(lhs, rhs);
+}
+
+/**
+ * Remove the last column value from a row
+ *
+ * @param pRow      A contiguous text protocol row
+ * @param n_columns Number of columns in the row
+ *
+ * @return The row without the last value
+ */
+GWBUF* remove_last_value(GWBUF* pRow, uint64_t n_columns)
+{
+    size_t offset = find_value(pRow, n_columns - 1, NULL);
+    pRow = gwbuf_rtrim(pRow, GWBUF_LENGTH(pRow) - offset);
+    gw_mysql_set_byte3(GWBUF_DATA(pRow), offset - MYSQL_HEADER_LEN);
+    return pRow;
+}
+
+/**
+ * Create a column count packet
+ *
+ * @param n_columns Number of columns
+ *
+ * @return The packet
+ */
+GWBUF* create_column_count(uint64_t n_columns)
+{
+    // A resultset has at most 4096 columns
+    size_t len = n_columns < 251 ? 1 : 3;
+    GWBUF* rval = gwbuf_alloc(MYSQL_HEADER_LEN + len);
+    MXS_ABORT_IF_NULL(rval);
+    uint8_t* ptr = GWBUF_DATA(rval);
+    gw_mysql_set_byte3(ptr, len);
+    ptr += MYSQL_HEADER_LEN;
+
+    if (len == 1)
+    {
+        *ptr = n_columns;
+    }
+    else
+    {
+        *ptr++ = 0xfc;
+        gw_mysql_set_byte2(ptr, n_columns);
+    }
+
+    return rval;
+}
+
+/** Offsets into the fixed length part of a column definition */
+struct ColumnInfo
+{
+    string   name;
+    uint8_t* length;    /**< 4 byte column length */
+    uint8_t* type;      /**< 1 byte column type */
+};
+
+ColumnInfo get_column_info(GWBUF* pColumn)
+{
+    uint8_t* ptr = GWBUF_DATA(pColumn) + MYSQL_HEADER_LEN;
+    ColumnInfo info;
+
+    // Skip catalog, schema, table and original table
+    for (int i = 0; i < 4; i++)
+    {
+        size_t len = mxs_leint_consume(&ptr);
+        ptr += len;
+    }
+
+    size_t len = mxs_leint_consume(&ptr);
+    info.name.assign((const char*)ptr, len);
+    ptr += len;
+
+    // Skip original name and the length of the fixed length fields
+    len = mxs_leint_consume(&ptr);
+    ptr += len;
+    ptr += mxs_leint_bytes(ptr);
+
+    // Skip the character set
+    ptr += 2;
+    info.length = ptr;
+    info.type = ptr + 4;
+
+    return info;
+}
+
+bool is_eof(GWBUF* pPacket)
+{
+    return MYSQL_GET_COMMAND(GWBUF_DATA(pPacket)) == MYSQL_REPLY_EOF
+           && MYSQL_GET_PAYLOAD_LEN(GWBUF_DATA(pPacket)) < MYSQL_EOF_PACKET_LEN;
+}
+}
+
+namespace schemarouter
+{
+
+bool parse_scatter_statement(const std::string& sql,
+                             std::vector<std::string>* branches,
+                             MergeSpec* spec)
+{
+    std::vector<Token> tokens;
+
+    if (!tokenize(sql, &tokens))
+    {
+        return false;
+    }
+
+    while (!tokens.empty() && token_is(sql, tokens.back(), ";"))
+    {
+        tokens.pop_back();
+    }
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t begin = 0;
+
+    for (size_t i = 0; i < tokens.size(); i++)
+    {
+        if (token_is(sql, tokens[i], "UNION"))
+        {
+            if (i + 1 < tokens.size() && token_is(sql, tokens[i + 1], "ALL"))
+            {
+                ranges.push_back(std::make_pair(begin, i));
+                begin = i + 2;
+                ++i;
+            }
+            else
+            {
+                // Removing duplicates would require the whole result to be buffered
+                return false;
+            }
+        }
+    }
+
+    ranges.push_back(std::make_pair(begin, tokens.size()));
+
+    if (!parse_merge_spec(sql, tokens, ranges.back().first, &ranges.back().second, spec))
+    {
+        return false;
+    }
+
+    for (const auto& r : ranges)
+    {
+        if (r.first >= r.second)
+        {
+            return false;
+        }
+
+        size_t start = tokens[r.first].begin;
+        branches->push_back(sql.substr(start, tokens[r.second - 1].end - start));
+    }
+
+    return true;
+}
+
+bool combines_rows(const std::string& sql)
+{
+    size_t len = sql.length();
+    size_t pos = 0;
+    int depth = 0;
+
+    while (pos < len)
+    {
+        char c = sql[pos];
+        size_t next = skip_comment(sql, pos);
+
+        if (next != pos)
+        {
+            pos = next;
+        }
+        else if (c == '\'' || c == '"' || c == '`')
+        {
+            pos = skip_quoted(sql, pos);
+        }
+        else if (is_word_char(c))
+        {
+            Token token = {pos, pos};
+
+            while (token.end < len && is_word_char(sql[token.end]))
+            {
+                ++token.end;
+            }
+
+            size_t after = token.end;
+
+            while (after < len && isspace(sql[after]))
+            {
+                ++after;
+            }
+
+            bool is_call = after < len && sql[after] == '(';
+
+            if (token_is(sql, token, "GROUP")
+                || token_is(sql, token, "HAVING")
+                || token_is(sql, token, "DISTINCT")
+                || token_is(sql, token, "DISTINCTROW")
+                || (depth > 0 && token_is(sql, token, "LIMIT"))
+                || (is_call && (token_is(sql, token, "OVER") || is_aggregate_function(sql, token))))
+            {
+                return true;
+            }
+
+            pos = token.end;
+        }
+        else
+        {
+            if (c == '(')
+            {
+                ++depth;
+            }
+            else if (c == ')')
+            {
+                --depth;
+            }
+
+            ++pos;
+        }
+
+        if (pos == string::npos)
+        {
+            // Unterminated string or comment, assume the worst
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string push_down_merge_spec(const std::string& branch, const MergeSpec& spec)
+{
+    std::string rval = branch;
+
+    if (!spec.order_column.empty())
+    {
+        std::string column = spec.order_column;
+
+        for (size_t pos = column.find('`'); pos != std::string::npos; pos = column.find('`', pos + 2))
+        {
+            column.insert(pos, 1, '`');
+        }
+
+        // The sort key of the column is returned as an extra column. Comparing the
+        // keys byte by byte gives the same order as the collation of the column.
+        column = "sg_.`" + column + "`";
+        rval = "SELECT sg_.*, WEIGHT_STRING(" + column + ") FROM (" + branch + ") AS sg_ ORDER BY " + column;
+
+        if (spec.descending)
+        {
+            rval += " DESC";
+        }
+    }
+
+    if (spec.has_limit)
+    {
+        rval += " LIMIT " + std::to_string(spec.offset + spec.limit);
+    }
+
+    return rval;
+}
+
+ScatterGather::ScatterGather(MXS_SESSION* session, const MergeSpec& spec)
+    : m_session(session)
+    , m_spec(spec)
+    , m_output(NULL)
+    , m_seq(1)
+    , m_header_sent(false)
+    , m_failed(false)
+    , m_complete(false)
+    , m_order_index(-1)
+    , m_order_type(MYSQL_TYPE_VAR_STRING)
+    , m_skipped(0)
+    , m_rows_sent(0)
+    , m_warnings(0)
+    , m_status(0)
+{
+}
+
+ScatterGather::~ScatterGather()
+{
+    for (auto& source : m_sources)
+    {
+        gwbuf_free(source.partial);
+        gwbuf_free(source.header);
+        gwbuf_free(source.eof);
+
+        for (auto a : source.columns)
+        {
+            gwbuf_free(a);
+        }
+
+        for (auto a : source.rows)
+        {
+            gwbuf_free(a);
+        }
+    }
+
+    gwbuf_free(m_output);
+}
+
+void ScatterGather::add_source(const SSRBackend& backend)
+{
+    Source source;
+    source.backend = backend.get();
+    source.state = EXPECT_HEADER;
+    source.partial = NULL;
+    source.header = NULL;
+    source.eof = NULL;
+    source.n_columns = 0;
+    m_sources.push_back(source);
+}
+
+ScatterGather::Source* ScatterGather::find_source(const SSRBackend& backend)
+{
+    for (auto& source : m_sources)
+    {
+        if (source.backend == backend.get())
+        {
+            return &source;
+        }
+    }
+
+    return NULL;
+}
+
+bool ScatterGather::is_source(const SSRBackend& backend) const
+{
+    for (const auto& source : m_sources)
+    {
+        if (source.backend == backend.get())
+        {
+            return source.state != DONE;
+        }
+    }
+
+    return false;
+}
+
+void ScatterGather::process_reply(const SSRBackend& backend, GWBUF* pPacket)
+{
+    Source* source = find_source(backend);
+    mxb_assert(source);
+
+    source->partial = gwbuf_append(source->partial, pPacket);
+
+    while (source->state != DONE)
+    {
+        GWBUF* packet = modutil_get_next_MySQL_packet(&source->partial);
+
+        if (packet == NULL)
+        {
+            break;
+        }
+
+        packet = gwbuf_make_contiguous(packet);
+        MXS_ABORT_IF_NULL(packet);
+        process_packet(*source, packet);
+    }
+
+    if (source->state == DONE)
+    {
+        gwbuf_free(source->partial);
+        source->partial = NULL;
+    }
+
+    merge();
+}
+
+void ScatterGather::abort_source(const SSRBackend& backend)
+{
+    if (Source* source = find_source(backend))
+    {
+        if (source->state != DONE)
+        {
+            char msg[512];
+            snprintf(msg, sizeof(msg), "Lost connection to shard '%s' during a scatter-gather query",
+                     source->backend->name());
+            fail(ER_OUT_OF_RESOURCES, "HY000", msg);
+            source->state = DONE;
+        }
+    }
+
+    merge();
+}
+
+void ScatterGather::process_packet(Source& source, GWBUF* pPacket)
+{
+    uint8_t* data = GWBUF_DATA(pPacket);
+    uint8_t cmd = MYSQL_GET_COMMAND(data);
+
+    if (MYSQL_GET_PAYLOAD_LEN(data) == GW_MYSQL_MAX_PACKET_LEN)
+    {
+        source.state = DONE;
+        fail(ER_OUT_OF_RESOURCES, "HY000", "Rows larger than 16MB are not supported by scatter-gather queries");
+        gwbuf_free(pPacket);
+        return;
+    }
+
+    if (cmd == MYSQL_REPLY_ERR)
+    {
+        source.state = DONE;
+        fail(pPacket);
+        return;
+    }
+
+    switch (source.state)
+    {
+    case EXPECT_HEADER:
+        source.header = pPacket;
+
+        if (cmd == MYSQL_REPLY_OK)
+        {
+            source.state = DONE;
+        }
+        else
+        {
+            source.n_columns = mxs_leint_value(data + MYSQL_HEADER_LEN);
+            source.state = EXPECT_COLUMNS;
+        }
+        break;
+
+    case EXPECT_COLUMNS:
+        source.columns.push_back(pPacket);
+
+        if (source.columns.size() == source.n_columns)
+        {
+            source.state = EXPECT_EOF;
+        }
+        break;
+
+    case EXPECT_EOF:
+        mxb_assert(is_eof(pPacket));
+        source.eof = pPacket;
+        source.state = EXPECT_ROWS;
+        break;
+
+    case EXPECT_ROWS:
+        if (is_eof(pPacket))
+        {
+            m_warnings += gw_mysql_get_byte2(data + MYSQL_HEADER_LEN + 1);
+            m_status = gw_mysql_get_byte2(data + MYSQL_HEADER_LEN + 3);
+            source.state = DONE;
+            gwbuf_free(pPacket);
+        }
+        else if (m_failed)
+        {
+            gwbuf_free(pPacket);
+        }
+        else
+        {
+            source.rows.push_back(pPacket);
+        }
+        break;
+
+    case DONE:
+        mxb_assert(!true);
+        gwbuf_free(pPacket);
+        break;
+    }
+}
+
+bool ScatterGather::reconcile_columns(Source& first)
+{
+    for (auto& source : m_sources)
+    {
+        if (&source == &first || source.header == NULL)
+        {
+            continue;
+        }
+
+        if (source.n_columns != first.n_columns)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < first.n_columns; i++)
+        {
+            ColumnInfo lhs = get_column_info(first.columns[i]);
+            ColumnInfo rhs = get_column_info(source.columns[i]);
+
+            // Use the widest column length and fall back to a string type if the types differ
+            if (gw_mysql_get_byte4(rhs.length) > gw_mysql_get_byte4(lhs.length))
+            {
+                memcpy(lhs.length, rhs.length, 4);
+            }
+
+            if (*lhs.type != *rhs.type)
+            {
+                *lhs.type = MYSQL_TYPE_VAR_STRING;
+            }
+        }
+    }
+
+    if (!m_spec.order_column.empty())
+    {
+        // The last column is the sort key, numbers are compared by their value
+        m_order_index = first.n_columns - 1;
+        m_order_type = MYSQL_TYPE_VAR_STRING;
+
+        for (size_t i = 0; i < first.n_columns - 1; i++)
+        {
+            ColumnInfo info = get_column_info(first.columns[i]);
+
+            if (strcasecmp(info.name.c_str(), m_spec.order_column.c_str()) == 0)
+            {
+                if (is_numeric_type(*info.type))
+                {
+                    m_order_index = i;
+                    m_order_type = *info.type;
+                }
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ScatterGather::send_header()
+{
+    Source* first = NULL;
+
+    for (auto& source : m_sources)
+    {
+        if (source.state < EXPECT_ROWS)
+        {
+            // Still waiting for column definitions
+            return false;
+        }
+
+        if (!first && source.header && source.n_columns > 0)
+        {
+            first = &source;
+        }
+    }
+
+    if (first == NULL)
+    {
+        // None of the shards returned a resultset, send the first OK packet
+        for (auto& source : m_sources)
+        {
+            if (source.header)
+            {
+                emit(source.header);
+                source.header = NULL;
+                break;
+            }
+        }
+
+        m_header_sent = true;
+        return true;
+    }
+
+    if (!reconcile_columns(*first))
+    {
+        fail(ER_WRONG_NUMBER_OF_COLUMNS_IN_SELECT,
+             "21000",
+             "The shards returned a different number of columns");
+        return false;
+    }
+
+    if (m_spec.order_column.empty())
+    {
+        emit(first->header);
+    }
+    else
+    {
+        // Hide the sort key from the client
+        gwbuf_free(first->header);
+        emit(create_column_count(first->n_columns - 1));
+        gwbuf_free(first->columns.back());
+        first->columns.pop_back();
+    }
+
+    first->header = NULL;
+
+    for (auto& a : first->columns)
+    {
+        emit(a);
+    }
+
+    first->columns.clear();
+    emit(first->eof);
+    first->eof = NULL;
+    m_header_sent = true;
+
+    return true;
+}
+
+ScatterGather::Source* ScatterGather::next_ordered_source()
+{
+    Source* rval = NULL;
+    Value best = {NULL, 0, true};
+
+    for (auto& source : m_sources)
+    {
+        if (source.rows.empty())
+        {
+            if (source.state != DONE)
+            {
+                // The next row of this shard might come first
+                return NULL;
+            }
+
+            continue;
+        }
+
+        Value value = get_value(source.rows.front(), m_order_index);
+
+        if (rval == NULL)
+        {
+            rval = &source;
+            best = value;
+        }
+        else
+        {
+            int rc = compare_values(value, best, m_order_type);
+
+            if (m_spec.descending ? rc > 0 : rc < 0)
+            {
+                rval = &source;
+                best = value;
+            }
+        }
+    }
+
+    return rval;
+}
+
+void ScatterGather::merge()
+{
+    if (!m_failed && !m_header_sent)
+    {
+        send_header();
+    }
+
+    if (m_failed)
+    {
+        discard_rows();
+    }
+    else if (m_header_sent)
+    {
+        if (m_order_index != -1)
+        {
+            while (Source* source = next_ordered_source())
+            {
+                emit_row(remove_last_value(source->rows.front(), source->n_columns));
+                source->rows.pop_front();
+            }
+        }
+        else
+        {
+            for (auto& source : m_sources)
+            {
+                while (!source.rows.empty())
+                {
+                    emit_row(source.rows.front());
+                    source.rows.pop_front();
+                }
+            }
+        }
+    }
+
+    bool done = true;
+
+    for (const auto& source : m_sources)
+    {
+        if (source.state != DONE)
+        {
+            done = false;
+            break;
+        }
+    }
+
+    if (done && !m_complete)
+    {
+        if (!m_failed && m_header_sent)
+        {
+            bool resultset = false;
+
+            for (const auto& source : m_sources)
+            {
+                resultset = resultset || source.n_columns > 0;
+            }
+
+            if (resultset)
+            {
+                GWBUF* eof = gwbuf_alloc(MYSQL_EOF_PACKET_LEN);
+                MXS_ABORT_IF_NULL(eof);
+                uint8_t* ptr = GWBUF_DATA(eof);
+                gw_mysql_set_byte3(ptr, MYSQL_EOF_PACKET_LEN - MYSQL_HEADER_LEN);
+                ptr[4] = MYSQL_REPLY_EOF;
+                gw_mysql_set_byte2(ptr + 5, m_warnings);
+                gw_mysql_set_byte2(ptr + 7, m_status & ~SERVER_MORE_RESULTS_EXIST);
+                emit(eof);
+            }
+        }
+
+        m_complete = true;
+    }
+
+    if (m_output)
+    {
+        GWBUF* output = m_output;
+        m_output = NULL;
+        MXS_SESSION_ROUTE_REPLY(m_session, output);
+    }
+}
+
+void ScatterGather::emit_row(GWBUF* pRow)
+{
+    if (m_skipped < m_spec.offset)
+    {
+        ++m_skipped;
+        gwbuf_free(pRow);
+    }
+    else if (m_spec.has_limit && m_rows_sent >= m_spec.limit)
+    {
+        gwbuf_free(pRow);
+    }
+    else
+    {
+        ++m_rows_sent;
+        emit(pRow);
+    }
+}
+
+void ScatterGather::emit(GWBUF* pPacket)
+{
+    GWBUF_DATA(pPacket)[MYSQL_SEQ_OFFSET] = m_seq++;
+    m_output = gwbuf_append(m_output, pPacket);
+}
+
+void ScatterGather::fail(uint16_t errnum, const char* sqlstate, const char* message)
+{
+    if (!m_failed)
+    {
+        MXS_INFO("Scatter-gather query failed: %s", message);
+        fail(modutil_create_mysql_err_msg(m_seq, 0, errnum, sqlstate, message));
+    }
+}
+
+void ScatterGather::fail(GWBUF* pError)
+{
+    if (m_failed)
+    {
+        gwbuf_free(pError);
+    }
+    else
+    {
+        // The error replaces any rows that were not yet sent
+        m_failed = true;
+        discard_rows();
+        emit(pError);
+    }
+}
+
+void ScatterGather::discard_rows()
+{
+    for (auto& source : m_sources)
+    {
+        for (auto a : source.rows)
+        {
+            gwbuf_free(a);
+        }
+
+        source.rows.clear();
+    }
+}
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+/**
+ * @file scatter_gather.hh - Parallel execution of read-only statements on multiple shards
+ */
+
+#include "schemarouter.hh"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <maxscale/session.h>
+
+namespace schemarouter
+{
+
+/**
+ * The ORDER BY and LIMIT clauses that apply to the merged result
+ */
+struct MergeSpec
+{
+    std::string order_column;   /**< ORDER BY column name, empty if not ordered */
+    bool        descending;     /**< Whether the ordering is descending */
+    bool        has_limit;      /**< Whether a LIMIT clause was given */
+    uint64_t    offset;         /**< Number of merged rows to skip */
+    uint64_t    limit;          /**< Maximum number of merged rows to return */
+
+    MergeSpec()
+        : descending(false)
+        , has_limit(false)
+        , offset(0)
+        , limit(0)
+    {
+    }
+};
+
+/**
+ * A statement that is sent to a shard
+ */
+struct ScatterTarget
+{
+    SERVER*     server; /**< The shard */
+    std::string sql;    /**< The statement to execute */
+};
+
+/**
+ * Split a statement into the statements that are executed on the shards
+ *
+ * The statement is split on each top-level UNION ALL and a trailing ORDER BY
+ * on a single column name and LIMIT clause is removed from the last branch and
+ * stored in @c spec. Statements with a top-level UNION DISTINCT or with a
+ * trailing ORDER BY or LIMIT clause that cannot be merged are rejected.
+ *
+ * @param sql      The SQL statement
+ * @param branches The statements that need to be executed
+ * @param spec     The merge specification
+ *
+ * @return True if the statement can be executed as a scatter-gather query
+ */
+bool parse_scatter_statement(const std::string& sql,
+                             std::vector<std::string>* branches,
+                             MergeSpec* spec);
+
+/**
+ * Check whether the result of a statement depends on all of the rows it reads
+ *
+ * Aggregate and window functions, GROUP BY, HAVING, DISTINCT and a LIMIT in a
+ * subquery all combine rows. Executing such a statement on each shard and
+ * concatenating the results is not the same as executing it on all of the data.
+ *
+ * @param sql The SQL statement
+ *
+ * @return True if the statement combines rows
+ */
+bool combines_rows(const std::string& sql);
+
+/**
+ * Add the pushed down ORDER BY and LIMIT clauses to a branch
+ *
+ * Each shard sorts its own rows and returns at most `offset + limit` rows. The
+ * offset is applied only once the results are merged. An ordered statement is
+ * wrapped in a derived table that also returns WEIGHT_STRING() of the ORDER BY
+ * column as the last column. The rows are merged by it, so the merged result
+ * is sorted by the collation of the column as each shard sorts it.
+ *
+ * @param branch Branch statement
+ * @param spec   The merge specification
+ *
+ * @return The statement that is sent to the shard
+ */
+std::string push_down_merge_spec(const std::string& branch, const MergeSpec& spec);
+
+/**
+ * Merges the resultsets of a statement executed on multiple shards
+ *
+ * The column definitions of all shards are reconciled into one set of column
+ * definitions after which rows are streamed to the client as they arrive. If
+ * the result is ordered, a row is sent only when all shards that are still
+ * returning rows have at least one row buffered.
+ */
+class ScatterGather
+{
+    ScatterGather(const ScatterGather&);
+    ScatterGather& operator=(const ScatterGather&);
+
+public:
+    ScatterGather(MXS_SESSION* session, const MergeSpec& spec);
+    ~ScatterGather();
+
+    /**
+     * Add a shard that the query was sent to
+     *
+     * @param backend The backend the query was sent to
+     */
+    void add_source(const SSRBackend& backend);
+
+    /**
+     * Check whether a backend takes part in this query
+     *
+     * @param backend Backend to check
+     *
+     * @return True if the query was sent to the backend and its reply is not yet complete
+     */
+    bool is_source(const SSRBackend& backend) const;
+
+    /**
+     * Process a reply from a shard
+     *
+     * @param backend The backend that sent the reply
+     * @param pPacket The reply, takes ownership of the buffer
+     */
+    void process_reply(const SSRBackend& backend, GWBUF* pPacket);
+
+    /**
+     * Abort the reply from a shard that failed
+     *
+     * An error is sent to the client unless one has already been sent. The
+     * replies from the remaining shards are discarded.
+     *
+     * @param backend The backend that failed
+     */
+    void abort_source(const SSRBackend& backend);
+
+    /**
+     * Check whether all shards have replied
+     *
+     * @return True if the merged result has been sent to the client
+     */
+    bool is_complete() const
+    {
+        return m_complete;
+    }
+
+private:
+    enum source_state
+    {
+        EXPECT_HEADER,
+        EXPECT_COLUMNS,
+        EXPECT_EOF,
+        EXPECT_ROWS,
+        DONE
+    };
+
+    struct Source
+    {
+        SRBackend*          backend;    /**< The shard */
+        source_state        state;      /**< The reply state */
+        GWBUF*              partial;    /**< Data that is not yet a complete packet */
+        GWBUF*              header;     /**< The column count packet or the OK packet */
+        GWBUF*              eof;        /**< The EOF packet after the column definitions */
+        uint64_t            n_columns;  /**< Number of columns in the resultset */
+        std::vector<GWBUF*> columns;    /**< The column definitions */
+        std::deque<GWBUF*>  rows;       /**< Rows waiting to be sent */
+    };
+
+    Source* find_source(const SSRBackend& backend);
+    void    process_packet(Source& source, GWBUF* pPacket);
+    void    merge();
+    bool    send_header();
+    bool    reconcile_columns(Source& first);
+    Source* next_ordered_source();
+    void    emit_row(GWBUF* pRow);
+    void    emit(GWBUF* pPacket);
+    void    fail(uint16_t errnum, const char* sqlstate, const char* message);
+    void    fail(GWBUF* pError);
+    void    discard_rows();
+
+    MXS_SESSION*        m_session;      /**< The client session */
+    MergeSpec           m_spec;         /**< ORDER BY and LIMIT of the merged result */
+    std::vector<Source> m_sources;      /**< The shards */
+    GWBUF*              m_output;       /**< Packets waiting to be routed to the client */
+    uint8_t             m_seq;          /**< Next sequence number sent to the client */
+    bool                m_header_sent;  /**< Whether the column definitions have been sent */
+    bool                m_failed;       /**< Whether an error was sent to the client */
+    bool                m_complete;     /**< Whether the result is complete */
+    int                 m_order_index;  /**< The index of the compared column or -1 */
+    uint8_t             m_order_type;   /**< The type of the compared column */
+    uint64_t            m_skipped;      /**< Number of rows skipped due to the offset */
+    uint64_t            m_rows_sent;    /**< Number of rows sent to the client */
+    uint16_t            m_warnings;     /**< Total number of warnings */
+    uint16_t            m_status;       /**< Server status of the final EOF packet */
+};
+}
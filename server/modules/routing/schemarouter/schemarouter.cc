@@ -25,6 +25,7 @@ Config::Config(MXS_CONFIG_PARAMETER* conf)
     , ignore_regex(config_get_compiled_regex(conf, "ignore_databases_regex", 0, NULL))
     , ignore_match_data(ignore_regex ? pcre2_match_data_create_from_pattern(ignore_regex, NULL) : NULL)
     , preferred_server(config_get_server(conf, "preferred_server"))
+    , scatter_gather(config_get_bool(conf, "scatter_gather"))
 {
     ignored_dbs.insert("mysql");
     ignored_dbs.insert("information_schema");
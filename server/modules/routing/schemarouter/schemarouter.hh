@@ -48,6 +48,7 @@ struct Config
     pcre2_match_data*     ignore_match_data;/**< Match data for @c ignore_regex */
     std::set<std::string> ignored_dbs;      /**< Set of ignored databases */
     SERVER*               preferred_server; /**< Server to prefer in conflict situations */
+    bool                  scatter_gather;   /**< Execute cross-shard reads on all shards */
 
     Config(MXS_CONFIG_PARAMETER* conf);
 
@@ -76,6 +77,7 @@ struct Stats
     double ses_longest;     /*< Longest session */
     double ses_shortest;    /*< Shortest session */
     double ses_average;     /*< Average session length */
+    int    n_scatter_gather;/*< Number of scatter-gather queries */
 
     Stats()
         : n_queries(0)
@@ -88,6 +90,7 @@ struct Stats
         , ses_longest(0.0)
         , ses_shortest(std::numeric_limits<double>::max())
         , ses_average(0.0)
+        , n_scatter_gather(0)
     {
     }
 };
@@ -236,6 +236,7 @@ void SchemaRouter::diagnostics(DCB* dcb)
     }
     dcb_printf(dcb, "Shard map cache hits: %d\n", m_stats.shmap_cache_hit);
     dcb_printf(dcb, "Shard map cache misses: %d\n", m_stats.shmap_cache_miss);
+    dcb_printf(dcb, "Scatter-gather queries: %d\n", m_stats.n_scatter_gather);
     dcb_printf(dcb, "\n");
 }
 
@@ -261,6 +262,7 @@ json_t* SchemaRouter::diagnostics_json() const
 
     json_object_set_new(rval, "shard_map_hits", json_integer(m_stats.shmap_cache_hit));
     json_object_set_new(rval, "shard_map_misses", json_integer(m_stats.shmap_cache_miss));
+    json_object_set_new(rval, "scatter_gather_queries", json_integer(m_stats.n_scatter_gather));
 
     return rval;
 }
@@ -303,6 +305,7 @@ extern "C" MXS_MODULE* MXS_CREATE_MODULE()
             {"refresh_interval",                              MXS_MODULE_PARAM_COUNT, DEFAULT_REFRESH_INTERVAL},
             {"debug",                                         MXS_MODULE_PARAM_BOOL, "false"},
             {"preferred_server",                              MXS_MODULE_PARAM_SERVER  },
+            {"scatter_gather",                                MXS_MODULE_PARAM_BOOL, "false"},
             {MXS_END_MODULE_PARAMS}
         }
     };
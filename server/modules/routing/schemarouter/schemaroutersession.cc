@@ -17,6 +17,8 @@
 
 #include <inttypes.h>
 
+#include <map>
+
 #include <maxbase/atomic.hh>
 #include <maxscale/alloc.h>
 #include <maxscale/modutil.h>
@@ -289,6 +291,13 @@ int32_t SchemaRouterSession::routeQuery(GWBUF* pPacket)
 
     int ret = 0;
 
+    if (m_sg)
+    {
+        /** A scatter-gather query is still active, route this once it completes */
+        m_queue.push_back(pPacket);
+        return 1;
+    }
+
     /**
      * If the databases are still being mapped or if the client connected
      * with a default database but no database mapping was performed we need
@@ -359,6 +368,12 @@ int32_t SchemaRouterSession::routeQuery(GWBUF* pPacket)
             gwbuf_free(pPacket);
             return ret;
         }
+        else if (m_config->scatter_gather && route_scatter_gather(pPacket, command, type))
+        {
+            mxb::atomic::add(&m_router->m_stats.n_scatter_gather, 1, mxb::atomic::RELAXED);
+            mxb::atomic::add(&m_router->m_stats.n_queries, 1, mxb::atomic::RELAXED);
+            return 1;
+        }
 
         /** The default database changes must be routed to a specific server */
         if (command == MXS_COM_INIT_DB || op == QUERY_OP_CHANGE_DB)
@@ -580,7 +595,22 @@ void SchemaRouterSession::clientReply(GWBUF* pPacket, DCB* pDcb)
             route_queued_query();
         }
     }
+    else if (m_sg && m_sg->is_source(bref))
+    {
+        /** The merged result is routed to the client by the scatter-gather query */
+        m_sg->process_reply(bref, pPacket);
+        pPacket = NULL;
+
+        if (m_sg->is_complete())
+        {
+            m_sg.reset();
 
+            if (m_queue.size())
+            {
+                route_queued_query();
+            }
+        }
+    }
     else if (m_queue.size())
     {
         mxb_assert(m_state == INIT_READY);
@@ -624,10 +654,29 @@ void SchemaRouterSession::handleError(GWBUF* pMessage,
         return;
     }
 
+    bool replied = false;
+
+    if (m_sg && m_sg->is_source(bref))
+    {
+        /** The error is reported to the client as a part of the merged result */
+        m_sg->abort_source(bref);
+        replied = true;
+
+        if (m_sg->is_complete())
+        {
+            m_sg.reset();
+
+            if (m_queue.size())
+            {
+                route_queued_query();
+            }
+        }
+    }
+
     switch (action)
     {
     case ERRACT_NEW_CONNECTION:
-        if (bref->is_waiting_result())
+        if (bref->is_waiting_result() && !replied)
         {
             /** If the client is waiting for a reply, send an error. */
             m_client->func.write(m_client, gwbuf_clone(pMessage));
@@ -638,7 +687,7 @@ void SchemaRouterSession::handleError(GWBUF* pMessage,
 
     case ERRACT_REPLY_CLIENT:
         // The session pointer can be NULL if the creation fails when filters are being set up
-        if (m_client->session && m_client->session->state == SESSION_STATE_ROUTER_READY)
+        if (m_client->session && m_client->session->state == SESSION_STATE_ROUTER_READY && !replied)
         {
             m_client->func.write(m_client, gwbuf_clone(pMessage));
         }
@@ -1821,4 +1870,223 @@ SERVER* SchemaRouterSession::get_ps_target(GWBUF* buffer, uint32_t qtype, qc_que
     }
     return rval;
 }
+
+/**
+ * Check whether a query only reads data
+ *
+ * @param type Query type mask
+ *
+ * @return True if the query can be executed on multiple shards in parallel
+ */
+static bool is_read_only(uint32_t type)
+{
+    const uint32_t read_types = QUERY_TYPE_READ | QUERY_TYPE_LOCAL_READ | QUERY_TYPE_USERVAR_READ
+        | QUERY_TYPE_SYSVAR_READ | QUERY_TYPE_GSYSVAR_READ;
+
+    return qc_query_is_type(type, QUERY_TYPE_READ) && (type & ~read_types) == 0;
+}
+
+/**
+ * Check whether all tables in a query are in the information_schema database
+ *
+ * @param buffer Query to inspect
+ *
+ * @return True if the query reads only metadata
+ */
+static bool is_metadata_query(GWBUF* buffer)
+{
+    int n_tables = 0;
+    char** tables = qc_get_table_names(buffer, &n_tables, true);
+    bool rval = n_tables > 0;
+    const char prefix[] = "information_schema.";
+
+    for (int i = 0; i < n_tables; i++)
+    {
+        if (strncasecmp(tables[i], prefix, sizeof(prefix) - 1) != 0)
+        {
+            rval = false;
+        }
+
+        MXS_FREE(tables[i]);
+    }
+
+    MXS_FREE(tables);
+    return rval;
+}
+
+/**
+ * Find out which shards a query should be executed on
+ *
+ * A UNION ALL whose branches target different shards is split so that each
+ * branch is executed on the shard where its tables are. Queries that only read
+ * from information_schema are executed on all shards unless they combine rows.
+ *
+ * @param pPacket The query
+ * @param targets The statements to execute and their shards
+ * @param spec    The ORDER BY and LIMIT clauses of the merged result
+ *
+ * @return True if the query should be executed as a scatter-gather query
+ */
+bool SchemaRouterSession::plan_scatter_gather(GWBUF* pPacket,
+                                              std::vector<ScatterTarget>* targets,
+                                              MergeSpec* spec)
+{
+    char* sql;
+    int len;
+
+    if (!modutil_extract_SQL(pPacket, &sql, &len))
+    {
+        return false;
+    }
+
+    std::string stmt(sql, len);
+    std::vector<std::string> branches;
+
+    if (!parse_scatter_statement(stmt, &branches, spec))
+    {
+        return false;
+    }
+
+    if (branches.size() > 1)
+    {
+        std::map<SERVER*, std::string> statements;
+
+        for (const auto& branch : branches)
+        {
+            GWBUF* buffer = modutil_create_query(branch.c_str());
+            MXS_ABORT_IF_NULL(buffer);
+            SERVER* target = get_query_target(buffer);
+            gwbuf_free(buffer);
+
+            if (target == NULL && m_current_db.length())
+            {
+                target = m_shard.get_location(m_current_db);
+            }
+
+            if (target == NULL)
+            {
+                MXS_INFO("No shard found for UNION ALL branch: %s", branch.c_str());
+                return false;
+            }
+
+            // Branches that target the same shard are executed as one UNION ALL
+            std::string& stmt = statements[target];
+            stmt += stmt.empty() ? branch : " UNION ALL " + branch;
+        }
+
+        for (const auto& a : statements)
+        {
+            ScatterTarget t = {a.first, push_down_merge_spec(a.second, *spec)};
+            targets->push_back(t);
+        }
+
+        // A UNION ALL that only targets one shard is routed normally
+        return targets->size() > 1;
+    }
+    else if (is_metadata_query(pPacket))
+    {
+        if (combines_rows(stmt))
+        {
+            // Each shard would return its own aggregate of its own rows
+            MXS_INFO("Metadata query combines rows, not executing it on all shards: %s", stmt.c_str());
+            return false;
+        }
+
+        for (const auto& b : m_backends)
+        {
+            if (b->in_use() && server_is_usable(b->backend()->server))
+            {
+                ScatterTarget t = {b->backend()->server, push_down_merge_spec(branches[0], *spec)};
+                targets->push_back(t);
+            }
+        }
+
+        return targets->size() > 1;
+    }
+
+    return false;
+}
+
+/**
+ * Execute a read-only query on multiple shards in parallel
+ *
+ * @param pPacket The query, freed if the query was routed
+ * @param command The command byte
+ * @param type    Query type mask
+ *
+ * @return True if the query was routed as a scatter-gather query
+ */
+bool SchemaRouterSession::route_scatter_gather(GWBUF* pPacket, uint8_t command, uint32_t type)
+{
+    if (command != MXS_COM_QUERY
+        || !is_read_only(type)
+        || pPacket->hint
+        || session_trx_is_active(m_client->session)
+        || modutil_count_statements(pPacket) > 1)
+    {
+        return false;
+    }
+
+    std::vector<ScatterTarget> targets;
+    MergeSpec spec;
+
+    if (!plan_scatter_gather(pPacket, &targets, &spec))
+    {
+        return false;
+    }
+
+    std::vector<SSRBackend> brefs;
+
+    for (const auto& t : targets)
+    {
+        DCB* dcb = NULL;
+
+        if (!get_shard_dcb(&dcb, t.server->name))
+        {
+            MXS_INFO("Shard '%s' is not available for a scatter-gather query", t.server->name);
+            return false;
+        }
+
+        SSRBackend bref = get_bref_from_dcb(dcb);
+
+        if (bref->has_session_commands())
+        {
+            // The statements would have to wait for the session commands, route it normally
+            return false;
+        }
+
+        brefs.push_back(bref);
+    }
+
+    m_sg.reset(new ScatterGather(m_client->session, spec));
+
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        GWBUF* query = modutil_create_query(targets[i].sql.c_str());
+        MXS_ABORT_IF_NULL(query);
+        SSRBackend& bref = brefs[i];
+
+        MXS_INFO("Scatter-gather query to %s: %s", bref->name(), targets[i].sql.c_str());
+
+        m_sg->add_source(bref);
+
+        if (bref->write(query))
+        {
+            mxb::atomic::add(&bref->server()->stats.packets, 1, mxb::atomic::RELAXED);
+        }
+        else
+        {
+            MXS_ERROR("Failed to write scatter-gather query to '%s'", bref->name());
+            m_sg->abort_source(bref);
+        }
+    }
+
+    if (m_sg->is_complete())
+    {
+        m_sg.reset();
+    }
+
+    gwbuf_free(pPacket);
+    return true;
+}
 }
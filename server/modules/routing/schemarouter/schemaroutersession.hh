@@ -16,11 +16,13 @@
 
 #include <string>
 #include <list>
+#include <memory>
 
 #include <maxscale/protocol/mysql.h>
 #include <maxscale/router.hh>
 #include <maxscale/session_command.hh>
 
+#include "scatter_gather.hh"
 #include "shard_map.hh"
 
 namespace schemarouter
@@ -153,21 +155,26 @@ private:
     void                 handle_mapping_reply(SSRBackend& bref, GWBUF** pPacket);
     bool                 handle_statement(GWBUF* querybuf, SSRBackend& bref, uint8_t command, uint32_t type);
 
+    /** Scatter-gather functions */
+    bool route_scatter_gather(GWBUF* pPacket, uint8_t command, uint32_t type);
+    bool plan_scatter_gather(GWBUF* pPacket, std::vector<ScatterTarget>* targets, MergeSpec* spec);
+
     /** Member variables */
-    bool                   m_closed;        /**< True if session closed */
-    DCB*                   m_client;        /**< The client DCB */
-    MYSQL_session*         m_mysql_session; /**< Session client data (username, password, SHA1). */
-    SSRBackendList         m_backends;      /**< Backend references */
-    SConfig                m_config;        /**< Session specific configuration */
-    SchemaRouter*          m_router;        /**< The router instance */
-    Shard                  m_shard;         /**< Database to server mapping */
-    std::string            m_connect_db;    /**< Database the user was trying to connect to */
-    std::string            m_current_db;    /**< Current active database */
-    int                    m_state;         /**< Initialization state bitmask */
-    std::list<mxs::Buffer> m_queue;         /**< Query that was received before the session was ready */
-    Stats                  m_stats;         /**< Statistics for this router */
-    uint64_t               m_sent_sescmd;   /**< The latest session command being executed */
-    uint64_t               m_replied_sescmd;/**< The last session command reply that was sent to the client */
-    SERVER*                m_load_target;   /**< Target for LOAD DATA LOCAL INFILE */
+    bool                           m_closed;         /**< True if session closed */
+    DCB*                           m_client;         /**< The client DCB */
+    MYSQL_session*                 m_mysql_session;  /**< Session client data (username, password, SHA1). */
+    SSRBackendList                 m_backends;       /**< Backend references */
+    SConfig                        m_config;         /**< Session specific configuration */
+    SchemaRouter*                  m_router;         /**< The router instance */
+    Shard                          m_shard;          /**< Database to server mapping */
+    std::string                    m_connect_db;     /**< Database the user was trying to connect to */
+    std::string                    m_current_db;     /**< Current active database */
+    int                            m_state;          /**< Initialization state bitmask */
+    std::list<mxs::Buffer>         m_queue;          /**< Query that was received before the session was ready */
+    Stats                          m_stats;          /**< Statistics for this router */
+    uint64_t                       m_sent_sescmd;    /**< The latest session command being executed */
+    uint64_t                       m_replied_sescmd; /**< The last session command reply that was sent to the client */
+    SERVER*                        m_load_target;    /**< Target for LOAD DATA LOCAL INFILE */
+    std::unique_ptr<ScatterGather> m_sg;             /**< Active scatter-gather query */
 };
 }
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "../scatter_gather.hh"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::cout;
+using schemarouter::MergeSpec;
+
+namespace
+{
+
+string join(const std::vector<string>& branches)
+{
+    string rval;
+
+    for (const auto& b : branches)
+    {
+        rval += rval.empty() ? b : " | " + b;
+    }
+
+    return rval;
+}
+
+/**
+ * Test splitting of statements
+ *
+ * @return Number of errors
+ */
+int test_parse()
+{
+    struct TestCase
+    {
+        string   sql;
+        bool     ok;
+        string   branches;      // Separated with " | "
+        string   order_column;
+        bool     descending;
+        bool     has_limit;
+        uint64_t offset;
+        uint64_t limit;
+    };
+
+    std::vector<TestCase> cases = {
+        {"SELECT a FROM t1", true, "SELECT a FROM t1", "", false, false, 0, 0},
+        {"SELECT a FROM t1 UNION ALL SELECT a FROM t2;", true,
+         "SELECT a FROM t1 | SELECT a FROM t2", "", false, false, 0, 0},
+        {"SELECT a FROM t1 UNION ALL SELECT a FROM t2 ORDER BY a DESC LIMIT 5, 10", true,
+         "SELECT a FROM t1 | SELECT a FROM t2", "a", true, true, 5, 10},
+        {"SELECT a FROM t1 UNION ALL SELECT a FROM t2 ORDER BY t2.a ASC LIMIT 10 OFFSET 5", true,
+         "SELECT a FROM t1 | SELECT a FROM t2", "a", false, true, 5, 10},
+        {"SELECT `a``b` FROM t1 ORDER BY `a``b`", true, "SELECT `a``b` FROM t1", "a`b", false, false, 0, 0},
+        {"SELECT a FROM t1 LIMIT 3", true, "SELECT a FROM t1", "", false, true, 0, 3},
+        {"SELECT 'UNION' FROM t1 UNION ALL SELECT (SELECT 1 UNION SELECT 2) FROM t2", true,
+         "SELECT 'UNION' FROM t1 | SELECT (SELECT 1 UNION SELECT 2) FROM t2", "", false, false, 0, 0},
+        {"SELECT a FROM t1 /* UNION */ UNION ALL -- UNION\nSELECT a FROM t2", true,
+         "SELECT a FROM t1 | SELECT a FROM t2", "", false, false, 0, 0},
+        {"SELECT a FROM t1 UNION SELECT a FROM t2", false},
+        {"SELECT a FROM t1 UNION DISTINCT SELECT a FROM t2", false},
+        {"SELECT a FROM t1 UNION ALL", false},
+        {"SELECT a FROM t1 ORDER BY 1", false},
+        {"SELECT a, b FROM t1 ORDER BY a, b", false},
+        {"SELECT a FROM t1 ORDER BY LENGTH(a)", false},
+        {"SELECT a FROM t1 LIMIT 1 ORDER BY a", false},
+        {"SELECT a FROM t1 LIMIT ?", false},
+        {"SELECT a FROM t1 LIMIT 1 FOR UPDATE", false},
+        {"SELECT /*!50000 a */ FROM t1", false},
+        {"SELECT 'a FROM t1", false},
+    };
+
+    int errors = 0;
+
+    for (const auto& tc : cases)
+    {
+        std::vector<string> branches;
+        MergeSpec spec;
+        bool ok = schemarouter::parse_scatter_statement(tc.sql, &branches, &spec);
+
+        if (ok != tc.ok)
+        {
+            cout << "'" << tc.sql << "' should " << (tc.ok ? "" : "not ") << "be accepted.\n";
+            errors++;
+        }
+        else if (ok && (join(branches) != tc.branches
+                        || spec.order_column != tc.order_column
+                        || spec.descending != tc.descending
+                        || spec.has_limit != tc.has_limit
+                        || spec.offset != tc.offset
+                        || spec.limit != tc.limit))
+        {
+            cout << "Wrong result for '" << tc.sql << "': '" << join(branches) << "', ORDER BY '"
+                 << spec.order_column << "'" << (spec.descending ? " DESC" : "")
+                 << (spec.has_limit ? ", LIMIT " : ", no LIMIT ") << spec.offset << ", " << spec.limit
+                 << "\n";
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+/**
+ * Test the statements sent to the shards
+ *
+ * @return Number of errors
+ */
+int test_push_down()
+{
+    struct TestCase
+    {
+        string sql;
+        string result;
+    };
+
+    std::vector<TestCase> cases = {
+        {"SELECT a FROM t1", "SELECT a FROM t1"},
+        {"SELECT a FROM t1 UNION ALL SELECT a FROM t2 LIMIT 5, 10",
+         "SELECT a FROM t1 UNION ALL SELECT a FROM t2 LIMIT 15"},
+        {"SELECT a FROM t1 ORDER BY a DESC LIMIT 10",
+         "SELECT sg_.*, WEIGHT_STRING(sg_.`a`) FROM (SELECT a FROM t1) AS sg_ ORDER BY sg_.`a` DESC LIMIT 10"},
+        {"SELECT `a``b` FROM t1 ORDER BY `a``b`",
+         "SELECT sg_.*, WEIGHT_STRING(sg_.`a``b`) FROM (SELECT `a``b` FROM t1) AS sg_ ORDER BY sg_.`a``b`"},
+    };
+
+    int errors = 0;
+
+    for (const auto& tc : cases)
+    {
+        std::vector<string> branches;
+        MergeSpec spec;
+        string result;
+
+        if (schemarouter::parse_scatter_statement(tc.sql, &branches, &spec))
+        {
+            string stmt;
+
+            for (const auto& b : branches)
+            {
+                stmt += stmt.empty() ? b : " UNION ALL " + b;
+            }
+
+            result = schemarouter::push_down_merge_spec(stmt, spec);
+        }
+
+        if (result != tc.result)
+        {
+            cout << "'" << tc.sql << "' produced '" << result << "' while '" << tc.result
+                 << "' was expected.\n";
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+/**
+ * Test detection of statements whose results cannot be concatenated
+ *
+ * @return Number of errors
+ */
+int test_combines_rows()
+{
+    struct TestCase
+    {
+        string sql;
+        bool   result;
+    };
+
+    std::vector<TestCase> cases = {
+        {"SELECT table_name FROM information_schema.tables", false},
+        {"SELECT table_name FROM information_schema.tables ORDER BY table_name LIMIT 10", false},
+        {"SELECT t.count, 'COUNT(*)', `sum` FROM information_schema.tables t", false},
+        {"SELECT COUNT(*) FROM information_schema.tables", true},
+        {"SELECT max (table_rows) FROM information_schema.tables", true},
+        {"SELECT table_schema FROM information_schema.tables GROUP BY table_schema", true},
+        {"SELECT DISTINCT table_schema FROM information_schema.tables", true},
+        {"SELECT table_schema FROM information_schema.tables HAVING 1", true},
+        {"SELECT ROW_NUMBER() OVER (ORDER BY table_name) FROM information_schema.tables", true},
+        {"SELECT * FROM information_schema.tables WHERE table_name IN "
+         "(SELECT table_name FROM information_schema.columns LIMIT 1)", true},
+        {"SELECT * FROM information_schema.tables WHERE table_name = 'a", true},
+    };
+
+    int errors = 0;
+
+    for (const auto& tc : cases)
+    {
+        if (schemarouter::combines_rows(tc.sql) != tc.result)
+        {
+            cout << "'" << tc.sql << "' should " << (tc.result ? "" : "not ") << "combine rows.\n";
+            errors++;
+        }
+    }
+
+    return errors;
+}
+}
+
+int main()
+{
+    int errors = 0;
+
+    errors += test_parse();
+    errors += test_push_down();
+    errors += test_combines_rows();
+
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}